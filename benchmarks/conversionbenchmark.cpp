@@ -0,0 +1,117 @@
+/***************************************************************************
+                          conversionbenchmark.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+// Measures the throughput of the conversion of the raw samples into uV for each instruction set
+// supported by the processor, and checks that all of them give the same values.
+//
+// Usage: conversion-benchmark [number of channels] [number of samples per channel] [number of repetitions]
+
+//include files for the application
+#include "tracesconversion.h"
+
+// include files for QT
+#include <QElapsedTimer>
+#include <QVector>
+
+// include c/c++ headers
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+
+typedef void (*Kernel)(const QVector<int16_t>& samples,QVector<dataType>& data,int nbChannels,const QVector<TracesConversion::ChannelScaling>& scalings);
+
+void scaleKernel(const QVector<int16_t>& samples,QVector<dataType>& data,int,const QVector<TracesConversion::ChannelScaling>&){
+    TracesConversion::scale(samples.constData(),data.data(),samples.size(),0.195);
+}
+
+void shiftKernel(const QVector<int16_t>& samples,QVector<dataType>& data,int,const QVector<TracesConversion::ChannelScaling>&){
+    TracesConversion::shift(samples.constData(),data.data(),samples.size(),2048 * 0.195);
+}
+
+void affineKernel(const QVector<int16_t>& samples,QVector<dataType>& data,int nbChannels,const QVector<TracesConversion::ChannelScaling>& scalings){
+    TracesConversion::affine(samples.constData(),data.data(),samples.size() / nbChannels,nbChannels,scalings.constData());
+}
+
+/**Runs @p kernel with every instruction set and prints the number of samples converted per second.
+ * @return false if an instruction set gives different values than the scalar code.
+ */
+bool benchmark(const char* name,Kernel kernel,const QVector<int16_t>& samples,int nbChannels,const QVector<TracesConversion::ChannelScaling>& scalings,int nbRepetitions){
+    QVector<dataType> reference(samples.size());
+    QVector<dataType> data(samples.size());
+    bool identical = true;
+    double scalarRate = 0.0;
+
+    for(int set = TracesConversion::SCALAR; set <= TracesConversion::AVX2; ++set){
+        TracesConversion::InstructionSet used = TracesConversion::setInstructionSet(static_cast<TracesConversion::InstructionSet>(set));
+        if(used != set)
+            continue;
+
+        QElapsedTimer timer;
+        timer.start();
+        for(int i = 0; i < nbRepetitions; ++i)
+            kernel(samples,set == TracesConversion::SCALAR ? reference : data,nbChannels,scalings);
+        double seconds = timer.nsecsElapsed() / 1e9;
+        double rate = static_cast<double>(samples.size()) * nbRepetitions / seconds;
+
+        if(set == TracesConversion::SCALAR)
+            scalarRate = rate;
+        else if(data != reference){
+            identical = false;
+            printf("%-8s %-8s differs from the scalar conversion\n",name,TracesConversion::instructionSetName(used));
+        }
+        printf("%-8s %-8s %10.1f Msamples/s  x%.2f\n",name,TracesConversion::instructionSetName(used),rate / 1e6,rate / scalarRate);
+    }
+    return identical;
+}
+
+}
+
+int main(int argc,char** argv){
+    int nbChannels = (argc > 1) ? atoi(argv[1]) : 256;
+    int nbSamples = (argc > 2) ? atoi(argv[2]) : 30000;
+    int nbRepetitions = (argc > 3) ? atoi(argv[3]) : 20;
+    if(nbChannels <= 0 || nbSamples <= 0 || nbRepetitions <= 0){
+        fprintf(stderr,"usage: %s [number of channels] [number of samples per channel] [number of repetitions]\n",argv[0]);
+        return 1;
+    }
+
+    //Full scale pseudo random samples.
+    QVector<int16_t> samples(nbChannels * nbSamples);
+    srand(1);
+    for(int i = 0; i < samples.size(); ++i)
+        samples[i] = static_cast<int16_t>((rand() & 0xFFFF) - 32768);
+
+    //Typical Blackrock scalings, in uV and mV.
+    QVector<TracesConversion::ChannelScaling> scalings(nbChannels);
+    for(int channel = 0; channel < nbChannels; ++channel){
+        scalings[channel].minDigital = -32764;
+        scalings[channel].rangeDigital = 65528;
+        scalings[channel].minAnalog = -8191;
+        scalings[channel].rangeAnalog = 16382;
+        scalings[channel].unit = (channel % 2 == 0) ? 1 : 1000;
+    }
+
+    printf("%d channels x %d samples, %d repetitions, best instruction set: %s\n",nbChannels,nbSamples,nbRepetitions,
+           TracesConversion::instructionSetName(TracesConversion::instructionSet()));
+
+    bool identical = true;
+    identical &= benchmark("scale",scaleKernel,samples,nbChannels,scalings,nbRepetitions);
+    identical &= benchmark("shift",shiftKernel,samples,nbChannels,scalings,nbRepetitions);
+    identical &= benchmark("affine",affineKernel,samples,nbChannels,scalings,nbRepetitions);
+
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+/***************************************************************************
+                          decimationbenchmark.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+// Measures the throughput of the reduction of the traces to pixel columns for each decimation mode and
+// instruction set supported by the processor, and checks that all of them give the same values.
+//
+// Usage: decimation-benchmark [number of channels] [number of samples per channel] [number of columns] [number of repetitions]
+
+//include files for the application
+#include "tracesdecimation.h"
+#include "tracesconversion.h"
+
+// include files for QT
+#include <QElapsedTimer>
+#include <QVector>
+
+// include c/c++ headers
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace {
+
+/**Samples of the traces, interleaved channels, and the first sample of each pixel column followed by the end of the trace.*/
+struct Traces{
+    QVector<dataType> data;
+    int nbChannels;
+    QVector<qint64> starts;
+};
+
+typedef void (*Kernel)(const Traces& traces,int channel,QVector<dataType>& columns);
+
+void minMaxKernel(const Traces& traces,int channel,QVector<dataType>& columns){
+    const dataType* values = traces.data.constData() + channel;
+    const int nbColumns = traces.starts.size() - 1;
+    for(int i = 0; i < nbColumns; ++i){
+        const qint64 start = traces.starts[i];
+        TracesDecimation::extrema(values + start * traces.nbChannels,traces.nbChannels,traces.starts[i + 1] - start,columns[2 * i],columns[2 * i + 1]);
+    }
+}
+
+void rmsKernel(const Traces& traces,int channel,QVector<dataType>& columns){
+    const dataType* values = traces.data.constData() + channel;
+    const int nbColumns = traces.starts.size() - 1;
+    for(int i = 0; i < nbColumns; ++i){
+        const qint64 start = traces.starts[i];
+        TracesDecimation::band(values + start * traces.nbChannels,traces.nbChannels,traces.starts[i + 1] - start,columns[2 * i],columns[2 * i + 1]);
+    }
+}
+
+void lttbKernel(const Traces& traces,int channel,QVector<dataType>& columns){
+    //No bucket follows the last one.
+    QVector<qint64> starts = traces.starts;
+    starts.append(starts.last());
+    TracesDecimation::largestTriangles(traces.data.constData() + channel,traces.nbChannels,starts.constData(),starts.size() - 2,
+                                       0.0,0.0,false,columns.data());
+}
+
+/**Runs @p kernel on every channel with every instruction set and prints the number of samples reduced per second.
+ * @return false if an instruction set gives different values than the scalar code.
+ */
+bool benchmark(TracesDecimation::Mode mode,Kernel kernel,const Traces& traces,int nbRepetitions){
+    const int nbColumns = traces.starts.size() - 1;
+    QVector<dataType> reference(2 * nbColumns * traces.nbChannels);
+    QVector<dataType> results(reference.size());
+    QVector<dataType> columns(2 * nbColumns);
+    bool identical = true;
+    double scalarRate = 0.0;
+
+    for(int set = TracesConversion::SCALAR; set <= TracesConversion::AVX2; ++set){
+        TracesConversion::InstructionSet used = TracesConversion::setInstructionSet(static_cast<TracesConversion::InstructionSet>(set));
+        if(used != set)
+            continue;
+
+        QVector<dataType>& output = (set == TracesConversion::SCALAR) ? reference : results;
+        QElapsedTimer timer;
+        timer.start();
+        for(int i = 0; i < nbRepetitions; ++i){
+            for(int channel = 0; channel < traces.nbChannels; ++channel){
+                kernel(traces,channel,columns);
+                qCopy(columns.constBegin(),columns.constEnd(),output.begin() + channel * columns.size());
+            }
+        }
+        double seconds = timer.nsecsElapsed() / 1e9;
+        double rate = static_cast<double>(traces.data.size()) * nbRepetitions / seconds;
+
+        if(set == TracesConversion::SCALAR)
+            scalarRate = rate;
+        else if(results != reference){
+            identical = false;
+            printf("%-8s %-8s differs from the scalar reduction\n",TracesDecimation::modeName(mode),TracesConversion::instructionSetName(used));
+        }
+        printf("%-8s %-8s %10.1f Msamples/s  x%.2f\n",TracesDecimation::modeName(mode),TracesConversion::instructionSetName(used),rate / 1e6,rate / scalarRate);
+    }
+    return identical;
+}
+
+}
+
+int main(int argc,char** argv){
+    Traces traces;
+    traces.nbChannels = (argc > 1) ? atoi(argv[1]) : 64;
+    int nbSamples = (argc > 2) ? atoi(argv[2]) : 200000;
+    int nbColumns = (argc > 3) ? atoi(argv[3]) : 1920;
+    int nbRepetitions = (argc > 4) ? atoi(argv[4]) : 10;
+    if(traces.nbChannels <= 0 || nbSamples <= 0 || nbColumns <= 0 || nbColumns > nbSamples || nbRepetitions <= 0){
+        fprintf(stderr,"usage: %s [number of channels] [number of samples per channel] [number of columns] [number of repetitions]\n",argv[0]);
+        return 1;
+    }
+
+    //Pseudo random traces in uV, drifting as a random walk.
+    traces.data.resize(traces.nbChannels * nbSamples);
+    srand(1);
+    for(int channel = 0; channel < traces.nbChannels; ++channel){
+        dataType value = 0;
+        for(int i = 0; i < nbSamples; ++i){
+            value += (rand() % 201) - 100;
+            traces.data[i * traces.nbChannels + channel] = value;
+        }
+    }
+
+    //Columns as computed by the trace view.
+    const double downSampling = static_cast<double>(nbSamples) / nbColumns;
+    traces.starts.resize(nbColumns + 1);
+    for(int i = 0; i <= nbColumns; ++i)
+        traces.starts[i] = static_cast<qint64>(i * downSampling + 0.5);
+    traces.starts[nbColumns] = nbSamples;
+
+    printf("%d channels x %d samples into %d columns, %d repetitions, best instruction set: %s\n",traces.nbChannels,nbSamples,nbColumns,nbRepetitions,
+           TracesConversion::instructionSetName(TracesConversion::instructionSet()));
+
+    bool identical = true;
+    identical &= benchmark(TracesDecimation::MIN_MAX,minMaxKernel,traces,nbRepetitions);
+    identical &= benchmark(TracesDecimation::RMS_BAND,rmsKernel,traces,nbRepetitions);
+    identical &= benchmark(TracesDecimation::LTTB,lttbKernel,traces,nbRepetitions);
+
+    return identical ? 0 : 1;
+}
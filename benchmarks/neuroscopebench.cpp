@@ -0,0 +1,813 @@
+/***************************************************************************
+                          neuroscopebench.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+// Measures the providers reading the files of a session and the reduction of the traces to pixel columns, on synthetic
+// files generated from a seed: the same options give the same files and the same requested windows on every run.
+// The results are written as CSV, one line per benchmark, to compare them between two builds.
+//
+// Usage: neuroscope-bench [options], see usage() below.
+
+//include files for the application
+#include "tracesprovider.h"
+#include "nsxtracesprovider.h"
+#include "clustersprovider.h"
+#include "clusterscache.h"
+#include "eventsprovider.h"
+#include "positionsprovider.h"
+#include "tracesdecimation.h"
+#include "tracesconversion.h"
+#include "blackrock.h"
+
+// include files for QT
+#include <QCoreApplication>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QFile>
+#include <QDir>
+#include <QByteArray>
+
+// include c/c++ headers
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+namespace {
+
+/**Properties of the synthetic session and of the benchmarks, given on the command line.*/
+struct Options{
+    Options():nbChannels(64),samplingRate(20000.0),duration(60),nbSpikes(1000000),nbClusters(40),nbEvents(100000),
+        nbPositions(100000),window(1000),nbColumns(1920),nbRequests(100),nbRepetitions(10),seed(1){}
+
+    int nbChannels;
+    double samplingRate;
+    /**Length of the recording in seconds.*/
+    int duration;
+    int nbSpikes;
+    int nbClusters;
+    int nbEvents;
+    int nbPositions;
+    /**Length of the requested windows in miliseconds.*/
+    long window;
+    int nbColumns;
+    /**Number of windows requested by each repetition of the cluster and event benchmarks.*/
+    int nbRequests;
+    int nbRepetitions;
+    quint32 seed;
+    /**Only the benchmarks whose name contains it are run.*/
+    QString filter;
+    QString directory;
+    QString output;
+};
+
+/**Pseudo random numbers (xorshift), independent of the C library for the files to be the same on every system.*/
+class Random{
+public:
+    explicit Random(quint32 seed):state(seed == 0 ? 1 : seed){}
+
+    quint32 next(){
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    /**Returns a number uniformly distributed in [0, 1[.*/
+    double uniform(){return next() / 4294967296.0;}
+
+    /**Returns an integer uniformly distributed in [0, @p bound[.*/
+    qint64 bounded(qint64 bound){return static_cast<qint64>(uniform() * bound);}
+
+private:
+    quint32 state;
+};
+
+/**Paths of the generated files.*/
+struct Session{
+    QString datFile;
+    QString nsxFile;
+    QString cluFile;
+    QString evtFile;
+    QString whlFile;
+};
+
+qint64 nbSamples(const Options& options){
+    return static_cast<qint64>(options.duration * options.samplingRate);
+}
+
+bool writeAll(QFile& file,const QByteArray& buffer){
+    return file.write(buffer) == buffer.size();
+}
+
+/**Writes the 16 bits interleaved samples of the traces, a random walk per channel with some noise, as a .dat file or
+ * as the data packet of a .nsx file.*/
+bool writeSamples(QFile& file,const Options& options){
+    Random random(options.seed);
+    QVector<qint32> levels(options.nbChannels,0);
+    const int blockSize = 4096;
+    QVector<qint16> block(blockSize * options.nbChannels);
+    const qint64 total = nbSamples(options);
+    for(qint64 first = 0; first < total; first += blockSize){
+        const int nbRows = static_cast<int>(qMin(static_cast<qint64>(blockSize),total - first));
+        for(int i = 0; i < nbRows; ++i){
+            for(int channel = 0; channel < options.nbChannels; ++channel){
+                levels[channel] = qBound(-20000,levels[channel] + static_cast<qint32>(random.bounded(201)) - 100,20000);
+                block[i * options.nbChannels + channel] = static_cast<qint16>(levels[channel] + static_cast<qint32>(random.bounded(41)) - 20);
+            }
+        }
+        const qint64 size = static_cast<qint64>(nbRows) * options.nbChannels * sizeof(qint16);
+        if(file.write(reinterpret_cast<const char*>(block.constData()),size) != size)
+            return false;
+    }
+    return true;
+}
+
+bool writeDatFile(const QString& path,const Options& options){
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    return writeSamples(file,options);
+}
+
+/**The .nsx files give the sampling rate as a period of a 30 kHz clock.*/
+bool nsxSupported(const Options& options){
+    const double period = 30000.0 / options.samplingRate;
+    return period == floor(period);
+}
+
+/**Writes a Blackrock file with the same samples as the .dat file, in uV, and a single data packet.*/
+bool writeNsxFile(const QString& path,const Options& options){
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    NSXBasicHeader basicHeader;
+    memset(&basicHeader,0,sizeof(basicHeader));
+    memcpy(basicHeader.file_type,"NEURALCD",8);
+    basicHeader.file_spec = 0x0203;
+    basicHeader.header_size = sizeof(NSXBasicHeader) + options.nbChannels * sizeof(NSXExtensionHeader);
+    strncpy(basicHeader.label,"neuroscope-bench",sizeof(basicHeader.label));
+    basicHeader.sampling_period = static_cast<uint32_t>(qRound(30000.0 / options.samplingRate));
+    basicHeader.time_resolution = 30000;
+    basicHeader.channel_count = options.nbChannels;
+    if(file.write(reinterpret_cast<const char*>(&basicHeader),sizeof(basicHeader)) != sizeof(basicHeader))
+        return false;
+
+    for(int channel = 0; channel < options.nbChannels; ++channel){
+        NSXExtensionHeader header;
+        memset(&header,0,sizeof(header));
+        memcpy(header.type,"CC",2);
+        header.id = channel + 1;
+        snprintf(header.label,sizeof(header.label),"chan%d",channel + 1);
+        header.min_digital_value = -32767;
+        header.max_digital_value = 32767;
+        header.min_analog_value = -32767;
+        header.max_analog_value = 32767;
+        strncpy(header.unit,"uV",sizeof(header.unit));
+        if(file.write(reinterpret_cast<const char*>(&header),sizeof(header)) != sizeof(header))
+            return false;
+    }
+
+    NSXDataHeader dataHeader;
+    dataHeader.header = 0x01;
+    dataHeader.timestamp = 0;
+    dataHeader.length = static_cast<uint32_t>(nbSamples(options));
+    if(file.write(reinterpret_cast<const char*>(&dataHeader),sizeof(dataHeader)) != sizeof(dataHeader))
+        return false;
+    return writeSamples(file,options);
+}
+
+/**Writes the .res.1 and .clu.1 files of @p options.nbSpikes spikes spread uniformly over the recording.*/
+bool writeClusterFiles(const QString& cluPath,const QString& resPath,const Options& options){
+    Random random(options.seed + 1);
+    QVector<qint64> times(options.nbSpikes);
+    const qint64 total = nbSamples(options);
+    for(int i = 0; i < options.nbSpikes; ++i)
+        times[i] = random.bounded(total);
+    std::sort(times.begin(),times.end());
+
+    QFile resFile(resPath);
+    QFile cluFile(cluPath);
+    if(!resFile.open(QIODevice::WriteOnly | QIODevice::Truncate) || !cluFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    //The first line of the .clu file is the number of clusters, 0 and 1 being the artefact and noise clusters.
+    QByteArray res;
+    QByteArray clu = QByteArray::number(options.nbClusters + 2) + '\n';
+    for(int i = 0; i < options.nbSpikes; ++i){
+        res += QByteArray::number(times[i]) + '\n';
+        clu += QByteArray::number(random.bounded(options.nbClusters + 2)) + '\n';
+        if(res.size() > (1 << 20)){
+            if(!writeAll(resFile,res) || !writeAll(cluFile,clu))
+                return false;
+            res.clear();
+            clu.clear();
+        }
+    }
+    return writeAll(resFile,res) && writeAll(cluFile,clu);
+}
+
+/**Writes an .evt file of @p options.nbEvents events with a few different descriptions, the times being in miliseconds.*/
+bool writeEventFile(const QString& path,const Options& options){
+    static const char* const descriptions[] = {"stimulus on","stimulus off","reward","lick","ripple peak"};
+    Random random(options.seed + 2);
+    QVector<double> times(options.nbEvents);
+    for(int i = 0; i < options.nbEvents; ++i)
+        times[i] = random.uniform() * options.duration * 1000.0;
+    std::sort(times.begin(),times.end());
+
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    QByteArray events;
+    for(int i = 0; i < options.nbEvents; ++i)
+        events += QByteArray::number(times[i],'f',3) + '\t' + descriptions[random.bounded(5)] + '\n';
+    return writeAll(file,events);
+}
+
+/**Writes a .whl file of @p options.nbPositions positions of two lights wandering in a 368 x 240 field, the same
+ * format as a .pos file.*/
+bool writePositionFile(const QString& path,const Options& options){
+    Random random(options.seed + 3);
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    double x = 184.0;
+    double y = 120.0;
+    QByteArray positions;
+    for(int i = 0; i < options.nbPositions; ++i){
+        x = qBound(10.0,x + random.uniform() * 4.0 - 2.0,358.0);
+        y = qBound(10.0,y + random.uniform() * 4.0 - 2.0,230.0);
+        positions += QByteArray::number(x,'f',2) + ' ' + QByteArray::number(y,'f',2) + ' '
+                + QByteArray::number(x + 8.0,'f',2) + ' ' + QByteArray::number(y - 6.0,'f',2) + '\n';
+    }
+    return writeAll(file,positions);
+}
+
+/**Provider of the .dat file without overview: the views request windows at the resolution of the recording and the
+ * overview, built in a background thread, would make the measures depend on its progress.*/
+class BenchTracesProvider : public TracesProvider{
+public:
+    BenchTracesProvider(const QString& fileUrl,const Options& options)
+        : TracesProvider(fileUrl,options.nbChannels,16,20,1000,options.samplingRate,0){}
+
+protected:
+    virtual bool supportsPyramid() const{return false;}
+};
+
+/**A measured operation, run once to warm up, then once per repetition.*/
+class Benchmark{
+public:
+    Benchmark(const QString& name,const QString& variant):name(name),variant(variant){}
+    virtual ~Benchmark(){}
+
+    /**Prepares the repetition @p repetition, not measured.*/
+    virtual bool setUp(int repetition){Q_UNUSED(repetition); return true;}
+
+    /**Runs the repetition @p repetition.
+  * @return the number of items processed (samples, spikes, events, positions), -1 on error.
+  */
+    virtual qint64 run(int repetition) = 0;
+
+    /**Releases what setUp allocated, not measured.*/
+    virtual void tearDown(){}
+
+    QString name;
+    QString variant;
+};
+
+/**Requests random windows of the traces, the first one decoded, the following ones from the cache if @p cached.*/
+class TracesRequestBenchmark : public Benchmark{
+public:
+    TracesRequestBenchmark(const QString& name,TracesProvider& provider,const Options& options,bool cached)
+        : Benchmark(name,cached ? "request-cached" : "request-decode"),provider(provider),options(options),cached(cached),random(options.seed + 4){}
+
+    virtual bool setUp(int){
+        provider.setCacheSize(cached ? 256 : 0);
+        startTime = static_cast<long>(1 + random.bounded(qMax(Q_INT64_C(1),static_cast<qint64>(provider.recordingLength()) - options.window - 1)));
+        //A window given in recording units is not read ahead.
+        startInRecordingUnits = qMax(1L,provider.timeToRecordingUnits(startTime));
+        if(cached)
+            provider.requestData(startTime,startTime + options.window,0L,startInRecordingUnits);
+        return true;
+    }
+
+    virtual qint64 run(int){
+        provider.requestData(startTime,startTime + options.window,0L,startInRecordingUnits);
+        return static_cast<qint64>(provider.getNbSamples(startTime,startTime + options.window,startInRecordingUnits)) * provider.getNbChannels();
+    }
+
+private:
+    TracesProvider& provider;
+    const Options& options;
+    bool cached;
+    Random random;
+    long startTime;
+    long startInRecordingUnits;
+};
+
+/**Reads random windows of the traces synchronously, as the headless rendering does.*/
+class TracesGetDataBenchmark : public Benchmark{
+public:
+    TracesGetDataBenchmark(const QString& name,TracesProvider& provider,const Options& options)
+        : Benchmark(name,"getdata-decode"),provider(provider),options(options),random(options.seed + 5){}
+
+    virtual bool setUp(int){
+        provider.setCacheSize(0);
+        startTime = static_cast<long>(1 + random.bounded(qMax(Q_INT64_C(1),static_cast<qint64>(provider.recordingLength()) - options.window - 1)));
+        return true;
+    }
+
+    virtual qint64 run(int){
+        Array<dataType> data;
+        if(!provider.getData(startTime,startTime + options.window,0,QList<int>(),data))
+            return -1;
+        return static_cast<qint64>(data.nbOfRows()) * data.nbOfColumns();
+    }
+
+private:
+    TracesProvider& provider;
+    const Options& options;
+    Random random;
+    long startTime;
+};
+
+/**Loads the spikes, parsing the text files or, if @p cached, from the binary sidecar written by the previous load.*/
+class ClustersLoadBenchmark : public Benchmark{
+public:
+    ClustersLoadBenchmark(const Session& session,const Options& options,dataType fileMaxTime,bool cached)
+        : Benchmark("clusters",cached ? "load-cached" : "load-parse"),session(session),options(options),fileMaxTime(fileMaxTime),
+          cached(cached),provider(0L){}
+
+    virtual bool setUp(int){
+        if(!cached){
+            const QStringList sidecars = ClustersCache::sidecarNames(session.cluFile);
+            for(int i = 0; i < sidecars.size(); ++i)
+                QFile::remove(sidecars[i]);
+        }
+        provider = new ClustersProvider(session.cluFile,options.samplingRate,options.samplingRate,fileMaxTime);
+        return true;
+    }
+
+    virtual qint64 run(int){
+        return (provider->loadData() == ClustersProvider::OK) ? options.nbSpikes : -1;
+    }
+
+    virtual void tearDown(){
+        delete provider;
+        provider = 0L;
+    }
+
+private:
+    const Session& session;
+    const Options& options;
+    dataType fileMaxTime;
+    bool cached;
+    ClustersProvider* provider;
+};
+
+/**Requests @p options.nbRequests random windows of the spikes or of the events.
+ * @return the number of windows requested.*/
+template <class Provider>
+class WindowsRequestBenchmark : public Benchmark{
+public:
+    WindowsRequestBenchmark(const QString& name,Provider& provider,const Options& options,quint32 seed)
+        : Benchmark(name,"request"),provider(provider),options(options),random(seed){}
+
+    virtual bool setUp(int){
+        const qint64 length = static_cast<qint64>(options.duration) * 1000 - options.window;
+        startTimes.resize(options.nbRequests);
+        for(int i = 0; i < options.nbRequests; ++i)
+            startTimes[i] = static_cast<long>(random.bounded(qMax(Q_INT64_C(1),length)));
+        return true;
+    }
+
+    virtual qint64 run(int){
+        for(int i = 0; i < startTimes.size(); ++i)
+            provider.requestData(startTimes[i],startTimes[i] + options.window,0L,0);
+        return startTimes.size();
+    }
+
+private:
+    Provider& provider;
+    const Options& options;
+    Random random;
+    QVector<long> startTimes;
+};
+
+/**Looks up, from @p options.nbRequests random times, the next or previous spike of a single cluster among all the others.
+ * @return the number of spikes looked up.*/
+class ClustersBrowseBenchmark : public Benchmark{
+public:
+    ClustersBrowseBenchmark(ClustersProvider& provider,const Options& options,bool next)
+        : Benchmark("clusters",next ? "browse-next" : "browse-previous"),provider(provider),options(options),next(next),random(options.seed + 8){
+        selectedIds.append(2);
+    }
+
+    virtual bool setUp(int){
+        const qint64 length = static_cast<qint64>(options.duration) * 1000 - options.window;
+        startTimes.resize(options.nbRequests);
+        for(int i = 0; i < options.nbRequests; ++i)
+            startTimes[i] = static_cast<long>(random.bounded(qMax(Q_INT64_C(1),length)));
+        return true;
+    }
+
+    virtual qint64 run(int){
+        for(int i = 0; i < startTimes.size(); ++i){
+            if(next)
+                provider.requestNextClusterData(startTimes[i],options.window,selectedIds,0L,0);
+            else
+                provider.requestPreviousClusterData(startTimes[i],options.window,selectedIds,0L,0);
+        }
+        return startTimes.size();
+    }
+
+private:
+    ClustersProvider& provider;
+    const Options& options;
+    bool next;
+    Random random;
+    QList<int> selectedIds;
+    QVector<long> startTimes;
+};
+
+class EventsLoadBenchmark : public Benchmark{
+public:
+    EventsLoadBenchmark(const Session& session,const Options& options)
+        : Benchmark("events","load"),session(session),options(options),provider(0L){}
+
+    virtual bool setUp(int){
+        provider = new EventsProvider(session.evtFile,options.samplingRate);
+        return true;
+    }
+
+    virtual qint64 run(int){
+        return (provider->loadData() == EventsProvider::OK) ? options.nbEvents : -1;
+    }
+
+    virtual void tearDown(){
+        delete provider;
+        provider = 0L;
+    }
+
+private:
+    const Session& session;
+    const Options& options;
+    EventsProvider* provider;
+};
+
+/**Adds @p options.nbRequests events at random times, with an existing description.*/
+class EventsAddBenchmark : public Benchmark{
+public:
+    EventsAddBenchmark(EventsProvider& provider,const Options& options)
+        : Benchmark("events","add"),provider(provider),options(options),random(options.seed + 7){}
+
+    virtual qint64 run(int){
+        for(int i = 0; i < options.nbRequests; ++i)
+            provider.addEvent("reward",random.uniform() * options.duration * 1000.0);
+        return options.nbRequests;
+    }
+
+private:
+    EventsProvider& provider;
+    const Options& options;
+    Random random;
+};
+
+class PositionsLoadBenchmark : public Benchmark{
+public:
+    PositionsLoadBenchmark(const Session& session,const Options& options)
+        : Benchmark("positions","load"),session(session),options(options),provider(0L){}
+
+    virtual bool setUp(int){
+        provider = new PositionsProvider(session.whlFile,39.0625,368,240,0,0);
+        return true;
+    }
+
+    virtual qint64 run(int){
+        return (provider->loadData() == PositionsProvider::OK) ? options.nbPositions : -1;
+    }
+
+    virtual void tearDown(){
+        delete provider;
+        provider = 0L;
+    }
+
+private:
+    const Session& session;
+    const Options& options;
+    PositionsProvider* provider;
+};
+
+/**Reduces a window of the traces to the pixel columns as TraceView::decimateColumns does when drawing it, for all the channels.*/
+class DecimationBenchmark : public Benchmark{
+public:
+    DecimationBenchmark(TracesProvider& provider,const Options& options,TracesDecimation::Mode mode)
+        : Benchmark("decimation",TracesDecimation::modeName(mode)),provider(provider),options(options),mode(mode){}
+
+    virtual bool setUp(int repetition){
+        if(repetition > 0)
+            return true;
+        provider.setCacheSize(0);
+        if(!provider.getData(1,1 + options.window,0,QList<int>(),data))
+            return false;
+        extrema.resize(2 * options.nbColumns);
+        return true;
+    }
+
+    virtual qint64 run(int){
+        const int nbSamples = static_cast<int>(data.nbOfRows());
+        const float downSampling = static_cast<float>(nbSamples) / static_cast<float>(options.nbColumns);
+        for(int column = 1; column <= data.nbOfColumns(); ++column){
+            if(mode == TracesDecimation::LTTB)
+                largestTriangles(column,nbSamples,downSampling);
+            else
+                columns(column,nbSamples,downSampling);
+        }
+        return static_cast<qint64>(data.nbOfRows()) * data.nbOfColumns();
+    }
+
+private:
+    void columns(int column,int nbSamples,float downSampling){
+        long min;
+        long max;
+        for(int i = 1; i <= options.nbColumns; ++i){
+            const int start = static_cast<int>(floor((i-1) * downSampling + 0.5 + 1));
+            int stop = static_cast<int>(floor(i * downSampling + 0.5));
+            if(i > 1)
+                stop = qMin(stop,nbSamples);
+
+            switch(mode){
+            case TracesDecimation::STRIDE:
+                min = max = data(start,column);
+                break;
+            case TracesDecimation::RMS_BAND:
+                TracesDecimation::band(&data(start,column),data.nbOfColumns(),qMax(1,stop - start + 1),min,max);
+                break;
+            default:
+                TracesDecimation::extrema(&data(start,column),data.nbOfColumns(),stop - start + 1,min,max);
+            }
+
+            if(i > 1 && !TracesDecimation::isPointMode(mode)){
+                if(min > extrema[2 * (i - 2) + 1]) min = extrema[2 * (i - 2) + 1];
+                if(max < extrema[2 * (i - 2)]) max = extrema[2 * (i - 2)];
+            }
+            extrema[2 * (i - 1)] = min;
+            extrema[2 * (i - 1) + 1] = max;
+        }
+    }
+
+    void largestTriangles(int column,int nbSamples,float downSampling){
+        QVector<qint64> starts(options.nbColumns + 2);
+        for(int i = 1; i <= options.nbColumns + 1; ++i)
+            starts[i - 1] = static_cast<qint64>(floor((i-1) * downSampling + 0.5));
+        starts[options.nbColumns + 1] = starts[options.nbColumns];
+        for(int k = 1; k < starts.size(); ++k){
+            starts[k] = qMin(starts[k],static_cast<qint64>(nbSamples));
+            starts[k] = qMax(starts[k],starts[k - 1] + (k < starts.size() - 1 ? 1 : 0));
+        }
+        QVector<dataType> selected(options.nbColumns);
+        TracesDecimation::largestTriangles(&data(1,column),data.nbOfColumns(),starts.constData(),selected.size(),0.0,0.0,false,selected.data());
+        for(int i = 0; i < options.nbColumns; ++i)
+            extrema[2 * i] = extrema[2 * i + 1] = selected[i];
+    }
+
+    TracesProvider& provider;
+    const Options& options;
+    TracesDecimation::Mode mode;
+    Array<dataType> data;
+    QVector<long> extrema;
+};
+
+/**Runs @p benchmark and writes its line of results.
+ * @return false if the benchmark failed.
+ */
+bool measure(Benchmark& benchmark,const Options& options,FILE* output){
+    const QString fullName = benchmark.name + "/" + benchmark.variant;
+    if(!options.filter.isEmpty() && !fullName.contains(options.filter))
+        return true;
+
+    QVector<qint64> times;
+    qint64 nbItems = 0;
+    for(int repetition = -1; repetition < options.nbRepetitions; ++repetition){
+        if(!benchmark.setUp(qMax(0,repetition))){
+            fprintf(stderr,"%s: the set up failed\n",qPrintable(fullName));
+            return false;
+        }
+        QElapsedTimer timer;
+        timer.start();
+        nbItems = benchmark.run(qMax(0,repetition));
+        const qint64 elapsed = timer.nsecsElapsed();
+        benchmark.tearDown();
+        if(nbItems < 0){
+            fprintf(stderr,"%s: the run failed\n",qPrintable(fullName));
+            return false;
+        }
+        //The first run warms up the caches of the system and is not kept.
+        if(repetition >= 0)
+            times.append(elapsed);
+    }
+
+    std::sort(times.begin(),times.end());
+    const qint64 median = times[times.size() / 2];
+    fprintf(output,"%s,%s,%s,%d,%lld,%.3f,%.3f,%.3f,%.3f\n",qPrintable(benchmark.name),qPrintable(benchmark.variant),
+            TracesConversion::instructionSetName(TracesConversion::instructionSet()),options.nbRepetitions,static_cast<long long>(nbItems),
+            median / 1e6,times.first() / 1e6,times.last() / 1e6,(median > 0) ? nbItems * 1e3 / median : 0.0);
+    fflush(output);
+    return true;
+}
+
+void usage(const char* program){
+    fprintf(stderr,"usage: %s [options]\n"
+            "  --channels N      number of channels (64)\n"
+            "  --rate HZ         sampling rate, the .nsx file is only measured if it divides 30000 (20000)\n"
+            "  --duration S      length of the recording in seconds (60)\n"
+            "  --spikes N        number of spikes of the .res/.clu files (1000000)\n"
+            "  --clusters N      number of clusters (40)\n"
+            "  --events N        number of events of the .evt file (100000)\n"
+            "  --positions N     number of positions of the .whl file (100000)\n"
+            "  --window MS       length of the requested windows (1000)\n"
+            "  --columns N       number of pixel columns of the decimation (1920)\n"
+            "  --requests N      windows requested per repetition of the spike and event benchmarks (100)\n"
+            "  --repetitions N   number of measured repetitions (10)\n"
+            "  --seed N          seed of the generated files and windows (1)\n"
+            "  --filter TEXT     only run the benchmarks whose name contains TEXT, as clusters/load\n"
+            "  --directory DIR   directory of the generated files, kept, a temporary one otherwise\n"
+            "  --output FILE     file receiving the CSV results, the standard output otherwise\n",program);
+}
+
+bool parseOptions(const QStringList& arguments,Options& options){
+    for(int i = 1; i < arguments.size(); ++i){
+        const QString& option = arguments[i];
+        if(i + 1 >= arguments.size())
+            return false;
+        const QString value = arguments[++i];
+        bool ok = true;
+        if(option == "--channels") options.nbChannels = value.toInt(&ok);
+        else if(option == "--rate") options.samplingRate = value.toDouble(&ok);
+        else if(option == "--duration") options.duration = value.toInt(&ok);
+        else if(option == "--spikes") options.nbSpikes = value.toInt(&ok);
+        else if(option == "--clusters") options.nbClusters = value.toInt(&ok);
+        else if(option == "--events") options.nbEvents = value.toInt(&ok);
+        else if(option == "--positions") options.nbPositions = value.toInt(&ok);
+        else if(option == "--window") options.window = value.toLong(&ok);
+        else if(option == "--columns") options.nbColumns = value.toInt(&ok);
+        else if(option == "--requests") options.nbRequests = value.toInt(&ok);
+        else if(option == "--repetitions") options.nbRepetitions = value.toInt(&ok);
+        else if(option == "--seed") options.seed = value.toUInt(&ok);
+        else if(option == "--filter") options.filter = value;
+        else if(option == "--directory") options.directory = value;
+        else if(option == "--output") options.output = value;
+        else return false;
+        if(!ok)
+            return false;
+    }
+
+    return options.nbChannels > 0 && options.samplingRate > 0 && options.duration > 0 &&
+            options.nbSpikes > 0 && options.nbClusters > 0 && options.nbEvents > 0 && options.nbPositions > 0 &&
+            options.window > 0 && options.window < options.duration * 1000L - 2 && options.nbColumns > 0 &&
+            options.window * options.samplingRate / 1000.0 >= options.nbColumns && options.nbRequests > 0 && options.nbRepetitions > 0;
+}
+
+}
+
+int main(int argc,char** argv){
+    QCoreApplication application(argc,argv);
+    Options options;
+    if(!parseOptions(application.arguments(),options)){
+        usage(argv[0]);
+        return 1;
+    }
+
+    const bool temporary = options.directory.isEmpty();
+    if(temporary)
+        options.directory = QDir::tempPath() + "/neuroscope-bench-" + QString::number(QCoreApplication::applicationPid());
+    QDir directory(options.directory);
+    if(!directory.exists() && !directory.mkpath(".")){
+        fprintf(stderr,"cannot create the directory %s\n",qPrintable(options.directory));
+        return 1;
+    }
+
+    Session session;
+    session.datFile = directory.filePath("bench.dat");
+    session.nsxFile = directory.filePath("bench.ns5");
+    session.cluFile = directory.filePath("bench.clu.1");
+    session.evtFile = directory.filePath("bench.bch.evt");
+    session.whlFile = directory.filePath("bench.whl");
+    const QString resFile = directory.filePath("bench.res.1");
+
+    fprintf(stderr,"generating %d channels x %d s at %g Hz, %d spikes, %d events, %d positions in %s\n",options.nbChannels,options.duration,
+            options.samplingRate,options.nbSpikes,options.nbEvents,options.nbPositions,qPrintable(options.directory));
+    const bool nsx = nsxSupported(options);
+    if(!nsx)
+        fprintf(stderr,"%g Hz is not a divisor of 30 kHz, the .nsx file is not measured\n",options.samplingRate);
+    if(!writeDatFile(session.datFile,options) || (nsx && !writeNsxFile(session.nsxFile,options)) ||
+            !writeClusterFiles(session.cluFile,resFile,options) || !writeEventFile(session.evtFile,options) ||
+            !writePositionFile(session.whlFile,options)){
+        fprintf(stderr,"cannot write the files in %s\n",qPrintable(options.directory));
+        return 1;
+    }
+
+    FILE* output = stdout;
+    if(!options.output.isEmpty()){
+        output = fopen(QFile::encodeName(options.output).constData(),"w");
+        if(output == 0L){
+            fprintf(stderr,"cannot open %s\n",qPrintable(options.output));
+            return 1;
+        }
+    }
+    fprintf(output,"benchmark,variant,instruction_set,repetitions,items,median_ms,min_ms,max_ms,mitems_per_s\n");
+
+    bool succeeded = true;
+    {
+        BenchTracesProvider tracesProvider(session.datFile,options);
+        TracesRequestBenchmark datDecode("traces",tracesProvider,options,false);
+        TracesRequestBenchmark datCached("traces",tracesProvider,options,true);
+        TracesGetDataBenchmark datGetData("traces",tracesProvider,options);
+        succeeded &= measure(datDecode,options,output);
+        succeeded &= measure(datCached,options,output);
+        succeeded &= measure(datGetData,options,output);
+
+        if(nsx){
+            NSXTracesProvider nsxTracesProvider(session.nsxFile);
+            if(nsxTracesProvider.init()){
+                TracesRequestBenchmark nsxDecode("nsx",nsxTracesProvider,options,false);
+                TracesRequestBenchmark nsxCached("nsx",nsxTracesProvider,options,true);
+                succeeded &= measure(nsxDecode,options,output);
+                succeeded &= measure(nsxCached,options,output);
+            }
+            else{
+                fprintf(stderr,"cannot read %s\n",qPrintable(session.nsxFile));
+                succeeded = false;
+            }
+        }
+
+        const TracesDecimation::Mode modes[] = {TracesDecimation::MIN_MAX,TracesDecimation::LTTB,TracesDecimation::RMS_BAND,TracesDecimation::STRIDE};
+        for(int i = 0; i < 4; ++i){
+            DecimationBenchmark decimation(tracesProvider,options,modes[i]);
+            succeeded &= measure(decimation,options,output);
+        }
+
+        const dataType fileMaxTime = tracesProvider.getTotalNbSamples();
+        ClustersLoadBenchmark clustersParse(session,options,fileMaxTime,false);
+        ClustersLoadBenchmark clustersCached(session,options,fileMaxTime,true);
+        succeeded &= measure(clustersParse,options,output);
+        succeeded &= measure(clustersCached,options,output);
+        ClustersProvider clustersProvider(session.cluFile,options.samplingRate,options.samplingRate,fileMaxTime);
+        if(clustersProvider.loadData() == ClustersProvider::OK){
+            WindowsRequestBenchmark<ClustersProvider> clustersRequest("clusters",clustersProvider,options,options.seed + 6);
+            succeeded &= measure(clustersRequest,options,output);
+            ClustersBrowseBenchmark clustersNext(clustersProvider,options,true);
+            ClustersBrowseBenchmark clustersPrevious(clustersProvider,options,false);
+            succeeded &= measure(clustersNext,options,output);
+            succeeded &= measure(clustersPrevious,options,output);
+        }
+        else
+            succeeded = false;
+
+        EventsLoadBenchmark eventsLoad(session,options);
+        succeeded &= measure(eventsLoad,options,output);
+        EventsProvider eventsProvider(session.evtFile,options.samplingRate);
+        if(eventsProvider.loadData() == EventsProvider::OK){
+            WindowsRequestBenchmark<EventsProvider> eventsRequest("events",eventsProvider,options,options.seed + 6);
+            succeeded &= measure(eventsRequest,options,output);
+            EventsAddBenchmark eventsAdd(eventsProvider,options);
+            succeeded &= measure(eventsAdd,options,output);
+        }
+        else
+            succeeded = false;
+
+        PositionsLoadBenchmark positionsLoad(session,options);
+        succeeded &= measure(positionsLoad,options,output);
+    }
+
+    if(output != stdout)
+        fclose(output);
+    if(temporary){
+        QFile::remove(session.datFile);
+        QFile::remove(session.nsxFile);
+        QFile::remove(session.cluFile);
+        const QStringList sidecars = ClustersCache::sidecarNames(session.cluFile);
+        for(int i = 0; i < sidecars.size(); ++i)
+            QFile::remove(sidecars[i]);
+        QFile::remove(resFile);
+        QFile::remove(session.evtFile);
+        QFile::remove(session.whlFile);
+        directory.rmdir(options.directory);
+    }
+    return succeeded ? 0 : 1;
+}
@@ -251,9 +251,10 @@ protected:
 
     /**
   * Enumeration indicating in wich drawing contents mode the widget is:
-  * reuse of the double buffer or redraw the contents into the double buffer
+  * reuse of the double buffer, redraw the contents into the double buffer
+  * or scroll the contents already drawn (only the time frame has moved, see TraceView)
   */
-    enum DrawContentsMode{REFRESH=1, UPDATE=2,REDRAW=3};
+    enum DrawContentsMode{REFRESH=1, UPDATE=2,REDRAW=3,SCROLL=4};
 
     const int MIN_SIZE; //Default 500
     const int MAX_SIZE; //Default 4000
@@ -0,0 +1,317 @@
+/***************************************************************************
+                          batchrenderer.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+//include files for the application
+#include "batchrenderer.h"
+#include "tracesprovider.h"
+#include "tracerasterizer.h"
+#include "neuroscopexmlreader.h"
+#include "sessionInformation.h"
+#include "configuration.h"
+
+// include files for QT
+#include <QObject>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+#include <QStringList>
+#include <QRegExp>
+#include <QPainter>
+#include <QPolygon>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QDebug>
+
+/**Renders the snapshots of a BatchRenderer until none is left.*/
+class BatchRenderer::RenderWorker : public QRunnable {
+public:
+    explicit RenderWorker(BatchRenderer& renderer):renderer(renderer){}
+
+    void run(){
+        //Each thread has its own buffer for the traces.
+        TraceRasterizer rasterizer;
+        renderer.renderSnapshots(rasterizer);
+    }
+
+private:
+    BatchRenderer& renderer;
+};
+
+BatchRenderer::BatchRenderer():tracesProvider(0L),imageSize(1600,900),range(0),nbThreads(0),
+    nextSnapshot(0),nbFailures(0){
+    backgroundColor = configuration().getBackgroundColor();
+}
+
+BatchRenderer::~BatchRenderer(){
+    delete tracesProvider;
+}
+
+bool BatchRenderer::openDataFile(const QString& url,int nbChannels,double samplingRate,int resolution,int offset,int voltageRange,int amplification){
+    QFileInfo fileInfo(url);
+    if(!fileInfo.exists()){
+        error = QObject::tr("The file %1 does not exist.").arg(url);
+        return false;
+    }
+    baseName = fileInfo.completeBaseName();
+    const QString extension = fileInfo.suffix();
+
+    //The command line information, then the preferences, are used when there is no parameter file.
+    if(nbChannels == 0) nbChannels = configuration().getNbChannels();
+    if(resolution == 0) resolution = configuration().getResolution();
+    if(voltageRange == 0) voltageRange = configuration().getVoltageRange();
+    if(amplification == 0) amplification = configuration().getAmplification();
+    if(offset == 0) offset = configuration().getOffset();
+    double datSamplingRate = configuration().getDatSamplingRate();
+    double eegSamplingRate = configuration().getEegSamplingRate();
+    QMap<QString,double> extensionSamplingRates;
+
+    const QString parFileUrl = fileInfo.absolutePath() + QDir::separator() + baseName + QLatin1String(".xml");
+    if(QFileInfo(parFileUrl).exists()){
+        NeuroscopeXmlReader reader;
+        if(!reader.parseFile(parFileUrl,NeuroscopeXmlReader::PARAMETER)){
+            error = QObject::tr("The parameter file %1 could not be read.").arg(parFileUrl);
+            return false;
+        }
+        if(reader.getResolution() != 0) resolution = reader.getResolution();
+        if(reader.getNbChannels() != 0) nbChannels = reader.getNbChannels();
+        if(reader.getSamplingRate() != 0) datSamplingRate = reader.getSamplingRate();
+        if(reader.getLfpInformation() != 0) eegSamplingRate = reader.getLfpInformation();
+        if(reader.getVoltageRange() != 0) voltageRange = reader.getVoltageRange();
+        if(reader.getAmplification() != 0) amplification = reader.getAmplification();
+        if(reader.getOffset() != 0) offset = reader.getOffset();
+        extensionSamplingRates = reader.getSampleRateByExtension();
+
+        const QList<ChannelDescription> colorsList = reader.getChannelDescription();
+        QList<ChannelDescription>::const_iterator iterator;
+        for(iterator = colorsList.begin(); iterator != colorsList.end(); ++iterator)
+            if(!channelColors.contains((*iterator).getId())) channelColors.insert((*iterator).getId(),(*iterator).getColor());
+        reader.closeFile();
+
+        samplingRate = 0;
+    }
+
+    //Same rule as the document, except that the sampling rate of an unknown extension is not prompted.
+    if(samplingRate == 0){
+        if(extension == QLatin1String("eeg"))
+            samplingRate = eegSamplingRate;
+        else if(extension != QLatin1String("dat") && extensionSamplingRates.contains(extension))
+            samplingRate = extensionSamplingRates[extension];
+        else
+            samplingRate = datSamplingRate;
+    }
+
+    delete tracesProvider;
+    tracesProvider = new TracesProvider(fileInfo.absoluteFilePath(),nbChannels,resolution,voltageRange,amplification,samplingRate,offset);
+    tracesProvider->setCacheSize(configuration().getTraceCacheSize());
+    if(tracesProvider->recordingLength() <= 0){
+        error = QObject::tr("The file %1 does not contain any data.").arg(url);
+        return false;
+    }
+    return true;
+}
+
+bool BatchRenderer::loadSnapshots(const QString& url){
+    QFile file(url);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)){
+        error = QObject::tr("The snapshot list %1 could not be opened.").arg(url);
+        return false;
+    }
+
+    snapshots.clear();
+    QTextStream stream(&file);
+    int lineNumber = 0;
+    while(!stream.atEnd()){
+        const QString line = stream.readLine().trimmed();
+        ++lineNumber;
+        if(line.isEmpty() || line.startsWith(QLatin1Char('#')))
+            continue;
+
+        const QStringList fields = line.split(QRegExp(QLatin1String("\\s+")),QString::SkipEmptyParts);
+        Snapshot snapshot;
+        bool startOk = false;
+        bool durationOk = false;
+        if(fields.size() <= 3){
+            snapshot.startTime = fields.at(0).toLong(&startOk);
+            if(fields.size() > 1)
+                snapshot.duration = fields.at(1).toLong(&durationOk);
+        }
+        if(!startOk || !durationOk || snapshot.startTime < 0 || snapshot.duration <= 0 ||
+                (fields.size() == 3 && !parseChannels(fields.at(2),snapshot.channels))){
+            error = QObject::tr("Invalid snapshot at line %1 of %2.").arg(lineNumber).arg(url);
+            return false;
+        }
+        snapshots.append(snapshot);
+    }
+    return true;
+}
+
+bool BatchRenderer::parseChannels(const QString& text,QList<int>& channels) const{
+    const int nbChannels = tracesProvider != 0L ? tracesProvider->getNbChannels() : 0;
+    const QStringList items = text.split(QLatin1Char(','),QString::SkipEmptyParts);
+    QStringList::const_iterator iterator;
+    for(iterator = items.begin(); iterator != items.end(); ++iterator){
+        const QStringList bounds = (*iterator).split(QLatin1Char('-'));
+        bool firstOk = false;
+        bool lastOk = false;
+        const int first = bounds.at(0).toInt(&firstOk);
+        const int last = bounds.size() == 2 ? bounds.at(1).toInt(&lastOk) : first;
+        if(bounds.size() == 1) lastOk = firstOk;
+        if(!firstOk || !lastOk || bounds.size() > 2 || first < 0 || last < first || last >= nbChannels)
+            return false;
+        for(int channel = first; channel <= last; ++channel)
+            channels.append(channel);
+    }
+    return !channels.isEmpty();
+}
+
+int BatchRenderer::render(const QString& outputDirectory){
+    if(tracesProvider == 0L)
+        return snapshots.size();
+    if(!QDir().mkpath(outputDirectory)){
+        error = QObject::tr("The directory %1 could not be created.").arg(outputDirectory);
+        return snapshots.size();
+    }
+    this->outputDirectory = outputDirectory;
+    nextSnapshot.fetchAndStoreOrdered(0);
+    nbFailures.fetchAndStoreOrdered(0);
+
+    //The threads share the provider: a window decoded for one snapshot is reused by the others from the cache.
+    QThreadPool pool;
+    const int nbWorkers = qMax(1,qMin(nbThreads > 0 ? nbThreads : QThread::idealThreadCount(),snapshots.size()));
+    pool.setMaxThreadCount(nbWorkers);
+    for(int i = 0; i < nbWorkers; ++i)
+        pool.start(new RenderWorker(*this));
+    pool.waitForDone();
+
+    return nbFailures.fetchAndAddOrdered(0);
+}
+
+void BatchRenderer::renderSnapshots(TraceRasterizer& rasterizer){
+    //Enough digits for the names of the images to sort as the list.
+    const int nbDigits = QString::number(snapshots.size()).size();
+    QImage image;
+
+    forever{
+        const int index = nextSnapshot.fetchAndAddOrdered(1);
+        if(index >= snapshots.size())
+            return;
+        const Snapshot& snapshot = snapshots.at(index);
+        const QString fileName = outputDirectory + QDir::separator() +
+                QString::fromLatin1("%1-%2-%3ms.png").arg(baseName).arg(index + 1,nbDigits,10,QLatin1Char('0')).arg(snapshot.startTime);
+
+        if(!renderSnapshot(snapshot,rasterizer,image)){
+            qWarning() << "The traces of the snapshot" << index + 1 << "could not be read.";
+            nbFailures.fetchAndAddOrdered(1);
+        }
+        else if(!image.save(fileName,"PNG")){
+            qWarning() << "The image" << fileName << "could not be written.";
+            nbFailures.fetchAndAddOrdered(1);
+        }
+    }
+}
+
+bool BatchRenderer::renderSnapshot(const Snapshot& snapshot,TraceRasterizer& rasterizer,QImage& image){
+    const long endTime = qMin(static_cast<qlonglong>(snapshot.startTime + snapshot.duration),tracesProvider->recordingLength());
+    if(snapshot.startTime >= endTime)
+        return false;
+    Array<dataType> data;
+    if(!tracesProvider->getData(snapshot.startTime,endTime,0,snapshot.channels,data) || data.nbOfRows() == 0)
+        return false;
+
+    const int nbSamples = data.nbOfRows();
+    const int nbTraces = data.nbOfColumns();
+    const int width = imageSize.width();
+    const dataType* samples = &data[0];
+
+    if(image.size() != imageSize)
+        image = QImage(imageSize,QImage::Format_RGB32);
+    image.fill(backgroundColor.rgb());
+
+    //Each trace is centered in its band of the image, on the middle of its extent.
+    QVector<dataType> middles(nbTraces);
+    long amplitude = range;
+    for(int trace = 0; trace < nbTraces; ++trace){
+        dataType min = samples[trace];
+        dataType max = samples[trace];
+        for(int i = 1; i < nbSamples; ++i){
+            const dataType value = samples[i * nbTraces + trace];
+            if(value < min) min = value;
+            if(value > max) max = value;
+        }
+        middles[trace] = (min + max) / 2;
+        if(range <= 0) amplitude = qMax(amplitude,static_cast<long>(max - min));
+    }
+    if(amplitude <= 0) amplitude = 1;
+    const double traceHeight = static_cast<double>(imageSize.height()) / nbTraces;
+    const double factor = traceHeight / amplitude;
+
+    QColor defaultColor;
+    defaultColor.setHsv(210,255,255);
+
+    QPainter painter(&image);
+    for(int trace = 0; trace < nbTraces; ++trace){
+        const int channelId = snapshot.channels.isEmpty() ? trace : snapshot.channels.at(trace);
+        QPen pen(channelColors.value(channelId,defaultColor));
+        pen.setCosmetic(true);
+        painter.setPen(pen);
+
+        const double base = (trace + 0.5) * traceHeight;
+        const dataType middle = middles.at(trace);
+
+        if(nbSamples <= width){
+            QPolygon polyline(nbSamples);
+            for(int i = 0; i < nbSamples; ++i){
+                const int x = nbSamples > 1 ? static_cast<int>(static_cast<qint64>(i) * (width - 1) / (nbSamples - 1)) : 0;
+                polyline.setPoint(i,x,static_cast<int>(base - (samples[i * nbTraces + trace] - middle) * factor));
+            }
+            painter.drawPolyline(polyline);
+            continue;
+        }
+
+        //One vertical span per pixel column, joining the previous one, as in the trace view.
+        const bool rasterized = rasterizer.begin(painter);
+        dataType previousMin = 0;
+        dataType previousMax = 0;
+        for(int x = 0; x < width; ++x){
+            const int first = static_cast<int>(static_cast<qint64>(x) * nbSamples / width);
+            const int last = static_cast<int>(static_cast<qint64>(x + 1) * nbSamples / width);
+            dataType min = samples[first * nbTraces + trace];
+            dataType max = min;
+            for(int i = first + 1; i < last; ++i){
+                const dataType value = samples[i * nbTraces + trace];
+                if(value < min) min = value;
+                if(value > max) max = value;
+            }
+            if(x > 0){
+                if(min > previousMax) min = previousMax;
+                if(max < previousMin) max = previousMin;
+            }
+            previousMin = min;
+            previousMax = max;
+
+            const int yMin = static_cast<int>(base - (min - middle) * factor);
+            const int yMax = static_cast<int>(base - (max - middle) * factor);
+            if(rasterized) rasterizer.drawLine(x,yMin,x,yMax);
+            else painter.drawLine(x,yMin,x,yMax);
+        }
+        if(rasterized)
+            rasterizer.end();
+    }
+    painter.end();
+    return true;
+}
@@ -0,0 +1,120 @@
+/***************************************************************************
+                          batchrenderer.h  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+// include files for QT
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QColor>
+#include <QSize>
+#include <QImage>
+#include <QAtomicInt>
+
+class TracesProvider;
+class TraceRasterizer;
+
+/**
+  * Renders snapshots of the traces of a data file into PNG images, without any window.
+  *
+  * The snapshots are listed in a text file, one per line: the start time and the duration of the snapshot
+  * in miliseconds, optionally followed by the channels to draw (for instance 0-7,12), all of them otherwise.
+  * Empty lines and lines starting with # are ignored.
+  * The snapshots are rendered by several threads sharing the traces provider and its cache of decoded windows.
+  *@author the Neurosuite developers
+  */
+class BatchRenderer {
+public:
+    /**Time window and channels of an image.*/
+    struct Snapshot{
+        long startTime;
+        long duration;
+        QList<int> channels;
+    };
+
+    BatchRenderer();
+    ~BatchRenderer();
+
+    /**Opens the data file @p url. The properties of the recording are read from its parameter file if it exists,
+  * the other parameters, given on the command line, are used otherwise (0 to use the ones of the preferences).
+  * @return true if the file can be rendered, false otherwise, see errorString.
+  */
+    bool openDataFile(const QString& url,int nbChannels,double samplingRate,int resolution,int offset,int voltageRange,int amplification);
+
+    /**Reads the list of the snapshots to render from the file @p url, once the data file has been opened.
+  * @return true if the list could be read, false otherwise, see errorString.
+  */
+    bool loadSnapshots(const QString& url);
+
+    /**Sets the size of the images.*/
+    void setImageSize(const QSize& size){imageSize = size;}
+
+    /**Sets the amplitude, in uV, spanning the height given to each channel, 0 to fit the traces of each snapshot.*/
+    void setRange(long range){this->range = range;}
+
+    /**Sets the number of threads rendering the snapshots, 0 to use one per processor.*/
+    void setNbThreads(int nb){nbThreads = nb;}
+
+    /**Renders all the snapshots into the directory @p outputDirectory.
+  * @return the number of snapshots which could not be rendered.
+  */
+    int render(const QString& outputDirectory);
+
+    /**Returns the description of the last error.*/
+    QString errorString() const{return error;}
+
+private:
+    class RenderWorker;
+
+    /**Provider of the traces, shared by the rendering threads.*/
+    TracesProvider* tracesProvider;
+
+    QList<Snapshot> snapshots;
+
+    QSize imageSize;
+    long range;
+    int nbThreads;
+
+    /**Colors of the channels, read from the parameter file.*/
+    QMap<int,QColor> channelColors;
+
+    QColor backgroundColor;
+
+    /**Directory and base name of the images.*/
+    QString outputDirectory;
+    QString baseName;
+
+    /**Index of the next snapshot to render and number of snapshots which could not be rendered.*/
+    QAtomicInt nextSnapshot;
+    QAtomicInt nbFailures;
+
+    QString error;
+
+    /**Renders the next snapshots until none is left, called by each rendering thread.*/
+    void renderSnapshots(TraceRasterizer& rasterizer);
+
+    /**Renders the snapshot @p snapshot into @p image.
+  * @return true if the traces could be read, false otherwise.
+  */
+    bool renderSnapshot(const Snapshot& snapshot,TraceRasterizer& rasterizer,QImage& image);
+
+    /**Parses the list of channels @p text, given as ids and ranges of ids separated by commas.*/
+    bool parseChannels(const QString& text,QList<int>& channels) const;
+};
+
+#endif
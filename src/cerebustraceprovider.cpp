@@ -415,7 +415,7 @@ long CerebusTracesProvider::getNbSamples(long start, long end, long startInRecor
 }
 
 
-void CerebusTracesProvider::retrieveData(long start, long end, QObject* initiator, long startInRecordingUnits) {
+void CerebusTracesProvider::retrieveData(long start, long end, QObject* initiator, long startInRecordingUnits, const QList<int>&) {
 	Array<dataType> result;
 
 	// Abort if not initalized
@@ -137,6 +137,9 @@ public:
     /** Return the labels of each channel as read from cerebus config. */
     virtual QStringList getLabels();
 
+    /** The stream always delivers the latest samples, a time frame can not be retrieved in parts. */
+    virtual bool supportsPartialRetrieve() const { return false; }
+
     /** Called when paging is started.
      *  Recouples the buffer that is updated with the one that is
      *  viewed/returened.
@@ -167,6 +170,10 @@ public:
      */
     Array<dataType>* getEventData(long start, long end);
 
+    /** Live data can not be read ahead, the hint is ignored.
+     */
+    virtual void prefetchData(long, long, long = 0, const QList<int>& = QList<int>()) {}
+
 Q_SIGNALS:
     /**Signals that the data have been retrieved.
     * @param data array of data in uV (number of channels X number of samples).
@@ -240,12 +247,16 @@ private:
     * @param endTime end of the time frame from which to retrieve the data, given in milisecond.
     * @param initiator instance requesting the data.
     * @param startTimeInRecordingUnits begining of the time interval from which to retrieve the data in recording units.
+    * @param channels ignored, all the channels of the sampling group are always returned.
     */
-    virtual void retrieveData(long startTime, long endTime, QObject* initiator, long startTimeInRecordingUnits);
+    virtual void retrieveData(long startTime, long endTime, QObject* initiator, long startTimeInRecordingUnits, const QList<int>& channels);
 
     /**Computes the total length of the document in miliseconds.*/
     virtual void computeRecordingLength();
 
+    /** Live data have no overview. */
+    virtual bool supportsPyramid() const { return false; }
+
     /** Helper function that searches timestamps in buffer*/
     template <typename T>
     Array<dataType>* getTimeStampedData(UINT32* timeBuffer,
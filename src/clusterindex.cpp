@@ -0,0 +1,128 @@
+/***************************************************************************
+                          clusterindex.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+//include files for the application
+#include "clusterindex.h"
+
+// include c/c++ headers
+#include <algorithm>
+
+/**Compares the time of the spike at a position of the index with a time, to search the positions of a cluster.*/
+class TimeOrder{
+public:
+    explicit TimeOrder(const SpikeColumns& spikes):spikes(spikes){}
+    bool operator()(quint32 position,dataType time) const{return spikes.time(position) < time;}
+    bool operator()(dataType time,quint32 position) const{return time < spikes.time(position);}
+
+private:
+    const SpikeColumns& spikes;
+};
+
+ClusterIndex::ClusterIndex(){
+    offsets.append(0);
+}
+
+void ClusterIndex::clear(){
+    spikes.clear();
+    offsets.fill(0,1);
+    positions = QVector<quint32>();
+}
+
+void ClusterIndex::build(const SpikeColumns& spikeColumns){
+    clear();
+    spikes = spikeColumns;
+    const long nbSpikes = spikes.size();
+    offsets.fill(0,spikes.idList().size() + 1);
+    if(nbSpikes == 0)
+        return;
+
+    const quint16* ranks = spikes.rankColumn().constData();
+    long* offset = offsets.data();
+    for(long i = 0; i < nbSpikes; ++i)
+        ++offset[ranks[i] + 1];
+    for(int i = 1; i < offsets.size(); ++i)
+        offset[i] += offset[i - 1];
+
+    //Counting sort, which keeps the positions of each cluster in increasing time order.
+    positions.resize(static_cast<int>(nbSpikes));
+    QVector<long> next(offsets);
+    long* nextOffset = next.data();
+    quint32* position = positions.data();
+    for(long i = 0; i < nbSpikes; ++i)
+        position[nextOffset[ranks[i]]++] = static_cast<quint32>(i);
+}
+
+ClusterIndex::Merge::Merge(const ClusterIndex& index,const QList<int>& selectedIds,dataType time,bool forward):
+    spikes(index.spikes),positions(index.positions.constData()),forward(forward){
+    const TimeOrder order(spikes);
+    for(int i = 0; i < selectedIds.size(); ++i){
+        const int clusterRank = spikes.rankOf(selectedIds.at(i));
+        if(clusterRank < 0)
+            continue;
+        Cursor cursor;
+        cursor.begin = index.offsets.at(clusterRank);
+        cursor.end = index.offsets.at(clusterRank + 1);
+        if(forward)
+            cursor.position = std::lower_bound(positions + cursor.begin,positions + cursor.end,time,order) - positions;
+        else
+            cursor.position = (std::upper_bound(positions + cursor.begin,positions + cursor.end,time,order) - positions) - 1;
+        if(cursor.position < cursor.begin || cursor.position >= cursor.end)
+            continue;
+        cursor.time = spikes.time(positions[cursor.position]);
+        heap.append(cursor);
+        siftUp(heap.size() - 1);
+    }
+}
+
+void ClusterIndex::Merge::advance(){
+    Cursor& cursor = heap.first();
+    cursor.position += forward ? 1 : -1;
+    if(cursor.position < cursor.begin || cursor.position >= cursor.end){
+        cursor = heap.last();
+        heap.removeLast();
+    }
+    else
+        cursor.time = spikes.time(positions[cursor.position]);
+    if(!heap.isEmpty())
+        siftDown(0);
+}
+
+void ClusterIndex::Merge::siftUp(int i){
+    while(i > 0){
+        const int parent = (i - 1) / 2;
+        if(!after(heap.at(parent),heap.at(i)))
+            return;
+        qSwap(heap[parent],heap[i]);
+        i = parent;
+    }
+}
+
+void ClusterIndex::Merge::siftDown(int i){
+    const int size = heap.size();
+    forever{
+        int first = i;
+        const int left = 2 * i + 1;
+        const int right = left + 1;
+        if(left < size && after(heap.at(first),heap.at(left)))
+            first = left;
+        if(right < size && after(heap.at(first),heap.at(right)))
+            first = right;
+        if(first == i)
+            return;
+        qSwap(heap[i],heap[first]);
+        i = first;
+    }
+}
@@ -0,0 +1,92 @@
+/***************************************************************************
+                          clusterindex.h  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef CLUSTERINDEX_H
+#define CLUSTERINDEX_H
+
+//include files for the application
+#include <types.h>
+#include "spikecolumns.h"
+
+// include files for QT
+#include <QVector>
+#include <QList>
+
+/**
+  * Index of the spike times by cluster, used to browse the spikes of a few clusters among all the others.
+  *
+  * The positions of the spikes in the SpikeColumns are stored one cluster after the other, each cluster being a range,
+  * sorted by time, given by the offsets of the clusters (compressed sparse rows). A Merge walks through the spikes
+  * of several clusters in time order, forwards or backwards, with a heap holding the next spike of each cluster, so
+  * the spikes of the other clusters are never visited.
+  *@author the Neurosuite developers
+  */
+class ClusterIndex {
+public:
+    ClusterIndex();
+
+    /**Builds the index of @p spikes, which is kept (shared) by the index.*/
+    void build(const SpikeColumns& spikes);
+
+    /**Empties the index.*/
+    void clear();
+
+    /**Walk through the spikes of several clusters in time order.*/
+    class Merge {
+    public:
+        /**Starts at the first spike at or after @p time (@p forward true), or at the last spike at or before
+      * @p time (@p forward false), of the clusters @p selectedIds.
+      */
+        Merge(const ClusterIndex& index,const QList<int>& selectedIds,dataType time,bool forward);
+
+        /**Returns true once all the spikes have been walked through.*/
+        bool atEnd() const{return heap.isEmpty();}
+
+        /**Returns the time of the current spike.*/
+        dataType time() const{return heap.first().time;}
+
+        /**Moves to the following spike, or to the preceding one when walking backwards.*/
+        void advance();
+
+    private:
+        /**Current spike of a cluster, in the range [begin, end[ of the positions of the cluster.*/
+        struct Cursor{
+            dataType time;
+            long position;
+            long begin;
+            long end;
+        };
+
+        const SpikeColumns& spikes;
+        const quint32* positions;
+        bool forward;
+        /**Binary heap of the current spike of each cluster, the next one to walk through first.*/
+        QVector<Cursor> heap;
+
+        /**Returns true if the spike of @p a has to be walked through after the one of @p b.*/
+        bool after(const Cursor& a,const Cursor& b) const{return forward ? a.time > b.time : a.time < b.time;}
+        void siftUp(int i);
+        void siftDown(int i);
+    };
+
+private:
+    SpikeColumns spikes;
+    /**The cluster of rank i in the SpikeColumns owns the positions [offsets[i], offsets[i + 1][.*/
+    QVector<long> offsets;
+    QVector<quint32> positions;
+};
+
+#endif
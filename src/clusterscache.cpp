@@ -0,0 +1,154 @@
+/***************************************************************************
+                          clusterscache.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+//include files for the application
+#include "clusterscache.h"
+
+// include files for QT
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QVector>
+#include <QDebug>
+
+// include c/c++ headers
+#include <string.h>
+#include <limits>
+
+static const char CLUSTERS_MAGIC[8] = {'N','S','S','P','I','K','E','S'};
+static const qint32 CLUSTERS_VERSION = 2;
+
+QStringList ClustersCache::sidecarNames(const QString& cluFileName){
+    QFileInfo fileInfo(cluFileName);
+    QByteArray key = QCryptographicHash::hash(fileInfo.absoluteFilePath().toUtf8(),QCryptographicHash::Md5).toHex();
+    QStringList names;
+    names << fileInfo.absoluteDir().filePath(QString::fromLatin1(".%1.spikes").arg(fileInfo.fileName()));
+    names << QDir::temp().filePath(QString::fromLatin1("neuroscope-%1.spikes").arg(QString::fromLatin1(key)));
+    return names;
+}
+
+bool ClustersCache::identify(const QString& cluFileName,const QString& resFileName,Header& header){
+    QFileInfo cluInfo(cluFileName);
+    QFileInfo resInfo(resFileName);
+    if(!cluInfo.exists() || !resInfo.exists())
+        return false;
+
+    memset(&header,0,sizeof(Header));
+    memcpy(header.magic,CLUSTERS_MAGIC,sizeof(header.magic));
+    header.version = CLUSTERS_VERSION;
+    header.cluSize = cluInfo.size();
+    header.cluModified = cluInfo.lastModified().toMSecsSinceEpoch();
+    header.resSize = resInfo.size();
+    header.resModified = resInfo.lastModified().toMSecsSinceEpoch();
+    return true;
+}
+
+qint64 ClustersCache::fileSize(const Header& header){
+    return static_cast<qint64>(sizeof(Header)) + header.nbSpikes * static_cast<qint64>(sizeof(quint32) + sizeof(quint16)) +
+            2 * header.nbEpochs * static_cast<qint64>(sizeof(qint64)) + header.nbIds * static_cast<qint64>(sizeof(qint32));
+}
+
+bool ClustersCache::load(const QString& cluFileName,const QString& resFileName,SpikeColumns& spikes,int& nbClusters){
+    Header expected;
+    if(!identify(cluFileName,resFileName,expected))
+        return false;
+
+    const QStringList names = sidecarNames(cluFileName);
+    for(int i = 0; i < names.size(); ++i){
+        QFile sidecar(names[i]);
+        if(!sidecar.open(QIODevice::ReadOnly) || sidecar.size() < static_cast<qint64>(sizeof(Header)))
+            continue;
+        uchar* mapped = sidecar.map(0,sidecar.size());
+        if(mapped == 0L)
+            continue;
+
+        //The counts are the only fields which do not come from the text files.
+        Header header;
+        memcpy(&header,mapped,sizeof(Header));
+        expected.nbEpochs = header.nbEpochs;
+        expected.nbSpikes = header.nbSpikes;
+        expected.nbClusters = header.nbClusters;
+        expected.nbIds = header.nbIds;
+        if(memcmp(&header,&expected,sizeof(Header)) != 0 || header.nbSpikes <= 0 || header.nbEpochs < 0 || header.nbIds < 0 ||
+                header.nbSpikes > std::numeric_limits<int>::max() / static_cast<qint64>(sizeof(quint32)) || fileSize(header) != sidecar.size()){
+            sidecar.unmap(mapped);
+            continue;
+        }
+
+        const uchar* values = mapped + sizeof(Header);
+        QVector<quint32> lowTimes(static_cast<int>(header.nbSpikes));
+        memcpy(lowTimes.data(),values,lowTimes.size() * sizeof(quint32));
+        values += lowTimes.size() * sizeof(quint32);
+        QVector<quint16> ranks(static_cast<int>(header.nbSpikes));
+        memcpy(ranks.data(),values,ranks.size() * sizeof(quint16));
+        values += ranks.size() * sizeof(quint16);
+        QVector<qint64> epochStarts(header.nbEpochs);
+        memcpy(epochStarts.data(),values,epochStarts.size() * sizeof(qint64));
+        values += epochStarts.size() * sizeof(qint64);
+        QVector<qint64> epochBases(header.nbEpochs);
+        memcpy(epochBases.data(),values,epochBases.size() * sizeof(qint64));
+        values += epochBases.size() * sizeof(qint64);
+        QVector<int> ids(header.nbIds);
+        memcpy(ids.data(),values,ids.size() * sizeof(qint32));
+        sidecar.unmap(mapped);
+
+        if(!spikes.setColumns(lowTimes,ranks,epochStarts,epochBases,ids))
+            continue;
+        nbClusters = header.nbClusters;
+        return true;
+    }
+    return false;
+}
+
+void ClustersCache::save(const QString& cluFileName,const QString& resFileName,const SpikeColumns& spikes,int nbClusters){
+    Header header;
+    if(spikes.size() == 0 || !identify(cluFileName,resFileName,header))
+        return;
+    header.nbEpochs = spikes.epochStartList().size();
+    header.nbSpikes = spikes.size();
+    header.nbClusters = nbClusters;
+    header.nbIds = spikes.idList().size();
+
+    //The magic number is written last, a sidecar file left incomplete is never read.
+    Header incomplete = header;
+    memset(incomplete.magic,0,sizeof(incomplete.magic));
+    const qint64 lowTimesSize = header.nbSpikes * static_cast<qint64>(sizeof(quint32));
+    const qint64 ranksSize = header.nbSpikes * static_cast<qint64>(sizeof(quint16));
+    const qint64 epochsSize = header.nbEpochs * static_cast<qint64>(sizeof(qint64));
+    const qint64 idsSize = header.nbIds * static_cast<qint64>(sizeof(qint32));
+
+    const QStringList names = sidecarNames(cluFileName);
+    for(int i = 0; i < names.size(); ++i){
+        QFile sidecar(names[i]);
+        if(!sidecar.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            continue;
+        if(sidecar.write(reinterpret_cast<const char*>(&incomplete),sizeof(Header)) == sizeof(Header) &&
+                sidecar.write(reinterpret_cast<const char*>(spikes.lowTimeColumn().constData()),lowTimesSize) == lowTimesSize &&
+                sidecar.write(reinterpret_cast<const char*>(spikes.rankColumn().constData()),ranksSize) == ranksSize &&
+                sidecar.write(reinterpret_cast<const char*>(spikes.epochStartList().constData()),epochsSize) == epochsSize &&
+                sidecar.write(reinterpret_cast<const char*>(spikes.epochBaseList().constData()),epochsSize) == epochsSize &&
+                sidecar.write(reinterpret_cast<const char*>(spikes.idList().constData()),idsSize) == idsSize &&
+                sidecar.flush() && sidecar.seek(0) &&
+                sidecar.write(reinterpret_cast<const char*>(&header),sizeof(Header)) == sizeof(Header) && sidecar.flush())
+            return;
+
+        //The disk is probably full, do not leave a useless file behind.
+        qDebug()<<"the cache of "<<cluFileName<<" could not be written: "<<sidecar.errorString();
+        sidecar.remove();
+    }
+}
@@ -0,0 +1,81 @@
+/***************************************************************************
+                          clusterscache.h  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef CLUSTERSCACHE_H
+#define CLUSTERSCACHE_H
+
+//include files for the application
+#include <types.h>
+#include "spikecolumns.h"
+
+// include files for QT
+#include <QString>
+#include <QStringList>
+
+/**
+  * Binary copy of the spikes of a pair of .clu and .res files, written the first time the files are parsed
+  * and memory-mapped the next times they are opened, instead of parsing the text again.
+  *
+  * The sidecar file is stored next to the .clu file as a hidden file (or in the temporary directory if the
+  * directory is read only). It holds the columns of the SpikeColumns of the ClustersProvider: the low bits of the
+  * times, the ranks of the cluster ids, the epochs and the list of the cluster ids. It is ignored, and rewritten
+  * after the next parse, once the size or the modification time of either text file changes.
+  *@author the Neurosuite developers
+  */
+class ClustersCache {
+public:
+    /**Reads the spikes of @p cluFileName and @p resFileName from the sidecar file.
+  * @param cluFileName name of the .clu file.
+  * @param resFileName name of the .res file.
+  * @param spikes set to the spikes.
+  * @param nbClusters set to the number of clusters given on the first line of the .clu file.
+  * @return true if an up to date sidecar file has been read, false if the files have to be parsed.
+  */
+    static bool load(const QString& cluFileName,const QString& resFileName,SpikeColumns& spikes,int& nbClusters);
+
+    /**Writes the spikes parsed from @p cluFileName and @p resFileName in the sidecar file, the parameters being the
+  * ones filled by load. A failure is not an error, the files will be parsed again the next time.
+  */
+    static void save(const QString& cluFileName,const QString& resFileName,const SpikeColumns& spikes,int nbClusters);
+
+    /**Returns the possible names of the sidecar file of @p cluFileName, the preferred one first.*/
+    static QStringList sidecarNames(const QString& cluFileName);
+
+private:
+    /**Fixed size header at the beginning of the sidecar file.*/
+    struct Header{
+        char magic[8];
+        qint32 version;
+        qint32 nbEpochs;
+        qint64 nbSpikes;
+        qint32 nbClusters;
+        qint32 nbIds;
+        qint64 cluSize;
+        qint64 cluModified;
+        qint64 resSize;
+        qint64 resModified;
+    };
+
+    /**Fills the fields of @p header identifying the text files.
+  * @return false if one of the files does not exist.
+  */
+    static bool identify(const QString& cluFileName,const QString& resFileName,Header& header);
+
+    /**Returns the size of a sidecar file holding @p header.nbSpikes spikes, @p header.nbEpochs epochs and @p header.nbIds cluster ids.*/
+    static qint64 fileSize(const Header& header);
+};
+
+#endif
@@ -21,12 +21,14 @@
 
 #include <QList>
 #include <QMap> 
+#include <QVector>
 #include <QDebug>
 
 //include files for the application
 #include "clustersprovider.h"
+#include "clusterscache.h"
+#include "textparser.h"
 #include "timer.h"
-#include "utilities.h"
 
 
 ClustersProvider::ClustersProvider(const QString &fileUrl, double samplingRate, double currentSamplingRate, dataType fileMaxTime, int position)
@@ -61,133 +63,99 @@ int ClustersProvider::loadData(){
     //Fist check if the time file (.res) exists
     QString timeFilePath = timeFileUrl;
     if(!QFile(timeFileUrl).exists()){
-        clusters.setSize(0,0);
+        spikes.clear();
         return MISSING_FILE;
     }
 
-    //Get the number of spikes
-    nbSpikes = Utilities::getNbLines(timeFilePath);
+    RestartTimer();
 
-    qDebug()<<"nbSpikes "<<nbSpikes;
+    //The files have already been parsed if they have not changed since, read back the result.
+    if(ClustersCache::load(fileName,timeFilePath,spikes,nbClusters)){
+        nbSpikes = spikes.size();
+        clusterIds = spikes.clusterIdList();
+        qDebug() << "Loading clu file from its cache: "<<Timer() << endl;
+        indexSpikes();
+
+        //Initialize the variables
+        previousStartTime = 0;
+        double maxTime =  static_cast<double>(static_cast<double>(spikes.lastTime()) * static_cast<double>(1000) / static_cast<double>(samplingRate));
+        previousEndTime = static_cast<dataType>(floor(0.5 + maxTime));
+        fileMaxTime = previousEndTime;
 
-    if(nbSpikes == -1){
-        clusters.setSize(0,0);
-        return COUNT_ERROR;
+        return OK;
     }
 
+    //Parse the spike times, the spikes are counted in the same pass.
+    TextParser timeParser(TextParser::INTEGERS);
+    if(!timeParser.open(timeFilePath)){
+        spikes.clear();
+        return OPEN_ERROR;
+    }
+    nbSpikes = timeParser.nbLines();
+
+    qDebug()<<"nbSpikes "<<nbSpikes;
+
     //should not happen, but just in case
     if(nbSpikes == 0){
-        clusters.setSize(0,0);
+        spikes.clear();
+        indexSpikes();
 
         //Initialize the variables
         previousStartTime = 0;
-        previousStartIndex = 1;
-        previousEndIndex = 1;
         previousEndTime = 0;
         fileMaxTime = 0;
 
         return OK;
     }
 
-    RestartTimer();
-
-    //Create a reader on the clusterFile
-    QFile clusterFile(fileName);
-    bool status = clusterFile.open(QIODevice::ReadOnly);
-    if(!status){
-        clusters.setSize(0,0);
+    TextParser clusterParser(TextParser::INTEGERS);
+    if(!clusterParser.open(fileName)){
+        spikes.clear();
         return OPEN_ERROR;
     }
 
-    //Set the size of the Array containing the spikes and clusters ids.
-    clusters.setSize(2,nbSpikes);
-
-    //Get the number of clusters stored on the first line.
-    QString sNbClusters;
-    QByteArray buf;
-    buf.resize(255);
-    int ret=clusterFile.readLine(buf.data(), 255);
-    sNbClusters = QString::fromLatin1(buf, ret);
-
-
-    nbClusters = sNbClusters.toInt();
-    //This map is used as an easy way to compute the unique list of cluster ids
-    QMap<int,long> ids;
-    QByteArray buffer = clusterFile.readAll();
-    uint size = buffer.size();
-
-    //The buffer is read and each dataType is build char by char into a string. When the char read
-    //is not [1-9] (<=> blank space or a new line), the string is converted into a dataType and store
-    //into the first row of clusters.
-    //string of character which will contains the current seek dataType
-    dataType k = 0;
-    int l = 0;
-    char clusterID[255];
-    for(uint i = 0 ; i < size ; ++i){
-        if(buffer[i] >= '0' && buffer[i] <= '9')  {
-            clusterID[l++] = buffer[i];
-        } else if(l) {
-            clusterID[l] = '\0';
-            long id = atol(clusterID);
-            clusters[k++] = id;//Warning if the typedef dataType changes, change will have to be made here.
-            ids.insert(static_cast<int>(id),id);
-            l = 0;
-        }
-    }
-
-    clusterFile.close();
-    clusterIds = ids.keys();
-
-    //The number of spikes read has to be coherent with the number of spikes computed by wc -l (via Utilities::getNbLines).
-    if(k != nbSpikes){
-        clusters.setSize(0,0);
+    //The number of clusters is stored on the first line, followed by the cluster id of each spike.
+    //The number of spikes read has to be coherent with the number of lines of the .res file.
+    const int nbHeaderValues = clusterParser.nbValuesOnFirstLine();
+    if(clusterParser.nbValues() - nbHeaderValues != nbSpikes || timeParser.nbValues() != nbSpikes){
+        spikes.clear();
         return INCORRECT_CONTENT;
     }
 
-    //Get the spikes time
-
-    //Create a reader on the spikeFile
-    QFile spikeFile(timeFilePath);
-    status = spikeFile.open(QIODevice::ReadOnly);
-    if(!status){
-        clusters.setSize(0,0);
-        return OPEN_ERROR;
-    }
-
-
-    QByteArray spikeBuffer = spikeFile.readAll();
-    size = spikeBuffer.size();
-
-    //The buffer is read and each dataType is build char by char into a string. When the char read
-    //is not [1-9] (<=> blank space or a new line), the string is converted into a dataType and store
-    //into the second row of clusters.
-    //string of character which will contains the current seek dataType
-    l = 0;
-    char time[255];
-    for(uint i = 0 ; i < size ; ++i){
-        if(spikeBuffer[i] >= '0' && spikeBuffer[i] <= '9') time[l++] = spikeBuffer[i];
-        else if(l){
-            time[l] = '\0';
-            clusters[k++] = atol(time);//Warning if the typedef dataType changes, change will have to be made here.
-            l = 0;
+    dataType sNbClusters = 0;
+    clusterParser.read(0,qMin(nbHeaderValues,1),&sNbClusters);
+    nbClusters = static_cast<int>(sNbClusters);
+
+    //The spikes are parsed in batches, which are stored in the compact columns as they come.
+    const long batchSize = 4 * 1024 * 1024;
+    QVector<dataType> ids(static_cast<int>(qMin(nbSpikes,batchSize)));
+    QVector<dataType> times(ids.size());
+    spikes.reserve(nbSpikes);
+    for(long first = 0; first < nbSpikes; first += batchSize){
+        const long count = qMin(batchSize,nbSpikes - first);
+        clusterParser.read(nbHeaderValues + first,count,ids.data());
+        timeParser.read(first,count,times.data());
+        const dataType* batchIds = ids.constData();
+        const dataType* batchTimes = times.constData();
+        for(long i = 0; i < count; ++i){
+            if(!spikes.append(batchIds[i],batchTimes[i])){
+                spikes.clear();
+                return INCORRECT_CONTENT;
+            }
         }
     }
-
-    spikeFile.close();
-
-    //The number of spikes read has to be coherent with the number of spikes computed by wc -l (via Utilities::getNbLines).
-    if(k != (2 * nbSpikes)){
-        clusters.setSize(0,0);
-        return INCORRECT_CONTENT;
-    }
+    spikes.finish();
+    clusterIds = spikes.clusterIdList();
 
     qDebug() << "Loading clu file into memory: "<<Timer() << endl;
 
+    //Keep the result for the next time the files are opened.
+    ClustersCache::save(fileName,timeFilePath,spikes,nbClusters);
+    indexSpikes();
+
     //Initialize the variables
     previousStartTime = 0;
-    previousStartIndex = 1;
-    previousEndIndex = nbSpikes;
-    double maxTime =  static_cast<double>(static_cast<double>(clusters(2,nbSpikes)) * static_cast<double>(1000) / static_cast<double>(samplingRate));
+    double maxTime =  static_cast<double>(static_cast<double>(spikes.lastTime()) * static_cast<double>(1000) / static_cast<double>(samplingRate));
     previousEndTime = static_cast<dataType>(floor(0.5 + maxTime));
     fileMaxTime = previousEndTime;
 
@@ -201,12 +169,7 @@ void ClustersProvider::requestData(long startTime,long endTime,QObject* initiato
 void ClustersProvider::retrieveData(long startTime,long endTime,QObject* initiator,long startTimeInRecordingUnits){
     Array<dataType> data;
 
-    //qDebug()<<" in retrieveData, startTime " <<startTime<<" endTime " <<endTime<<" startTimeInRecordingUnits "<<startTimeInRecordingUnits;
-
-    //qDebug()<<" in retrieveData, fileMaxTime " <<fileMaxTime<<" samplingRate " <<samplingRate;
-
-
-    if(startTime > fileMaxTime){
+    if(startTime > fileMaxTime || nbSpikes == 0){
         //Send the information to the receiver.
         emit dataReady(data,initiator,name);
         return;
@@ -226,202 +189,59 @@ void ClustersProvider::retrieveData(long startTime,long endTime,QObject* initiat
     dataType endInRecordingUnits;
     //Hack to be sure not to forget a spike due to conversion rounding
     if(endTime == fileMaxTime)
-        endInRecordingUnits = clusters(2,nbSpikes);
+        endInRecordingUnits = spikes.lastTime();
     else
         endInRecordingUnits =  static_cast<dataType>(endTime * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
 
-    long startIndex;
-    long endIndex;
-    long dicotomyBreak = 1000;
-    long time;
-
-    //Look up for the closest starting index to the one corresponding to startTime
-    //Dicotomy will be used with a stop at dicotomyBreak.
-    if((startTime != previousStartTime) && (startTime != previousEndTime)){
-        if(startTime == 0){
-            startIndex = 1;
-            if(endTime <= previousStartTime) endIndex = previousStartIndex;
-            else if(endTime <= previousEndTime) endIndex = previousEndIndex;
-            else if(endTime > previousEndTime) endIndex = nbSpikes;
-        }
-        if(startTime < previousStartTime){
-            startIndex = static_cast<int>(previousStartIndex / 2);
-            if(startIndex <= 0)
-                startIndex = 1;
-
-            if(endTime <= previousStartTime)
-                endIndex = previousStartIndex;
-            else if(endTime <= previousEndTime)
-                endIndex = previousEndIndex;
-            else if(endTime > previousEndTime)
-                endIndex = nbSpikes;
-        }
-        else if(startTime < previousEndTime && startTime > previousStartTime){
-            startIndex = previousStartIndex + static_cast<int>((previousEndIndex - previousStartIndex + 1)/ 2);
-            if(endTime <= previousEndTime)
-                endIndex = previousEndIndex;
-            else if(endTime > previousEndTime)
-                endIndex = nbSpikes;
-        }
-        else if(startTime > previousEndTime){
-            startIndex = previousEndIndex;
-            endIndex = nbSpikes;
-        }
+    retrieveSpikes(startInRecordingUnits,endInRecordingUnits,data);
 
-        long newStartIndex = startIndex;
-        long newEndIndex = endIndex;
-        //dicotomy
-        while((newEndIndex - newStartIndex + 1) > dicotomyBreak){
-            time = clusters(2,newStartIndex);
-            if(time == startInRecordingUnits) break;
-            else if(time > startInRecordingUnits){
-                long previousStart = newStartIndex;
-                newStartIndex = previousStart - ((newEndIndex - previousStart + 1) / 2);
-                if(newStartIndex <= 0){
-                    newStartIndex = 1;
-                    break;
-                }
-                newEndIndex = previousStart;
-            }
-            else{
-                newStartIndex = newStartIndex + ((newEndIndex - newStartIndex + 1) / 2);
-                if(newStartIndex > nbSpikes){
-                    newStartIndex = nbSpikes;
-                    break;
-                }
-            }
-        }
-
-        //look up for the startIndex index by index
-        time = clusters(2,newStartIndex);
-
-        if(time < startInRecordingUnits && (newStartIndex < nbSpikes)){
-            while(time < startInRecordingUnits){
-                newStartIndex++;
-                if(newStartIndex > nbSpikes){
-                    newStartIndex = nbSpikes;
-                    time =  clusters(2,newStartIndex);
-                    break;
-                }
-                else{
-                    time =  clusters(2,newStartIndex);
-                }
-            }
-        }
-        else if(time > startInRecordingUnits && (newStartIndex > 1)){
-            while(time > startInRecordingUnits){
-                newStartIndex--;
-                if(newStartIndex <= 0){
-                    newStartIndex = 1;
-                    time =  clusters(2,newStartIndex);
-                    break;
-                }
-                else{
-                    time =  clusters(2,newStartIndex);
-                    if(time < startInRecordingUnits){
-                        newStartIndex++;
-                        time =  clusters(2,newStartIndex);
-                        break;
-                    }
-                }
-            }
-        }
-
-        startIndex = newStartIndex;
-    }//end (startTime != previousStartTime) || (startTime != previousEndTime)
-
-    else{
-        if(startTime == previousStartTime) startIndex = previousStartIndex;
-        else if(startTime == previousEndTime){
-            if(clusters(2,previousEndIndex) < startInRecordingUnits){
-                startIndex = previousEndIndex + 1;
-                if(startIndex > nbSpikes) startIndex = nbSpikes;
-            }
-            else startIndex = previousEndIndex;
-        }
-
-        if(endTime <= previousEndTime) endIndex = previousEndIndex;
-        else if(endTime > previousEndTime) endIndex = nbSpikes;
-    }
+    qDebug()<<" in retrieveData, count " <<data.nbOfColumns()<<" startInRecordingUnits " <<startInRecordingUnits<<" endInRecordingUnits " <<endInRecordingUnits<<" endTime " <<endTime<<endl;
 
     //Store the information for the next request
     previousStartTime = startTime;
-    previousStartIndex = startIndex;
-
-    //look up for the cluster ids and indexes.
-    //The exact size (<=> number of spikes is not known yet, so the size of data is set to the maximum possible)
-    data.setSize(2,(endIndex - startIndex + 1));//line 1 sample index,line 2 clusterId
-    time = clusters(2,startIndex);
-
-    long count = 0;
-    if(dataCurrentRatio != 1){
-        while(time <= endInRecordingUnits && startIndex <= nbSpikes){
-            double currentTime = static_cast<double>(time - startInRecordingUnits) / static_cast<double>(dataCurrentRatio);
-            data(1,count + 1) = static_cast<dataType>(floor(0.5 + currentTime));
-            data(2,count + 1) = clusters(1,startIndex);
-
-            //if(data(2,count + 1) ==9 || data(2,count + 1) == 8)qDebug()<<" in retrieveData, data(1,count + 1) " <<data(1,count + 1)<<" data(2,count + 1) " <<data(2,count + 1)<<endl;
-
-
-            count++;
-            startIndex++;
-            time = clusters(2,startIndex);
-        }
-    }
-    else{
-        while(time <= endInRecordingUnits && startIndex <= nbSpikes){
-            data(1,count + 1) = time - startInRecordingUnits;
-            data(2,count + 1) = clusters(1,startIndex);
-            count++;
-            startIndex++;
-            if(startIndex > nbSpikes) break;
-            time = clusters(2,startIndex);
-        }
-    }
-
-
-    qDebug()<<" in retrieveData, count " <<count<<" startInRecordingUnits " <<startInRecordingUnits<<" endInRecordingUnits " <<endInRecordingUnits<<" endTime " <<endTime<<endl;
-
-
-    //Store the data in a array of the good size
-    Array<dataType> finalData;
-    finalData.setSize(2,count);
-    finalData.copySubset(data,count);
-
-    //Store the information for the next request
     previousEndTime = endTime;
-    previousEndIndex = startIndex - 1;
 
     //Send the information to the receiver.
-    emit dataReady(finalData,initiator,name);
+    emit dataReady(data,initiator,name);
 }
 
-void ClustersProvider::requestNextClusterData(long startTime, long timeFrame, const QList<int> &selectedIds, QObject* initiator, long startTimeInRecordingUnits){
-    long initialStartTime = startTime;
-    //Compute the start time for the spike look up
-    startTime = initialStartTime + static_cast<long>(timeFrame * clusterPosition);
-
-    qDebug()<<"timeFrame " <<timeFrame<<" clusterPosition " <<clusterPosition<<" initialStartTime " <<initialStartTime<<" startTime " <<startTime<<" startTime " <<startTime<<" startTimeInRecordingUnits " <<startTimeInRecordingUnits;
+void ClustersProvider::retrieveSpikes(dataType startInRecordingUnits,dataType endInRecordingUnits,Array<dataType>& data){
+    if(nbSpikes == 0){
+        data.setSize(2,0);
+        return;
+    }
 
-    //first look up for the index corresponding to the startTime and then for the first valid spike (contained in selectedIds)
-    //after that time
-    Array<dataType> data;
+    //The times are sorted, the spikes of the time frame are found by binary search.
+    const long first = spikes.lowerBound(startInRecordingUnits);
+    const long end = qMax(spikes.upperBound(endInRecordingUnits),first);
 
-    if(startTime > fileMaxTime){
-        //Send the information to the receiver.
-        emit dataReady(data,initiator,name);
+    //line 1 sample index,line 2 clusterId
+    data.setSize(2,end - first);
+    if(end == first)
         return;
+    spikes.readTimes(first,end,&data(1,1));
+    spikes.readIds(first,end,&data(2,1));
+    dataType* times = &data(1,1);
+    if(dataCurrentRatio != 1){
+        for(long i = 0; i < end - first; ++i){
+            double currentTime = static_cast<double>(times[i] - startInRecordingUnits) / static_cast<double>(dataCurrentRatio);
+            times[i] = static_cast<dataType>(floor(0.5 + currentTime));
+        }
     }
+    else{
+        for(long i = 0; i < end - first; ++i)
+            times[i] -= startInRecordingUnits;
+    }
+}
 
-    long startIndex = previousStartIndex;
-    //By default we will go up to the end of the file
-    long endIndex = nbSpikes;
-    long dicotomyBreak = 1000;
-    long time;
-
+bool ClustersProvider::isBrowsedSpike(dataType time,dataType startInRecordingUnits,long timeFrame) const{
+    dataType previousTime = previousStartTime + static_cast<long>(timeFrame * clusterPosition);
+    double computeTime = static_cast<double>(static_cast<double>(time) * static_cast<double>(1000) / static_cast<double>(samplingRate));
+    dataType timeInMiliseconds = static_cast<dataType>(floor(0.5 + computeTime));
+    return (time == startInRecordingUnits) || (timeInMiliseconds == previousTime);
+}
 
-    //Convert the time in miliseconds to time in recording units (to compare it with the data from the file) if need it.
-    dataType startInRecordingUnits;
+dataType ClustersProvider::browsingStartTime(long startTime,long timeFrame,long startTimeInRecordingUnits) const{
     //startTimeInRecordingUnits has been computed in a previous call to a browsing function. It has to be used insted of computing
     //the value from startTime because of the rounding which has been applied to it.
     if(startTimeInRecordingUnits != 0){
@@ -431,220 +251,93 @@ void ClustersProvider::requestNextClusterData(long startTime, long timeFrame, co
         //startTimeInRecordingUnits is given in recording units computed with the current sampling rate, it has to be converted in
         //the recording units corresponding to the acquisiton system sampling rate (unit used in the cluster file).
         double start = static_cast<double>(startTimeInRecordingUnits) * static_cast<double>(dataCurrentRatio);
-        startInRecordingUnits = static_cast<dataType>(floor(0.5 + start)) + static_cast<long>(position);
+        return static_cast<dataType>(floor(0.5 + start)) + static_cast<long>(position);
     }
-    else startInRecordingUnits = static_cast<dataType>(startTime * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
-
-    //Look up for the closest starting index to the one corresponding to startTime
-    //Dicotomy will be used with a stop at dicotomyBreak.
-    if((startTime != previousStartTime) && (startTime != previousEndTime)){
-        if(startTime == 0){
-            startIndex = 1;
-        }
-        if(startTime < previousStartTime){
-            startIndex = static_cast<int>(previousStartIndex / 2);
-            if(startIndex <= 0) startIndex = 1;
-        }
-        else if(startTime < previousEndTime && startTime > previousStartTime){
-            startIndex = previousStartIndex + static_cast<int>((previousEndIndex - previousStartIndex + 1)/ 2);
-        }
-        else if(startTime > previousEndTime){
-            startIndex = previousEndIndex;
-        }
+    return static_cast<dataType>(startTime * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
+}
 
-        long newStartIndex = startIndex;
-        long newEndIndex = endIndex;
-        //dicotomy
-        while((newEndIndex - newStartIndex + 1) > dicotomyBreak){
-            time = clusters(2,newStartIndex);
-            if(time == startInRecordingUnits) break;
-            else if(time > startInRecordingUnits){
-                long previousStart = newStartIndex;
-                newStartIndex = previousStart - ((newEndIndex - previousStart + 1) / 2);
-                if(newStartIndex <= 0){
-                    newStartIndex = 1;
-                    break;
-                }
-                newEndIndex = previousStart;
-            }
-            else{
-                newStartIndex = newStartIndex + ((newEndIndex - newStartIndex + 1) / 2);
-                if(newStartIndex > nbSpikes){
-                    newStartIndex = nbSpikes;
-                    break;
-                }
-            }
-        }
+bool ClustersProvider::findBrowsingWindow(long startTime,long timeFrame,const QList<int>& selectedIds,long startTimeInRecordingUnits,bool forward,dataType& startingInRecordingUnits) const{
+    //Convert the time in miliseconds to time in recording units (to compare it with the data from the file) if need it.
+    long lookUpTime = startTime + static_cast<long>(timeFrame * clusterPosition);
+    dataType startInRecordingUnits = browsingStartTime(lookUpTime,timeFrame,startTimeInRecordingUnits);
+
+    //look up for the first spike of the selected clusters after (or the last one before) startInRecordingUnits, only the spikes of these
+    //clusters being visited. If it is the one already at clusterPosition, take the following (or previous) one.
+    ClusterIndex::Merge spikes(spikeIndex,selectedIds,startInRecordingUnits,forward);
+    if(!spikes.atEnd() && isBrowsedSpike(spikes.time(),startInRecordingUnits,timeFrame)){
+        const dataType browsedTime = spikes.time();
+        while(!spikes.atEnd() && spikes.time() == browsedTime)
+            spikes.advance();
+    }
+    if(spikes.atEnd())
+        return false;
 
+    //the found spike will be placed at clusterPosition*100 % of the timeFrame
+    dataType timeFrameInRecordingUnits = static_cast<dataType>(timeFrame * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
+    float position = static_cast<float>(timeFrameInRecordingUnits) * clusterPosition;
+    startingInRecordingUnits = qMax(spikes.time() - static_cast<long>(position),0L);
 
-        //look up for the startIndex index by index
-        time = clusters(2,newStartIndex);
+    //Always keep the same timeFrame
+    if(forward && startingInRecordingUnits + timeFrameInRecordingUnits > dataFileMaxTime)
+        startingInRecordingUnits = dataFileMaxTime - timeFrameInRecordingUnits;
+    return true;
+}
 
-        qDebug()<<"newStartIndex " <<newStartIndex<<" time " <<time<<" nbSpikes " <<nbSpikes <<endl;
+bool ClustersProvider::browsingTarget(long startTime,long timeFrame,const QList<int>& selectedIds,bool forward,long startTimeInRecordingUnits,
+                                      long& targetStartTime,long& targetStartTimeInRecordingUnits) const{
+    if(nbSpikes == 0 || selectedIds.isEmpty())
+        return false;
+    if(forward && startTime + static_cast<long>(timeFrame * clusterPosition) > fileMaxTime)
+        return false;
 
-        if(time < startInRecordingUnits && (newStartIndex < nbSpikes)){
-            while(time < startInRecordingUnits){
-                newStartIndex++;
-                if(newStartIndex > nbSpikes){
-                    newStartIndex = nbSpikes;
-                    time =clusters(2,newStartIndex);
-                    break;
-                }
-                else{
-                    time = clusters(2,newStartIndex);
-                }
-            }
-        }
-        else if(time > startInRecordingUnits && (newStartIndex > 1)){
-            while(time > startInRecordingUnits){
-                newStartIndex--;
-                if(newStartIndex <= 0){
-                    newStartIndex = 1;
-                    time =  clusters(2,newStartIndex);
-                    break;
-                }
-                else{
-                    time =  clusters(2,newStartIndex);
-                    if(time < startInRecordingUnits){
-                        newStartIndex++;
-                        time =  clusters(2,newStartIndex);
-                        break;
-                    }
-                }
-            }
-        }
+    dataType startingInRecordingUnits;
+    if(!findBrowsingWindow(startTime,timeFrame,selectedIds,startTimeInRecordingUnits,forward,startingInRecordingUnits))
+        return false;
 
-        startIndex = newStartIndex;
-    }//end (startTime != previousStartTime) || (startTime != previousEndTime)
+    //Same conversions as the ones done by requestNextClusterData and requestPreviousClusterData.
+    double computeStartingTime = static_cast<double>(static_cast<double>(startingInRecordingUnits) * static_cast<double>(1000) / static_cast<double>(samplingRate));
+    targetStartTime = static_cast<long>(floor(0.5 + computeStartingTime));
+    double startingInCurrentRecordingUnits = static_cast<double>(startingInRecordingUnits) / static_cast<double>(dataCurrentRatio);
+    targetStartTimeInRecordingUnits = static_cast<long>(floor(0.5 + startingInCurrentRecordingUnits));
+    return true;
+}
 
-    else{
-        if(startTime == previousStartTime) startIndex = previousStartIndex;
-        else if(startTime == previousEndTime){
-            if(clusters(2,previousEndIndex) < startTime){
-                startIndex = previousEndIndex + 1;
-                if(startIndex > nbSpikes) startIndex = nbSpikes;
-            }
-            else startIndex = previousEndIndex;
-        }
-    }
+void ClustersProvider::requestNextClusterData(long startTime, long timeFrame, const QList<int> &selectedIds, QObject* initiator, long startTimeInRecordingUnits){
+    long initialStartTime = startTime;
+    //Compute the start time for the spike look up
+    startTime = initialStartTime + static_cast<long>(timeFrame * clusterPosition);
 
+    qDebug()<<"timeFrame " <<timeFrame<<" clusterPosition " <<clusterPosition<<" initialStartTime " <<initialStartTime<<" startTime " <<startTime<<" startTime " <<startTime<<" startTimeInRecordingUnits " <<startTimeInRecordingUnits;
 
-    time = clusters(2,startIndex);
+    Array<dataType> data;
 
-    dataType previousTime = previousStartTime + static_cast<long>(timeFrame * clusterPosition);
-    double computeTime = static_cast<double>(static_cast<double>(time) * static_cast<double>(1000) / static_cast<double>(samplingRate));
-    dataType timeInMiliseconds = static_cast<dataType>(floor(0.5 + computeTime));
-    //check that the spike corresponding to the current startIndex
-    //is not the one already at clusterPosition, if so take the following start index.
-    if(((timeInMiliseconds == previousTime) || (time == startInRecordingUnits)) && (startIndex < nbSpikes))
-        startIndex++;
-
-    //look up for the first spike contained in selectedIds which exist after startTime
-    while(true){
-        int id = clusters(1,startIndex);
-        if(selectedIds.contains(id)) break;
-        startIndex++;
-        if(startIndex > nbSpikes){
-            startIndex = nbSpikes;
-            break;
-        }
+    if(startTime > fileMaxTime){
+        //Send the information to the receiver.
+        emit dataReady(data,initiator,name);
+        return;
     }
 
-    //check that a valid index has been found (the startIndex corresponds to a spike included in selectedIds)
-    //if that is not the case return startTime as the startingTime => no change will be done in the view, and startTimeInRecordingUnits
-    int id = clusters(1,startIndex);
-    if(!selectedIds.contains(id)){
-        Array<dataType> data;
+    //look up for the first spike of the selected clusters after startTime and compute the time interval showing it.
+    //if no spike has been found return startTime as the startingTime => no change will be done in the view, and startTimeInRecordingUnits
+    dataType startingInRecordingUnits;
+    if(!findBrowsingWindow(initialStartTime,timeFrame,selectedIds,startTimeInRecordingUnits,true,startingInRecordingUnits)){
         emit nextClusterDataReady(data,initiator,name,initialStartTime,startTimeInRecordingUnits);
         return;
     }
-
-    time = clusters(2,startIndex);
-
-    //the found spike will be placed at clusterPosition*100 % of the timeFrame
     dataType timeFrameInRecordingUnits = static_cast<dataType>(timeFrame * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
-
-    //compute the final starting time
-    float position = static_cast<float>(timeFrameInRecordingUnits) * clusterPosition;
-    dataType startingInRecordingUnits = qMax(time - static_cast<long>(position),0L);
-
-    //compute the final index corresponding to the final starting time
-    long newStartIndex = startIndex;
-    while(time > startingInRecordingUnits){
-        newStartIndex--;
-        if(newStartIndex <= 0){
-            newStartIndex = 1;
-            time =  clusters(2,newStartIndex);
-            break;
-        }
-        else{
-            time =  clusters(2,newStartIndex);
-            if(time < startingInRecordingUnits){
-                newStartIndex++;
-                time =  clusters(2,newStartIndex);
-                break;
-            }
-        }
-    }
-
-    startIndex = newStartIndex;
-
     dataType endInRecordingUnits = startingInRecordingUnits + timeFrameInRecordingUnits;
 
-    //Always keep the same timeFrame
-    if(endInRecordingUnits > dataFileMaxTime){
-        startingInRecordingUnits = dataFileMaxTime - timeFrameInRecordingUnits;
-        endInRecordingUnits = dataFileMaxTime;
-    }
-
     //Store the information for the next request
     double computeStartingTime = static_cast<double>(static_cast<double>(startingInRecordingUnits) * static_cast<double>(1000) / static_cast<double>(samplingRate));
     previousStartTime = static_cast<dataType>(floor(0.5 + computeStartingTime));
-    previousStartIndex = startIndex;
-
-    //look up for the spike ids and indexes.
-    //The exact size (<=> number of spikes is not known yet, so the size of data is set to the maximum possible)
-
-    data.setSize(2,(endIndex - startIndex + 1));//line 1 sample index,line 2 clusterId
-    time = clusters(2,startIndex);
-
-    long count = 0;
-    if(dataCurrentRatio != 1){
-        while(time <= endInRecordingUnits && startIndex <= nbSpikes){
-            double currentTime = static_cast<double>(time - startingInRecordingUnits) / static_cast<double>(dataCurrentRatio);
-            data(1,count + 1) = static_cast<dataType>(floor(0.5 + currentTime));
-            data(2,count + 1) = clusters(1,startIndex);
-
-            count++;
-            startIndex++;
-            if(startIndex > nbSpikes) break;
-            time = clusters(2,startIndex);
-        }
-    }
-    else{
-        while(time <= endInRecordingUnits && startIndex <= nbSpikes){
-            data(1,count + 1) = (time - startingInRecordingUnits);
-            data(2,count + 1) = clusters(1,startIndex);
-            count++;
-            startIndex++;
-            if(startIndex > nbSpikes) break;
-            time = clusters(2,startIndex);
-        }
-    }
-
 
-    qDebug()<<" count " <<count <<endl;
+    retrieveSpikes(startingInRecordingUnits,endInRecordingUnits,data);
 
-
-    //Store the data in a array of the good size
-    Array<dataType> finalData;
-    finalData.setSize(2,count);
-    finalData.copySubset(data,count);
+    qDebug()<<" count " <<data.nbOfColumns() <<endl;
 
     //Store the information for the next request
     double computeEndTime = static_cast<double>(static_cast<double>(endInRecordingUnits) * static_cast<double>(1000) / static_cast<double>(samplingRate));
     previousEndTime = static_cast<dataType>(computeEndTime) + 1;
-    previousEndIndex = startIndex - 1;
 
     //the data provider needs the startingInRecordingUnits computed with the current sampling rate and not the one use to record
     //the data (if the currently open file is a .dat file the sampling rates are equals)
@@ -652,238 +345,34 @@ void ClustersProvider::requestNextClusterData(long startTime, long timeFrame, co
     dataType startingInCurrentRecordingUnits2 = static_cast<dataType>(floor(0.5 + startingInCurrentRecordingUnits));
 
     //Send the information to the receiver.
-    emit nextClusterDataReady(finalData,initiator,name,previousStartTime,startingInCurrentRecordingUnits2);
+    emit nextClusterDataReady(data,initiator,name,previousStartTime,startingInCurrentRecordingUnits2);
 }
 
 
 void ClustersProvider::requestPreviousClusterData(long startTime,long timeFrame,QList<int> selectedIds,QObject* initiator,long startTimeInRecordingUnits){
 
     long initialStartTime = startTime;
-    //Compute the start time for the spike look up
-    startTime = initialStartTime + static_cast<long>(timeFrame * clusterPosition);
-
-    //first look up for the index corresponding to the startTime and then for the first valid spike (contained in selectedIds)
-    //before that time.
     Array<dataType> data;
 
-    long startIndex = previousStartIndex;
-    //By default we will go up to the end of the file
-    long endIndex = nbSpikes;
-    long dicotomyBreak = 1000;
-    long time;
-
-    //Convert the time in miliseconds to time in recording units (to compare it with the data from the file) if need it.
-    dataType startInRecordingUnits;
-    //startTimeInRecordingUnits has been computed in a previous call to a browsing function. It has to be used insted of computing
-    //the value from startTime because of the rounding which has been applied to it.
-    if(startTimeInRecordingUnits != 0){
-        //the found spike will be placed at clusterPosition*100 % of the timeFrame
-        dataType timeFrameInRecordingUnits = static_cast<dataType>(timeFrame * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
-        float position = static_cast<float>(timeFrameInRecordingUnits) * clusterPosition;
-
-        //startTimeInRecordingUnits is given in recording units computed with the current sampling rate, it has to be converted in
-        //the recording units corresponding to the acquisiton system sampling rate (unit used in the cluster file).
-        double start = static_cast<double>(startTimeInRecordingUnits) * static_cast<double>(dataCurrentRatio);
-        startInRecordingUnits = static_cast<dataType>(floor(0.5 + start)) + static_cast<long>(position);
-    }
-    else startInRecordingUnits = static_cast<dataType>(startTime * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
-
-    //Look up for the closest starting index to the one corresponding to startTime
-    //Dicotomy will be used with a stop at dicotomyBreak.
-    if((startTime != previousStartTime) && (startTime != previousEndTime)){
-        if(startTime == 0){
-            startIndex = 1;
-        }
-        if(startTime < previousStartTime){
-            startIndex = static_cast<int>(previousStartIndex / 2);
-            if(startIndex <= 0) startIndex = 1;
-        }
-        else if(startTime < previousEndTime && startTime > previousStartTime){
-            startIndex = previousStartIndex + static_cast<int>((previousEndIndex - previousStartIndex + 1)/ 2);
-        }
-        else if(startTime > previousEndTime){
-            startIndex = previousEndIndex;
-        }
-
-        long newStartIndex = startIndex;
-        long newEndIndex = endIndex;
-
-        //dicotomy
-        while((newEndIndex - newStartIndex + 1) > dicotomyBreak){
-            time = clusters(2,newStartIndex);
-            if(time == startInRecordingUnits) break;
-            else if(time > startInRecordingUnits){
-                long previousStart = newStartIndex;
-                newStartIndex = previousStart - ((newEndIndex - previousStart + 1) / 2);
-                if(newStartIndex <= 0){
-                    newStartIndex = 1;
-                    break;
-                }
-                newEndIndex = previousStart;
-            }
-            else{
-                newStartIndex = newStartIndex + ((newEndIndex - newStartIndex + 1) / 2);
-                if(newStartIndex > nbSpikes){
-                    newStartIndex = nbSpikes;
-                    break;
-                }
-            }
-        }
-
-
-        //look up for the startIndex index by index
-        time = clusters(2,newStartIndex);
-
-        if(time < startInRecordingUnits && (newStartIndex < nbSpikes)){
-            while(time < startInRecordingUnits){
-                newStartIndex++;
-                if(newStartIndex > nbSpikes){
-                    newStartIndex = nbSpikes;
-                    time = clusters(2,newStartIndex);
-                    break;
-                }
-                else{
-                    time = clusters(2,newStartIndex);
-                    if(time > startInRecordingUnits){
-                        newStartIndex--;
-                        time =  clusters(2,newStartIndex);
-                        break;
-                    }
-                }
-            }
-        }
-        else if(time > startInRecordingUnits && (newStartIndex > 1)){
-            while(time > startInRecordingUnits){
-                newStartIndex--;
-                if(newStartIndex <= 0){
-                    newStartIndex = 1;
-                    time =  clusters(2,newStartIndex);
-                    break;
-                }
-                else{
-                    time =  clusters(2,newStartIndex);
-                    if(time < startInRecordingUnits) break;
-                }
-            }
-        }
-
-        startIndex = newStartIndex;
-    }//end (startTime != previousStartTime) || (startTime != previousEndTime)
-
-    else{
-        if(startTime == previousStartTime) startIndex = previousStartIndex;
-        else if(startTime == previousEndTime){
-            if(clusters(2,previousEndIndex) < startTime){
-                startIndex = previousEndIndex + 1;
-                if(startIndex > nbSpikes) startIndex = nbSpikes;
-            }
-            else startIndex = previousEndIndex;
-        }
-    }
-
-
-    //check that the spike corresponding to the startIndex
-    //is not the one already at clusterPosition, if so take the previous index
-    time = clusters(2,startIndex);
-
-    dataType previousTime = previousStartTime + static_cast<long>(timeFrame * clusterPosition);
-    double computeTime = static_cast<double>(static_cast<double>(time) * static_cast<double>(1000) / static_cast<double>(samplingRate));
-    dataType timeInMiliseconds = static_cast<dataType>(floor(0.5 + computeTime));
-    if((time == startInRecordingUnits || timeInMiliseconds == previousTime) && (startIndex > 1)) startIndex--;
-
-    //now, look up for the first spike contained in selectedIds which exist before endTime
-    while(true){
-        int id = clusters(1,startIndex);
-        if(selectedIds.contains(id)) break;
-        startIndex--;
-        if(startIndex <= 0){
-            startIndex = 1;
-            break;
-        }
-    }
-
-    //check that a valid index has been found: the startIndex corresponds to n spike included in selectedIds
-    //and the corresponding time in before the startTime
-    //if that is not the case return initialStartTime as the startingTime => no change will be done in the view, and startTimeInRecordingUnits
-    int id = clusters(1,startIndex);
-    time = clusters(2,startIndex);
-    if(!selectedIds.contains(id) || time > startInRecordingUnits){
-        Array<dataType> data;
+    //look up for the last spike of the selected clusters before startTime and compute the time interval showing it.
+    //if no spike has been found return initialStartTime as the startingTime => no change will be done in the view, and startTimeInRecordingUnits
+    dataType startingInRecordingUnits;
+    if(!findBrowsingWindow(initialStartTime,timeFrame,selectedIds,startTimeInRecordingUnits,false,startingInRecordingUnits)){
         emit previousClusterDataReady(data,initiator,name,initialStartTime,startTimeInRecordingUnits);
         return;
     }
-
-    //the found spike will be placed at clusterPosition*100 % of the timeFrame
     dataType timeFrameInRecordingUnits = static_cast<dataType>(timeFrame * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
-    //compute the final starting time and the corresponding index
-    float position = static_cast<float>(timeFrameInRecordingUnits) * clusterPosition;
-    dataType startingInRecordingUnits = qMax(time - static_cast<long>(position),0L);
-
-    //compute the final index corresponding to the final starting time
-    long newStartIndex = startIndex;
-    while(time > startingInRecordingUnits){
-        newStartIndex--;
-        if(newStartIndex <= 0){
-            newStartIndex = 1;
-            time =  clusters(2,newStartIndex);
-            break;
-        }
-        else{
-            time =  clusters(2,newStartIndex);
-            if(time < startingInRecordingUnits){
-                newStartIndex++;
-                time =  clusters(2,newStartIndex);
-                break;
-            }
-        }
-    }
-
-    startIndex = newStartIndex;
+    dataType endInRecordingUnits = startingInRecordingUnits + timeFrameInRecordingUnits;
 
     //Store the information for the next request
     double computeStartingTime = static_cast<double>(static_cast<double>(startingInRecordingUnits) * static_cast<double>(1000) / static_cast<double>(samplingRate));
     previousStartTime = static_cast<dataType>(floor(0.5 + computeStartingTime));
-    previousStartIndex = startIndex;
 
-    //look up for the cluster ids and indexes.
-    //The exact size (<=> number of spikes is not known yet, so the size of data is set to the maximum possible)
-    data.setSize(2,(endIndex - startIndex + 1));//line 1 sample index,line 2 clusterId
-    time = clusters(2,startIndex);
-    dataType endInRecordingUnits = startingInRecordingUnits + timeFrameInRecordingUnits;
-
-    long count = 0;
-    if(dataCurrentRatio != 1){
-        while(time <= endInRecordingUnits && startIndex <= nbSpikes){
-            double currentTime = static_cast<double>(time - startingInRecordingUnits) / static_cast<double>(dataCurrentRatio);
-            data(1,count + 1) = static_cast<dataType>(floor(0.5 + currentTime));
-            data(2,count + 1) = clusters(1,startIndex);
-            count++;
-            startIndex++;
-            if(startIndex > nbSpikes) break;
-            time = clusters(2,startIndex);
-        }
-    }
-    else{
-        while(time <= endInRecordingUnits && startIndex <= nbSpikes){
-            data(1,count + 1) = (time - startingInRecordingUnits);
-            data(2,count + 1) = clusters(1,startIndex);
-
-            count++;
-            startIndex++;
-            if(startIndex > nbSpikes) break;
-            time = clusters(2,startIndex);
-        }
-    }
-
-    //Store the data in a array of the good size
-    Array<dataType> finalData;
-    finalData.setSize(2,count);
-    finalData.copySubset(data,count);
+    retrieveSpikes(startingInRecordingUnits,endInRecordingUnits,data);
 
     //Store the information for the next request
     double computeEndTime = static_cast<double>(static_cast<double>(endInRecordingUnits) * static_cast<double>(1000) / static_cast<double>(samplingRate));
     previousEndTime = static_cast<dataType>(computeEndTime) + 1;
-    previousEndIndex = startIndex - 1;
 
     //the data provider needs the startingInRecordingUnits computed with the current sampling rate and not the one use to record
     //the data (if the currently open file is a .dat file the sampling rates are equals)
@@ -892,5 +381,13 @@ void ClustersProvider::requestPreviousClusterData(long startTime,long timeFrame,
 
 
     //Send the information to the receiver.
-    emit previousClusterDataReady(finalData,initiator,name,previousStartTime,startingInCurrentRecordingUnits2);
+    emit previousClusterDataReady(data,initiator,name,previousStartTime,startingInCurrentRecordingUnits2);
+}
+
+void ClustersProvider::indexSpikes(){
+    if(nbSpikes == 0){
+        spikeIndex.clear();
+        return;
+    }
+    spikeIndex.build(spikes);
 }
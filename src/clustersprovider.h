@@ -22,6 +22,8 @@
 #include <dataprovider.h>
 #include <array.h>
 #include <types.h>
+#include "spikecolumns.h"
+#include "clusterindex.h"
 
 // include files for QT
 #include <QObject>
@@ -84,6 +86,20 @@ public:
   */
     virtual void requestPreviousClusterData(long startTime,long timeFrame,QList<int> selectedIds,QObject* initiator,long startTimeInRecordingUnits);
 
+    /**Computes the time interval which requestNextClusterData (@p forward true) or requestPreviousClusterData would retrieve,
+  * without retrieving anything. Used to read ahead the traces of the following jump.
+  * @param startTime starting time, in miliseconds, for the look up.
+  * @param timeFrame time interval for which the data would be retrieved.
+  * @param selectedIds list of cluster ids to look up for.
+  * @param forward true to look up for the next spike, false for the previous one.
+  * @param startTimeInRecordingUnits starting time, in recording units, for the look up.
+  * @param targetStartTime set to the start time, in miliseconds, of the time interval.
+  * @param targetStartTimeInRecordingUnits set to the start time, in recording units, of the time interval.
+  * @return false if no spike has been found.
+  */
+    bool browsingTarget(long startTime,long timeFrame,const QList<int>& selectedIds,bool forward,long startTimeInRecordingUnits,
+                        long& targetStartTime,long& targetStartTimeInRecordingUnits) const;
+
     /**Loads the cluster ids and the corresponding spike time.
   * @return an loadReturnMessage enum giving the load status
   */
@@ -111,9 +127,7 @@ public:
 
         //Initialize the variables
         previousStartTime = 0;
-        previousStartIndex = 1;
-        previousEndIndex = nbSpikes;
-        double maxTime =  static_cast<double>(static_cast<double>(clusters(2,nbSpikes)) * static_cast<double>(1000) / static_cast<double>(samplingRate));
+        double maxTime =  static_cast<double>(static_cast<double>(spikes.lastTime()) * static_cast<double>(1000) / static_cast<double>(samplingRate));
         previousEndTime = static_cast<dataType>(floor(0.5 + maxTime));
         fileMaxTime = previousEndTime;
     }
@@ -128,9 +142,7 @@ public:
 
         //Initialize the variables
         previousStartTime = 0;
-        previousStartIndex = 1;
-        previousEndIndex = nbSpikes;
-        double maxTime =  static_cast<double>(static_cast<double>(clusters(2,nbSpikes)) * static_cast<double>(1000) / static_cast<double>(samplingRate));
+        double maxTime =  static_cast<double>(static_cast<double>(spikes.lastTime()) * static_cast<double>(1000) / static_cast<double>(samplingRate));
         previousEndTime = static_cast<dataType>(floor(0.5 + maxTime));
         fileMaxTime = previousEndTime;
     }
@@ -175,8 +187,8 @@ protected:
     /**Sampling rate used to record the data.*/
     double samplingRate;
 
-    /**A 2 line array containing the cluster ids and the spikes time.*/
-    Array<dataType> clusters;
+    /**The time and the cluster id of each spike.*/
+    SpikeColumns spikes;
 
     /**The start time for the previously requested data.*/
     long previousStartTime;
@@ -184,12 +196,6 @@ protected:
     /**The end time for the previously requested data.*/
     long previousEndTime;
 
-    /**The start index for the previously requested data.*/
-    long previousStartIndex;
-
-    /**The end index for the previously requested data.*/
-    long previousEndIndex;
-
     /**Number of spikes.*/
     long nbSpikes;
 
@@ -202,6 +208,9 @@ protected:
     /**List of the cluster ids.*/
     QList<int> clusterIds;
 
+    /**Times of the spikes by cluster, to browse the spikes of the selected clusters.*/
+    ClusterIndex spikeIndex;
+
     /**The maximum time, in miliseconds, contained in the file.*/
     long fileMaxTime;
 
@@ -221,6 +230,26 @@ protected:
   */
     void retrieveData(long startTime,long endTime,QObject* initiator,long startTimeInRecordingUnits);
 
+    /**Fills @p data with the spikes included in the time frame given by @p startInRecordingUnits and @p endInRecordingUnits,
+  * as sent by dataReady, the times being relative to @p startInRecordingUnits.
+  */
+    void retrieveSpikes(dataType startInRecordingUnits,dataType endInRecordingUnits,Array<dataType>& data);
+
+    /**Builds the index of the spike times by cluster, once the spikes are known.*/
+    void indexSpikes();
+
+private:
+    /**Returns the time, in recording units, from which the next or previous spike is looked up by the browsing functions.*/
+    dataType browsingStartTime(long startTime,long timeFrame,long startTimeInRecordingUnits) const;
+
+    /**Returns true if the spike at @p time is the one already shown at clusterPosition, after a browsing from @p startInRecordingUnits.*/
+    bool isBrowsedSpike(dataType time,dataType startInRecordingUnits,long timeFrame) const;
+
+    /**Looks up for the spike following (@p forward true) or preceding the one at clusterPosition of the time interval starting at @p startTime
+  * and sets @p startingInRecordingUnits to the start, in recording units, of the time interval showing it at clusterPosition.
+  * @return false if no spike has been found.
+  */
+    bool findBrowsingWindow(long startTime,long timeFrame,const QList<int>& selectedIds,long startTimeInRecordingUnits,bool forward,dataType& startingInRecordingUnits) const;
 };
 
 
@@ -43,6 +43,8 @@ const int  Configuration::rotationDefault = 0;
 const int  Configuration::flipDefault = 0;
 const bool Configuration::drawPositionsOnBackgroundDefault = false;
 const QString  Configuration::traceBackgroundImageDefault = "";
+const int  Configuration::traceCacheSizeDefault = 256;
+const bool Configuration::traceRasterizerDefault = false;
 
 Configuration::Configuration(){
     read(); // read the settings or set them to the default values
@@ -76,6 +78,8 @@ void Configuration::read() {
     drawPositionsOnBackground = settings.value("drawPositionsOnBackground",drawPositionsOnBackgroundDefault).toBool();
     traceBackgroundImage = settings.value("traceBackgroundImage",traceBackgroundImageDefault).toString();
     useWhiteColorDuringPrinting = settings.value("useWhiteColorDuringPrinting",true).toBool();
+    traceCacheSize = settings.value("traceCacheSize",traceCacheSizeDefault).toInt();
+    traceRasterizer = settings.value("traceRasterizer",traceRasterizerDefault).toBool();
     settings.endGroup();
 }
 
@@ -106,6 +110,8 @@ void Configuration::write() const {
     settings.setValue("drawPositionsOnBackground",drawPositionsOnBackground);
     settings.setValue("traceBackgroundImage",traceBackgroundImage);
     settings.setValue("useWhiteColorDuringPrinting",useWhiteColorDuringPrinting);
+    settings.setValue("traceCacheSize",traceCacheSize);
+    settings.setValue("traceRasterizer",traceRasterizer);
     settings.endGroup();
 }
 
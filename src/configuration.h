@@ -115,6 +115,12 @@ public:
     
     /**Sets the background image for the trace view.*/
     void setTraceBackgroundImage(const QString &image){traceBackgroundImage = image;}
+
+    /**Sets the memory budget, in megabytes, of the cache of decoded traces shared by the displays of a document.*/
+    void setTraceCacheSize(int size){traceCacheSize = size;}
+
+    /**Sets whether the traces are drawn with the fast rasterizer instead of the painter.*/
+    void setTraceRasterizer(bool rasterizer){traceRasterizer = rasterizer;}
     
     /**Returns the screen gain in milivolts by centimeters used to display the field potentiels.
     */
@@ -175,6 +181,12 @@ public:
     /**Returns the background image for the TraceView.*/
     QString getTraceBackgroundImage()const{return traceBackgroundImage;}
 
+    /**Returns the memory budget, in megabytes, of the cache of decoded traces shared by the displays of a document.*/
+    int getTraceCacheSize()const{return traceCacheSize;}
+
+    /**Returns true if the traces are drawn with the fast rasterizer, false if they are drawn with the painter.*/
+    bool getTraceRasterizer()const{return traceRasterizer;}
+
     /**Returns the event position, in percentage from the begining of the window, where the events are display when browsing.*/
     int getEventPosition()const{return eventPosition;}
     
@@ -291,6 +303,12 @@ public:
     */
     bool getPositionsBackgroundDefault()const{return drawPositionsOnBackgroundDefault;}
 
+    /**Returns the default memory budget, in megabytes, of the cache of decoded traces.*/
+    int getTraceCacheSizeDefault()const{return traceCacheSizeDefault;}
+
+    /**Returns the default use of the fast rasterizer to draw the traces.*/
+    bool getTraceRasterizerDefault()const{return traceRasterizerDefault;}
+
     bool getUseWhiteColorDuringPrinting() const { return useWhiteColorDuringPrinting; }
 
     void setUseWhiteColorDuringPrinting(bool b) { useWhiteColorDuringPrinting = b; }
@@ -340,6 +358,10 @@ private:
     bool drawPositionsOnBackground;
     /**Background image for the trace view*/
     QString traceBackgroundImage;
+    /**Memory budget, in megabytes, of the cache of decoded traces.*/
+    int traceCacheSize;
+    /**Boolean indicating if the traces are drawn with the fast rasterizer.*/
+    bool traceRasterizer;
 
     bool useWhiteColorDuringPrinting;
     static const float  screenGainDefault;
@@ -364,6 +386,8 @@ private:
     static const int  flipDefault;
     static const bool drawPositionsOnBackgroundDefault;
     static const QString traceBackgroundImageDefault;
+    static const int traceCacheSizeDefault;
+    static const bool traceRasterizerDefault;
 
     Configuration();
     ~Configuration(){}
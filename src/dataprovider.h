@@ -47,6 +47,11 @@ public:
   */
     virtual void requestData(long startTime,long endTime,QObject* initiator,long startTimeInRecordingUnits=0){}
 
+    /**Loads the data of the file, the return value being specific to each type of provider.
+  * The function does not interact with the GUI, it may be called on any thread (see ProviderLoader).
+  */
+    virtual int loadData(){return 0;}
+
     /**Enables the caller to know if there is any thread running launch by the provider.*/
     virtual inline bool isThreadsRunning(){return false;}
 
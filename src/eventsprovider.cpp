@@ -17,7 +17,7 @@
 //QT include files
 #include <QStringList>
 #include <QFileInfo> 
-#include <QRegExp>
+#include <QVector>
 
 #include <QTextStream>
 #include <QList>
@@ -25,8 +25,8 @@
 
 //include files for the application
 #include "eventsprovider.h"
+#include "textparser.h"
 #include "timer.h"
-#include "utilities.h"
 
 
 EventsProvider::EventsProvider(const QString &fileUrl, double currentSamplingRate, int position): DataProvider(fileUrl),nbEvents(0),
@@ -54,65 +54,36 @@ EventsProvider::~EventsProvider(){
 int EventsProvider::loadData(){
     RestartTimer();
 
-    //Get the number of events
-    nbEvents = Utilities::getNbLines(fileName);
-
-    //qDebug()<<"nbEvents "<<nbEvents<<endl;
-
-    if(nbEvents == -1){
+    //Parse the events, they are counted in the same pass.
+    TextParser parser(TextParser::TIMED_LABELS);
+    if(!parser.open(fileName)){
         events.setSize(0,0);
         timeStamps.setSize(0,0);
-        return COUNT_ERROR;
+        return OPEN_ERROR;
     }
+    nbEvents = parser.nbLines();
+
+    //qDebug()<<"nbEvents "<<nbEvents<<endl;
 
     if(nbEvents == 0){
         initializeEmptyProvider();
         return OK;
     }
 
-    //Create a reader on the eventFile
-    QFile eventFile(fileName);
-    bool status = eventFile.open(QIODevice::ReadOnly);
-    if(!status){
-        events.setSize(0,0);
-        timeStamps.setSize(0,0);
-        return OPEN_ERROR;
-    }
-
     //Set the size of the Arrays containing the time and ids of the events.
     events.setSize(1,nbEvents);
     timeStamps.setSize(1,nbEvents);
 
-    QTextStream fileStream(&eventFile);
-    QString line;
-    int lineCounter = 0;
-    for(line = fileStream.readLine(); !line.isNull() && lineCounter< nbEvents;line = fileStream.readLine()){
-        line = line.trimmed();
-
-        int index1 = line.indexOf(QRegExp("\\s"));
-        int index2 = line.indexOf(QRegExp("\\S"),index1);
-
-        timeStamps[lineCounter] = line.left(index1).toDouble();
-        EventDescription label = line.right(line.length() - index2);
-        events[lineCounter] = label;
-        if(eventDescriptionCounter.contains(label)){
-            eventDescriptionCounter.insert(label,eventDescriptionCounter[label] + 1);
-        }
-        else eventDescriptionCounter.insert(label,1);
-        lineCounter ++;
+    QVector<QString> labels(nbEvents);
+    parser.readTimedLabels(&timeStamps[0],labels.data());
+    for(int i = 0; i < nbEvents; ++i){
+        const EventDescription label = labels[i];
+        events[i] = label;
+        eventDescriptionCounter[label] += 1;
     }
 
-    eventFile.close();
     qDebug()<< "Loading evt file into memory: "<<Timer() << endl;
 
-
-    //The number of events read has to be coherent with the number of events read.
-    if(lineCounter != nbEvents){
-        events.setSize(0,0);
-        timeStamps.setSize(0,0);
-        return INCORRECT_CONTENT;
-    }
-
     updateMappingAndDescriptionLength();
 
     //Initialize the variables
@@ -546,6 +517,38 @@ void EventsProvider::requestNextEventData(long startTime,long timeFrame,const QL
     emit nextEventDataReady(finalTimes,finalIds,initiator,name,startingTime);
 }
 
+long EventsProvider::browsingTarget(long startTime,long timeFrame,const QList<int>& selectedIds,bool forward){
+    if(nbEvents == 0 || selectedIds.isEmpty())
+        return -1;
+
+    //The current event is located at eventPosition percentage of the time interval.
+    const long eventTime = startTime + static_cast<long>(timeFrame * eventPosition);
+
+    //Binary search of the first event after eventTime (forward), or of the one following the last event before eventTime.
+    long first = 1;
+    long end = nbEvents + 1;
+    while(first < end){
+        const long middle = first + (end - first) / 2;
+        const long time = static_cast<long>(floor(0.5 + timeStamps(1,middle)));
+        if(forward ? time <= eventTime : time < eventTime)
+            first = middle + 1;
+        else
+            end = middle;
+    }
+
+    //Look up for the first event contained in selectedIds, within a limited number of events as the result is only a hint.
+    const long maxLookedUp = 100000;
+    long index = forward ? first : first - 1;
+    for(long i = 0; i < maxLookedUp && index >= 1 && index <= nbEvents; ++i){
+        if(selectedIds.contains(eventIds.value(events(1,index)))){
+            const long time = static_cast<long>(floor(0.5 + timeStamps(1,index)));
+            return qMax(time - static_cast<long>(timeFrame * eventPosition),0L);
+        }
+        index += forward ? 1 : -1;
+    }
+    return -1;
+}
+
 void EventsProvider::requestPreviousEventData(long startTime,long timeFrame,QList<int> selectedIds,QObject* initiator){
     long initialStartTime = startTime;
     //Compute the start time for the event look up
@@ -92,6 +92,16 @@ public:
   */
     virtual void requestPreviousEventData(long endTime,long timeFrame,QList<int> selectedIds,QObject* initiator);
 
+    /**Returns the start time of the time interval which requestNextEventData (@p forward true) or requestPreviousEventData
+  * would retrieve, without retrieving anything. Used to read ahead the traces of the following jump.
+  * @param startTime starting time for the look up.
+  * @param timeFrame time interval for which the data would be retrieved.
+  * @param selectedIds list of event ids to look up for.
+  * @param forward true to look up for the next event, false for the previous one.
+  * @return the start time, or -1 if no event has been found.
+  */
+    long browsingTarget(long startTime,long timeFrame,const QList<int>& selectedIds,bool forward);
+
     /**Loads the event ids and the corresponding spike time.
   * @return an loadReturnMessage enum giving the load status
   */
@@ -0,0 +1,145 @@
+/***************************************************************************
+                          frametimings.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+//include files for the application
+#include "frametimings.h"
+
+// include files for QT
+#include <QFile>
+#include <QTextStream>
+
+// include c/c++ headers
+#include <math.h>
+#include <algorithm>
+
+FrameTimings::Frame::Frame():total(0),bytesRead(0),nbRequests(0),nbCacheHits(0){
+    for(int i = 0; i < NB_STAGES; ++i)
+        durations[i] = 0;
+}
+
+FrameTimings::FrameTimings(int capacity):first(0),capacity(qMax(1,capacity)),nbRecorded(0){
+}
+
+void FrameTimings::add(const Frame& frame){
+    if (frames.size() < capacity)
+        frames.append(frame);
+    else{
+        frames[first] = frame;
+        first = (first + 1) % capacity;
+    }
+    ++nbRecorded;
+}
+
+void FrameTimings::clear(){
+    frames.clear();
+    first = 0;
+    nbRecorded = 0;
+}
+
+double FrameTimings::percentile(int stage,double p) const{
+    if (frames.isEmpty())
+        return 0;
+    QVector<double> values(frames.size());
+    for(int i = 0; i < frames.size(); ++i)
+        values[i] = duration(frames.at(i),stage);
+    std::sort(values.begin(),values.end());
+
+    //Nearest rank.
+    const int rank = static_cast<int>(ceil(p * values.size()));
+    return values.at(qBound(0,rank - 1,values.size() - 1));
+}
+
+double FrameTimings::cacheHitRate() const{
+    int nbRequests = 0;
+    int nbCacheHits = 0;
+    for(int i = 0; i < frames.size(); ++i){
+        nbRequests += frames.at(i).nbRequests;
+        nbCacheHits += frames.at(i).nbCacheHits;
+    }
+    return (nbRequests == 0) ? -1 : static_cast<double>(nbCacheHits) / nbRequests;
+}
+
+QString FrameTimings::summary() const{
+    if (frames.isEmpty())
+        return QString();
+    const Frame& last = frame(frames.size() - 1);
+    QString text = QString("Frame %1 ms (p50 %2, p95 %3)").arg(last.total,0,'f',1).arg(percentile(NB_STAGES,0.5),0,'f',1)
+            .arg(percentile(NB_STAGES,0.95),0,'f',1);
+    for(int stage = 0; stage < NB_STAGES; ++stage)
+        text.append(QString(" %1 %2").arg(stageName(stage)).arg(last.durations[stage],0,'f',1));
+    text.append(QString(" | read %1 KB").arg(last.bytesRead / 1024));
+    const double hitRate = cacheHitRate();
+    if (hitRate >= 0)
+        text.append(QString(" | cache hits %1%").arg(hitRate * 100,0,'f',0));
+    return text;
+}
+
+QStringList FrameTimings::table() const{
+    QStringList lines;
+    if (frames.isEmpty())
+        return lines;
+    const Frame& last = frame(frames.size() - 1);
+    lines.append(QString("%1 %2 %3 %4 %5").arg("ms",-10).arg("last",7).arg("p50",7).arg("p95",7).arg("p99",7));
+    for(int stage = 0; stage <= NB_STAGES; ++stage){
+        lines.append(QString("%1 %2 %3 %4 %5").arg(stageName(stage),-10).arg(duration(last,stage),7,'f',1)
+                     .arg(percentile(stage,0.5),7,'f',1).arg(percentile(stage,0.95),7,'f',1).arg(percentile(stage,0.99),7,'f',1));
+    }
+    lines.append(QString("read %1 KB in %2 requests").arg(last.bytesRead / 1024).arg(last.nbRequests));
+    const double hitRate = cacheHitRate();
+    if (hitRate >= 0)
+        lines.append(QString("cache hits %1% over %2 frames").arg(hitRate * 100,0,'f',0).arg(frames.size()));
+    return lines;
+}
+
+bool FrameTimings::exportCsv(const QString& fileName) const{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream stream(&file);
+    stream << "frame";
+    for(int stage = 0; stage <= NB_STAGES; ++stage)
+        stream << "," << stageName(stage) << "_ms";
+    stream << ",bytes_read,requests,cache_hits\n";
+
+    const qint64 firstNumber = nbRecorded - frames.size() + 1;
+    for(int i = 0; i < frames.size(); ++i){
+        const Frame& current = frame(i);
+        stream << firstNumber + i;
+        for(int stage = 0; stage <= NB_STAGES; ++stage)
+            stream << "," << QString::number(duration(current,stage),'f',3);
+        stream << "," << current.bytesRead << "," << current.nbRequests << "," << current.nbCacheHits << "\n";
+    }
+    stream.flush();
+    return file.error() == QFile::NoError;
+}
+
+const char* FrameTimings::stageName(int stage){
+    switch(stage){
+    case IO:
+        return "io";
+    case CONVERSION:
+        return "conversion";
+    case DECIMATION:
+        return "decimation";
+    case OVERLAY:
+        return "overlay";
+    case PAINT:
+        return "paint";
+    default:
+        return "total";
+    }
+}
@@ -0,0 +1,109 @@
+/***************************************************************************
+                          frametimings.h  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FRAMETIMINGS_H
+#define FRAMETIMINGS_H
+
+// include files for QT
+#include <QVector>
+#include <QString>
+#include <QStringList>
+
+/**
+  * Rolling record of the time spent in each stage of the drawing of the traces, frame by frame.
+  *
+  * A frame is a complete drawing of the traces of a view. The time spent reading and converting the samples is the one of
+  * the requests made since the previous frame. The decimation time is summed over the rendering threads, the part done by
+  * the threads drawing the tiles overlaps the painting, which only counts the time spent on the GUI thread.
+  *@author the Neurosuite developers
+  */
+class FrameTimings {
+public:
+    /**Stages of a frame.*/
+    enum Stage{IO = 0,CONVERSION = 1,DECIMATION = 2,OVERLAY = 3,PAINT = 4,NB_STAGES = 5};
+
+    /**Timings of a frame, in miliseconds.*/
+    struct Frame{
+        Frame();
+
+        double durations[NB_STAGES];
+
+        /**Time spent reading and converting the samples of the frame plus the time spent drawing it on the GUI thread.*/
+        double total;
+
+        /**Number of bytes of the data file read or mapped by the requests of the frame.*/
+        qint64 bytesRead;
+
+        /**Number of requests of the frame, and how many of them were served by the cache of decoded windows.*/
+        int nbRequests;
+        int nbCacheHits;
+    };
+
+    /**Constructor.
+  * @param capacity number of frames kept, the oldest ones being discarded.
+  */
+    explicit FrameTimings(int capacity = 1000);
+
+    /**Records the timings of a new frame.*/
+    void add(const Frame& frame);
+
+    /**Discards all the frames recorded.*/
+    void clear();
+
+    /**Returns the number of frames kept.*/
+    int nbFrames() const{return frames.size();}
+
+    /**Returns the frame @p index, 0 being the oldest one kept.*/
+    const Frame& frame(int index) const{return frames.at((first + index) % frames.size());}
+
+    /**Returns the total time (stage equal to NB_STAGES) or the time of the stage @p stage, in miliseconds, below which
+  * the proportion @p p (between 0 and 1) of the frames kept are.
+  */
+    double percentile(int stage,double p) const;
+
+    /**Returns the proportion of the requests of the frames kept served by the cache of decoded windows, -1 if there are none.*/
+    double cacheHitRate() const;
+
+    /**Returns a one line summary of the frames kept, for the status bar.*/
+    QString summary() const;
+
+    /**Returns the lines of the table of the last frame and of the percentiles of the frames kept, drawn by the views.*/
+    QStringList table() const;
+
+    /**Writes the frames kept as comma separated values in the file @p fileName, one line per frame.
+  * @return true if the file could be written, false otherwise.
+  */
+    bool exportCsv(const QString& fileName) const;
+
+    /**Returns the name of the stage @p stage, "total" for NB_STAGES.*/
+    static const char* stageName(int stage);
+
+private:
+    /**Frames kept, starting at first once the capacity is reached.*/
+    QVector<Frame> frames;
+    int first;
+    int capacity;
+
+    /**Number of frames recorded since the last clear, used to number them.*/
+    qint64 nbRecorded;
+
+    /**Returns the time of the stage @p stage of @p frame, the total time for NB_STAGES.*/
+    static double duration(const Frame& frame,int stage){
+        return (stage == NB_STAGES) ? frame.total : frame.durations[stage];
+    }
+};
+
+#endif
@@ -25,9 +25,14 @@
 #include <QDir>
 #include <QString>
 #include <QApplication>
+#include <QFileInfo>
+#include <QStringList>
+#include <QSize>
+#include <QTime>
 
 //Application specific include files
 #include "neuroscope.h"
+#include "batchrenderer.h"
 int main(int argc, char *argv[])
 {    
     // QApplication::setGraphicsSystem() was removed from Qt5
@@ -38,7 +43,19 @@ int main(int argc, char *argv[])
     QApplication::setOrganizationDomain("neurosuite.github.io");
     QApplication::setApplicationName("neuroscope");
 
+    //The snapshots are rendered without opening any window.
+    bool batchMode = false;
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--render") == 0 || qstrcmp(argv[i], "-render") == 0)
+            batchMode = true;
+    }
+#if QT_VERSION >= 0x050000
+    if (batchMode && qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
     QApplication app(argc, argv);
+#else
+    QApplication app(argc, argv, !batchMode);
+#endif
     QString file;
     QStringList args = QApplication::arguments();
     QString channelNb;
@@ -49,6 +66,11 @@ int main(int argc, char *argv[])
     QString amplification;
     QString screenGain;
     QString timeWindow;
+    QString snapshotList;
+    QString outputDirectory;
+    QString imageSize;
+    QString nbThreads;
+    QString range;
     bool streamMode = false;
     //TODO Qt5.2 use QCommandLineParser
     for (int i = 1, n = args.size(); i < n; ++i) {
@@ -66,6 +88,15 @@ int main(int argc, char *argv[])
                        << "  -s, --samplingRate      Sampling rate.\n"
                        << "  -t, --timeWindow        Initial time window (in miliseconds).\n"
                        << "\n"
+                       << "Batch rendering:\n"
+                       << "  --render <list>         Render the snapshots listed in the file <list> as PNG images, without any window.\n"
+                       << "                          Each line gives a start time and a duration in miliseconds, then optionally\n"
+                       << "                          the channels to draw (for instance 0-7,12).\n"
+                       << "  --output <directory>    Directory receiving the images (default: current directory).\n"
+                       << "  --size <width>x<height> Size of the images (default: 1600x900).\n"
+                       << "  --threads <number>      Number of rendering threads (default: one per processor).\n"
+                       << "  --range <uV>            Amplitude spanning the height of each channel (default: fit the traces).\n"
+                       << "\n"
                        << "Optional flags:\n"
             #if WITH_CEREBUS
                        << "  -n, --stream            Open network stream instead of file.\n"
@@ -96,6 +127,16 @@ int main(int argc, char *argv[])
                   SR = args.at(++i);
              } else if (arg == "-t" || arg == "--timeWindow" || arg == "-timeWindow") {
                   timeWindow = args.at(++i);
+             } else if (arg == "--render" || arg == "-render") {
+                  snapshotList = args.at(++i);
+             } else if (arg == "--output" || arg == "-output") {
+                  outputDirectory = args.at(++i);
+             } else if (arg == "--size" || arg == "-size") {
+                  imageSize = args.at(++i);
+             } else if (arg == "--threads" || arg == "-threads") {
+                  nbThreads = args.at(++i);
+             } else if (arg == "--range" || arg == "-range") {
+                  range = args.at(++i);
 #ifdef WITH_CEREBUS
              } else if (arg == "-n" || arg == "--stream" || arg == "-stream") {
                  streamMode = true;
@@ -116,6 +157,39 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    if (batchMode) {
+        if (file.isEmpty() || snapshotList.isEmpty()) {
+            std::cerr << "The batch rendering expects a data file and a list of snapshots." << std::endl;
+            return 1;
+        }
+        BatchRenderer renderer;
+        const QStringList size = imageSize.split(QLatin1Char('x'));
+        if (size.size() == 2 && size.at(0).toInt() > 0 && size.at(1).toInt() > 0)
+            renderer.setImageSize(QSize(size.at(0).toInt(), size.at(1).toInt()));
+        else if (!imageSize.isEmpty()) {
+            std::cerr << "The size of the images has to be given as <width>x<height>." << std::endl;
+            return 1;
+        }
+        renderer.setNbThreads(nbThreads.toInt());
+        renderer.setRange(range.toLong());
+
+        if (!renderer.openDataFile(QFileInfo(file).absoluteFilePath(), channelNb.toInt(), SR.toDouble(), resolution.toInt(),
+                                   offset.toInt(), voltageRange.toInt(), amplification.toInt()) ||
+                !renderer.loadSnapshots(snapshotList)) {
+            std::cerr << qPrintable(renderer.errorString()) << std::endl;
+            return 1;
+        }
+
+        QTime time;
+        time.start();
+        const int nbFailures = renderer.render(outputDirectory.isEmpty() ? QDir::currentPath() : outputDirectory);
+        if (!renderer.errorString().isEmpty())
+            std::cerr << qPrintable(renderer.errorString()) << std::endl;
+        std::cout << "Rendered the snapshots in " << time.elapsed() / 1000.0 << " s, "
+                  << nbFailures << " failed." << std::endl;
+        return nbFailures == 0 ? 0 : 2;
+    }
+
     NeuroscopeApp* neuroscope = new NeuroscopeApp();
     neuroscope->setFileProperties(channelNb,SR,resolution,
                                   offset,voltageRange,amplification,
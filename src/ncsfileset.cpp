@@ -0,0 +1,347 @@
+/***************************************************************************
+                          ncsfileset.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+//include files for the application
+#include "ncsfileset.h"
+
+// include files for QT
+#include <QFile>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QDebug>
+
+// include c/c++ headers
+#include <algorithm>
+#include <string.h>
+
+const qint64 NCSFileSet::HEADER_SIZE = 16 * 1024;
+const qint64 NCSFileSet::RECORD_HEADER_SIZE = 20;
+const qint64 NCSFileSet::SAMPLES_PER_RECORD = 512;
+
+/**Size of a record, header included.*/
+static const qint64 RECORD_SIZE = NCSFileSet::RECORD_HEADER_SIZE + NCSFileSet::SAMPLES_PER_RECORD * sizeof(int16_t);
+
+/**Position of the number of valid samples in the record header.*/
+static const qint64 NB_VALID_SAMPLES_POSITION = 16;
+
+/**Work executed by the thread pool, signaling its completion.*/
+class NCSFileSet::Task : public QRunnable {
+public:
+    Task():done(0L){setAutoDelete(false);}
+    virtual ~Task(){}
+
+    void run(){
+        execute();
+        done->release();
+    }
+
+    virtual void execute() = 0;
+
+    QSemaphore* done;
+};
+
+/**Indexes the records of one file.*/
+class NCSFileSet::IndexTask : public NCSFileSet::Task {
+public:
+    explicit IndexTask(ChannelFile& channelFile):channelFile(channelFile){}
+
+    void execute(){NCSFileSet::indexRecords(channelFile);}
+
+private:
+    ChannelFile& channelFile;
+};
+
+/**Reads a group of channels.*/
+class NCSFileSet::ReadTask : public NCSFileSet::Task {
+public:
+    ReadTask(const NCSFileSet& fileSet,qint64 firstSample,qint64 nbSamples,const QList<int>& channels,int firstColumn,int lastColumn,int16_t* data)
+        :fileSet(fileSet),firstSample(firstSample),nbSamples(nbSamples),channels(channels),
+          firstColumn(firstColumn),lastColumn(lastColumn),data(data){}
+
+    void execute(){
+        const int nbColumns = channels.isEmpty() ? fileSet.nbChannels : channels.size();
+        for(int column = firstColumn; column < lastColumn; ++column){
+            const int channel = channels.isEmpty() ? column : channels.at(column);
+            NCSFileSet::readChannel(fileSet.files.at(channel),firstSample,nbSamples,data + column,nbColumns);
+        }
+    }
+
+private:
+    const NCSFileSet& fileSet;
+    qint64 firstSample;
+    qint64 nbSamples;
+    const QList<int>& channels;
+    int firstColumn;
+    int lastColumn;
+    int16_t* data;
+};
+
+NCSFileSet::NCSFileSet(const QString& fileName,int nbChannels)
+    : fileName(fileName),
+      nbChannels(nbChannels),
+      opened(false)
+{
+}
+
+NCSFileSet::~NCSFileSet(){
+    pool.waitForDone();
+    close();
+}
+
+void NCSFileSet::close(){
+    for(int i = 0; i < files.size(); ++i){
+        ChannelFile& channelFile = files[i];
+        if(channelFile.file == 0L)
+            continue;
+        if(channelFile.mappedData != 0L)
+            channelFile.file->unmap(const_cast<uchar*>(channelFile.mappedData));
+        channelFile.file->close();
+        delete channelFile.file;
+    }
+    files.clear();
+    opened = false;
+}
+
+QString NCSFileSet::channelFileName(int channel) const{
+    // The channel number is at the end of the base name, remove it.
+    int p = fileName.lastIndexOf(".");
+    QString baseName = fileName;
+    baseName.truncate(p-1);
+    p = baseName.lastIndexOf(QRegExp("[^0-9]"));
+    baseName.truncate(p+1);
+
+    // Files are numbered 1...N but we do not know if they are zero-padded,
+    // so we try different padding lengths (from 0 to 3 digits)
+    for(int i = 0; i <= 3; ++i){
+        QString cscFileName = baseName + QString(i,QLatin1Char('0')) + QString::fromLatin1("%1.ncs").arg(channel);
+        if(QFile::exists(cscFileName))
+            return cscFileName;
+    }
+    return QString();
+}
+
+bool NCSFileSet::open(){
+    if(opened)
+        return true;
+
+    close();
+    ChannelFile empty;
+    empty.file = 0L;
+    empty.mappedData = 0L;
+    empty.size = 0;
+    empty.nbRecords = 0;
+    empty.nbSamples = 0;
+    empty.nbTailSamples = 0;
+    files.fill(empty,nbChannels);
+
+    for(int channel = 0; channel < nbChannels; ++channel){
+        ChannelFile& channelFile = files[channel];
+        QString cscFileName = channelFileName(channel + 1);
+        if(cscFileName.isEmpty()){
+            qDebug()<<"missing Neuralynx file for channel "<<(channel + 1);
+            close();
+            return false;
+        }
+        channelFile.file = new QFile(cscFileName);
+        if(!channelFile.file->open(QIODevice::ReadOnly)){
+            qDebug()<<"the Neuralynx file could not be opened: "<<cscFileName;
+            close();
+            return false;
+        }
+        channelFile.size = channelFile.file->size();
+        //Without a mapping the data are read with QFile, one file per thread.
+        if(channelFile.size > 0)
+            channelFile.mappedData = channelFile.file->map(0,channelFile.size);
+    }
+
+    //Index the files in parallel.
+    QList<Task*> tasks;
+    for(int channel = 0; channel < nbChannels; ++channel)
+        tasks.append(new IndexTask(files[channel]));
+    runInParallel(tasks);
+
+    opened = true;
+    return true;
+}
+
+void NCSFileSet::update(){
+    if(!opened)
+        return;
+
+    QList<Task*> tasks;
+    for(int channel = 0; channel < nbChannels; ++channel){
+        ChannelFile& channelFile = files[channel];
+        qint64 size = QFileInfo(channelFile.file->fileName()).size();
+        if(size == channelFile.size)
+            continue;
+
+        //The mapping does not cover the appended records, map the file again.
+        if(channelFile.mappedData != 0L)
+            channelFile.file->unmap(const_cast<uchar*>(channelFile.mappedData));
+        channelFile.size = size;
+        channelFile.mappedData = channelFile.file->map(0,size);
+        tasks.append(new IndexTask(channelFile));
+    }
+    runInParallel(tasks);
+}
+
+qint64 NCSFileSet::getNbSamples() const{
+    qint64 nbSamples = 0;
+    for(int i = 0; i < files.size(); ++i)
+        nbSamples = qMax(nbSamples,files.at(i).nbSamples + files.at(i).nbTailSamples);
+    return nbSamples;
+}
+
+void NCSFileSet::indexRecords(ChannelFile& channelFile){
+    //The incomplete record at the end of the file, if any, is indexed again.
+    channelFile.nbTailSamples = 0;
+
+    for(qint64 record = channelFile.nbRecords;; ++record){
+        qint64 position = HEADER_SIZE + record * RECORD_SIZE;
+        if(position + RECORD_HEADER_SIZE > channelFile.size)
+            break;
+
+        quint32 nbValidSamples;
+        if(!readBytes(channelFile,position + NB_VALID_SAMPLES_POSITION,sizeof(nbValidSamples),&nbValidSamples))
+            break;
+        qint64 nbSamples = qMin(static_cast<qint64>(nbValidSamples),SAMPLES_PER_RECORD);
+
+        //The record is being written or the file has been truncated.
+        qint64 nbAvailableSamples = (channelFile.size - position - RECORD_HEADER_SIZE) / static_cast<qint64>(sizeof(int16_t));
+        if(nbAvailableSamples < SAMPLES_PER_RECORD){
+            channelFile.nbTailSamples = qMin(nbSamples,nbAvailableSamples);
+            break;
+        }
+
+        //Start a new segment if the previous record was short (or if it is the first record).
+        bool contiguous = false;
+        if(!channelFile.segments.isEmpty()){
+            const Segment& last = channelFile.segments.last();
+            contiguous = (last.firstSample + (record - last.firstRecord) * SAMPLES_PER_RECORD == channelFile.nbSamples);
+        }
+        if(!contiguous){
+            Segment segment;
+            segment.firstRecord = record;
+            segment.firstSample = channelFile.nbSamples;
+            channelFile.segments.append(segment);
+        }
+
+        channelFile.nbSamples += nbSamples;
+        channelFile.nbRecords = record + 1;
+    }
+}
+
+bool NCSFileSet::isBefore(qint64 sample,const Segment& segment){
+    return sample < segment.firstSample;
+}
+
+void NCSFileSet::readChannel(const ChannelFile& channelFile,qint64 firstSample,qint64 nbSamples,int16_t* data,int stride){
+    QVector<int16_t> buffer;
+    qint64 sample = firstSample;
+    qint64 remaining = nbSamples;
+
+    while(remaining > 0){
+        qint64 record;
+        qint64 inRecord;
+        qint64 available;
+        if(sample >= 0 && sample < channelFile.nbSamples){
+            //The sample belongs to the last segment starting at or before it.
+            QVector<Segment>::const_iterator next = std::upper_bound(channelFile.segments.constBegin(),channelFile.segments.constEnd(),sample,isBefore);
+            const Segment& segment = *(next - 1);
+            record = segment.firstRecord + (sample - segment.firstSample) / SAMPLES_PER_RECORD;
+            inRecord = (sample - segment.firstSample) % SAMPLES_PER_RECORD;
+
+            qint64 limit = segment.firstSample + (record - segment.firstRecord + 1) * SAMPLES_PER_RECORD;
+            if(next != channelFile.segments.constEnd())
+                limit = qMin(limit,next->firstSample);
+            else
+                limit = qMin(limit,channelFile.nbSamples);
+            available = limit - sample;
+        }
+        else if(sample >= channelFile.nbSamples && sample < channelFile.nbSamples + channelFile.nbTailSamples){
+            record = channelFile.nbRecords;
+            inRecord = sample - channelFile.nbSamples;
+            available = channelFile.nbTailSamples - inRecord;
+        }
+        else{
+            //Missing records at the end of the file.
+            for(qint64 i = 0; i < remaining; ++i,data += stride)
+                *data = 0;
+            return;
+        }
+
+        qint64 nbToCopy = qMin(available,remaining);
+        qint64 position = HEADER_SIZE + record * RECORD_SIZE + RECORD_HEADER_SIZE + inRecord * static_cast<qint64>(sizeof(int16_t));
+        const int16_t* samples;
+        if(channelFile.mappedData != 0L)
+            samples = reinterpret_cast<const int16_t*>(channelFile.mappedData + position);
+        else{
+            buffer.resize(nbToCopy);
+            if(!readBytes(channelFile,position,nbToCopy * sizeof(int16_t),buffer.data()))
+                buffer.fill(0);
+            samples = buffer.constData();
+        }
+        for(qint64 i = 0; i < nbToCopy; ++i,data += stride)
+            *data = samples[i];
+
+        sample += nbToCopy;
+        remaining -= nbToCopy;
+    }
+}
+
+bool NCSFileSet::readBytes(const ChannelFile& channelFile,qint64 position,qint64 nbBytes,void* buffer){
+    if(position < 0 || position + nbBytes > channelFile.size)
+        return false;
+    if(channelFile.mappedData != 0L){
+        memcpy(buffer,channelFile.mappedData + position,nbBytes);
+        return true;
+    }
+    return channelFile.file->seek(position) && channelFile.file->read(static_cast<char*>(buffer),nbBytes) == nbBytes;
+}
+
+void NCSFileSet::read(qint64 firstSample,qint64 nbSamples,const QList<int>& channels,int16_t* data){
+    const int nbColumns = channels.isEmpty() ? nbChannels : channels.size();
+    if(!opened || nbColumns == 0 || nbSamples <= 0)
+        return;
+
+    //Split the channels in as many groups as threads.
+    const int nbGroups = qMin(nbColumns,qMax(1,pool.maxThreadCount()));
+    QList<Task*> tasks;
+    for(int group = 0; group < nbGroups; ++group){
+        int firstColumn = (group * nbColumns) / nbGroups;
+        int lastColumn = ((group + 1) * nbColumns) / nbGroups;
+        tasks.append(new ReadTask(*this,firstSample,nbSamples,channels,firstColumn,lastColumn,data));
+    }
+    runInParallel(tasks);
+}
+
+void NCSFileSet::runInParallel(QList<Task*>& tasks){
+    if(tasks.isEmpty())
+        return;
+
+    QSemaphore done;
+    for(int i = 0; i < tasks.size(); ++i)
+        tasks[i]->done = &done;
+    for(int i = 1; i < tasks.size(); ++i)
+        pool.start(tasks[i]);
+    tasks[0]->run();
+    done.acquire(tasks.size());
+
+    qDeleteAll(tasks);
+    tasks.clear();
+}
@@ -0,0 +1,150 @@
+/***************************************************************************
+                          ncsfileset.h  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef NCSFILESET_H
+#define NCSFILESET_H
+
+// include files for QT
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QThreadPool>
+
+// include c/c++ headers
+#include <stdint.h>
+
+class QFile;
+
+/**
+  * Set of Neuralynx continuously sampled channel files (.ncs), one file per channel.
+  *
+  * The files are resolved and opened once, and kept memory mapped (or open if the mapping fails).
+  * When a file is opened its record headers are scanned to build an index from the samples to the records,
+  * which takes into account the records holding less than 512 valid samples and the records missing at the
+  * end of some files. The channels are read in parallel, each channel being independent.
+  *@author the Neurosuite developers
+  */
+class NCSFileSet {
+public:
+    /**Constructor.
+  * @param fileName name of one of the files of the set, the channel number being the last digits of the base name.
+  * @param nbChannels number of channels, the files being numbered from 1 to @p nbChannels.
+  */
+    NCSFileSet(const QString& fileName,int nbChannels);
+    ~NCSFileSet();
+
+    /**Opens and indexes all the files of the set.
+  * @return true if all the files could be opened, false otherwise.
+  */
+    bool open();
+
+    /**Returns true if all the files of the set are open.*/
+    bool isOpen() const {return opened;}
+
+    /**Indexes the records appended to the files since the last call (recording in progress).*/
+    void update();
+
+    /**Returns the number of channels of the set.*/
+    int getNbChannels() const {return nbChannels;}
+
+    /**Returns the number of samples of the longest channel.*/
+    qint64 getNbSamples() const;
+
+    /**Reads the samples [@p firstSample, @p firstSample + @p nbSamples[ of the channels @p channels.
+  * The samples missing at the end of a shorter channel are set to 0.
+  * @param firstSample index of the first sample, starting at 0.
+  * @param nbSamples number of samples per channel.
+  * @param channels ids of the channels to read (starting at 0), all the channels if empty.
+  * @param data interleaved samples (number of samples X number of read channels).
+  */
+    void read(qint64 firstSample,qint64 nbSamples,const QList<int>& channels,int16_t* data);
+
+    /**Size of the file header.*/
+    static const qint64 HEADER_SIZE;
+
+    /**Size of the header of a record, the timestamp, channel number, sampling frequency and number of valid samples.*/
+    static const qint64 RECORD_HEADER_SIZE;
+
+    /**Maximum number of samples in a record.*/
+    static const qint64 SAMPLES_PER_RECORD;
+
+private:
+    /**Run of consecutive records whose samples follow each other, only the last one may hold less than
+  * SAMPLES_PER_RECORD valid samples.
+  */
+    struct Segment{
+        qint64 firstRecord;
+        qint64 firstSample;
+    };
+
+    /**File of one channel and its record index.*/
+    struct ChannelFile{
+        QFile* file;
+        const uchar* mappedData;
+        qint64 size;
+        /**Segments of records, sorted by first sample.*/
+        QVector<Segment> segments;
+        /**Number of records indexed so far, the last one being complete.*/
+        qint64 nbRecords;
+        /**Number of samples in the indexed records.*/
+        qint64 nbSamples;
+        /**Number of valid samples available in the incomplete record at the end of the file, if any.*/
+        qint64 nbTailSamples;
+    };
+
+    class Task;
+    class IndexTask;
+    class ReadTask;
+
+    QString fileName;
+    int nbChannels;
+    bool opened;
+    QVector<ChannelFile> files;
+
+    /**Threads reading the channels, independent from the global pool which may be used by the caller.*/
+    QThreadPool pool;
+
+    /**Unmaps and closes all the files.*/
+    void close();
+
+    /**Resolves the name of the file of the channel @p channel (starting at 1), trying different zero paddings.
+  * @return the name of the existing file, an empty string if none exists.
+  */
+    QString channelFileName(int channel) const;
+
+    /**Returns true if @p sample precedes the first sample of @p segment.*/
+    static bool isBefore(qint64 sample,const Segment& segment);
+
+    /**Indexes the records of @p channelFile following the ones already indexed.*/
+    static void indexRecords(ChannelFile& channelFile);
+
+    /**Reads the samples [@p firstSample, @p firstSample + @p nbSamples[ of @p channelFile into @p data,
+  * writing every @p stride values.
+  */
+    static void readChannel(const ChannelFile& channelFile,qint64 firstSample,qint64 nbSamples,int16_t* data,int stride);
+
+    /**Copies @p nbBytes from @p channelFile starting at @p position into @p buffer.
+  * @return true if the bytes have been read, false otherwise.
+  */
+    static bool readBytes(const ChannelFile& channelFile,qint64 position,qint64 nbBytes,void* buffer);
+
+    /**Runs @p tasks in parallel, the first one in the calling thread, and waits for their completion.
+  * The tasks are deleted.
+  */
+    void runInParallel(QList<Task*>& tasks);
+};
+
+#endif
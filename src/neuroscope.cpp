@@ -54,6 +54,8 @@
 #include "traceview.h"
 #include "itempalette.h"
 #include "eventsprovider.h"
+#include "clustersprovider.h"
+#include "providerloader.h"
 #include "qhelpviewer.h"
 
 
@@ -92,6 +94,7 @@ NeuroscopeApp::NeuroscopeApp()
                             initialOffsetDefault,voltageRangeDefault,amplificationDefault,screenGainDefault,resolutionDefault,
                             eventPosition,clusterPosition,nbSamplesDefault,peakIndexDefault,videoSamplingRateDefault,videoWidthDefault,videoHeightDefault,backgroundImageDefault,traceBackgroundImageDefault,
                             rotationDefault,flipDefault,drawPositionsOnBackgroundDefault);
+    doc->setTraceCacheSize(traceCacheSize);
 
 
     initActions();
@@ -482,6 +485,36 @@ void NeuroscopeApp::initActions()
 
     showHideLabels->setChecked(false);
 
+    QMenu* decimationMenu = traceMenu->addMenu(tr("Trace &Decimation"));
+    decimationModes = new QActionGroup(this);
+    decimationModes->setExclusive(true);
+    QAction* decimationMode = decimationMenu->addAction(tr("&Min/Max Envelope"));
+    decimationMode->setData(TracesDecimation::MIN_MAX);
+    decimationModes->addAction(decimationMode);
+    decimationMode = decimationMenu->addAction(tr("&Largest Triangle (LTTB)"));
+    decimationMode->setData(TracesDecimation::LTTB);
+    decimationModes->addAction(decimationMode);
+    decimationMode = decimationMenu->addAction(tr("&RMS Band"));
+    decimationMode->setData(TracesDecimation::RMS_BAND);
+    decimationModes->addAction(decimationMode);
+    decimationMode = decimationMenu->addAction(tr("&Stride"));
+    decimationMode->setData(TracesDecimation::STRIDE);
+    decimationModes->addAction(decimationMode);
+    const QList<QAction*> decimationActions = decimationModes->actions();
+    for(int i = 0; i < decimationActions.size(); ++i)
+        decimationActions.at(i)->setCheckable(true);
+    decimationActions.first()->setChecked(true);
+    connect(decimationModes,SIGNAL(triggered(QAction*)), this,SLOT(slotDecimationMode(QAction*)));
+
+    showFrameTimings = traceMenu->addAction(tr("Show Frame &Timings"));
+    showFrameTimings->setCheckable(true);
+    connect(showFrameTimings,SIGNAL(triggered()), this,SLOT(slotShowFrameTimings()));
+
+    showFrameTimings->setChecked(false);
+
+    mExportFrameTimings = traceMenu->addAction(tr("E&xport Frame Timings..."));
+    connect(mExportFrameTimings,SIGNAL(triggered()), this,SLOT(slotExportFrameTimings()));
+
 	 /// Added by M.Zugaro to enable automatic forward paging
     traceMenu->addSeparator();
     mPage = traceMenu->addAction(tr("Auto-advance to end of recording"));
@@ -776,6 +809,14 @@ void NeuroscopeApp::applyPreferences() {
         doc->setClusterPosition(clusterPosition);
     }
 
+    if(traceCacheSize != configuration().getTraceCacheSize()){
+        traceCacheSize = configuration().getTraceCacheSize();
+        doc->setTraceCacheSize(traceCacheSize);
+    }
+
+    //The rasterizer draws the same pixels as the painter, the displays do not need to be redrawn.
+    TraceView::setRenderingBackend(configuration().getTraceRasterizer() ? TraceView::RASTERIZER : TraceView::QPAINTER);
+
     if(nbSamplesDefault != configuration().getNbSamples() || peakIndexDefault != configuration().getPeakIndex()){
         nbSamplesDefault = configuration().getNbSamples();
         peakIndexDefault = configuration().getPeakIndex();
@@ -871,6 +912,8 @@ void NeuroscopeApp::initializePreferences(){
     resolutionDefault = configuration().getResolution();
     eventPosition = configuration().getEventPosition();
     clusterPosition = configuration().getClusterPosition();
+    traceCacheSize = configuration().getTraceCacheSize();
+    TraceView::setRenderingBackend(configuration().getTraceRasterizer() ? TraceView::RASTERIZER : TraceView::QPAINTER);
     nbSamplesDefault = configuration().getNbSamples();
     peakIndexDefault = configuration().getPeakIndex();
     videoSamplingRateDefault = configuration().getVideoSamplingRate();
@@ -1987,6 +2030,8 @@ void NeuroscopeApp::resetState(){
     displayMode->setChecked(false);
     editMode->setChecked(true);
     showHideLabels->setChecked(false);
+    decimationModes->actions().first()->setChecked(true);
+    showFrameTimings->setChecked(false);
     positionViewToggle->setChecked(false);
     showEventsInPositionView->setChecked(false);
     isPositionFileLoaded = false;
@@ -2180,6 +2225,25 @@ void NeuroscopeApp::slotAutocenterChannels(){
     view->setAutocenterChannels(autocenterChannels->isChecked());
 }
 
+void NeuroscopeApp::slotDecimationMode(QAction* action){
+    NeuroscopeView* view = activeView();
+    view->setDecimationMode(static_cast<TracesDecimation::Mode>(action->data().toInt()));
+}
+
+void NeuroscopeApp::slotShowFrameTimings(){
+    NeuroscopeView* view = activeView();
+    view->showFrameTimings(showFrameTimings->isChecked());
+}
+
+void NeuroscopeApp::slotExportFrameTimings(){
+    QString url = QFileDialog::getSaveFileName(this, tr("Export Frame Timings..."),doc->sessionPath(),
+                                               tr("Comma separated values (*.csv);;All files (*.*)"));
+    if(url.isEmpty())
+        return;
+    if(!activeView()->exportFrameTimings(url))
+        QMessageBox::critical(0,tr("I/O Error !"),tr("The frame timings could not be saved possibly because of insufficient file access permissions."));
+}
+
 void NeuroscopeApp::slotShowLabels(){
     NeuroscopeView* view = activeView();
     view->showLabelsUpdate(showHideLabels->isChecked());
@@ -2311,6 +2375,12 @@ void NeuroscopeApp::slotTabChange(int index){
     clusterWaveforms->setChecked(activeView->getClusterWaveforms());
     autocenterChannels->setChecked(activeView->getAutocenterChannels());
     showHideLabels->setChecked(activeView->getLabelStatus());
+    const QList<QAction*> decimationActions = decimationModes->actions();
+    for(int i = 0; i < decimationActions.size(); ++i){
+        if (decimationActions.at(i)->data().toInt() == activeView->getDecimationMode())
+            decimationActions.at(i)->setChecked(true);
+    }
+    showFrameTimings->setChecked(activeView->isFrameTimingsShown());
     positionViewToggle->setChecked(activeView->isPositionView());
     showEventsInPositionView->setChecked(activeView->isEventsInPositionView());
 
@@ -2852,52 +2922,53 @@ void NeuroscopeApp::customEvent (QEvent* event){
 
 void NeuroscopeApp::loadClusterFiles(const QStringList &urls){
     NeuroscopeView* view = activeView();
-    QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+    ProviderLoader loader(this,tr("Loading cluster file(s)..."));
+    QStringList loaderUrls;
 
-    //Loop on the files
+    //Create the providers, their data are loaded concurrently
     QStringList::const_iterator iterator;
     for(iterator = urls.constBegin();iterator != urls.constEnd();++iterator){
-        //Create the provider
-        int returnStatus = doc->loadClusterFile(*iterator,view);
-        if(returnStatus == NeuroscopeDoc::OPEN_ERROR){
-            QApplication::restoreOverrideCursor();
-            QMessageBox::critical (this, tr("Error!"),tr("Could not load the file %1").arg(*iterator));
+        //A Blackrock file gives several providers, which are created and loaded at once
+        if((*iterator).indexOf(".nev") != -1){
             QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-            continue;
-        }
-        else if(returnStatus == NeuroscopeDoc::INCORRECT_FILE){
+            int returnStatus = doc->loadClusterFile(*iterator,view);
             QApplication::restoreOverrideCursor();
-            QMessageBox::critical (this, tr("Error!"),
-                                   tr("Incorrect file name (%1): the name has to be of the form baseName.n.clu or baseName.clu.n (with n a number identifier).").arg(*iterator));
-            QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+            clusterFileError(returnStatus,*iterator);
             continue;
         }
-        else if(returnStatus == NeuroscopeDoc::MISSING_FILE){
-            QApplication::restoreOverrideCursor();
-            QMessageBox::critical (this, tr("Error!"),tr("There is no time file (.res) corresponding to the requested file %1").arg(*iterator));
-            QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+        ClustersProvider* clustersProvider;
+        int returnStatus = doc->createClusterProvider(*iterator,clustersProvider);
+        if(returnStatus != NeuroscopeDoc::OK){
+            clusterFileError(returnStatus,*iterator);
             continue;
         }
-        else if(returnStatus == NeuroscopeDoc::INCORRECT_CONTENT){
-            QApplication::restoreOverrideCursor();
-            QMessageBox::critical (this, tr("Error!"),tr("The number of spikes read in the requested file (%1) or the corresponding time file (.res) does not correspond to number of spikes computed.").arg(*iterator));
-            QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-            continue;
-        }
-        else if(returnStatus == NeuroscopeDoc::CREATION_ERROR){
-            QApplication::restoreOverrideCursor();
-            QMessageBox::critical (this, tr("Error!"),tr("The number of spikes of the requested file (%1) could not be determined.").arg(*iterator));
-            QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-            continue;
-        }
-        else if(returnStatus == NeuroscopeDoc::ALREADY_OPENED){
-            QApplication::restoreOverrideCursor();
-            QMessageBox::critical (this, tr("Error!"),tr("The requested file (%1) is already loaded.").arg(*iterator));
-            QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-            continue;
-        }
-    }
-    QApplication::restoreOverrideCursor();
+        loader.add(clustersProvider,*iterator);
+        loaderUrls.append(*iterator);
+    }
+
+    //Show each file as soon as it is loaded
+    loader.start();
+    int index;
+    int returnStatus;
+    DataProvider* provider;
+    while((provider = loader.next(index,returnStatus)) != 0L)
+        clusterFileError(doc->addClusterProvider(loaderUrls.at(index),static_cast<ClustersProvider*>(provider),returnStatus,view),loaderUrls.at(index));
+}
+
+void NeuroscopeApp::clusterFileError(int returnStatus,const QString& url){
+    if(returnStatus == NeuroscopeDoc::OPEN_ERROR)
+        QMessageBox::critical (this, tr("Error!"),tr("Could not load the file %1").arg(url));
+    else if(returnStatus == NeuroscopeDoc::INCORRECT_FILE)
+        QMessageBox::critical (this, tr("Error!"),
+                               tr("Incorrect file name (%1): the name has to be of the form baseName.n.clu or baseName.clu.n (with n a number identifier).").arg(url));
+    else if(returnStatus == NeuroscopeDoc::MISSING_FILE)
+        QMessageBox::critical (this, tr("Error!"),tr("There is no time file (.res) corresponding to the requested file %1").arg(url));
+    else if(returnStatus == NeuroscopeDoc::INCORRECT_CONTENT)
+        QMessageBox::critical (this, tr("Error!"),tr("The number of spikes read in the requested file (%1) or the corresponding time file (.res) does not correspond to number of spikes computed.").arg(url));
+    else if(returnStatus == NeuroscopeDoc::CREATION_ERROR)
+        QMessageBox::critical (this, tr("Error!"),tr("The number of spikes of the requested file (%1) could not be determined.").arg(url));
+    else if(returnStatus == NeuroscopeDoc::ALREADY_OPENED)
+        QMessageBox::critical (this, tr("Error!"),tr("The requested file (%1) is already loaded.").arg(url));
 }
 
 /** Updates view, because a new cluster file was loaded. */
@@ -3070,47 +3141,43 @@ void NeuroscopeApp::loadPositionFile(const QString& url){
 }
 
 void NeuroscopeApp::loadEventFiles(const QStringList& urls){
-
     NeuroscopeView* view = activeView();
-    QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+    ProviderLoader loader(this,tr("Loading event file(s)..."));
+    QStringList loaderUrls;
 
-    //Loop on the files
+    //Create the providers, their data are loaded concurrently
     QStringList::const_iterator iterator;
     for(iterator = urls.constBegin();iterator != urls.constEnd();++iterator){
-        //Create the provider
-        int returnStatus = doc->loadEventFile(*iterator,view);
-        if(returnStatus == NeuroscopeDoc::OPEN_ERROR){
-            QApplication::restoreOverrideCursor();
-            QMessageBox::critical (this, tr("Error!"),tr("Could not load the file %1").arg(*iterator));
-            QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-            continue;
-        }
-        else if(returnStatus == NeuroscopeDoc::INCORRECT_FILE){
-            QApplication::restoreOverrideCursor();
-            QMessageBox::critical (this, tr("Error!"),tr("Incorrect file name (%1): the name has to be of the form baseName.id.evt or baseName.evt.id (with id a 3 character identifier).").arg(*iterator));
-            QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-            continue;
-        }
-        else if(returnStatus == NeuroscopeDoc::CREATION_ERROR){
-            QApplication::restoreOverrideCursor();
-            QMessageBox::critical (this, tr("Error!"),tr("The number of events of the requested file (%1) could not be determined.").arg(*iterator));
-            QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-            continue;
-        }
-        else if(returnStatus == NeuroscopeDoc::INCORRECT_CONTENT){
-            QApplication::restoreOverrideCursor();
-            QMessageBox::critical (this, tr("Error!"),tr("The content of the requested file (%1) is incorrect (see file format information).").arg(*iterator));
-            QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-            continue;
-        }
-        else if(returnStatus == NeuroscopeDoc::ALREADY_OPENED){
-            QApplication::restoreOverrideCursor();
-            QMessageBox::critical (this, tr("Error!"),tr("The requested file (%1) is already loaded.").arg(*iterator));
-            QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+        EventsProvider* eventsProvider;
+        int returnStatus = doc->createEventProvider(*iterator,eventsProvider);
+        if(returnStatus != NeuroscopeDoc::OK){
+            eventFileError(returnStatus,*iterator);
             continue;
         }
+        loader.add(eventsProvider,*iterator);
+        loaderUrls.append(*iterator);
     }
-    QApplication::restoreOverrideCursor();
+
+    //Show each file as soon as it is loaded
+    loader.start();
+    int index;
+    int returnStatus;
+    DataProvider* provider;
+    while((provider = loader.next(index,returnStatus)) != 0L)
+        eventFileError(doc->addEventProvider(loaderUrls.at(index),static_cast<EventsProvider*>(provider),returnStatus,view),loaderUrls.at(index));
+}
+
+void NeuroscopeApp::eventFileError(int returnStatus,const QString& url){
+    if(returnStatus == NeuroscopeDoc::OPEN_ERROR)
+        QMessageBox::critical (this, tr("Error!"),tr("Could not load the file %1").arg(url));
+    else if(returnStatus == NeuroscopeDoc::INCORRECT_FILE)
+        QMessageBox::critical (this, tr("Error!"),tr("Incorrect file name (%1): the name has to be of the form baseName.id.evt or baseName.evt.id (with id a 3 character identifier).").arg(url));
+    else if(returnStatus == NeuroscopeDoc::CREATION_ERROR)
+        QMessageBox::critical (this, tr("Error!"),tr("The number of events of the requested file (%1) could not be determined.").arg(url));
+    else if(returnStatus == NeuroscopeDoc::INCORRECT_CONTENT)
+        QMessageBox::critical (this, tr("Error!"),tr("The content of the requested file (%1) is incorrect (see file format information).").arg(url));
+    else if(returnStatus == NeuroscopeDoc::ALREADY_OPENED)
+        QMessageBox::critical (this, tr("Error!"),tr("The requested file (%1) is already loaded.").arg(url));
 }
 
 void NeuroscopeApp::slotEventFileLoaded(const QString& fileId) {
@@ -3470,6 +3537,9 @@ void NeuroscopeApp::slotStateChanged(const QString& state)
         mMoveToNewGroup->setEnabled(false);
         autocenterChannels->setEnabled(false);
         showHideLabels->setEnabled(false);
+        decimationModes->setEnabled(false);
+        showFrameTimings->setEnabled(false);
+        mExportFrameTimings->setEnabled(false);
         mPage->setEnabled(false);
         mAccelerate->setEnabled(false);
         mDecelerate->setEnabled(false);
@@ -3534,6 +3604,9 @@ void NeuroscopeApp::slotStateChanged(const QString& state)
         mMoveToNewGroup->setEnabled(true);
         autocenterChannels->setEnabled(true);
         showHideLabels->setEnabled(true);
+        decimationModes->setEnabled(true);
+        showFrameTimings->setEnabled(true);
+        mExportFrameTimings->setEnabled(true);
         mPage->setEnabled(true);
         mAccelerate->setEnabled(true);
         mDecelerate->setEnabled(true);
@@ -25,6 +25,7 @@
 #include <QDockWidget>
 
 #include <QMenu>
+#include <QActionGroup>
 //QT include files
 #include <QCheckBox>
 
@@ -618,6 +619,17 @@ private Q_SLOTS:
     /**Enables or disables the display of labels next to the traces.*/
     void slotShowLabels();
 
+    /**Changes the reduction of the samples to the pixel columns of the traces of the active display.
+   * @param action the action of the chosen reduction, holding the TracesDecimation::Mode.
+   */
+    void slotDecimationMode(QAction* action);
+
+    /**Shows or hides the timings of the frames drawn by the active display.*/
+    void slotShowFrameTimings();
+
+    /**Writes the timings of the last frames drawn by the active display in a comma separated values file chosen by the user.*/
+    void slotExportFrameTimings();
+
     /**Changes the color of a cluster contained in the cluster file identified by @p groupName.
    * @param clusterId id of the cluster which has had its color changed.
    * @param groupName identifier of the file containing the cluster to update.
@@ -743,6 +755,9 @@ private:
     QAction* editMode;
     QAction* autocenterChannels;
     QAction* showHideLabels;
+    QActionGroup* decimationModes;
+    QAction* showFrameTimings;
+    QAction* mExportFrameTimings;
     QAction* calibrationBar;
     QMenu* addEventPopup;
     QAction* addEventToolBarAction;
@@ -917,6 +932,9 @@ private:
     /**Represents the cluster position, in percentage from the begining of the window, where the clusters are display when browsing.*/
     int clusterPosition;
 
+    /**Memory budget, in megabytes, of the cache of decoded traces shared by the displays of the document.*/
+    int traceCacheSize;
+
     /**The current number of undo used to enable/disable the the undo action.*/
     int currentNbUndo;
 
@@ -969,16 +987,24 @@ private:
     /**Resets the state of the application to a none document open state.*/
     void resetState();
 
-    /**Loads the cluster files and creates the corresponding groups in the cluster palette.
+    /**Loads the cluster files concurrently and creates the corresponding groups in the cluster palette
+   * as each file is loaded.
    * @param urls file list to be opened.
    */
     void loadClusterFiles(const QStringList& urls);
 
-    /**Loads the event files and creates the corresponding groups in the cluseventer palette.
+    /**Informs the user that the cluster file @p url could not be loaded, if @p returnStatus is not NeuroscopeDoc::OK.*/
+    void clusterFileError(int returnStatus,const QString& url);
+
+    /**Loads the event files concurrently and creates the corresponding groups in the cluseventer palette
+   * as each file is loaded.
    * @param urls file list to be opened.
    */
     void loadEventFiles(const QStringList& urls);
 
+    /**Informs the user that the event file @p url could not be loaded, if @p returnStatus is not NeuroscopeDoc::OK.*/
+    void eventFileError(int returnStatus,const QString& url);
+
     /**Loads the position file and creates the position view in the current display.
    * @param url file to be opened.
    */
@@ -50,6 +50,7 @@
 #include "positionsprovider.h"
 #include "imagecreator.h"
 #include "utilities.h"
+#include "providerloader.h"
 
 #ifdef WITH_CEREBUS
 #include "cerebustraceprovider.h"
@@ -57,6 +58,16 @@
 
 extern QString version;
 
+namespace {
+/**File of a session whose provider is being loaded, with what is needed to add the provider once loaded.*/
+struct SessionFileLoading{
+    SessionFile::type type;
+    QString url;
+    QMap<EventDescription,QColor> itemColors;
+    bool modified;
+};
+}
+
 NeuroscopeDoc::NeuroscopeDoc(QWidget* parent, ChannelPalette& displayChannelPalette, ChannelPalette& spikeChannelPalette, int channelNbDefault,
                              double datSamplingRateDefault, double eegSamplingRateDefault, int initialOffset, int voltageRangeDefault,
                              int amplificationDefault, float screenGainDefault, int resolutionDefault, int eventPosition, int clusterPosition,
@@ -81,6 +92,7 @@ NeuroscopeDoc::NeuroscopeDoc(QWidget* parent, ChannelPalette& displayChannelPale
       peakSampleIndexDefault(peakSampleIndex),
       eventPosition(eventPosition),
       clusterPosition(clusterPosition),
+      traceCacheSize(256),
       newEventDescriptionCreated(false),
       videoWidthDefault(width),
       videoHeightDefault(height),
@@ -263,6 +275,7 @@ int NeuroscopeDoc::openDocument(const QString& url)
         }
 
         this->tracesProvider = nsxTracesProvider;
+        nsxTracesProvider->setCacheSize(traceCacheSize);
 
         // Warn user if command line properties were used
         if(this->isCommandLineProperties){
@@ -576,6 +589,7 @@ int NeuroscopeDoc::openDocument(const QString& url)
     }
 
     qDebug()<<" NeuroscopeDoc::openDocument END ?";
+    tracesProvider->setCacheSize(traceCacheSize);
     //if skipStatus is empty, set the default status to 0
     if(skipStatus.isEmpty()){
         for(int i = 0; i < channelNb; ++i)
@@ -1667,16 +1681,21 @@ void NeuroscopeDoc::loadSession(NeuroscopeXmlReader reader){
             emit loadFirstDisplay(channelsToDisplay,verticalLines,raster,waveforms,showLabels,multipleColumns,greyMode,autocenterChannels,offsets,
                                   channelGains,selectedChannels,skipStatus,startTime,duration,tabLabel,isAPositionView,rasterHeight,showEventsInPositionView);
 
-            //Now that the channel palettes are created, load the files and create the palettes
-            bool fistClusterFile = true;
-            bool fistEventFile = true;
+            //Now that the channel palettes are created, load the files and create the palettes.
+            //The files are loaded concurrently, the palettes are filled in the order of the session file, the view being
+            //informed of the providers once all the files are loaded.
+            ProviderLoader loader(parent,tr("Loading the files of the session..."));
+            QList<SessionFileLoading> filesLoading;
             QList<SessionFile>::iterator sessionIterator;
             for(sessionIterator = filesToLoad.begin(); sessionIterator != filesToLoad.end(); ++sessionIterator){
                 SessionFile sessionFile = static_cast<SessionFile>(*sessionIterator);
                 QString fileUrl = sessionFile.getUrl().path();
                 SessionFile::type fileType = sessionFile.getType();
                 QDateTime lastModified = sessionFile.getModification();
-                QMap<EventDescription,QColor> itemColors = sessionFile.getItemColors();
+                SessionFileLoading fileLoading;
+                fileLoading.type = fileType;
+                fileLoading.itemColors = sessionFile.getItemColors();
+                fileLoading.modified = false;
                 if(fileType == SessionFile::CLUSTER){
                     //If the file does not exist in the location specified in the session file (absolute path), look up in the directory
                     //where the session file is. This is useful if you moved your file or you backup them (<=> the absolute path is not good anymore)
@@ -1691,10 +1710,11 @@ void NeuroscopeDoc::loadSession(NeuroscopeXmlReader reader){
                         selectedClusters.insert(fileUrl,ids);
                         skippedClusters.insert(fileUrl,skippedIds);
                     }
-                    OpenSaveCreateReturnMessage status = loadClusterFileForSession(fileUrl,itemColors,lastModified,fistClusterFile);
-                    if(status == OK){
-                        loadedClusterFiles.append(lastLoadedProvider);
-                        fistClusterFile = false;
+                    ClustersProvider* clustersProvider;
+                    if(createClusterProviderForSession(fileUrl,lastModified,clustersProvider,fileLoading.modified) == OK){
+                        fileLoading.url = fileUrl;
+                        filesLoading.append(fileLoading);
+                        loader.add(clustersProvider,fileUrl);
                     }
                 }
                 if(fileType == SessionFile::EVENT){
@@ -1711,19 +1731,11 @@ void NeuroscopeDoc::loadSession(NeuroscopeXmlReader reader){
                         selectedEvents.insert(fileUrl,ids);
                         skippedEvents.insert(fileUrl,skippedIds);
                     }
-                    OpenSaveCreateReturnMessage status = loadEventFileForSession(fileUrl,itemColors,lastModified,fistEventFile);
-                    if(status == OK){
-                        loadedEventFiles.append(lastLoadedProvider);
-                        fistEventFile = false;
-                        QMap<EventDescription,int> loadedItems;
-                        QMap<EventDescription,QColor>::ConstIterator it;
-                        QMap<EventDescription,QColor>::ConstIterator endColor(itemColors.constEnd());
-                        int index = 1;
-                        for(it = itemColors.constBegin(); it != endColor; ++it){
-                            loadedItems.insert(it.key(),index);
-                            index++;
-                        }
-                        loadedEventItems.insert(lastLoadedProvider,loadedItems);
+                    EventsProvider* eventsProvider;
+                    if(createEventProviderForSession(fileUrl,lastModified,eventsProvider,fileLoading.modified) == OK){
+                        fileLoading.url = fileUrl;
+                        filesLoading.append(fileLoading);
+                        loader.add(eventsProvider,fileUrl);
                     }
                 }
                 if(fileType == SessionFile::POSITION){
@@ -1751,7 +1763,45 @@ void NeuroscopeDoc::loadSession(NeuroscopeXmlReader reader){
                         }
                     }
 
-                    OpenSaveCreateReturnMessage status = loadPositionFile(fileUrl);
+                    PositionsProvider* positionsProvider;
+                    if(createPositionProviderForSession(fileUrl,positionsProvider) == OK){
+                        fileLoading.url = fileUrl;
+                        filesLoading.append(fileLoading);
+                        loader.add(positionsProvider,fileUrl);
+                    }
+                }
+            }
+
+            loader.start();
+            int fileIndex;
+            int returnStatus;
+            DataProvider* provider;
+            while((provider = loader.next(fileIndex,returnStatus)) != 0L){
+                const SessionFileLoading& fileLoading = filesLoading.at(fileIndex);
+                if(fileLoading.type == SessionFile::CLUSTER){
+                    OpenSaveCreateReturnMessage status = addClusterProviderForSession(fileLoading.url,static_cast<ClustersProvider*>(provider),returnStatus,
+                                                                                      fileLoading.itemColors,fileLoading.modified,loadedClusterFiles.isEmpty());
+                    if(status == OK)
+                        loadedClusterFiles.append(lastLoadedProvider);
+                }
+                if(fileLoading.type == SessionFile::EVENT){
+                    OpenSaveCreateReturnMessage status = addEventProviderForSession(fileLoading.url,static_cast<EventsProvider*>(provider),returnStatus,
+                                                                                    fileLoading.itemColors,fileLoading.modified,loadedEventFiles.isEmpty());
+                    if(status == OK){
+                        loadedEventFiles.append(lastLoadedProvider);
+                        QMap<EventDescription,int> loadedItems;
+                        QMap<EventDescription,QColor>::ConstIterator it;
+                        QMap<EventDescription,QColor>::ConstIterator endColor(fileLoading.itemColors.constEnd());
+                        int index = 1;
+                        for(it = fileLoading.itemColors.constBegin(); it != endColor; ++it){
+                            loadedItems.insert(it.key(),index);
+                            index++;
+                        }
+                        loadedEventItems.insert(lastLoadedProvider,loadedItems);
+                    }
+                }
+                if(fileLoading.type == SessionFile::POSITION){
+                    OpenSaveCreateReturnMessage status = addPositionProviderForSession(fileLoading.url,static_cast<PositionsProvider*>(provider),returnStatus);
                     if(status == OK){
                         loadedPositionFile = lastLoadedProvider;
                         if(!backgroundImage.isEmpty() || (backgroundImage.isEmpty() && drawPositionsOnBackground))
@@ -2221,8 +2271,19 @@ NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadNevClusterFile(con
 }
 
 NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadCluClusterFile(const QString &clusterUrl,NeuroscopeView* activeView){
+    ClustersProvider* clustersProvider;
+    OpenSaveCreateReturnMessage status = createClusterProvider(clusterUrl,clustersProvider);
+    if(status != OK)
+        return status;
+    return addClusterProvider(clusterUrl,clustersProvider,clustersProvider->loadData(),activeView);
+}
+
+NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::createClusterProvider(const QString &clusterUrl,ClustersProvider*& clustersProvider){
+    if(clusterUrl.indexOf(".clu") == -1)
+        return INCORRECT_FILE;
+
     // Open file with appropiate provider
-    ClustersProvider* clustersProvider = new ClustersProvider(clusterUrl,datSamplingRate,samplingRate,tracesProvider->getTotalNbSamples(),clusterPosition);
+    clustersProvider = new ClustersProvider(clusterUrl,datSamplingRate,samplingRate,tracesProvider->getTotalNbSamples(),clusterPosition);
     QString name = clustersProvider->getName();
 
     //The name should only contains digits
@@ -2236,7 +2297,18 @@ NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadCluClusterFile(con
         return ALREADY_OPENED;
     }
 
-    int returnStatus = clustersProvider->loadData();
+    return OK;
+}
+
+NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::addClusterProvider(const QString &clusterUrl,ClustersProvider* clustersProvider,int returnStatus,NeuroscopeView* activeView){
+    QString name = clustersProvider->getName();
+
+    //Another file with the same name may have been loaded in the meantime.
+    if(providers.contains(name) && qobject_cast<ClustersProvider*>(providers[name])){
+        delete clustersProvider;
+        return ALREADY_OPENED;
+    }
+
     if(returnStatus == ClustersProvider::OPEN_ERROR){
         delete clustersProvider;
         return OPEN_ERROR;
@@ -2291,7 +2363,7 @@ NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadCluClusterFile(con
     return OK;
 }
 
-NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadClusterFileForSession(const QString &clusterUrl, QMap<EventDescription,QColor>& itemColors, const QDateTime &lastModified, bool firstFile){
+NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::createClusterProviderForSession(const QString &clusterUrl,const QDateTime &lastModified,ClustersProvider*& clustersProvider,bool& modified){
     //Check that the selected file is a cluster file (should always be the case as the file has
     //already be loaded once).
     QString fileName = clusterUrl;
@@ -2315,11 +2387,10 @@ NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadClusterFileForSess
     }
 
 
-    bool modified = false;
     //check if the file has been modified since the last session.
-    if(fileInfo.lastModified() != lastModified) modified = true;
+    modified = (fileInfo.lastModified() != lastModified);
 
-    ClustersProvider* clustersProvider = new ClustersProvider(clusterUrl,datSamplingRate,samplingRate,tracesProvider->getTotalNbSamples(),clusterPosition);
+    clustersProvider = new ClustersProvider(clusterUrl,datSamplingRate,samplingRate,tracesProvider->getTotalNbSamples(),clusterPosition);
     QString name = clustersProvider->getName();
 
     //The name should only contains digits
@@ -2331,7 +2402,12 @@ NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadClusterFileForSess
         return INCORRECT_FILE;
     }
 
-    int returnStatus = clustersProvider->loadData();
+    return OK;
+}
+
+NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::addClusterProviderForSession(const QString &clusterUrl,ClustersProvider* clustersProvider,int returnStatus,const QMap<EventDescription,QColor>& itemColors,bool modified,bool firstFile){
+    QString name = clustersProvider->getName();
+
     if(returnStatus == ClustersProvider::OPEN_ERROR){
         delete clustersProvider;
         QApplication::restoreOverrideCursor();
@@ -2445,9 +2521,16 @@ void NeuroscopeDoc::setClusterPosition(int position){
 }
 
 NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadEventFile(const QString &eventUrl, NeuroscopeView*activeView){
+    EventsProvider* eventsProvider;
+    OpenSaveCreateReturnMessage status = createEventProvider(eventUrl,eventsProvider);
+    if(status != OK)
+        return status;
+    return addEventProvider(eventUrl,eventsProvider,eventsProvider->loadData(),activeView);
+}
+
+NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::createEventProvider(const QString &eventUrl,EventsProvider*& eventsProvider){
     //Check that the selected file is a event file
     QString fileName = eventUrl;
-    EventsProvider* eventsProvider(NULL);
     if(fileName.indexOf(".nev") != -1) {
         eventsProvider = new NEVEventsProvider(eventUrl, eventPosition);
     } else if(fileName.indexOf(".evt") != -1){
@@ -2468,7 +2551,18 @@ NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadEventFile(const QS
         return ALREADY_OPENED;
     }
 
-    int returnStatus = eventsProvider->loadData();
+    return OK;
+}
+
+NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::addEventProvider(const QString &eventUrl,EventsProvider* eventsProvider,int returnStatus,NeuroscopeView* activeView){
+    QString name = eventsProvider->getName();
+
+    //Another file with the same name may have been loaded in the meantime.
+    if(providers.contains(name) && qobject_cast<EventsProvider*>(providers[name])){
+        delete eventsProvider;
+        return ALREADY_OPENED;
+    }
+
     if(returnStatus == EventsProvider::OPEN_ERROR){
         delete eventsProvider;
         return OPEN_ERROR;
@@ -2519,7 +2613,7 @@ NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadEventFile(const QS
     return OK;
 }
 
-NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadEventFileForSession(const QString &eventUrl,QMap<EventDescription,QColor>& itemColors, const QDateTime& lastModified,bool firstFile){
+NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::createEventProviderForSession(const QString &eventUrl,const QDateTime &lastModified,EventsProvider*& eventsProvider,bool& modified){
     //Check that the selected file is a event file (should always be the case as the file has
     //already be loaded once).
     QString fileName = eventUrl;
@@ -2540,10 +2634,10 @@ NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadEventFileForSessio
         return OPEN_ERROR;
     }
 
-    bool modified = false;
-    if(fileInfo.lastModified() != lastModified) modified = true;
+    //check if the file has been modified since the last session.
+    modified = (fileInfo.lastModified() != lastModified);
 
-    EventsProvider* eventsProvider = new EventsProvider(eventUrl,samplingRate,eventPosition);
+    eventsProvider = new EventsProvider(eventUrl,samplingRate,eventPosition);
     QString name = eventsProvider->getName();
 
     //The name should be of 3 characters length with at least one none digit character.
@@ -2555,7 +2649,11 @@ NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadEventFileForSessio
         return INCORRECT_FILE;
     }
 
-    int returnStatus = eventsProvider->loadData();
+    return OK;
+}
+
+NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::addEventProviderForSession(const QString &eventUrl,EventsProvider* eventsProvider,int returnStatus,const QMap<EventDescription,QColor>& itemColors,bool modified,bool firstFile){
+    QString name = eventsProvider->getName();
 
     if(returnStatus == EventsProvider::OPEN_ERROR){
         delete eventsProvider;
@@ -2663,6 +2761,12 @@ void NeuroscopeDoc::setEventPosition(int position){
     }
 }
 
+void NeuroscopeDoc::setTraceCacheSize(int megabytes){
+    traceCacheSize = megabytes;
+    if(tracesProvider != 0L)
+        tracesProvider->setCacheSize(megabytes);
+}
+
 void NeuroscopeDoc::eventModified(const QString& providerName,int selectedEventId,double time,double newTime,NeuroscopeView* activeView){
     //clear the undo/redo data of all the event providers except providerName
     QHashIterator<QString, DataProvider*> i(providers);
@@ -3026,7 +3130,7 @@ NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadPositionFile(const
     return OK;
 }
 
-NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadPositionFile(const QString& fileUrl) {
+NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::createPositionProviderForSession(const QString& fileUrl,PositionsProvider*& positionsProvider) {
     //get the sampling rate for the given position file extension, if there is none already set, use the default
     QString positionUrl = fileUrl;
     QString positionFileName = positionUrl;
@@ -3048,10 +3152,13 @@ NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::loadPositionFile(const
     if(extensionSamplingRates.contains(positionFileExtension)) videoSamplingRate = extensionSamplingRates[positionFileExtension];
     else extensionSamplingRates.insert(positionFileExtension,videoSamplingRate);
 
-    PositionsProvider* positionsProvider = new PositionsProvider(fileUrl,videoSamplingRate,videoWidth,videoHeight,rotation,flip);
+    positionsProvider = new PositionsProvider(fileUrl,videoSamplingRate,videoWidth,videoHeight,rotation,flip);
+    return OK;
+}
+
+NeuroscopeDoc::OpenSaveCreateReturnMessage NeuroscopeDoc::addPositionProviderForSession(const QString& fileUrl,PositionsProvider* positionsProvider,int returnStatus) {
     QString name = positionsProvider->getName();
 
-    int returnStatus = positionsProvider->loadData();
     if(returnStatus == PositionsProvider::OPEN_ERROR){
         delete positionsProvider;
         return OPEN_ERROR;
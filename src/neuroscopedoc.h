@@ -45,6 +45,8 @@ class TracesProvider;
 class NeuroscopeXmlReader;
 class ItemColors;
 class ItemPalette;
+class ClustersProvider;
+class PositionsProvider;
 
 /**
   * The NeuroscopeDoc class provides a document object that can be used in conjunction with the classes
@@ -480,15 +482,46 @@ public:
     OpenSaveCreateReturnMessage loadNevClusterFile(const QString &clusterUrl,NeuroscopeView* activeView);
     OpenSaveCreateReturnMessage loadCluClusterFile(const QString &clusterUrl,NeuroscopeView* activeView);
 
+    /**Creates the provider of the cluster file (.clu) identified by @p clusterUrl, without loading its data
+    * (see ProviderLoader).
+    * @param clusterUrl url of the cluster file to load.
+    * @param clustersProvider set to the new provider if the returned status is OK.
+    * @return an OpenSaveCreateReturnMessage enum giving the creation status.
+    */
+    OpenSaveCreateReturnMessage createClusterProvider(const QString &clusterUrl,ClustersProvider*& clustersProvider);
 
-    /**Loads the cluster file store in the session file and identified by @p clusterUrl.
+    /**Adds the cluster provider created by createClusterProvider to the document once its data are loaded,
+    * the provider being deleted if its data could not be loaded.
+    * @param clusterUrl url of the cluster file.
+    * @param clustersProvider the provider.
+    * @param returnStatus the status returned by the loadData function of the provider.
+    * @param activeView the view in which the change has to be immediate.
+    * @return an OpenSaveCreateReturnMessage enum giving the load status.
+    */
+    OpenSaveCreateReturnMessage addClusterProvider(const QString &clusterUrl,ClustersProvider* clustersProvider,int returnStatus,NeuroscopeView* activeView);
+
+    /**Creates the provider of the cluster file store in the session file and identified by @p clusterUrl,
+    * without loading its data.
     * @param clusterUrl url of the cluster file to load.
-    * @param itemColors a map given the colors for the clusters contained in the file.
     * @param lastModified the date of last modification of the file store in the session file.
+    * @param clustersProvider set to the new provider if the returned status is OK.
+    * @param modified set to true if the file has been modified since the session file was saved.
+    * @return an OpenSaveCreateReturnMessage enum giving the creation status.
+    */
+    OpenSaveCreateReturnMessage createClusterProviderForSession(const QString &clusterUrl,const QDateTime &lastModified,ClustersProvider*& clustersProvider,bool& modified);
+
+    /**Adds the cluster provider created by createClusterProviderForSession once its data are loaded,
+    * the provider being deleted if its data could not be loaded.
+    * @param clusterUrl url of the cluster file.
+    * @param clustersProvider the provider.
+    * @param returnStatus the status returned by the loadData function of the provider.
+    * @param itemColors a map given the colors for the clusters contained in the file.
+    * @param modified true if the file has been modified since the session file was saved.
     * @param firstFile true if the file to load if the first one, false otherwise.
     * @return an OpenSaveCreateReturnMessage enum giving the load status.
     */
-    OpenSaveCreateReturnMessage loadClusterFileForSession(const QString &clusterUrl,QMap<EventDescription,QColor>& itemColors,const QDateTime &lastModified,bool firstFile);
+    OpenSaveCreateReturnMessage addClusterProviderForSession(const QString &clusterUrl,ClustersProvider* clustersProvider,int returnStatus,
+                                                             const QMap<EventDescription,QColor>& itemColors,bool modified,bool firstFile);
 
 
     /**Loads the position file and creates the position view in the current display.
@@ -498,11 +531,21 @@ public:
     */
     OpenSaveCreateReturnMessage loadPositionFile(const QString &url,NeuroscopeView*activeView);
 
-    /**Loads the position file.
+    /**Creates the provider of the position file store in the session file, without loading its data.
     * @param filePath path of the file to be opened.
+    * @param positionsProvider set to the new provider if the returned status is OK.
+    * @return an OpenSaveCreateReturnMessage enum giving the creation status.
+    */
+    OpenSaveCreateReturnMessage createPositionProviderForSession(const QString &filePath,PositionsProvider*& positionsProvider);
+
+    /**Adds the position provider created by createPositionProviderForSession once its data are loaded,
+    * the provider being deleted if its data could not be loaded.
+    * @param filePath path of the file.
+    * @param positionsProvider the provider.
+    * @param returnStatus the status returned by the loadData function of the provider.
     * @return an OpenSaveCreateReturnMessage enum giving the load status.
     */
-    OpenSaveCreateReturnMessage loadPositionFile(const QString &filePath);
+    OpenSaveCreateReturnMessage addPositionProviderForSession(const QString &filePath,PositionsProvider* positionsProvider,int returnStatus);
 
     /**Removes the cluster provider corresponding to the identifier @p providerName
     * from the list of providers.
@@ -518,14 +561,46 @@ public:
     */
     OpenSaveCreateReturnMessage loadEventFile(const QString &eventUrl,NeuroscopeView* activeView);
 
-    /**Loads the event file store in the session file and identified by @p eventUrl.
+    /**Creates the provider of the event file identified by @p eventUrl, without loading its data
+    * (see ProviderLoader).
+    * @param eventUrl url of the event file to load.
+    * @param eventsProvider set to the new provider if the returned status is OK.
+    * @return an OpenSaveCreateReturnMessage enum giving the creation status.
+    */
+    OpenSaveCreateReturnMessage createEventProvider(const QString &eventUrl,EventsProvider*& eventsProvider);
+
+    /**Adds the event provider created by createEventProvider to the document once its data are loaded,
+    * the provider being deleted if its data could not be loaded.
+    * @param eventUrl url of the event file.
+    * @param eventsProvider the provider.
+    * @param returnStatus the status returned by the loadData function of the provider.
+    * @param activeView the view in which the change has to be immediate.
+    * @return an OpenSaveCreateReturnMessage enum giving the load status.
+    */
+    OpenSaveCreateReturnMessage addEventProvider(const QString &eventUrl,EventsProvider* eventsProvider,int returnStatus,NeuroscopeView* activeView);
+
+    /**Creates the provider of the event file store in the session file and identified by @p eventUrl,
+    * without loading its data.
     * @param eventUrl url of the event file to load.
-    * @param itemColors a map given the colors for the events contained in the file.
     * @param lastModified the date of last modification of the file store in the session file.
+    * @param eventsProvider set to the new provider if the returned status is OK.
+    * @param modified set to true if the file has been modified since the session file was saved.
+    * @return an OpenSaveCreateReturnMessage enum giving the creation status.
+    */
+    OpenSaveCreateReturnMessage createEventProviderForSession(const QString &eventUrl,const QDateTime &lastModified,EventsProvider*& eventsProvider,bool& modified);
+
+    /**Adds the event provider created by createEventProviderForSession once its data are loaded,
+    * the provider being deleted if its data could not be loaded.
+    * @param eventUrl url of the event file.
+    * @param eventsProvider the provider.
+    * @param returnStatus the status returned by the loadData function of the provider.
+    * @param itemColors a map given the colors for the events contained in the file.
+    * @param modified true if the file has been modified since the session file was saved.
     * @param firstFile true if the file to load if the first one, false otherwise.
     * @return an OpenSaveCreateReturnMessage enum giving the load status.
     */
-    OpenSaveCreateReturnMessage loadEventFileForSession(const QString &eventUrl,QMap<EventDescription,QColor>& itemColors,const QDateTime &lastModified,bool firstFile);
+    OpenSaveCreateReturnMessage addEventProviderForSession(const QString &eventUrl,EventsProvider* eventsProvider,int returnStatus,
+                                                           const QMap<EventDescription,QColor>& itemColors,bool modified,bool firstFile);
 
     /**Removes the event provider corresponding to the identifier @p providerName
     * from the list of providers.
@@ -576,6 +651,11 @@ public:
     /**Sets the cluster position in percentage from the begining of the window where the clusters are display when browsing.*/
     void setClusterPosition(int position);
 
+    /**Sets the memory budget of the cache of decoded traces shared by all the displays.
+    * @param megabytes maximum amount of memory used by the cache, in megabytes, 0 to disable the cache.
+    */
+    void setTraceCacheSize(int megabytes);
+
     /**Informs that an event has been modified.
     * @param providerName name use to identified the event provider containing the modified event.
     * @param selectedEventId id of the modified event.
@@ -1011,6 +1091,9 @@ private:
     /**Represents the cluster position, in percentage from the begining of the window, where the clusters are display when browsing.*/
     int clusterPosition;
 
+    /**Memory budget, in megabytes, of the cache of decoded traces shared by all the displays.*/
+    int traceCacheSize;
+
     /**Stores the name of the event provider which will provide the data for the next undo/redo action.*/
     QString undoRedoProviderName;
 
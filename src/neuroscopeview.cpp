@@ -40,6 +40,7 @@ NeuroscopeView::NeuroscopeView(NeuroscopeApp& mainWindow, const QString &label,
     DockArea(parent)
   ,shownChannels(channelsToDisplay),mainWindow(mainWindow),greyScaleMode(greyScale),
     multiColumns(multiColumns),verticalLines(verticalLines),raster(raster),waveforms(waveforms),selectMode(false),autocenterChannels(autocenterChannels),
+    decimationMode(TracesDecimation::MIN_MAX),frameTimingsShown(false),
     channelOffsets(),gains(),selectedChannels(),tabLabel(label),startTime(startTime),timeWindow(duration),
     labelsDisplay(labelsDisplay),isPositionFileShown(false),positionView(0L),eventsInPositionView(false), positionsDockWidget(0){
 
@@ -106,6 +107,7 @@ NeuroscopeView::NeuroscopeView(NeuroscopeApp& mainWindow, const QString &label,
     connect(this,SIGNAL(reset()),traceWidget,SLOT(reset()));
     connect(traceWidget,SIGNAL(updateStartAndDuration(long,long)),this, SLOT(setStartAndDuration(long,long)));
     connect(this,SIGNAL(autocenterChannelsChanged(bool)),traceWidget, SLOT(setAutocenterChannels(bool)));
+    connect(this,SIGNAL(decimationModeChanged(TracesDecimation::Mode)),traceWidget, SLOT(setDecimationMode(TracesDecimation::Mode)));
     connect(this,SIGNAL(showLabels(bool)),traceWidget, SLOT(showLabels(bool)));
     connect(this,SIGNAL(displayCalibration(bool,bool)),traceWidget, SLOT(showCalibration(bool,bool)));
     connect(this,SIGNAL(newSamplingRate(qlonglong)),traceWidget,SLOT(samplingRateModified(qlonglong)));
@@ -548,6 +550,12 @@ void NeuroscopeView::setAutocenterChannels(bool status)
     emit autocenterChannelsChanged(status);
 }
 
+void NeuroscopeView::setDecimationMode(TracesDecimation::Mode mode)
+{
+    decimationMode = mode;
+    emit decimationModeChanged(mode);
+}
+
 void NeuroscopeView::showLabelsUpdate(bool status)
 {
     labelsDisplay = status;
@@ -327,6 +327,27 @@ public:
    */
     const bool getAutocenterChannels() const{return autocenterChannels;}
 
+    /** Returns the reduction of the samples to the pixel columns of the traces.
+   * @return the reduction used by the display.
+   */
+    TracesDecimation::Mode getDecimationMode() const{return decimationMode;}
+
+    /** Shows or hides the timings of the frames drawn by the trace view.
+   * @param show true if the timings have to be shown, false otherwise.
+   */
+    void showFrameTimings(bool show){
+        frameTimingsShown = show;
+        traceWidget->showFrameTimings(show);
+    }
+
+    /** Returns true if the timings of the frames are shown, false otherwise.*/
+    bool isFrameTimingsShown() const{return frameTimingsShown;}
+
+    /** Writes the timings of the last frames drawn by the trace view as comma separated values in the file @p fileName.
+   * @return true if the file could be written, false otherwise.
+   */
+    bool exportFrameTimings(const QString& fileName) const{return traceWidget->exportFrameTimings(fileName);}
+
     /** Returns the list containing the offset for each channel.
    * @return the list of the offsets.
    */
@@ -372,6 +393,11 @@ public:
   */
     void setAutocenterChannels(bool status);
 
+    /**Changes the reduction of the samples to the pixel columns of the traces, see TracesDecimation.
+  * @param mode the new reduction.
+  */
+    void setDecimationMode(TracesDecimation::Mode mode);
+
     /**Displays or hides the labels next to the traces.
   * @param status true if the labels have to be drawn, false otherwise.
   */
@@ -738,6 +764,7 @@ Q_SIGNALS:
     void drawTraces();
     void reset();
     void autocenterChannelsChanged(bool status);
+    void decimationModeChanged(TracesDecimation::Mode mode);
     void showLabels(bool show);
     void displayCalibration(bool show,bool active);
     void newClusterProvider(ClustersProvider* clustersProvider,QString name,ItemColors* clusterColors,bool active,
@@ -813,6 +840,12 @@ private:
     /**Whether channels should be centered around their offset.*/
     bool autocenterChannels;
 
+    /**Reduction of the samples to the pixel columns of the traces.*/
+    TracesDecimation::Mode decimationMode;
+
+    /**True if the timings of the frames are shown.*/
+    bool frameTimingsShown;
+
     /**List containing the offset for each channel.*/
     QList<int> channelOffsets;
 
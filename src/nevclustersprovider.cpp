@@ -16,9 +16,9 @@
 #include "nevclustersprovider.h"
 
 #include <QMap>
+#include <QVector>
 
-NEVClustersProvider::NEVClustersProvider(unsigned int channel,Array<dataType>& data,
-                                         int spikeCount,
+NEVClustersProvider::NEVClustersProvider(unsigned int channel,const SpikeColumns& data,
                                          double samplingRate,
                                          double currentSamplingRate,
                                          dataType fileMaxTime,
@@ -32,24 +32,19 @@ NEVClustersProvider::NEVClustersProvider(unsigned int channel,Array<dataType>& d
     // Override base clase settings
     // TODO: Clean up base clases so this is no longer required.
     this->name = QString::number(channel + 1);
-    this->nbSpikes = spikeCount;
-    this->clusters.setSize(2, spikeCount);
 
-    // Copy data to internal structure
-    clusters.copySubset(data, this->nbSpikes);
+    // Share the data, no copy is made
+    this->spikes = data;
+    this->nbSpikes = spikes.size();
 
-    // Determine list of unique cluster
-    for(int i = 1; i <= this->nbSpikes; i++) {
-        if(!clusterIds.contains(clusters(1, i)))
-            clusterIds << clusters(1, i);
-    }
+    // List of unique cluster
+    clusterIds = spikes.clusterIdList();
     this->nbClusters = clusterIds.size();
+    indexSpikes();
 
     //Initialize the variables
     this->previousStartTime = 0;
-    this->previousStartIndex = 1;
-    this->previousEndIndex = this->nbSpikes;
-    this->previousEndTime = (clusters(2, this->nbSpikes) * 1000.0 / samplingRate) + 0.5;
+    this->previousEndTime = (spikes.lastTime() * 1000.0 / samplingRate) + 0.5;
     this->fileMaxTime = this->previousEndTime;
 }
 
@@ -123,13 +118,7 @@ QList<NEVClustersProvider*> NEVClustersProvider::fromFile(const QString& fileUrl
     // Prepare data structure
     int channelCount = channelLabels.size();
 
-    QList<long> spikeCount;
-    // Array copy constructor is broken, so we have to use pointers.
-    QList<Array<dataType>*> data;
-    for(int i = 0; i < channelCount; i++) {
-        data << new Array<dataType>(2, eventCount);
-        spikeCount << 0;
-    }
+    QVector<SpikeColumns> data(channelCount);
 
     // Read data packages
     NEVDataHeader dataHeader;
@@ -149,10 +138,9 @@ QList<NEVClustersProvider*> NEVClustersProvider::fromFile(const QString& fileUrl
             // Check if we are interested in spikes on this channel.
             int index = channelIds.indexOf(dataHeader.id);
             if(index != -1) {
-                // We are interested, so copy spike info;
-                spikeCount[index]++;
-                (*data[index])(1, spikeCount[index]) = spikeData.unit_class;
-                (*data[index])(2, spikeCount[index]) = dataHeader.timestamp;
+                // We are interested, so store spike info;
+                if(!data[index].append(spikeData.unit_class, dataHeader.timestamp))
+                    return result;
             }
 
             // Skip the rest of the data
@@ -172,19 +160,14 @@ QList<NEVClustersProvider*> NEVClustersProvider::fromFile(const QString& fileUrl
 
     // Create provider objects
     for(int i = 0; i < channelCount; i++) {
+        data[i].finish();
         result.append(new NEVClustersProvider(i,
-                                              *data[i],
-                                              spikeCount[i],
+                                              data[i],
                                               samplingRate,
                                               currentSamplingRate,
                                               fileMaxTime,
                                               position));
     }
 
-    // Array copy constructor is broken, so we have to use pointers.
-    for(int i = 0; i < channelCount; i++) {
-        delete data[i];
-    }
-
     return result;
 }
@@ -40,8 +40,7 @@ public:
 
 private:
     NEVClustersProvider(unsigned int channel,
-                        Array<dataType>& data,
-                        int spikeCount,
+                        const SpikeColumns& data,
                         double samplingRate,
                         double currentSamplingRate,
                         dataType fileMaxTime,
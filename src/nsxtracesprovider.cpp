@@ -14,19 +14,73 @@
  ***************************************************************************/
 
 #include "nsxtracesprovider.h"
+#include "tracesconversion.h"
 
 #include <QFile>
+#include <QFileInfo>
+#include <QVector>
 #include <stdint.h>
+#include <string.h>
 
+namespace {
+
+// Header byte of the data packets.
+const uint8_t NSX_DATA_PACKET = 0x01;
+
+// Number of samples gathered at once when only some of the channels are retrieved.
+const qint64 GATHER_BLOCK_SIZE = 4096;
+
+// Conversion of a block of samples into uV, the values being written in place in the final array.
+class ConversionJob : public TracesConversion::BlockJob {
+public:
+    ConversionJob(const int16_t* samples, int nbChannels, const QList<int>& channels, const TracesConversion::ChannelScaling* scalings, dataType* data)
+        : samples(samples), nbChannels(nbChannels), channels(channels), scalings(scalings), data(data) {}
+
+    void run(qint64 first, qint64 nbSamples) const {
+        const int16_t* blockSamples = samples + first * nbChannels;
+
+        // All the channels are converted in place
+        if(channels.isEmpty()) {
+            TracesConversion::affine(blockSamples, data + first * nbChannels, nbSamples, nbChannels, scalings);
+            return;
+        }
+
+        // Keep only the requested channels, one column per channel, a block at a time
+        int nbColumns = channels.size();
+        dataType* blockData = data + first * nbColumns;
+        QVector<int16_t> block(qMin(GATHER_BLOCK_SIZE, nbSamples) * nbColumns);
+        for(qint64 gatheredFirst = 0; gatheredFirst < nbSamples; gatheredFirst += GATHER_BLOCK_SIZE) {
+            qint64 nbGatheredSamples = qMin(GATHER_BLOCK_SIZE, nbSamples - gatheredFirst);
+            for(qint64 i = 0; i < nbGatheredSamples; i++) {
+                const int16_t* sample = blockSamples + (gatheredFirst + i) * nbChannels;
+                int16_t* selected = block.data() + i * nbColumns;
+                for(int column = 0; column < nbColumns; column++)
+                    selected[column] = sample[channels.at(column)];
+            }
+            TracesConversion::affine(block.constData(), blockData + gatheredFirst * nbColumns, nbGatheredSamples, nbColumns, scalings);
+        }
+    }
+
+private:
+    const int16_t* samples;
+    int nbChannels;
+    const QList<int>& channels;
+    const TracesConversion::ChannelScaling* scalings;
+    dataType* data;
+};
+
+}
 
 const int NSXTracesProvider::NSX_RESOLUTION = 16;
 const int NSXTracesProvider::NSX_OFFSET = 0;
 
 NSXTracesProvider::NSXTracesProvider(const QString &fileName)
-    : TracesProvider(fileName, -1, NSX_RESOLUTION, 0, 0, 0, NSX_OFFSET), mInitialized(false), mExtensionHeaders(NULL), mDataFilePos(-1) {
+    : TracesProvider(fileName, -1, NSX_RESOLUTION, 0, 0, 0, NSX_OFFSET), mExtensionHeaders(NULL), mFirstPacketPos(0), mIndexedSize(0), mNbSamples(0), mInitialized(false) {
 }
 
 NSXTracesProvider::~NSXTracesProvider() {
+    // The prefetching thread may still be decoding with readData, which is about to vanish.
+    stopPrefetching();
     if(mInitialized)
         delete[] mExtensionHeaders;
 }
@@ -63,16 +117,37 @@ bool NSXTracesProvider::init() {
         }
     }
 
-    // Read data header
-    if(!readStruct<NSXDataHeader>(dataFile, mDataHeader)) {
+    // Compute the transform of each channel to uV once and for all
+    mScalings.resize(this->nbChannels);
+    for(int channel = 0; channel < this->nbChannels; channel++) {
+        const NSXExtensionHeader& header = mExtensionHeaders[channel];
+        TracesConversion::ChannelScaling& scaling = mScalings[channel];
+
+        // Determine unit data is saved in, the channels in an unknown unit can not be read
+        if(!strncmp(header.unit, "uV", 16)) {
+            scaling.unit = 1;
+        } else if(!strncmp(header.unit, "mV", 16)) {
+            scaling.unit = 1000;
+        } else {
+            qDebug() << "unknown unit: " << QString::fromLatin1(header.unit, qstrnlen(header.unit, 16));
+            scaling.unit = 0;
+        }
+
+        scaling.minDigital = header.min_digital_value;
+        scaling.rangeDigital = header.max_digital_value - header.min_digital_value;
+        scaling.minAnalog = header.min_analog_value;
+        scaling.rangeAnalog = header.max_analog_value - header.min_analog_value;
+    }
+
+    // Index all the data packets
+    mFirstPacketPos = dataFile.pos();
+    if(!indexSegments(dataFile, mFirstPacketPos)) {
         delete[] mExtensionHeaders;
+        mExtensionHeaders = NULL;
         dataFile.close();
         return false;
     }
 
-    // Save beginning of data block
-    mDataFilePos = dataFile.pos();
-
     // Close file and update recording length
     dataFile.close();
     mInitialized = true;
@@ -80,10 +155,54 @@ bool NSXTracesProvider::init() {
     return true;
 }
 
+bool NSXTracesProvider::indexSegments(QFile& dataFile, qint64 filePos) {
+    mSegments.clear();
+    mNbSamples = 0;
+
+    qint64 fileSize = dataFile.size();
+    mIndexedSize = fileSize;
+    qint64 sampleSize = this->nbChannels * sizeof(int16_t);
+    double timestampsToSamples = (mBasicHeader.time_resolution == 0) ? 1.0 : this->samplingRate / mBasicHeader.time_resolution;
+
+    while(filePos + static_cast<qint64>(sizeof(NSXDataHeader)) <= fileSize) {
+        NSXDataHeader dataHeader;
+        if(!dataFile.seek(filePos) || !readStruct<NSXDataHeader>(dataFile, dataHeader))
+            break;
+        if(dataHeader.header != NSX_DATA_PACKET) {
+            qDebug() << "unexpected data packet header at " << filePos;
+            break;
+        }
+
+        // A packet still being written (or cut short) holds less samples than announced
+        Segment segment;
+        segment.filePos = filePos + sizeof(NSXDataHeader);
+        qint64 nbAvailableSamples = (sampleSize == 0) ? 0 : (fileSize - segment.filePos) / sampleSize;
+        segment.nbSamples = qMin(static_cast<qint64>(dataHeader.length), nbAvailableSamples);
+        if(dataHeader.length == 0)
+            segment.nbSamples = nbAvailableSamples;
+
+        // The packets are positioned with their timestamps, the pauses being filled with zeros.
+        // A packet starting before the end of the previous one is appended to it.
+        segment.firstSample = static_cast<qint64>(dataHeader.timestamp * timestampsToSamples + 0.5);
+        segment.firstSample = qMax(segment.firstSample, mNbSamples);
+
+        if(segment.nbSamples > 0) {
+            mSegments.append(segment);
+            mNbSamples = segment.firstSample + segment.nbSamples;
+        }
+
+        filePos = segment.filePos + segment.nbSamples * sampleSize;
+        if(segment.nbSamples < dataHeader.length)
+            break;
+    }
+
+    return !mSegments.isEmpty();
+}
+
 long NSXTracesProvider::getNbSamples(long start, long end, long startInRecordingUnits) {
     // Check if startInRecordingUnits was supplied, else compute it.
     if(startInRecordingUnits == 0)
-        startInRecordingUnits = this->samplingRate * start / 1000.0;
+        startInRecordingUnits = timeToRecordingUnits(start);
 
     // The caller should have check that we do not go over the end of the file.
     // The recording starts at time equals 0 and ends at length of the file minus one.
@@ -93,90 +212,111 @@ long NSXTracesProvider::getNbSamples(long start, long end, long startInRecording
     return endInRecordingUnits - startInRecordingUnits;
 }
 
-void NSXTracesProvider::retrieveData(long start, long end, QObject* initiator, long startInRecordingUnits) {
-    Array<dataType> data;
+bool NSXTracesProvider::readData(long start, long end, long startInRecordingUnits, const QList<int>& channels, Array<dataType>& data) {
 
     if(!mInitialized) {
         qDebug() << "no init!";
-        emit dataReady(data,initiator);
-        return;
-    }
-
-    QFile dataFile(this->fileName);
-    if(!dataFile.open(QIODevice::ReadOnly)) {
-        qDebug() << "cant open!";
-        emit dataReady(data,initiator);
-        return;
+        return false;
     }
 
     // Check if startInRecordingUnits was supplied, else compute it.
     if(startInRecordingUnits == 0)
-        startInRecordingUnits = this->samplingRate * start / 1000.0;
-
-    long fileOffset = startInRecordingUnits * this->nbChannels * sizeof(int16_t);
+        startInRecordingUnits = timeToRecordingUnits(start);
 
     // The caller should have check that we do not go over the end of the file.
     // The recording starts at time equals 0 and ends at length of the file minus one.
     // Therefore the sample at endInRecordingUnits is never returned.
     long endInRecordingUnits = (this->samplingRate * end / 1000.0);
 
-    long lengthInRecordingUnits = endInRecordingUnits - startInRecordingUnits;
+    long lengthInRecordingUnits = qMax(endInRecordingUnits - startInRecordingUnits, 0L);
 
-    // Jump to position to read (skipping headers)
-    if(!dataFile.seek(mDataFilePos + fileOffset)) {
-        qDebug() << "cant skip!";
-        dataFile.close();
-        emit dataReady(data,initiator);
-        return;
+    // Scalings of the retrieved channels, one per column
+    int nbColumns = channels.isEmpty() ? this->nbChannels : channels.size();
+    QVector<TracesConversion::ChannelScaling> columnScalings;
+    if(!channels.isEmpty()) {
+        columnScalings.resize(nbColumns);
+        for(int column = 0; column < nbColumns; column++)
+            columnScalings[column] = mScalings.at(channels.at(column));
+    }
+    const QVector<TracesConversion::ChannelScaling>& scalings = channels.isEmpty() ? mScalings : columnScalings;
+    for(int column = 0; column < nbColumns; column++) {
+        if(scalings.at(column).unit == 0) {
+            data.setSize(0, 0);
+            return false;
+        }
     }
 
-    // Allocate buffer
-    Array<int16_t> buffer(lengthInRecordingUnits, this->nbChannels);
-
-    // Read data
-    qint64 bytesToRead = lengthInRecordingUnits * this->nbChannels * sizeof(int16_t);
-    qint64 bytesRead = dataFile.read(reinterpret_cast<char*>(&buffer[0]), bytesToRead);
+    data.setSize(lengthInRecordingUnits, nbColumns);
+    if(lengthInRecordingUnits == 0)
+        return true;
 
-    if(bytesToRead != bytesRead) {
-        qDebug() << "cant read " << bytesRead  << " not " << bytesToRead;
-        dataFile.close();
-        emit dataReady(data,initiator);
-        return;
+    // The samples are converted straight from the memory mapping, the file is read only if it could not be mapped
+    bool mapped = mapDataFile();
+    QFile dataFile;
+    QVector<int16_t> buffer;
+    if(!mapped) {
+        dataFile.setFileName(this->fileName);
+        if(!dataFile.open(QIODevice::ReadOnly)) {
+            qDebug() << "cant open!";
+            data.setSize(0, 0);
+            return false;
+        }
     }
-    dataFile.close();
 
-    // Copy data to dataType array after translating them to uV
-    data.setSize(lengthInRecordingUnits, this->nbChannels);
-    for(int channel = 0; channel < this->nbChannels; channel++) {
-        // Determine unit data is saved in
-        int unit_correction = 0;
-        if(!strncmp(mExtensionHeaders[channel].unit, "uV", 16)) {
-            unit_correction = 1;
-        } else if(!strncmp(mExtensionHeaders[channel].unit, "mV", 16)) {
-            unit_correction = 1000;
-        } else {
-            qDebug() << "unknown unit: " << mExtensionHeaders[channel].unit;
-            dataFile.close();
-            data.setSize(0, 0);
-            emit dataReady(data, initiator);
-            return;
+    qint64 sampleSize = this->nbChannels * sizeof(int16_t);
+    qint64 endSample = startInRecordingUnits + lengthInRecordingUnits;
+    qint64 position = startInRecordingUnits;
+    for(int i = 0; i < mSegments.size() && position < endSample; i++) {
+        const Segment& segment = mSegments.at(i);
+        qint64 segmentEnd = segment.firstSample + segment.nbSamples;
+        if(segmentEnd <= position)
+            continue;
+
+        // Pause before the packet
+        qint64 gapEnd = qMin(segment.firstSample, endSample);
+        if(position < gapEnd) {
+            memset(&data[(position - startInRecordingUnits) * nbColumns], 0, (gapEnd - position) * nbColumns * sizeof(dataType));
+            position = gapEnd;
         }
 
-        // Get all the values needed to translate measurement unit to uV
-        int min_digital =  mExtensionHeaders[channel].min_digital_value;
-        int range_digital =  mExtensionHeaders[channel].max_digital_value - min_digital;
-        int min_analog =  mExtensionHeaders[channel].min_analog_value;
-        int range_analog =  mExtensionHeaders[channel].max_analog_value - min_analog;
+        qint64 nbSamples = qMin(segmentEnd, endSample) - position;
+        if(nbSamples <= 0)
+            continue;
 
-        // Convert data
-        for(int i = 1; i <= lengthInRecordingUnits; i++) {
-            data(i, channel + 1) = static_cast<dataType>((((static_cast<double>(buffer(i, channel + 1)) - min_digital) / range_digital) * range_analog + min_analog) * unit_correction);
+        qint64 filePos = segment.filePos + (position - segment.firstSample) * sampleSize;
+        const int16_t* samples;
+        if(mapped && filePos + nbSamples * sampleSize <= mappedSize) {
+            samples = reinterpret_cast<const int16_t*>(mappedData + filePos);
+        } else {
+            if(!dataFile.isOpen()) {
+                dataFile.setFileName(this->fileName);
+                dataFile.open(QIODevice::ReadOnly);
+            }
+            buffer.resize(nbSamples * this->nbChannels);
+            qint64 bytesToRead = nbSamples * sampleSize;
+            if(!dataFile.seek(filePos) || dataFile.read(reinterpret_cast<char*>(buffer.data()), bytesToRead) != bytesToRead) {
+                qDebug() << "cant read " << bytesToRead << " bytes at " << filePos;
+                data.setSize(0, 0);
+                return false;
+            }
+            samples = buffer.constData();
         }
 
+        convertSamples(samples, nbSamples, channels, scalings.constData(), &data[(position - startInRecordingUnits) * nbColumns]);
+        position += nbSamples;
     }
 
-    //Send the information to the receiver.
-    emit dataReady(data, initiator);
+    // Past the last packet
+    if(position < endSample)
+        memset(&data[(position - startInRecordingUnits) * nbColumns], 0, (endSample - position) * nbColumns * sizeof(dataType));
+
+    return true;
+}
+
+void NSXTracesProvider::convertSamples(const int16_t* samples, qint64 nbSamples, const QList<int>& channels, const TracesConversion::ChannelScaling* scalings, dataType* data) {
+    // Large windows are split between the conversion threads
+    ConversionJob job(samples, this->nbChannels, channels, scalings, data);
+    TracesConversion::forEachBlock(nbSamples, this->nbChannels, job);
 }
 
 void NSXTracesProvider::computeRecordingLength(){
@@ -186,7 +326,23 @@ void NSXTracesProvider::computeRecordingLength(){
         return;
     }
 
-    this->length = (1000.0 * mDataHeader.length) / this->samplingRate;
+    // The file has grown (recording in progress): index the packets again, the last one may have been extended
+    QFileInfo fileInfo(this->fileName);
+    if(fileInfo.size() != mIndexedSize) {
+        QFile dataFile(this->fileName);
+        if(dataFile.open(QIODevice::ReadOnly))
+            indexSegments(dataFile, mFirstPacketPos);
+
+        // The current mapping does not cover the new data, the file will be mapped again on the next read
+        unmapDataFile();
+        mappingUnavailable = false;
+    }
+
+    this->length = (1000.0 * mNbSamples) / this->samplingRate;
+}
+
+long NSXTracesProvider::timeToRecordingUnits(long startTime) const {
+    return static_cast<long>(this->samplingRate * startTime / 1000.0);
 }
 
 QStringList NSXTracesProvider::getLabels() {
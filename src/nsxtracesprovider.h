@@ -21,9 +21,11 @@
 #include "array.h"
 #include "types.h"
 #include "blackrock.h"
+#include "tracesconversion.h"
 
 // include files for QT
 #include <QObject>
+#include <QVector>
 #include <QtDebug>
 
 /** Class providing the row recorded data (contained in a .nsx file).
@@ -87,41 +89,78 @@ public:
     */
     virtual long getNbSamples(long start, long end, long startInRecordingUnits);
 
+    /**Returns the index of the first sample retrieved for a time frame starting at @p startTime.
+    * @param startTime begining of the time frame, given in milisecond.
+    */
+    virtual long timeToRecordingUnits(long startTime) const;
+
     /** Return the labels of each channel as read from nsx file. */
     virtual QStringList getLabels();
 
-Q_SIGNALS:
-    /**Signals that the data have been retrieved.
-    * @param data array of data in uV (number of channels X number of samples).
-    * @param initiator instance requesting the data.
-    */
-    void dataReady(Array<dataType>& data,QObject* initiator);
-
 private:
     static const int NSX_RESOLUTION;
     static const int NSX_OFFSET;
 
+    /**Data packet of the file. A recording paused and resumed is stored in several packets,
+    * each one starting with the timestamp of its first sample.
+    */
+    struct Segment {
+        // Position of the first sample in the recording, given in recording units.
+        qint64 firstSample;
+        // Number of samples per channel.
+        qint64 nbSamples;
+        // Position of the first sample in the file, given in bytes.
+        qint64 filePos;
+    };
+
     // Headers that are parsed from the file to open
     NSXBasicHeader mBasicHeader;
     NSXExtensionHeader* mExtensionHeaders;
-    NSXDataHeader mDataHeader;
 
-    // Start of first sample in first data package.
-    long mDataFilePos;
+    // Position of the first data packet in the file.
+    qint64 mFirstPacketPos;
+
+    // Size of the file when its data packets were indexed.
+    qint64 mIndexedSize;
+
+    // Data packets sorted by first sample, they do not overlap.
+    QVector<Segment> mSegments;
+
+    // Number of samples in the recording, gaps between packets included.
+    qint64 mNbSamples;
+
+    // Transform of each channel from digital values to uV, the unit is 0 if it is unknown.
+    QVector<TracesConversion::ChannelScaling> mScalings;
+
     bool mInitialized;
 
     //Functions
 
-    /**Retrieves the traces included in the time frame given by @p startTime and @p endTime.
+    /**Decodes the traces included in the time frame given by @p startTime and @p endTime into @p data.
     * @param startTime begining of the time frame from which to retrieve the data, given in milisecond.
     * @param endTime end of the time frame from which to retrieve the data, given in milisecond.
-    * @param initiator instance requesting the data.
     * @param startTimeInRecordingUnits begining of the time interval from which to retrieve the data in recording units.
+    * @param channels ids of the channels to retrieve, all the channels if empty.
+    * @param data array filled with the data in uV (number of samples X number of retrieved channels).
+    * @return true if the data could be read, false otherwise.
     */
-    virtual void retrieveData(long startTime, long endTime, QObject* initiator, long startTimeInRecordingUnits);
+    virtual bool readData(long startTime, long endTime, long startTimeInRecordingUnits, const QList<int>& channels, Array<dataType>& data);
 
     /**Computes the total length of the document in miliseconds.*/
     virtual void computeRecordingLength();
+
+    /**Indexes the data packets following the headers, starting at @p filePos.
+    * @return false if no data packet could be found.
+    */
+    bool indexSegments(QFile& dataFile, qint64 filePos);
+
+    /**Converts @p nbSamples samples of all the channels starting at @p samples into uV,
+    * keeping only the channels @p channels (all the channels if empty). Large windows are converted in parallel.
+    */
+    void convertSamples(const int16_t* samples, qint64 nbSamples, const QList<int>& channels, const TracesConversion::ChannelScaling* scalings, dataType* data);
+
+    /**The samples follow the nsx headers and are scaled per channel, the overview is not built.*/
+    virtual bool supportsPyramid() const { return false; }
 };
 
 #endif
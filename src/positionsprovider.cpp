@@ -16,8 +16,8 @@
  ***************************************************************************/
 //include files for the application
 #include "positionsprovider.h"
+#include "textparser.h"
 #include "timer.h"
-#include "utilities.h"
 
 // include files for QT
 #include <QStringList>
@@ -47,79 +47,36 @@ void PositionsProvider::requestData(long startTime,long endTime,QObject* initiat
 
 int PositionsProvider::loadData(){
 
-    //Get the number of positions
-    nbPositions = Utilities::getNbLines(fileName);
-    
-    if(nbPositions == -1){
+    RestartTimer();
+
+    //Parse the positions, they are counted in the same pass.
+    TextParser parser(TextParser::NUMBERS);
+    if(!parser.open(fileName)){
         positions.setSize(0,0);
-        return COUNT_ERROR;
+        return OPEN_ERROR;
     }
+    nbPositions = parser.nbLines();
 
     if(nbPositions == 0){
         positions.setSize(0,0);
         return OK;
     }
 
-    //Create a reader on the eventFile
-    QFile positionFile(fileName);
-    bool status = positionFile.open(QIODevice::ReadOnly);
-    if(!status){
+    //Set the size of the Arrays containing the positions using the first line.
+    nbCoordinates = parser.nbValuesOnFirstLine();
+
+    //The number of values read has to be coherent with the number of positions.
+    if(parser.nbValues() != static_cast<qint64>(nbPositions) * nbCoordinates){
         positions.setSize(0,0);
-        return OPEN_ERROR;
+        return INCORRECT_CONTENT;
     }
 
-    RestartTimer();
-
-    QString firstLine;
-
-    QByteArray buf;
-    buf.resize(255);
-    int ret=positionFile.readLine(buf.data(), 255);
-    firstLine = QString::fromLatin1(buf, ret);
-
-
-    //Set the size of the Arrays containing the positions using the first line.
-    firstLine = firstLine.simplified();
-    QStringList lineParts = firstLine.split(QLatin1String(" "), QString::SkipEmptyParts);
-    nbCoordinates = lineParts.count();
-    dataType k = nbCoordinates;
+    //The precision is lost
     positions.setSize(nbPositions,nbCoordinates);
-    for(int i = 0;i<nbCoordinates;++i){
-        positions(i+1,1) = static_cast<dataType>(floor(0.5 + lineParts[i].toDouble()));
-    }
-
-
-    QByteArray buffer = positionFile.readAll();
-    uint size = buffer.size();
-
-    //The buffer is read and each dataType is build char by char into a string. When the char read
-    //is not [1-9],e or + (<=> blank space or a new line), the string is converted into a dataType and store
-    //into positions.
-    //string of character which will contains the current seek dataType
-    int l = 0;
-    char clusterID[255];
-    for(uint i = 0 ; i < size ; ++i){
-        if(buffer[i] >= '0' && buffer[i] <= '9' || buffer[i] == 'e'| buffer[i] == 'E' || buffer[i] == '+' || buffer[i] == '-' || buffer[i] == '.')
-            clusterID[l++] = buffer[i];
-        else if(l){
-            clusterID[l] = '\0';
-            double pos = atof(clusterID);
-            //The precision is lost
-            positions[k++] = static_cast<dataType>(floor(0.5 + pos));//Warning if the typedef dataType changes, change will have to be make here.
-            l = 0;
-        }
-    }
+    parser.read(0,parser.nbValues(),&positions[0]);
 
-    positionFile.close();
     qDebug() << "Loading pos file into memory: "<<Timer() << endl;
 
-
-    //The number of positions read has to be coherent with the number of positions read.
-    if(k != nbPositions*nbCoordinates){
-        positions.setSize(0,0);
-        return INCORRECT_CONTENT;
-    }
-
     return OK;
 }
 
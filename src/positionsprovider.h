@@ -67,7 +67,7 @@ public:
     /**Loads the positions.
   * @return an loadReturnMessage enum giving the load status
   */
-    int loadData();
+    virtual int loadData();
 
     /**Returns the name of the provider which is the position file name.
   * @return provider'name.
@@ -87,6 +87,8 @@ PrefDialog::PrefDialog(QWidget *parent)
     connect(prefGeneral->eventPositionSpinBox,SIGNAL(valueChanged(int)),this,SLOT(enableApply()));
     connect(prefGeneral->clusterPositionSpinBox,SIGNAL(valueChanged(int)),this,SLOT(enableApply()));
     connect(prefGeneral->useWhiteColorPrinting,SIGNAL(clicked()),this,SLOT(enableApply()));
+    connect(prefGeneral->traceCacheSpinBox,SIGNAL(valueChanged(int)),this,SLOT(enableApply()));
+    connect(prefGeneral->traceRasterizerCheckBox,SIGNAL(clicked()),this,SLOT(enableApply()));
     connect(prefDefaults->screenGainLineEdit,SIGNAL(textChanged(QString)),this,SLOT(enableApply()));
     connect(prefDefaults->voltageRangeLineEdit,SIGNAL(textChanged(QString)),this,SLOT(enableApply()));
     connect(prefDefaults->amplificationLineEdit,SIGNAL(textChanged(QString)),this,SLOT(enableApply()));
@@ -127,6 +129,8 @@ void PrefDialog::updateDialog() {
     prefGeneral->setPaletteHeaders(configuration().isPaletteHeadersDisplayed());
     prefGeneral->setEventPosition(configuration().getEventPosition());
     prefGeneral->setClusterPosition(configuration().getClusterPosition());
+    prefGeneral->setTraceCacheSize(configuration().getTraceCacheSize());
+    prefGeneral->setTraceRasterizer(configuration().getTraceRasterizer());
     prefDefaults->setScreenGain(configuration().getScreenGain());
     prefDefaults->setVoltageRange(configuration().getVoltageRange());
     prefDefaults->setAmplification(configuration().getAmplification());
@@ -158,6 +162,8 @@ void PrefDialog::updateConfiguration(){
     configuration().setPaletteHeaders(prefGeneral->isPaletteHeadersDisplayed());
     configuration().setEventPosition(prefGeneral->getEventPosition());
     configuration().setClusterPosition(prefGeneral->getClusterPosition());
+    configuration().setTraceCacheSize(prefGeneral->getTraceCacheSize());
+    configuration().setTraceRasterizer(prefGeneral->isTraceRasterizer());
     configuration().setScreenGain(prefDefaults->getScreenGain());
     configuration().setVoltageRange(prefDefaults->getVoltageRange());
     configuration().setAmplification(prefDefaults->getAmplification());
@@ -190,6 +196,8 @@ void PrefDialog::slotDefault() {
         prefGeneral->setPaletteHeaders(configuration().isPaletteHeadersDisplayedDefault());
         prefGeneral->setEventPosition(configuration().getEventPositionDefault());
         prefGeneral->setClusterPosition(configuration().getClusterPositionDefault());
+        prefGeneral->setTraceCacheSize(configuration().getTraceCacheSizeDefault());
+        prefGeneral->setTraceRasterizer(configuration().getTraceRasterizerDefault());
         prefGeneral->setUseWhiteColorDuringPrinting(configuration().getUseWhiteColorDuringPrinting());
 
         prefDefaults->setScreenGain(configuration().getScreenGainDefault());
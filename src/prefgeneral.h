@@ -62,6 +62,12 @@ public:
     /**Sets the cluster position in percentage from the begining of the window where the clusters are display when browsing.*/
     void setClusterPosition(int position){clusterPositionSpinBox->setValue(position);}
 
+    /**Sets the memory budget, in megabytes, of the cache of decoded traces.*/
+    void setTraceCacheSize(int size){traceCacheSpinBox->setValue(size);}
+
+    /**Sets whether the traces are drawn with the fast rasterizer.*/
+    void setTraceRasterizer(bool rasterizer){traceRasterizerCheckBox->setChecked(rasterizer);}
+
     /**Returns the background color.*/
     QColor getBackgroundColor() const{
         return backgroundColorButton->color();
@@ -76,6 +82,12 @@ public:
     /**Returns the cluster position in percentage from the begining of the window where the clusters are display when browsing.*/
     int getClusterPosition()const{return clusterPositionSpinBox->value();}
 
+    /**Returns the memory budget, in megabytes, of the cache of decoded traces.*/
+    int getTraceCacheSize()const{return traceCacheSpinBox->value();}
+
+    /**Returns true if the traces are drawn with the fast rasterizer, false otherwise.*/
+    bool isTraceRasterizer()const{return traceRasterizerCheckBox->isChecked();}
+
     bool useWhiteColorDuringPrinting() const;
 
     void setUseWhiteColorDuringPrinting(bool b);
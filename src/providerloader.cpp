@@ -0,0 +1,136 @@
+/***************************************************************************
+                          providerloader.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+//include files for the application
+#include "providerloader.h"
+#include "dataprovider.h"
+
+// include files for QT
+#include <QRunnable>
+#include <QProgressDialog>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QMetaObject>
+
+/**Loads the data of a provider on a thread of the pool and reports the status to the GUI thread.*/
+class ProviderLoader::LoadJob : public QRunnable {
+public:
+    LoadJob(ProviderLoader& loader,DataProvider* provider,int index):loader(loader),provider(provider),index(index){}
+
+    void run(){
+        //The provider is not touched once the loading has been canceled, it is about to be deleted.
+        int status = -1;
+        if(loader.canceled.fetchAndAddOrdered(0) == 0)
+            status = provider->loadData();
+        QMetaObject::invokeMethod(&loader,"loaded",Qt::QueuedConnection,Q_ARG(int,index),Q_ARG(int,status));
+    }
+
+private:
+    ProviderLoader& loader;
+    DataProvider* provider;
+    int index;
+};
+
+ProviderLoader::ProviderLoader(QWidget* parent,const QString& label):
+    nbLoaded(0),nbReturned(0),canceled(0),waiting(0L){
+    progress = new QProgressDialog(label,tr("Cancel"),0,0,parent);
+    //The dialog is shown at once: until it is, the actions of the main window could close the document being loaded.
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(0);
+    progress->setAutoReset(false);
+    connect(progress,SIGNAL(canceled()),this,SLOT(cancel()));
+}
+
+ProviderLoader::~ProviderLoader(){
+    canceled.fetchAndStoreOrdered(1);
+    pool.waitForDone();
+    qDeleteAll(providers);
+    delete progress;
+}
+
+int ProviderLoader::add(DataProvider* provider,const QString& fileName){
+    providers.append(provider);
+    fileNames.append(QFileInfo(fileName).fileName());
+    return providers.size() - 1;
+}
+
+void ProviderLoader::start(){
+    progress->setMaximum(providers.size());
+    progress->setValue(0);
+    if(!providers.isEmpty())
+        progress->show();
+    for(int i = 0; i < providers.size(); ++i)
+        pool.start(new LoadJob(*this,providers.at(i),i));
+}
+
+DataProvider* ProviderLoader::next(int& index,int& status){
+    forever{
+        //The providers are returned in the order in which they have been added, whatever the order in which they are loaded.
+        for(int i = 0; i < results.size(); ++i){
+            if(results.at(i).first != nbReturned)
+                continue;
+            index = results.at(i).first;
+            status = results.at(i).second;
+            results.removeAt(i);
+            ++nbReturned;
+            DataProvider* provider = providers.at(index);
+            providers[index] = 0L;
+            return provider;
+        }
+        if(wasCanceled() || nbReturned == providers.size()){
+            progress->reset();
+            return 0L;
+        }
+
+        QEventLoop loop;
+        waiting = &loop;
+        loop.exec();
+        waiting = 0L;
+    }
+}
+
+bool ProviderLoader::wasCanceled() const{
+    return canceled.fetchAndAddOrdered(0) != 0;
+}
+
+void ProviderLoader::cancel(){
+    canceled.fetchAndStoreOrdered(1);
+    //The providers still loading are deleted by loaded, once they are done.
+    while(!results.isEmpty()){
+        const int index = results.dequeue().first;
+        delete providers.at(index);
+        providers[index] = 0L;
+    }
+    if(waiting != 0L)
+        waiting->quit();
+}
+
+void ProviderLoader::loaded(int index,int status){
+    ++nbLoaded;
+    if(wasCanceled()){
+        delete providers.at(index);
+        providers[index] = 0L;
+    }
+    else{
+        results.enqueue(qMakePair(index,status));
+        progress->setLabelText(tr("%1 loaded (%2 of %3 files).").arg(fileNames.at(index)).arg(nbLoaded).arg(providers.size()));
+        progress->setValue(nbLoaded);
+        if(nbLoaded == providers.size())
+            progress->reset();
+    }
+    if(waiting != 0L)
+        waiting->quit();
+}
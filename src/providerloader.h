@@ -0,0 +1,106 @@
+/***************************************************************************
+                          providerloader.h  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PROVIDERLOADER_H
+#define PROVIDERLOADER_H
+
+// include files for QT
+#include <QObject>
+#include <QList>
+#include <QStringList>
+#include <QQueue>
+#include <QPair>
+#include <QThreadPool>
+#include <QAtomicInt>
+
+class DataProvider;
+class QWidget;
+class QProgressDialog;
+class QEventLoop;
+
+/**
+  * Loads the data of several providers (cluster, event and position files) concurrently, in a pool of threads,
+  * while a progress dialog lets the user follow and cancel the loading.
+  *
+  * The providers are created and checked on the GUI thread, only their loadData function runs on the pool.
+  * The caller gets them back one by one with next, in the order in which they have been added, each one as soon as
+  * it and the ones added before are loaded: while it waits, the events of the application are processed, so the
+  * providers already returned can be shown and the main window repaints. The progress dialog is window modal and
+  * shown at once, no other file can be opened in the meantime.
+  *@author the Neurosuite developers
+  */
+class ProviderLoader : public QObject {
+    Q_OBJECT
+public:
+    /**Constructor.
+  * @param parent the window over which the progress dialog is shown.
+  * @param label text of the progress dialog.
+  */
+    ProviderLoader(QWidget* parent,const QString& label);
+
+    /**Cancels the loadings which have not started yet, waits for the others and deletes the providers
+  * which have not been returned by next.*/
+    ~ProviderLoader();
+
+    /**Adds @p provider, which now belongs to the loader, to the providers to load.
+  * @param provider provider whose data have not been loaded yet.
+  * @param fileName name of the file of the provider, shown in the progress dialog.
+  * @return the index identifying the provider in next.
+  */
+    int add(DataProvider* provider,const QString& fileName);
+
+    /**Starts loading all the providers added.*/
+    void start();
+
+    /**Waits for the next provider, in the order of add, to be loaded.
+  * @param index set to the index of the provider, as returned by add.
+  * @param status set to the value returned by the loadData function of the provider.
+  * @return the provider, which then belongs to the caller, or 0 once all the providers have been returned or
+  * the loading has been canceled.
+  */
+    DataProvider* next(int& index,int& status);
+
+    /**Returns true if the user has canceled the loading.*/
+    bool wasCanceled() const;
+
+public Q_SLOTS:
+    /**Cancels the loading: the providers which have not been returned by next yet are dropped.*/
+    void cancel();
+
+private Q_SLOTS:
+    /**Called on the GUI thread when the provider @p index has been loaded with the status @p status.*/
+    void loaded(int index,int status);
+
+private:
+    class LoadJob;
+
+    QThreadPool pool;
+    /**Providers which have not been returned by next yet, the other entries are null.*/
+    QList<DataProvider*> providers;
+    QStringList fileNames;
+    /**Index and status of the providers loaded but not returned by next yet.*/
+    QQueue<QPair<int,int> > results;
+    int nbLoaded;
+    /**Number of providers returned by next, which is also the index of the next one to return.*/
+    int nbReturned;
+    /**Read by the threads of the pool, set on the GUI thread.*/
+    mutable QAtomicInt canceled;
+    QProgressDialog* progress;
+    /**Event loop run by next while it waits for a provider.*/
+    QEventLoop* waiting;
+};
+
+#endif
@@ -0,0 +1,201 @@
+/***************************************************************************
+                          spikecolumns.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+//include files for the application
+#include "spikecolumns.h"
+
+// include c/c++ headers
+#include <algorithm>
+#include <limits>
+
+/**Number of different cluster ids which can be stored as a rank on 16 bits.*/
+static const int MAX_CLUSTERS = 65536;
+/**The ranks of the ids below this value are looked up in a table while the spikes are appended.*/
+static const int MAX_TABULATED_IDS = 65536;
+/**A QVector can not hold more than 2GB.*/
+static const long MAX_SPIKES = (std::numeric_limits<int>::max() - 1024) / static_cast<long>(sizeof(quint32));
+/**Bits of a time shared by the spikes of an epoch.*/
+static const qint64 EPOCH_BITS = ~Q_INT64_C(0xFFFFFFFF);
+
+SpikeColumns::SpikeColumns(){
+}
+
+void SpikeColumns::reserve(long nbSpikes){
+    const int capacity = static_cast<int>(qMin(nbSpikes,MAX_SPIKES));
+    lowTimes.reserve(capacity);
+    ranks.reserve(capacity);
+}
+
+bool SpikeColumns::append(dataType id,dataType time){
+    if(size() >= MAX_SPIKES)
+        return false;
+
+    const int clusterId = static_cast<int>(id);
+    const bool tabulated = (id >= 0 && id < MAX_TABULATED_IDS);
+    int rank = -1;
+    if(tabulated){
+        if(tabulatedRanks.isEmpty())
+            tabulatedRanks.fill(-1,MAX_TABULATED_IDS);
+        rank = tabulatedRanks.at(clusterId);
+    }
+    else{
+        QMap<int,int>::const_iterator found = otherRanks.constFind(clusterId);
+        if(found != otherRanks.constEnd())
+            rank = found.value();
+    }
+    if(rank < 0){
+        if(ids.size() == MAX_CLUSTERS)
+            return false;
+        rank = ids.size();
+        ids.append(clusterId);
+        if(tabulated)
+            tabulatedRanks[clusterId] = rank;
+        else
+            otherRanks.insert(clusterId,rank);
+    }
+
+    const qint64 base = static_cast<qint64>(time) & EPOCH_BITS;
+    if(epochBases.isEmpty() || epochBases.last() != base){
+        epochStarts.append(size());
+        epochBases.append(base);
+    }
+    lowTimes.append(static_cast<quint32>(static_cast<qint64>(time) - base));
+    ranks.append(static_cast<quint16>(rank));
+    return true;
+}
+
+void SpikeColumns::finish(){
+    //The ranks have been given in the order of appearance of the ids, they are replaced by the ranks of the sorted ids.
+    QVector<int> sortedIds(ids);
+    std::sort(sortedIds.begin(),sortedIds.end());
+    if(sortedIds != ids){
+        QVector<quint16> sortedRanks(ids.size());
+        for(int i = 0; i < ids.size(); ++i)
+            sortedRanks[i] = static_cast<quint16>(std::lower_bound(sortedIds.constBegin(),sortedIds.constEnd(),ids.at(i)) - sortedIds.constBegin());
+        quint16* rank = ranks.data();
+        const quint16* sortedRank = sortedRanks.constData();
+        for(long i = 0; i < size(); ++i)
+            rank[i] = sortedRank[rank[i]];
+        ids = sortedIds;
+    }
+
+    lowTimes.squeeze();
+    ranks.squeeze();
+    tabulatedRanks = QVector<int>();
+    otherRanks.clear();
+}
+
+bool SpikeColumns::setColumns(const QVector<quint32>& newLowTimes,const QVector<quint16>& newRanks,const QVector<qint64>& newEpochStarts,
+                              const QVector<qint64>& newEpochBases,const QVector<int>& newIds){
+    clear();
+    const int nbSpikes = newRanks.size();
+    if(newLowTimes.size() != nbSpikes || newEpochStarts.size() != newEpochBases.size() || newIds.size() > MAX_CLUSTERS)
+        return false;
+    if(nbSpikes == 0 ? !newEpochStarts.isEmpty() : (newEpochStarts.isEmpty() || newEpochStarts.first() != 0 || newEpochStarts.last() >= nbSpikes))
+        return false;
+    for(int i = 1; i < newEpochStarts.size(); ++i)
+        if(newEpochStarts.at(i) <= newEpochStarts.at(i - 1) || newEpochBases.at(i) <= newEpochBases.at(i - 1))
+            return false;
+    for(int i = 1; i < newIds.size(); ++i)
+        if(newIds.at(i) <= newIds.at(i - 1))
+            return false;
+    const quint16* rank = newRanks.constData();
+    for(int i = 0; i < nbSpikes; ++i)
+        if(rank[i] >= newIds.size())
+            return false;
+
+    lowTimes = newLowTimes;
+    ranks = newRanks;
+    epochStarts = newEpochStarts;
+    epochBases = newEpochBases;
+    ids = newIds;
+    return true;
+}
+
+void SpikeColumns::clear(){
+    lowTimes = QVector<quint32>();
+    ranks = QVector<quint16>();
+    epochStarts.clear();
+    epochBases.clear();
+    ids.clear();
+    tabulatedRanks = QVector<int>();
+    otherRanks.clear();
+}
+
+int SpikeColumns::epoch(long index) const{
+    if(epochStarts.size() == 1)
+        return 0;
+    return static_cast<int>(std::upper_bound(epochStarts.constBegin(),epochStarts.constEnd(),static_cast<qint64>(index)) - epochStarts.constBegin()) - 1;
+}
+
+int SpikeColumns::findEpoch(dataType time,bool& exact) const{
+    const qint64 base = static_cast<qint64>(time) & EPOCH_BITS;
+    const int found = static_cast<int>(std::lower_bound(epochBases.constBegin(),epochBases.constEnd(),base) - epochBases.constBegin());
+    exact = (found < epochBases.size() && epochBases.at(found) == base);
+    return found;
+}
+
+dataType SpikeColumns::time(long index) const{
+    return static_cast<dataType>(epochBases.at(epoch(index)) + lowTimes.at(static_cast<int>(index)));
+}
+
+int SpikeColumns::rankOf(int id) const{
+    const int* position = std::lower_bound(ids.constBegin(),ids.constEnd(),id);
+    return (position != ids.constEnd() && *position == id) ? static_cast<int>(position - ids.constBegin()) : -1;
+}
+
+long SpikeColumns::lowerBound(dataType time) const{
+    bool exact;
+    const int found = findEpoch(time,exact);
+    if(found == epochBases.size())
+        return size();
+    if(!exact)
+        return static_cast<long>(epochStarts.at(found));
+    const quint32 low = static_cast<quint32>(static_cast<qint64>(time) - epochBases.at(found));
+    const quint32* column = lowTimes.constData();
+    return std::lower_bound(column + epochStarts.at(found),column + epochEnd(found),low) - column;
+}
+
+long SpikeColumns::upperBound(dataType time) const{
+    bool exact;
+    const int found = findEpoch(time,exact);
+    if(found == epochBases.size())
+        return size();
+    if(!exact)
+        return static_cast<long>(epochStarts.at(found));
+    const quint32 low = static_cast<quint32>(static_cast<qint64>(time) - epochBases.at(found));
+    const quint32* column = lowTimes.constData();
+    return std::upper_bound(column + epochStarts.at(found),column + epochEnd(found),low) - column;
+}
+
+void SpikeColumns::readTimes(long first,long end,dataType* times) const{
+    if(first >= end)
+        return;
+    const quint32* column = lowTimes.constData();
+    for(int i = epoch(first); first < end; ++i){
+        const long last = qMin(end,epochEnd(i));
+        const qint64 base = epochBases.at(i);
+        for(; first < last; ++first)
+            *times++ = static_cast<dataType>(base + column[first]);
+    }
+}
+
+void SpikeColumns::readIds(long first,long end,dataType* clusterIds) const{
+    const quint16* column = ranks.constData();
+    const int* idOfRank = ids.constData();
+    for(long i = first; i < end; ++i)
+        *clusterIds++ = idOfRank[column[i]];
+}
@@ -0,0 +1,127 @@
+/***************************************************************************
+                          spikecolumns.h  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SPIKECOLUMNS_H
+#define SPIKECOLUMNS_H
+
+//include files for the application
+#include <types.h>
+
+// include files for QT
+#include <QVector>
+#include <QList>
+#include <QMap>
+
+/**
+  * Compact storage of the spikes of a cluster file, sorted by time, in two columns: 6 bytes per spike instead of
+  * the 16 bytes of a 2 line array of dataType.
+  *
+  * The time column holds the low 32 bits of each time, the spikes being split into epochs sharing the same high bits
+  * (a single epoch for any recording shorter than 2^32 samples). The cluster column holds the rank of the cluster id
+  * of each spike in the sorted list of the cluster ids, on 16 bits, so at most 65536 different cluster ids are supported.
+  *
+  * The columns are implicitly shared: the copies of a SpikeColumns, kept by the provider and by its ClusterIndex,
+  * share the same memory as long as none of them is modified, which does not happen once the spikes are loaded.
+  *@author the Neurosuite developers
+  */
+class SpikeColumns {
+public:
+    SpikeColumns();
+
+    /**Reserves the memory for @p nbSpikes spikes, to avoid growing the columns while they are appended.*/
+    void reserve(long nbSpikes);
+
+    /**Appends a spike, the spikes having to be appended in increasing time order.
+  * @return false if the spike can not be stored, its cluster id being the 65537th one or the maximum number
+  * of spikes having been reached.
+  */
+    bool append(dataType id,dataType time);
+
+    /**Sorts the cluster ids once all the spikes have been appended, the spikes can not be appended afterwards.*/
+    void finish();
+
+    /**Sets the columns read back from a ClustersCache sidecar file, see the column functions.
+  * @return false if the columns are not coherent, the SpikeColumns being then empty.
+  */
+    bool setColumns(const QVector<quint32>& lowTimes,const QVector<quint16>& ranks,const QVector<qint64>& epochStarts,
+                    const QVector<qint64>& epochBases,const QVector<int>& ids);
+
+    /**Empties the columns.*/
+    void clear();
+
+    /**Returns the number of spikes.*/
+    inline long size() const{return ranks.size();}
+
+    /**Returns the time of the spike @p index, in recording units.*/
+    dataType time(long index) const;
+
+    /**Returns the time of the last spike, 0 if there is no spike.*/
+    inline dataType lastTime() const{return ranks.isEmpty() ? 0 : time(size() - 1);}
+
+    /**Returns the rank of the cluster id of the spike @p index in clusterIdList.*/
+    inline int clusterRank(long index) const{return ranks.at(static_cast<int>(index));}
+
+    /**Returns the sorted list of the cluster ids used by the spikes.*/
+    inline QList<int> clusterIdList() const{return ids.toList();}
+
+    /**Returns the rank of the cluster @p id in clusterIdList, -1 if no spike belongs to it.*/
+    int rankOf(int id) const;
+
+    /**Returns the index of the first spike at or after @p time, size() if there is none.*/
+    long lowerBound(dataType time) const;
+
+    /**Returns the index of the first spike after @p time, size() if there is none.*/
+    long upperBound(dataType time) const;
+
+    /**Copies the times of the spikes [@p first, @p end[ into @p times.*/
+    void readTimes(long first,long end,dataType* times) const;
+
+    /**Copies the cluster ids of the spikes [@p first, @p end[ into @p clusterIds.*/
+    void readIds(long first,long end,dataType* clusterIds) const;
+
+    /**Columns, as written by ClustersCache: the low 32 bits of the times, the ranks of the cluster ids, the index of
+  * the first spike and the high bits of the times of each epoch, and the sorted cluster ids.*/
+    inline const QVector<quint32>& lowTimeColumn() const{return lowTimes;}
+    inline const QVector<quint16>& rankColumn() const{return ranks;}
+    inline const QVector<qint64>& epochStartList() const{return epochStarts;}
+    inline const QVector<qint64>& epochBaseList() const{return epochBases;}
+    inline const QVector<int>& idList() const{return ids;}
+
+private:
+    QVector<quint32> lowTimes;
+    QVector<quint16> ranks;
+    QVector<qint64> epochStarts;
+    QVector<qint64> epochBases;
+    /**Cluster ids, sorted once finish has been called, in the order of appearance before.*/
+    QVector<int> ids;
+
+    /**Ranks of the ids in the order of appearance while the spikes are appended, the small ids being looked up in a table.*/
+    QVector<int> tabulatedRanks;
+    QMap<int,int> otherRanks;
+
+    /**Returns the epoch of the spike @p index.*/
+    int epoch(long index) const;
+
+    /**Returns the index following the last spike of the epoch @p epoch.*/
+    inline long epochEnd(int epoch) const{return (epoch + 1 < epochStarts.size()) ? static_cast<long>(epochStarts.at(epoch + 1)) : size();}
+
+    /**Returns the epoch holding the times with the high bits of @p time, or the following one if there is none,
+  * and sets @p exact to true in the first case.
+  */
+    int findEpoch(dataType time,bool& exact) const;
+};
+
+#endif
@@ -0,0 +1,365 @@
+/***************************************************************************
+                          textparser.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+//include files for the application
+#include "textparser.h"
+#include "tracesconversion.h"
+
+// include c/c++ headers
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+/**Size of the chunks, a chunk being large enough to be a whole block of TracesConversion::forEachBlock.*/
+const qint64 CHUNK_SIZE = 4 * 1024 * 1024;
+
+/**Powers of ten exactly represented by a double.*/
+const double POWERS_OF_TEN[23] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+                                  1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+
+inline bool isDigit(char c){
+    return c >= '0' && c <= '9';
+}
+
+inline bool isNumberCharacter(char c){
+    return isDigit(c) || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E';
+}
+
+inline bool isBlank(char c){
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+inline bool isTokenCharacter(TextParser::Syntax syntax,char c){
+    return (syntax == TextParser::INTEGERS) ? isDigit(c) : isNumberCharacter(c);
+}
+
+/**Parses the number at the beginning of [@p begin, @p end[ as strtod does in the C locale.
+ * The number is computed exactly when its significant digits and its power of ten are both exactly represented
+ * by a double, which is always the case for the files written by the acquisition and the spike sorting programs.
+ * @return the number of characters of the number, 0 if there is none (@p value is then 0).
+ */
+int parseNumber(const char* begin,const char* end,double& value){
+    const char* p = begin;
+    bool negative = false;
+    if(p < end && (*p == '+' || *p == '-')){
+        negative = (*p == '-');
+        ++p;
+    }
+
+    quint64 mantissa = 0;
+    int nbSignificantDigits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    bool truncated = false;
+    for(; p < end && isDigit(*p); ++p){
+        hasDigits = true;
+        if(nbSignificantDigits < 19){
+            mantissa = mantissa * 10 + (*p - '0');
+            if(mantissa != 0) ++nbSignificantDigits;
+        }
+        else{
+            ++exponent;
+            truncated |= (*p != '0');
+        }
+    }
+    if(p < end && *p == '.'){
+        for(++p; p < end && isDigit(*p); ++p){
+            hasDigits = true;
+            if(nbSignificantDigits < 19){
+                mantissa = mantissa * 10 + (*p - '0');
+                if(mantissa != 0) ++nbSignificantDigits;
+                --exponent;
+            }
+            else truncated |= (*p != '0');
+        }
+    }
+    if(!hasDigits){
+        value = 0;
+        return 0;
+    }
+
+    //The exponent is part of the number only if it has digits.
+    if(p < end && (*p == 'e' || *p == 'E')){
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if(q < end && (*q == '+' || *q == '-')){
+            negativeExponent = (*q == '-');
+            ++q;
+        }
+        if(q < end && isDigit(*q)){
+            int e = 0;
+            for(; q < end && isDigit(*q); ++q)
+                if(e < 100000) e = e * 10 + (*q - '0');
+            exponent += negativeExponent ? -e : e;
+            p = q;
+        }
+    }
+
+    const int length = static_cast<int>(p - begin);
+    if(mantissa == 0 && !truncated)
+        value = 0;
+    else if(!truncated && mantissa <= (Q_UINT64_C(1) << 53) && exponent >= -22 && exponent <= 22){
+        value = static_cast<double>(mantissa);
+        value = (exponent < 0) ? value / POWERS_OF_TEN[-exponent] : value * POWERS_OF_TEN[exponent];
+    }
+    else{
+        value = QByteArray(begin,length).toDouble();
+        return length;
+    }
+    if(negative) value = -value;
+    return length;
+}
+
+inline void convertToken(TextParser::Syntax syntax,const char* begin,const char* end,dataType& value){
+    if(syntax == TextParser::INTEGERS){
+        dataType integer = 0;
+        for(const char* p = begin; p < end; ++p)
+            integer = integer * 10 + (*p - '0');
+        value = integer;
+    }
+    else{
+        double number;
+        parseNumber(begin,end,number);
+        value = static_cast<dataType>(floor(0.5 + number));
+    }
+}
+
+inline void convertToken(TextParser::Syntax syntax,const char* begin,const char* end,double& value){
+    if(syntax == TextParser::INTEGERS){
+        dataType integer;
+        convertToken(syntax,begin,end,integer);
+        value = static_cast<double>(integer);
+    }
+    else parseNumber(begin,end,value);
+}
+
+/**Counts the lines and the values of each chunk.*/
+class CountJob : public TracesConversion::BlockJob{
+public:
+    CountJob(TextParser::Syntax syntax,const char* text,qint64 size,TextParser::Chunk* chunks)
+        :syntax(syntax),text(text),size(size),chunks(chunks){}
+
+    virtual void run(qint64 first,qint64 nbChunks) const{
+        for(qint64 i = first; i < first + nbChunks; ++i){
+            TextParser::Chunk& chunk = chunks[i];
+            const char* end = text + chunk.end;
+            qint64 nbLines = 0;
+            qint64 nbValues = 0;
+            bool inToken = false;
+            for(const char* p = text + chunk.begin; p < end; ++p){
+                const char c = *p;
+                if(c == '\n') ++nbLines;
+                const bool tokenCharacter = isTokenCharacter(syntax,c);
+                if(tokenCharacter && !inToken) ++nbValues;
+                inToken = tokenCharacter;
+            }
+            //The last line may not end with a new line.
+            if(chunk.end == size && text[size - 1] != '\n') ++nbLines;
+            chunk.nbLines = nbLines;
+            chunk.nbValues = (syntax == TextParser::TIMED_LABELS) ? nbLines : nbValues;
+        }
+    }
+
+private:
+    TextParser::Syntax syntax;
+    const char* text;
+    qint64 size;
+    TextParser::Chunk* chunks;
+};
+
+/**Parses the values [firstValue, firstValue + nbValues[ of the chunks into values.*/
+template <typename T>
+class ReadJob : public TracesConversion::BlockJob{
+public:
+    ReadJob(TextParser::Syntax syntax,const char* text,const TextParser::Chunk* chunks,qint64 firstValue,qint64 nbValues,T* values)
+        :syntax(syntax),text(text),chunks(chunks),firstValue(firstValue),lastValue(firstValue + nbValues),values(values){}
+
+    virtual void run(qint64 first,qint64 nbChunks) const{
+        for(qint64 i = first; i < first + nbChunks; ++i){
+            const TextParser::Chunk& chunk = chunks[i];
+            if(chunk.firstValue >= lastValue || chunk.firstValue + chunk.nbValues <= firstValue)
+                continue;
+
+            const char* p = text + chunk.begin;
+            const char* end = text + chunk.end;
+            qint64 index = chunk.firstValue;
+            while(index < lastValue){
+                while(p < end && !isTokenCharacter(syntax,*p)) ++p;
+                if(p == end)
+                    break;
+                const char* tokenEnd = p;
+                while(tokenEnd < end && isTokenCharacter(syntax,*tokenEnd)) ++tokenEnd;
+                if(index >= firstValue)
+                    convertToken(syntax,p,tokenEnd,values[index - firstValue]);
+                ++index;
+                p = tokenEnd;
+            }
+        }
+    }
+
+private:
+    TextParser::Syntax syntax;
+    const char* text;
+    const TextParser::Chunk* chunks;
+    qint64 firstValue;
+    qint64 lastValue;
+    T* values;
+};
+
+/**Parses the time and the label of each line of the chunks.*/
+class TimedLabelsJob : public TracesConversion::BlockJob{
+public:
+    TimedLabelsJob(const char* text,const TextParser::Chunk* chunks,double* times,QString* labels)
+        :text(text),chunks(chunks),times(times),labels(labels){}
+
+    virtual void run(qint64 first,qint64 nbChunks) const{
+        for(qint64 i = first; i < first + nbChunks; ++i){
+            const TextParser::Chunk& chunk = chunks[i];
+            const char* p = text + chunk.begin;
+            const char* end = text + chunk.end;
+            qint64 index = chunk.firstValue;
+            while(p < end){
+                const char* lineEnd = static_cast<const char*>(memchr(p,'\n',end - p));
+                if(lineEnd == 0L)
+                    lineEnd = end;
+                const char* begin = p;
+                const char* last = lineEnd;
+                while(begin < last && isBlank(*begin)) ++begin;
+                while(last > begin && isBlank(last[-1])) --last;
+
+                //The time is the first word, 0 if it is not a number as a whole.
+                const char* timeEnd = begin;
+                while(timeEnd < last && !isBlank(*timeEnd)) ++timeEnd;
+                double time;
+                if(parseNumber(begin,timeEnd,time) != timeEnd - begin)
+                    time = QByteArray(begin,static_cast<int>(timeEnd - begin)).toDouble();
+                const char* label = timeEnd;
+                while(label < last && isBlank(*label)) ++label;
+
+                times[index] = time;
+                labels[index] = QString::fromLocal8Bit(label,static_cast<int>(last - label));
+                ++index;
+                p = lineEnd + 1;
+            }
+        }
+    }
+
+private:
+    const char* text;
+    const TextParser::Chunk* chunks;
+    double* times;
+    QString* labels;
+};
+
+}
+
+TextParser::TextParser(Syntax syntax)
+    :syntax(syntax),text(0L),size(0),mapped(0L),totalLines(0),totalValues(0),firstLineValues(0){
+}
+
+TextParser::~TextParser(){
+    close();
+}
+
+void TextParser::close(){
+    if(mapped != 0L)
+        file.unmap(mapped);
+    mapped = 0L;
+    file.close();
+    buffer.clear();
+    text = 0L;
+    size = 0;
+    chunks.clear();
+    totalLines = 0;
+    totalValues = 0;
+    firstLineValues = 0;
+}
+
+bool TextParser::open(const QString& fileName){
+    close();
+    file.setFileName(fileName);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+    size = file.size();
+    if(size == 0)
+        return true;
+
+    //A file which can not be mapped (on some network file systems for instance) is read.
+    mapped = file.map(0,size);
+    if(mapped != 0L)
+        text = reinterpret_cast<const char*>(mapped);
+    else{
+        buffer = file.readAll();
+        if(buffer.size() != size){
+            close();
+            return false;
+        }
+        text = buffer.constData();
+    }
+
+    //The chunks end after a new line, no value nor line spans two of them.
+    for(qint64 begin = 0; begin < size;){
+        Chunk chunk;
+        chunk.begin = begin;
+        chunk.end = qMin(begin + CHUNK_SIZE,size);
+        if(chunk.end < size){
+            const char* newLine = static_cast<const char*>(memchr(text + chunk.end - 1,'\n',size - chunk.end + 1));
+            chunk.end = (newLine == 0L) ? size : (newLine - text) + 1;
+        }
+        chunk.nbLines = 0;
+        chunk.nbValues = 0;
+        chunk.firstValue = 0;
+        chunks.append(chunk);
+        begin = chunk.end;
+    }
+
+    TracesConversion::forEachBlock(chunks.size(),static_cast<int>(CHUNK_SIZE),CountJob(syntax,text,size,chunks.data()));
+    for(int i = 0; i < chunks.size(); ++i){
+        chunks[i].firstValue = totalValues;
+        totalValues += chunks[i].nbValues;
+        totalLines += chunks[i].nbLines;
+    }
+
+    const char* firstLineEnd = static_cast<const char*>(memchr(text,'\n',size));
+    if(firstLineEnd == 0L)
+        firstLineEnd = text + size;
+    if(syntax == TIMED_LABELS)
+        firstLineValues = 1;
+    else{
+        bool inToken = false;
+        for(const char* p = text; p < firstLineEnd; ++p){
+            const bool tokenCharacter = isTokenCharacter(syntax,*p);
+            if(tokenCharacter && !inToken) ++firstLineValues;
+            inToken = tokenCharacter;
+        }
+    }
+    return true;
+}
+
+void TextParser::read(qint64 first,qint64 nbValues,dataType* values) const{
+    if(nbValues > 0)
+        TracesConversion::forEachBlock(chunks.size(),static_cast<int>(CHUNK_SIZE),ReadJob<dataType>(syntax,text,chunks.constData(),first,nbValues,values));
+}
+
+void TextParser::read(qint64 first,qint64 nbValues,double* values) const{
+    if(nbValues > 0)
+        TracesConversion::forEachBlock(chunks.size(),static_cast<int>(CHUNK_SIZE),ReadJob<double>(syntax,text,chunks.constData(),first,nbValues,values));
+}
+
+void TextParser::readTimedLabels(double* times,QString* labels) const{
+    TracesConversion::forEachBlock(chunks.size(),static_cast<int>(CHUNK_SIZE),TimedLabelsJob(text,chunks.constData(),times,labels));
+}
@@ -0,0 +1,105 @@
+/***************************************************************************
+                          textparser.h  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TEXTPARSER_H
+#define TEXTPARSER_H
+
+//include files for the application
+#include <types.h>
+
+// include files for QT
+#include <QFile>
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/**
+  * Parser of the text files of a session (.res, .clu, .evt, .whl, .pos).
+  *
+  * The file is memory-mapped and split into chunks at line boundaries, which are parsed by the conversion threads
+  * (see TracesConversion::forEachBlock). open counts the lines and the values of each chunk in a first pass, the read
+  * functions then parse the values directly into their destination, each chunk knowing where its first value goes.
+  * The numbers are parsed without any call to the C library, except for the rare ones which can not be converted
+  * exactly with double precision arithmetic.
+  *@author the Neurosuite developers
+  */
+class TextParser {
+public:
+    /**Syntax of the files.
+  * INTEGERS: the values are the runs of digits, any other character separating them (.res and .clu files).
+  * NUMBERS: the values are real numbers, the characters which can not be part of a number separating them (.whl and .pos files).
+  * TIMED_LABELS: each line holds a time followed by a label, separated by blanks (.evt files).
+  */
+    enum Syntax{INTEGERS,NUMBERS,TIMED_LABELS};
+
+    explicit TextParser(Syntax syntax);
+    ~TextParser();
+
+    /**Maps the file @p fileName and counts its lines and values.
+  * @return false if the file can not be read.
+  */
+    bool open(const QString& fileName);
+
+    /**Returns the number of lines, the last one being counted even if it does not end with a new line.*/
+    inline qint64 nbLines() const{return totalLines;}
+
+    /**Returns the number of values, one per line for TIMED_LABELS.*/
+    inline qint64 nbValues() const{return totalValues;}
+
+    /**Returns the number of values of the first line.*/
+    inline int nbValuesOnFirstLine() const{return firstLineValues;}
+
+    /**Parses the values [@p first, @p first + @p nbValues[ into @p values, the real numbers being rounded to the nearest integer.*/
+    void read(qint64 first,qint64 nbValues,dataType* values) const;
+
+    /**Parses the values [@p first, @p first + @p nbValues[ into @p values.*/
+    void read(qint64 first,qint64 nbValues,double* values) const;
+
+    /**Parses all the lines of a TIMED_LABELS file.
+  * @param times the time of each line, 0 if it is not a number.
+  * @param labels the label of each line, without the surrounding blanks.
+  */
+    void readTimedLabels(double* times,QString* labels) const;
+
+    /**Part of the file parsed by a thread, made of whole lines.*/
+    struct Chunk{
+        qint64 begin;
+        qint64 end;
+        qint64 nbLines;
+        qint64 nbValues;
+        /**Index of the first value of the chunk in the whole file.*/
+        qint64 firstValue;
+    };
+
+private:
+    Syntax syntax;
+    QFile file;
+    /**Content of the file, mapped or read if the mapping fails.*/
+    const char* text;
+    qint64 size;
+    uchar* mapped;
+    QByteArray buffer;
+
+    QVector<Chunk> chunks;
+    qint64 totalLines;
+    qint64 totalValues;
+    int firstLineValues;
+
+    /**Releases the content of the file.*/
+    void close();
+};
+
+#endif
@@ -0,0 +1,106 @@
+/***************************************************************************
+                          tracerasterizer.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+//include files for the application
+#include "tracerasterizer.h"
+
+// include files for QT
+#include <QPainter>
+#include <QPaintDevice>
+#include <QPen>
+
+// include c/c++ headers
+#include <math.h>
+#include <string.h>
+
+TraceRasterizer::TraceRasterizer():painter(0L),color(0),left(0),top(0),right(-1),bottom(-1){
+}
+
+bool TraceRasterizer::begin(QPainter& painter){
+    const QPen& pen = painter.pen();
+    if (pen.style() != Qt::SolidLine || !pen.isCosmetic() || pen.widthF() > 1.0 ||
+            pen.color().alpha() != 255 || (painter.renderHints() & QPainter::Antialiasing) ||
+            painter.compositionMode() != QPainter::CompositionMode_SourceOver || painter.device() == 0L)
+        return false;
+
+    //The transform has to keep the vertical lines vertical.
+    transform = painter.combinedTransform();
+    if (transform.type() > QTransform::TxScale)
+        return false;
+
+    //Printers and other vector devices keep the painter.
+    QPaintDevice* device = painter.device();
+    if (device->devType() != QInternal::Pixmap && device->devType() != QInternal::Image)
+        return false;
+    if (image.width() != device->width() || image.height() != device->height()){
+        image = QImage(device->width(),device->height(),QImage::Format_ARGB32_Premultiplied);
+        image.fill(0);
+    }
+    if (image.isNull())
+        return false;
+
+    this->painter = &painter;
+    color = pen.color().rgba();
+    left = image.width();
+    top = image.height();
+    right = -1;
+    bottom = -1;
+    return true;
+}
+
+void TraceRasterizer::addSpan(int x,int y1,int y2){
+    //Pixels containing the end points, in device coordinates.
+    const int deviceX = static_cast<int>(floor(transform.m11() * x + transform.dx()));
+    int deviceY1 = static_cast<int>(floor(transform.m22() * y1 + transform.dy()));
+    int deviceY2 = static_cast<int>(floor(transform.m22() * y2 + transform.dy()));
+    if (deviceY1 > deviceY2)
+        qSwap(deviceY1,deviceY2);
+
+    //The painter clips what is drawn outside of the device, the image has the same size.
+    if (deviceX < 0 || deviceX >= image.width() || deviceY2 < 0 || deviceY1 >= image.height())
+        return;
+    deviceY1 = qMax(deviceY1,0);
+    deviceY2 = qMin(deviceY2,image.height() - 1);
+
+    const int bytesPerLine = image.bytesPerLine();
+    uchar* pixel = image.scanLine(deviceY1) + deviceX * sizeof(QRgb);
+    for (int y = deviceY1; y <= deviceY2; ++y,pixel += bytesPerLine)
+        *reinterpret_cast<QRgb*>(pixel) = color;
+
+    left = qMin(left,deviceX);
+    right = qMax(right,deviceX);
+    top = qMin(top,deviceY1);
+    bottom = qMax(bottom,deviceY2);
+}
+
+void TraceRasterizer::end(){
+    if (painter == 0L)
+        return;
+
+    if (right >= left && bottom >= top){
+        //Draw the painted area in device coordinates, the clipping of the painter still applies.
+        const QRect area(left,top,right - left + 1,bottom - top + 1);
+        painter->save();
+        painter->resetTransform();
+        painter->drawImage(area.topLeft(),image,area);
+        painter->restore();
+
+        //Make the area transparent again for the next trace.
+        for (int y = top; y <= bottom; ++y)
+            memset(image.scanLine(y) + left * sizeof(QRgb),0,area.width() * sizeof(QRgb));
+    }
+    painter = 0L;
+}
@@ -0,0 +1,85 @@
+/***************************************************************************
+                          tracerasterizer.h  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TRACERASTERIZER_H
+#define TRACERASTERIZER_H
+
+// include files for QT
+#include <QImage>
+#include <QTransform>
+#include <QRect>
+#include <QVector>
+
+class QPainter;
+
+/**
+  * Rasterizer of the vertical spans and points making a decimated trace.
+  *
+  * Instead of one QPainter call per pixel column, the spans are written straight into the scanlines of
+  * a transparent QImage, which is drawn once per trace on top of what has already been painted.
+  * The spans are placed as the aliased cosmetic stroker of Qt places the 1 pixel wide lines: the pixel
+  * containing each end point of the span (in device coordinates) is painted, both ends included.
+  * It only handles opaque 1 pixel wide cosmetic pens without antialiasing, begin tells the caller to
+  * use the painter otherwise.
+  *@author the Neurosuite developers
+  */
+class TraceRasterizer {
+public:
+    TraceRasterizer();
+
+    /**Starts a trace drawn with the pen and the transform of @p painter.
+  * @return true if the trace can be rasterized, false if it has to be drawn with @p painter.
+  */
+    bool begin(QPainter& painter);
+
+    /**Adds a vertical line, given in the coordinates of the painter, @p x1 has to be equal to @p x2.*/
+    inline void drawLine(int x1,int y1,int x2,int y2){
+        Q_UNUSED(x2);
+        addSpan(x1,y1,y2);
+    }
+
+    /**Adds a point, given in the coordinates of the painter.*/
+    inline void drawPoint(int x,int y){
+        addSpan(x,y,y);
+    }
+
+    /**Draws the trace on the painter given to begin.*/
+    void end();
+
+private:
+    /**Buffer receiving the traces, as large as the painted device and transparent outside of the trace being drawn.*/
+    QImage image;
+
+    /**Painter the trace is drawn on, 0 outside of begin and end.*/
+    QPainter* painter;
+
+    /**Transform from the coordinates of the painter to the device.*/
+    QTransform transform;
+
+    /**Premultiplied color of the pen.*/
+    QRgb color;
+
+    /**Bounding rectangle of the pixels painted since begin.*/
+    int left;
+    int top;
+    int right;
+    int bottom;
+
+    /**Adds the span joining (@p x, @p y1) and (@p x, @p y2), given in the coordinates of the painter.*/
+    void addSpan(int x,int y1,int y2);
+};
+
+#endif
@@ -0,0 +1,350 @@
+/***************************************************************************
+                          tracesconversion.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+//include files for the application
+#include "tracesconversion.h"
+
+// include files for QT
+#include <QVector>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QThread>
+
+// include c/c++ headers
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRACES_CONVERSION_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/**The vectorized kernels convert to 32 bits integers, they are only used if the results are guaranteed to fit.*/
+const double MAX_INT32 = 2147483647.0;
+
+template <typename T> inline double maxAbsSample();
+template <> inline double maxAbsSample<int16_t>(){return 32768.0;}
+template <> inline double maxAbsSample<int32_t>(){return 2147483648.0;}
+
+/**Returns the instruction set selected at run time.*/
+TracesConversion::InstructionSet detectInstructionSet(){
+#ifdef TRACES_CONVERSION_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        return TracesConversion::AVX2;
+    if(__builtin_cpu_supports("sse2"))
+        return TracesConversion::SSE2;
+#endif
+    return TracesConversion::SCALAR;
+}
+
+/**Number of values converted in a block by forEachBlock, large enough to amortize the dispatch
+ * and small enough to balance the work between the threads.*/
+const qint64 BLOCK_SIZE = 256 * 1024;
+
+/**Threads converting the blocks, independent from the global pool which may be used by the caller.*/
+Q_GLOBAL_STATIC(QThreadPool,conversionPool)
+
+/**Blocks shared by the threads of a forEachBlock call, each thread taking the next block left.*/
+class BlockQueue : public QRunnable{
+public:
+    BlockQueue(const TracesConversion::BlockJob& job,qint64 nbSamples,qint64 blockSize,QAtomicInt& nextBlock,QSemaphore& done)
+        :job(job),nbSamples(nbSamples),blockSize(blockSize),nextBlock(nextBlock),done(done){
+        setAutoDelete(false);
+    }
+
+    void run(){
+        process();
+        done.release();
+    }
+
+    /**Processes blocks until there is none left.*/
+    void process(){
+        int nbBlocks = static_cast<int>((nbSamples + blockSize - 1) / blockSize);
+        int block;
+        while((block = nextBlock.fetchAndAddOrdered(1)) < nbBlocks){
+            qint64 first = block * blockSize;
+            job.run(first,qMin(blockSize,nbSamples - first));
+        }
+    }
+
+private:
+    const TracesConversion::BlockJob& job;
+    qint64 nbSamples;
+    qint64 blockSize;
+    QAtomicInt& nextBlock;
+    QSemaphore& done;
+};
+
+const TracesConversion::InstructionSet supportedInstructionSet = detectInstructionSet();
+
+/**Maximum number of threads used by forEachBlock, the calling thread included.*/
+int conversionThreadCount = qMax(QThread::idealThreadCount(),1);
+TracesConversion::InstructionSet currentInstructionSet = supportedInstructionSet;
+
+template <bool SCALE,typename T>
+inline void convertScalar(const T* samples,dataType* data,qint64 nbValues,double factor){
+    if(SCALE){
+        for(qint64 i = 0; i < nbValues; ++i)
+            data[i] = TracesConversion::round(samples[i] * factor);
+    }
+    else{
+        for(qint64 i = 0; i < nbValues; ++i)
+            data[i] = TracesConversion::round(static_cast<dataType>(samples[i]) - factor);
+    }
+}
+
+inline dataType affineScalar(int16_t sample,const TracesConversion::ChannelScaling& scaling){
+    return static_cast<dataType>((((static_cast<double>(sample) - scaling.minDigital) / scaling.rangeDigital) * scaling.rangeAnalog + scaling.minAnalog) * scaling.unit);
+}
+
+#ifdef TRACES_CONVERSION_X86
+
+/**Loads 4 samples as 32 bits integers.*/
+__attribute__((target("sse2"))) inline __m128i load4Sse2(const int16_t* samples){
+    __m128i values = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(samples));
+    return _mm_srai_epi32(_mm_unpacklo_epi16(values,values),16);
+}
+
+__attribute__((target("sse2"))) inline __m128i load4Sse2(const int32_t* samples){
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+}
+
+/**Rounds 2 doubles halves away from zero and truncates them to 32 bits integers, in the low half of the result.*/
+__attribute__((target("sse2"))) inline __m128i round2Sse2(__m128d d){
+    __m128d positive = _mm_cmpgt_pd(d,_mm_setzero_pd());
+    __m128d half = _mm_or_pd(_mm_and_pd(positive,_mm_set1_pd(0.5)),_mm_andnot_pd(positive,_mm_set1_pd(-0.5)));
+    return _mm_cvttpd_epi32(_mm_add_pd(d,half));
+}
+
+/**Stores 4 32 bits integers in @p data.*/
+__attribute__((target("sse2"))) inline void store4Sse2(__m128i values,dataType* data){
+    if(sizeof(dataType) == 8){
+        __m128i sign = _mm_srai_epi32(values,31);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data),_mm_unpacklo_epi32(values,sign));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + 2),_mm_unpackhi_epi32(values,sign));
+    }
+    else
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data),values);
+}
+
+template <bool SCALE,typename T>
+__attribute__((target("sse2"))) qint64 convertSse2(const T* samples,dataType* data,qint64 nbValues,double factor){
+    const __m128d vectorFactor = _mm_set1_pd(factor);
+    qint64 i = 0;
+    for(; i + 4 <= nbValues; i += 4){
+        __m128i values = load4Sse2(samples + i);
+        __m128d low = _mm_cvtepi32_pd(values);
+        __m128d high = _mm_cvtepi32_pd(_mm_shuffle_epi32(values,_MM_SHUFFLE(1,0,3,2)));
+        if(SCALE){
+            low = _mm_mul_pd(low,vectorFactor);
+            high = _mm_mul_pd(high,vectorFactor);
+        }
+        else{
+            low = _mm_sub_pd(low,vectorFactor);
+            high = _mm_sub_pd(high,vectorFactor);
+        }
+        store4Sse2(_mm_unpacklo_epi64(round2Sse2(low),round2Sse2(high)),data + i);
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) inline __m128i load4Avx2(const int16_t* samples){
+    return _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(samples)));
+}
+
+__attribute__((target("avx2"))) inline __m128i load4Avx2(const int32_t* samples){
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+}
+
+__attribute__((target("avx2"))) inline void store4Avx2(__m128i values,dataType* data){
+    if(sizeof(dataType) == 8)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data),_mm256_cvtepi32_epi64(values));
+    else
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data),values);
+}
+
+template <bool SCALE,typename T>
+__attribute__((target("avx2"))) qint64 convertAvx2(const T* samples,dataType* data,qint64 nbValues,double factor){
+    const __m256d vectorFactor = _mm256_set1_pd(factor);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d plusHalf = _mm256_set1_pd(0.5);
+    const __m256d minusHalf = _mm256_set1_pd(-0.5);
+    qint64 i = 0;
+    for(; i + 4 <= nbValues; i += 4){
+        __m256d d = _mm256_cvtepi32_pd(load4Avx2(samples + i));
+        d = SCALE ? _mm256_mul_pd(d,vectorFactor) : _mm256_sub_pd(d,vectorFactor);
+        __m256d half = _mm256_blendv_pd(minusHalf,plusHalf,_mm256_cmp_pd(d,zero,_CMP_GT_OQ));
+        store4Avx2(_mm256_cvttpd_epi32(_mm256_add_pd(d,half)),data + i);
+    }
+    return i;
+}
+
+/**Converts the channels [0, nbVectorChannels[ of each sample, nbVectorChannels being a multiple of 4.*/
+__attribute__((target("avx2"))) void affineAvx2(const int16_t* samples,dataType* data,qint64 nbSamples,int nbChannels,int nbVectorChannels,
+                                               const double* minDigital,const double* rangeDigital,const double* minAnalog,const double* rangeAnalog,const double* unit){
+    for(qint64 sample = 0; sample < nbSamples; ++sample){
+        const int16_t* row = samples + sample * nbChannels;
+        dataType* dataRow = data + sample * nbChannels;
+        for(int channel = 0; channel < nbVectorChannels; channel += 4){
+            __m256d d = _mm256_cvtepi32_pd(load4Avx2(row + channel));
+            d = _mm256_sub_pd(d,_mm256_loadu_pd(minDigital + channel));
+            d = _mm256_div_pd(d,_mm256_loadu_pd(rangeDigital + channel));
+            d = _mm256_mul_pd(d,_mm256_loadu_pd(rangeAnalog + channel));
+            d = _mm256_add_pd(d,_mm256_loadu_pd(minAnalog + channel));
+            d = _mm256_mul_pd(d,_mm256_loadu_pd(unit + channel));
+            store4Avx2(_mm256_cvttpd_epi32(d),dataRow + channel);
+        }
+    }
+}
+
+#endif
+
+template <bool SCALE,typename T>
+void convert(const T* samples,dataType* data,qint64 nbValues,double factor){
+    qint64 done = 0;
+#ifdef TRACES_CONVERSION_X86
+    double bound = SCALE ? maxAbsSample<T>() * fabs(factor) + 0.5 : maxAbsSample<T>() + fabs(factor) + 0.5;
+    if(bound < MAX_INT32){
+        if(currentInstructionSet == TracesConversion::AVX2)
+            done = convertAvx2<SCALE>(samples,data,nbValues,factor);
+        else if(currentInstructionSet == TracesConversion::SSE2)
+            done = convertSse2<SCALE>(samples,data,nbValues,factor);
+    }
+#endif
+    convertScalar<SCALE>(samples + done,data + done,nbValues - done,factor);
+}
+
+}
+
+TracesConversion::InstructionSet TracesConversion::instructionSet(){
+    return currentInstructionSet;
+}
+
+TracesConversion::InstructionSet TracesConversion::setInstructionSet(InstructionSet set){
+    currentInstructionSet = qMin(set,supportedInstructionSet);
+    return currentInstructionSet;
+}
+
+const char* TracesConversion::instructionSetName(InstructionSet set){
+    switch(set){
+    case AVX2:
+        return "avx2";
+    case SSE2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+int TracesConversion::maxThreadCount(){
+    return conversionThreadCount;
+}
+
+void TracesConversion::setMaxThreadCount(int nbThreads){
+    conversionThreadCount = qMax(nbThreads,1);
+    conversionPool()->setMaxThreadCount(qMax(conversionThreadCount - 1,1));
+}
+
+void TracesConversion::forEachBlock(qint64 nbSamples,int nbValuesPerSample,const BlockJob& job){
+    if(nbSamples <= 0)
+        return;
+
+    qint64 blockSize = qMax(BLOCK_SIZE / qMax(nbValuesPerSample,1),static_cast<qint64>(1));
+    int nbBlocks = static_cast<int>((nbSamples + blockSize - 1) / blockSize);
+    int nbHelpers = qMin(nbBlocks,conversionThreadCount) - 1;
+    if(nbHelpers <= 0){
+        job.run(0,nbSamples);
+        return;
+    }
+
+    //The helpers and the calling thread share the blocks, a thread which is late (or a helper which starts late
+    //because the pool is busy) simply takes less blocks.
+    QAtomicInt nextBlock(0);
+    QSemaphore done;
+    QList<BlockQueue*> helpers;
+    for(int i = 0; i < nbHelpers; ++i){
+        helpers.append(new BlockQueue(job,nbSamples,blockSize,nextBlock,done));
+        conversionPool()->start(helpers.last());
+    }
+    BlockQueue(job,nbSamples,blockSize,nextBlock,done).process();
+    done.acquire(nbHelpers);
+    qDeleteAll(helpers);
+}
+
+void TracesConversion::scale(const int16_t* samples,dataType* data,qint64 nbValues,double gain){
+    convert<true>(samples,data,nbValues,gain);
+}
+
+void TracesConversion::scale(const int32_t* samples,dataType* data,qint64 nbValues,double gain){
+    convert<true>(samples,data,nbValues,gain);
+}
+
+void TracesConversion::shift(const int16_t* samples,dataType* data,qint64 nbValues,double shift){
+    convert<false>(samples,data,nbValues,shift);
+}
+
+void TracesConversion::shift(const int32_t* samples,dataType* data,qint64 nbValues,double shift){
+    convert<false>(samples,data,nbValues,shift);
+}
+
+void TracesConversion::affine(const int16_t* samples,dataType* data,qint64 nbSamples,int nbChannels,const ChannelScaling* scalings){
+    int nbVectorChannels = 0;
+#ifdef TRACES_CONVERSION_X86
+    //The division dominates the affine transform, SSE2 does not beat the scalar code which is used instead.
+    if(currentInstructionSet == AVX2){
+        //The transform is monotonic, its extrema are reached at the extrema of the samples.
+        bool fits = true;
+        for(int channel = 0; channel < nbChannels && fits; ++channel){
+            const ChannelScaling& scaling = scalings[channel];
+            double low = (((-32768.0 - scaling.minDigital) / scaling.rangeDigital) * scaling.rangeAnalog + scaling.minAnalog) * scaling.unit;
+            double high = (((32767.0 - scaling.minDigital) / scaling.rangeDigital) * scaling.rangeAnalog + scaling.minAnalog) * scaling.unit;
+            fits = fabs(low) < MAX_INT32 && fabs(high) < MAX_INT32;
+        }
+        if(fits)
+            nbVectorChannels = nbChannels - nbChannels % 4;
+    }
+
+    if(nbVectorChannels > 0){
+        QVector<double> minDigital(nbVectorChannels);
+        QVector<double> rangeDigital(nbVectorChannels);
+        QVector<double> minAnalog(nbVectorChannels);
+        QVector<double> rangeAnalog(nbVectorChannels);
+        QVector<double> unit(nbVectorChannels);
+        for(int channel = 0; channel < nbVectorChannels; ++channel){
+            minDigital[channel] = scalings[channel].minDigital;
+            rangeDigital[channel] = scalings[channel].rangeDigital;
+            minAnalog[channel] = scalings[channel].minAnalog;
+            rangeAnalog[channel] = scalings[channel].rangeAnalog;
+            unit[channel] = scalings[channel].unit;
+        }
+        affineAvx2(samples,data,nbSamples,nbChannels,nbVectorChannels,minDigital.constData(),rangeDigital.constData(),minAnalog.constData(),rangeAnalog.constData(),unit.constData());
+    }
+#endif
+
+    //Remaining channels.
+    if(nbVectorChannels == nbChannels)
+        return;
+    for(qint64 sample = 0; sample < nbSamples; ++sample){
+        const int16_t* row = samples + sample * nbChannels;
+        dataType* dataRow = data + sample * nbChannels;
+        for(int channel = nbVectorChannels; channel < nbChannels; ++channel)
+            dataRow[channel] = affineScalar(row[channel],scalings[channel]);
+    }
+}
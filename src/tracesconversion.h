@@ -0,0 +1,126 @@
+/***************************************************************************
+                          tracesconversion.h  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TRACESCONVERSION_H
+#define TRACESCONVERSION_H
+
+//include files for the application
+#include <types.h>
+
+// include files for QT
+#include <QtGlobal>
+
+// include c/c++ headers
+#include <stdint.h>
+
+/**
+  * Conversion of the raw samples read by the traces providers into uV.
+  *
+  * The kernels are vectorized with SSE2 or AVX2 when the processor supports it, the instruction set being
+  * selected once at run time, and fall back to scalar code otherwise. All the implementations give exactly
+  * the same results: the computations are done in double precision in the same order as the scalar code.
+  *@author the Neurosuite developers
+  */
+class TracesConversion {
+public:
+    /**Work done on a range of samples by forEachBlock, possibly in several threads at once.*/
+    class BlockJob{
+    public:
+        virtual ~BlockJob(){}
+
+        /**Processes the samples [@p first, @p first + @p nbSamples[. The blocks never overlap.*/
+        virtual void run(qint64 first,qint64 nbSamples) const = 0;
+    };
+
+    /**Instruction sets the kernels can use.*/
+    enum InstructionSet{SCALAR = 0,SSE2 = 1,AVX2 = 2};
+
+    /**Per channel affine transform from digital values to uV:
+  * value = (((sample - minDigital) / rangeDigital) * rangeAnalog + minAnalog) * unit.
+  */
+    struct ChannelScaling{
+        double minDigital;
+        double rangeDigital;
+        double minAnalog;
+        double rangeAnalog;
+        double unit;
+    };
+
+    /**Returns the instruction set used by the kernels.*/
+    static InstructionSet instructionSet();
+
+    /**Forces the instruction set used by the kernels, within the ones supported by the processor.
+  * Used to compare the implementations.
+  * @param set the requested instruction set.
+  * @return the instruction set actually used.
+  */
+    static InstructionSet setInstructionSet(InstructionSet set);
+
+    /**Returns the name of @p set.*/
+    static const char* instructionSetName(InstructionSet set);
+
+    /**Converts @p nbValues samples: data[i] = round(samples[i] * gain).
+  * @param samples raw samples.
+  * @param data converted values.
+  * @param nbValues number of values to convert.
+  * @param gain acquisition gain.
+  */
+    static void scale(const int16_t* samples,dataType* data,qint64 nbValues,double gain);
+    static void scale(const int32_t* samples,dataType* data,qint64 nbValues,double gain);
+
+    /**Converts @p nbValues samples: data[i] = round(samples[i] - shift).
+  * @param samples raw samples.
+  * @param data converted values.
+  * @param nbValues number of values to convert.
+  * @param shift value to subtract, the offset multiplied by the acquisition gain.
+  */
+    static void shift(const int16_t* samples,dataType* data,qint64 nbValues,double shift);
+    static void shift(const int32_t* samples,dataType* data,qint64 nbValues,double shift);
+
+    /**Converts @p nbSamples interleaved samples of @p nbChannels channels, applying to each channel its own
+  * affine transform. The result is truncated toward zero.
+  * @param samples raw samples (number of samples X number of channels).
+  * @param data converted values (number of samples X number of channels).
+  * @param nbSamples number of samples per channel.
+  * @param nbChannels number of channels.
+  * @param scalings transform of each channel.
+  */
+    static void affine(const int16_t* samples,dataType* data,qint64 nbSamples,int nbChannels,const ChannelScaling* scalings);
+
+    /**Splits the samples [0, @p nbSamples[ into blocks and runs @p job on them with the conversion threads,
+  * the calling thread taking part in the work. Each thread takes the next block left as soon as it is done
+  * with the previous one. Small ranges are processed in the calling thread only.
+  * @param nbSamples number of samples.
+  * @param nbValuesPerSample number of values per sample, used to size the blocks.
+  * @param job work to do on each block.
+  */
+    static void forEachBlock(qint64 nbSamples,int nbValuesPerSample,const BlockJob& job);
+
+    /**Returns the maximum number of threads used by forEachBlock, the calling thread included.*/
+    static int maxThreadCount();
+
+    /**Sets the maximum number of threads used by forEachBlock, the calling thread included.
+  * 1 converts in the calling thread only.
+  */
+    static void setMaxThreadCount(int nbThreads);
+
+    /**Rounds @p d to the nearest integer, halves away from zero.*/
+    static inline dataType round(double d) {
+      return static_cast<dataType>( (d > 0.0) ? d + 0.5 : d - 0.5);
+    }
+};
+
+#endif
@@ -0,0 +1,286 @@
+/***************************************************************************
+                          tracesdecimation.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+//include files for the application
+#include "tracesdecimation.h"
+#include "tracesconversion.h"
+
+// include c/c++ headers
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRACES_DECIMATION_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/**Sums of the values and of their squares, accumulated in four lanes as in the vectorized code.*/
+template <bool SQUARES>
+void sumsScalar(const dataType* values,qint64 stride,qint64 nbValues,double& sum,double& squares){
+    double sums[4] = {0.0,0.0,0.0,0.0};
+    double sumsOfSquares[4] = {0.0,0.0,0.0,0.0};
+    qint64 i = 0;
+    for(; i + 4 <= nbValues; i += 4){
+        for(int lane = 0; lane < 4; ++lane){
+            const double value = static_cast<double>(values[(i + lane) * stride]);
+            sums[lane] += value;
+            if(SQUARES) sumsOfSquares[lane] += value * value;
+        }
+    }
+    sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    squares = (sumsOfSquares[0] + sumsOfSquares[1]) + (sumsOfSquares[2] + sumsOfSquares[3]);
+    for(; i < nbValues; ++i){
+        const double value = static_cast<double>(values[i * stride]);
+        sum += value;
+        if(SQUARES) squares += value * value;
+    }
+}
+
+#ifdef TRACES_DECIMATION_X86
+
+/**The values are 64 bits integers, loaded four at a time, contiguous or gathered.*/
+__attribute__((target("avx2"))) inline __m256i load4Avx2(const dataType* values,qint64 stride,__m256i offsets){
+    if(stride == 1)
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+    return _mm256_i64gather_epi64(reinterpret_cast<const long long*>(values),offsets,8);
+}
+
+/**Converts integers of magnitude below 2^51 (the traces in uV are far below) to doubles, exactly as the scalar cast:
+ * added to the mantissa of 1.5 * 2^52, they give 1.5 * 2^52 + value.*/
+__attribute__((target("avx2"))) inline __m256d toDoubleAvx2(__m256i values){
+    const __m256i magic = _mm256_set1_epi64x(0x4338000000000000LL);
+    return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(values,magic)),_mm256_castsi256_pd(magic));
+}
+
+__attribute__((target("avx2"))) inline __m256i strideOffsetsAvx2(qint64 stride){
+    return _mm256_set_epi64x(3 * stride,2 * stride,stride,0);
+}
+
+/**Computes the extrema of the first values by groups of four and returns the number of values processed.*/
+__attribute__((target("avx2"))) qint64 extremaAvx2(const dataType* values,qint64 stride,qint64 nbValues,dataType& min,dataType& max){
+    if(nbValues < 8)
+        return 0;
+    const __m256i offsets = strideOffsetsAvx2(stride);
+    __m256i vectorMin = load4Avx2(values,stride,offsets);
+    __m256i vectorMax = vectorMin;
+    qint64 i = 4;
+    for(; i + 4 <= nbValues; i += 4){
+        const __m256i v = load4Avx2(values + i * stride,stride,offsets);
+        vectorMin = _mm256_blendv_epi8(vectorMin,v,_mm256_cmpgt_epi64(vectorMin,v));
+        vectorMax = _mm256_blendv_epi8(vectorMax,v,_mm256_cmpgt_epi64(v,vectorMax));
+    }
+
+    long long mins[4];
+    long long maxs[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(mins),vectorMin);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(maxs),vectorMax);
+    min = mins[0];
+    max = maxs[0];
+    for(int lane = 1; lane < 4; ++lane){
+        if(mins[lane] < min) min = mins[lane];
+        if(maxs[lane] > max) max = maxs[lane];
+    }
+    return i;
+}
+
+template <bool SQUARES>
+__attribute__((target("avx2"))) void sumsAvx2(const dataType* values,qint64 stride,qint64 nbValues,double& sum,double& squares){
+    const __m256i offsets = strideOffsetsAvx2(stride);
+    __m256d sums = _mm256_setzero_pd();
+    __m256d sumsOfSquares = _mm256_setzero_pd();
+    qint64 i = 0;
+    for(; i + 4 <= nbValues; i += 4){
+        const __m256d value = toDoubleAvx2(load4Avx2(values + i * stride,stride,offsets));
+        sums = _mm256_add_pd(sums,value);
+        if(SQUARES) sumsOfSquares = _mm256_add_pd(sumsOfSquares,_mm256_mul_pd(value,value));
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes,sums);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm256_storeu_pd(lanes,sumsOfSquares);
+    squares = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for(; i < nbValues; ++i){
+        const double value = static_cast<double>(values[i * stride]);
+        sum += value;
+        if(SQUARES) squares += value * value;
+    }
+}
+
+/**Searches the largest triangle among the first values of a bucket by groups of four, see largestTriangle.
+ * @return the number of values processed.*/
+__attribute__((target("avx2"))) qint64 largestTriangleAvx2(const dataType* values,qint64 stride,qint64 first,qint64 nbValues,
+                                                            double ax,double ay,double dxc,double dyc,double& bestArea,qint64& bestIndex){
+    if(nbValues < 8)
+        return 0;
+    const __m256i offsets = strideOffsetsAvx2(stride);
+    const __m256d vectorAx = _mm256_set1_pd(ax);
+    const __m256d vectorAy = _mm256_set1_pd(ay);
+    const __m256d vectorDxc = _mm256_set1_pd(dxc);
+    const __m256d vectorDyc = _mm256_set1_pd(dyc);
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    const __m256d four = _mm256_set1_pd(4.0);
+    __m256d x = _mm256_set_pd(first + 3.0,first + 2.0,first + 1.0,static_cast<double>(first));
+    __m256d areas = _mm256_set1_pd(-1.0);
+    __m256d indexes = _mm256_setzero_pd();
+
+    qint64 i = 0;
+    for(; i + 4 <= nbValues; i += 4){
+        const __m256d y = toDoubleAvx2(load4Avx2(values + (first + i) * stride,stride,offsets));
+        const __m256d area = _mm256_andnot_pd(signMask,_mm256_sub_pd(_mm256_mul_pd(vectorDxc,_mm256_sub_pd(y,vectorAy)),
+                                                                     _mm256_mul_pd(_mm256_sub_pd(vectorAx,x),vectorDyc)));
+        const __m256d larger = _mm256_cmp_pd(area,areas,_CMP_GT_OQ);
+        areas = _mm256_blendv_pd(areas,area,larger);
+        indexes = _mm256_blendv_pd(indexes,x,larger);
+        x = _mm256_add_pd(x,four);
+    }
+
+    //Each lane holds its first largest triangle, the first one overall is the one with the smallest index.
+    double laneAreas[4];
+    double laneIndexes[4];
+    _mm256_storeu_pd(laneAreas,areas);
+    _mm256_storeu_pd(laneIndexes,indexes);
+    bestArea = laneAreas[0];
+    bestIndex = static_cast<qint64>(laneIndexes[0]);
+    for(int lane = 1; lane < 4; ++lane){
+        const qint64 index = static_cast<qint64>(laneIndexes[lane]);
+        if(laneAreas[lane] > bestArea || (laneAreas[lane] == bestArea && index < bestIndex)){
+            bestArea = laneAreas[lane];
+            bestIndex = index;
+        }
+    }
+    return i;
+}
+
+#endif
+
+inline bool useAvx2(){
+#ifdef TRACES_DECIMATION_X86
+    return sizeof(dataType) == 8 && TracesConversion::instructionSet() == TracesConversion::AVX2;
+#else
+    return false;
+#endif
+}
+
+template <bool SQUARES>
+inline void sums(const dataType* values,qint64 stride,qint64 nbValues,double& sum,double& squares){
+#ifdef TRACES_DECIMATION_X86
+    if(useAvx2()){
+        sumsAvx2<SQUARES>(values,stride,nbValues,sum,squares);
+        return;
+    }
+#endif
+    sumsScalar<SQUARES>(values,stride,nbValues,sum,squares);
+}
+
+/**Returns the index of the value of [first, end[ forming the largest triangle with (ax, ay) and (cx, cy), the first one if several do.*/
+qint64 largestTriangle(const dataType* values,qint64 stride,qint64 first,qint64 end,double ax,double ay,double cx,double cy){
+    const double dxc = ax - cx;
+    const double dyc = cy - ay;
+    double bestArea = -1.0;
+    qint64 bestIndex = first;
+    qint64 i = first;
+#ifdef TRACES_DECIMATION_X86
+    if(useAvx2())
+        i += largestTriangleAvx2(values,stride,first,end - first,ax,ay,dxc,dyc,bestArea,bestIndex);
+#endif
+    for(; i < end; ++i){
+        const double area = fabs(dxc * (static_cast<double>(values[i * stride]) - ay) - (ax - static_cast<double>(i)) * dyc);
+        if(area > bestArea){
+            bestArea = area;
+            bestIndex = i;
+        }
+    }
+    return bestIndex;
+}
+
+}
+
+const char* TracesDecimation::modeName(Mode mode){
+    switch(mode){
+    case LTTB:
+        return "lttb";
+    case RMS_BAND:
+        return "rms";
+    case STRIDE:
+        return "stride";
+    default:
+        return "minmax";
+    }
+}
+
+void TracesDecimation::extrema(const dataType* values,qint64 stride,qint64 nbValues,dataType& min,dataType& max){
+    min = values[0];
+    max = min;
+    qint64 i = 1;
+#ifdef TRACES_DECIMATION_X86
+    if(useAvx2()){
+        const qint64 done = extremaAvx2(values,stride,nbValues,min,max);
+        if(done > 0) i = done;
+    }
+#endif
+    for(; i < nbValues; ++i){
+        const dataType value = values[i * stride];
+        if(value < min) min = value;
+        if(value > max) max = value;
+    }
+}
+
+void TracesDecimation::band(const dataType* values,qint64 stride,qint64 nbValues,dataType& low,dataType& high){
+    double sum;
+    double squares;
+    sums<true>(values,stride,nbValues,sum,squares);
+    const double mean = sum / nbValues;
+    const double deviation = sqrt(qMax(0.0,squares / nbValues - mean * mean));
+    low = TracesConversion::round(mean - deviation);
+    high = TracesConversion::round(mean + deviation);
+}
+
+void TracesDecimation::largestTriangles(const dataType* values,qint64 stride,const qint64* starts,int nbBuckets,
+                                        double previousIndex,double previousValue,bool hasPrevious,dataType* selected){
+    double ax = previousIndex;
+    double ay = previousValue;
+    for(int bucket = 0; bucket < nbBuckets; ++bucket){
+        const qint64 first = starts[bucket];
+        const qint64 end = starts[bucket + 1];
+        qint64 index = first;
+
+        if(hasPrevious){
+            //Third vertex: the average of the next bucket, or the last value if there is none.
+            const qint64 nextEnd = starts[bucket + 2];
+            double cx;
+            double cy;
+            if(nextEnd > end){
+                double sum;
+                double unused;
+                sums<false>(values + end * stride,stride,nextEnd - end,sum,unused);
+                cx = (end + nextEnd - 1) / 2.0;
+                cy = sum / (nextEnd - end);
+            }
+            else{
+                cx = static_cast<double>(end - 1);
+                cy = static_cast<double>(values[(end - 1) * stride]);
+            }
+            index = largestTriangle(values,stride,first,end,ax,ay,cx,cy);
+        }
+
+        selected[bucket] = values[index * stride];
+        ax = static_cast<double>(index);
+        ay = static_cast<double>(selected[bucket]);
+        hasPrevious = true;
+    }
+}
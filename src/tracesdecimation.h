@@ -0,0 +1,79 @@
+/***************************************************************************
+                          tracesdecimation.h  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TRACESDECIMATION_H
+#define TRACESDECIMATION_H
+
+//include files for the application
+#include <types.h>
+
+// include files for QT
+#include <QtGlobal>
+
+/**
+  * Reduction of the samples of a trace to the pixel columns in which it is drawn.
+  *
+  * The samples are read with a stride, the traces being stored as interleaved channels (number of samples X number of channels).
+  * The kernels are vectorized with AVX2 when the instruction set selected by TracesConversion allows it, and give exactly the
+  * same results as the scalar code: the sums are accumulated in four lanes in both cases.
+  *@author the Neurosuite developers
+  */
+class TracesDecimation {
+public:
+    /**Reductions of the samples of a pixel column.
+  * MIN_MAX draws the range of the samples, LTTB (largest triangle three buckets) selects the sample of each column keeping the
+  * shape of the trace, RMS_BAND draws the mean plus or minus the root mean square deviation and STRIDE keeps the first sample.
+  * LTTB and STRIDE give one point per column, drawn as a polyline.
+  */
+    enum Mode{MIN_MAX = 0,LTTB = 1,RMS_BAND = 2,STRIDE = 3};
+
+    /**Returns the name of @p mode.*/
+    static const char* modeName(Mode mode);
+
+    /**Returns true if @p mode gives one point per column instead of a range.*/
+    static inline bool isPointMode(Mode mode){
+        return mode == LTTB || mode == STRIDE;
+    }
+
+    /**Computes the minimum and the maximum of @p nbValues values.
+  * @param values first value.
+  * @param stride distance between two consecutive values.
+  * @param nbValues number of values, at least 1.
+  */
+    static void extrema(const dataType* values,qint64 stride,qint64 nbValues,dataType& min,dataType& max);
+
+    /**Computes the band of the mean plus or minus the root mean square deviation of @p nbValues values.
+  * The parameters are the ones of extrema.
+  */
+    static void band(const dataType* values,qint64 stride,qint64 nbValues,dataType& low,dataType& high);
+
+    /**Selects one value per bucket with the largest triangle three buckets algorithm: the value of each bucket forms the
+  * largest triangle with the value selected in the previous bucket and the average of the next bucket.
+  * @param values first value of the first bucket.
+  * @param stride distance between two consecutive values.
+  * @param starts index of the first value of each bucket, @p nbBuckets + 2 entries: the last two ones are the end of the last
+  * bucket and the end of the bucket following it, equal if there is none.
+  * @param nbBuckets number of buckets, none of them being empty.
+  * @param previousIndex index (relative to @p values, possibly negative) of the value selected before the first bucket.
+  * @param previousValue value selected before the first bucket.
+  * @param hasPrevious false if there is no value before the first bucket, the first value of the first bucket is then selected.
+  * @param selected the value selected in each bucket.
+  */
+    static void largestTriangles(const dataType* values,qint64 stride,const qint64* starts,int nbBuckets,
+                                 double previousIndex,double previousValue,bool hasPrevious,dataType* selected);
+};
+
+#endif
@@ -0,0 +1,140 @@
+/***************************************************************************
+                          tracesprefetcher.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+//include files for the application
+#include "tracesprefetcher.h"
+#include "tracesprovider.h"
+
+// include files for QT
+#include <QMutexLocker>
+
+const int TracesPrefetcher::MAX_READY_WINDOWS = 4;
+
+TracesPrefetcher::TracesPrefetcher(TracesProvider& provider)
+    : QThread(),
+      provider(provider),
+      decoding(false),
+      generation(0),
+      stopped(false)
+{
+}
+
+TracesPrefetcher::~TracesPrefetcher(){
+    stop();
+    qDeleteAll(readyData);
+}
+
+void TracesPrefetcher::prefetch(const QList<TraceWindow>& windows){
+    QMutexLocker locker(&mutex);
+    if(stopped)
+        return;
+
+    pendingWindows.clear();
+    QList<TraceWindow>::const_iterator iterator;
+    for(iterator = windows.begin(); iterator != windows.end(); ++iterator){
+        if(readyWindows.contains(*iterator) || (decoding && currentWindow == *iterator))
+            continue;
+        pendingWindows.append(*iterator);
+    }
+
+    if(pendingWindows.isEmpty())
+        return;
+
+    if(!isRunning())
+        start(QThread::LowPriority);
+    pendingCondition.wakeOne();
+}
+
+Array<dataType>* TracesPrefetcher::take(const TraceWindow& window){
+    QMutexLocker locker(&mutex);
+
+    //The window is being decoded, wait for it rather than decoding it a second time.
+    while(decoding && currentWindow == window)
+        decodedCondition.wait(&mutex);
+
+    int index = readyWindows.indexOf(window);
+    if(index == -1)
+        return 0L;
+
+    readyWindows.removeAt(index);
+    return readyData.takeAt(index);
+}
+
+bool TracesPrefetcher::isAvailable(const TraceWindow& window){
+    QMutexLocker locker(&mutex);
+    return (decoding && currentWindow == window) || readyWindows.contains(window);
+}
+
+void TracesPrefetcher::clear(){
+    QMutexLocker locker(&mutex);
+    pendingWindows.clear();
+    readyWindows.clear();
+    qDeleteAll(readyData);
+    readyData.clear();
+    ++generation;
+}
+
+void TracesPrefetcher::stop(){
+    mutex.lock();
+    stopped = true;
+    pendingWindows.clear();
+    pendingCondition.wakeOne();
+    mutex.unlock();
+
+    wait();
+}
+
+void TracesPrefetcher::run(){
+    mutex.lock();
+    while(!stopped){
+        if(pendingWindows.isEmpty()){
+            pendingCondition.wait(&mutex);
+            continue;
+        }
+
+        currentWindow = pendingWindows.takeFirst();
+        if(readyWindows.contains(currentWindow))
+            continue;
+
+        decoding = true;
+        int currentGeneration = generation;
+        mutex.unlock();
+
+        //Decode outside of the lock so that the provider can take the windows already available in the meantime.
+        Array<dataType>* data = new Array<dataType>();
+        bool decoded;
+        {
+            QMutexLocker readLocker(&provider.readMutex);
+            decoded = provider.readData(currentWindow.startTime,currentWindow.endTime,currentWindow.startTimeInRecordingUnits,currentWindow.channels,*data);
+        }
+
+        mutex.lock();
+        decoding = false;
+        if(decoded && currentGeneration == generation && !stopped){
+            readyWindows.append(currentWindow);
+            readyData.append(data);
+            while(readyWindows.size() > MAX_READY_WINDOWS){
+                readyWindows.removeFirst();
+                delete readyData.takeFirst();
+            }
+        }
+        else
+            delete data;
+
+        decodedCondition.wakeAll();
+    }
+    mutex.unlock();
+}
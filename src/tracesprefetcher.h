@@ -0,0 +1,135 @@
+/***************************************************************************
+                          tracesprefetcher.h  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TRACESPREFETCHER_H
+#define TRACESPREFETCHER_H
+
+//include files for the application
+#include <array.h>
+#include <types.h>
+
+// include files for QT
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QList>
+#include <QHash>
+
+class TracesProvider;
+
+/**Time window of traces, as given to TracesProvider::requestData.*/
+struct TraceWindow{
+    long startTime;
+    long endTime;
+    long startTimeInRecordingUnits;
+    /**Requested channels, all the channels if empty.*/
+    QList<int> channels;
+
+    TraceWindow(long start = 0,long end = 0,long startInRecordingUnits = 0,const QList<int>& channelIds = QList<int>())
+        :startTime(start),endTime(end),startTimeInRecordingUnits(startInRecordingUnits),channels(channelIds){}
+
+    bool operator==(const TraceWindow& other) const{
+        return startTime == other.startTime && endTime == other.endTime &&
+                startTimeInRecordingUnits == other.startTimeInRecordingUnits && channels == other.channels;
+    }
+};
+
+/**Hash function allowing TraceWindow to be used as a key of QHash and QCache.*/
+inline uint qHash(const TraceWindow& window){
+    uint hash = ::qHash(static_cast<qint64>(window.startTime)) ^ (::qHash(static_cast<qint64>(window.endTime)) * 31U) ^
+            (::qHash(static_cast<qint64>(window.startTimeInRecordingUnits)) * 131U);
+    QList<int>::const_iterator iterator;
+    for(iterator = window.channels.begin(); iterator != window.channels.end(); ++iterator)
+        hash = hash * 33U + static_cast<uint>(*iterator);
+    return hash;
+}
+
+/**
+  * Background worker reading ahead the trace windows which are likely to be requested next.
+  * The windows are decoded by the TracesProvider in a separate thread and kept in memory
+  * until they are taken by the provider or replaced by newer ones.
+  *@author the Neurosuite developers
+  */
+class TracesPrefetcher : public QThread {
+public:
+    /**Constructor.
+  * @param provider provider used to decode the windows.
+  */
+    explicit TracesPrefetcher(TracesProvider& provider);
+    ~TracesPrefetcher();
+
+    /**Replaces the windows waiting to be decoded by @p windows, the first one being the most likely.
+  * @param windows list of windows to read ahead.
+  */
+    void prefetch(const QList<TraceWindow>& windows);
+
+    /**Returns the decoded data for @p window if it has been read ahead, 0 otherwise.
+  * If the window is being decoded, waits until it is available. The caller takes the ownership of the returned array.
+  * @param window the requested window.
+  */
+    Array<dataType>* take(const TraceWindow& window);
+
+    /**Returns true if @p window has been read ahead or is being decoded, take then not having to decode it again.*/
+    bool isAvailable(const TraceWindow& window);
+
+    /**Discards all the windows read ahead or waiting to be, used when the parameters of the provider change.*/
+    void clear();
+
+    /**Stops the worker thread and waits for its completion.*/
+    void stop();
+
+protected:
+    /**Decodes the pending windows until the worker is stopped.*/
+    virtual void run();
+
+private:
+    /**Maximum number of decoded windows kept in memory.*/
+    static const int MAX_READY_WINDOWS;
+
+    /**Provider decoding the windows.*/
+    TracesProvider& provider;
+
+    /**Protects all the following members.*/
+    QMutex mutex;
+
+    /**Wakes the worker up when new windows have to be decoded.*/
+    QWaitCondition pendingCondition;
+
+    /**Signals that the window being decoded is available.*/
+    QWaitCondition decodedCondition;
+
+    /**Windows waiting to be decoded.*/
+    QList<TraceWindow> pendingWindows;
+
+    /**Window being decoded.*/
+    TraceWindow currentWindow;
+
+    /**True while currentWindow is being decoded.*/
+    bool decoding;
+
+    /**Decoded windows and their data, the oldest first.*/
+    QList<TraceWindow> readyWindows;
+    QList<Array<dataType>*> readyData;
+
+    /**Incremented each time the decoded windows are discarded, so that a window decoded
+  * with obsolete parameters is not kept.*/
+    int generation;
+
+    /**True once the worker has been asked to stop.*/
+    bool stopped;
+};
+
+#endif
@@ -22,11 +22,18 @@
 
 //include files for the application
 #include "tracesprovider.h"
+#include "tracespyramid.h"
+#include "tracesconversion.h"
+#include "ncsfileset.h"
 
 #include <QFile>
 #include <QRegExp>
 #include <QDebug>
 #include <QFileInfo>
+#include <QVector>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QElapsedTimer>
 
 // include c/c++ headers
 #include <stdint.h>
@@ -34,6 +41,82 @@
 //include files for c/c++ libraries
 #include <math.h>
 
+namespace {
+
+/**Number of samples gathered at once when only a subset of the channels is converted,
+ * small enough for the gathered block to stay in the cache.*/
+const qint64 GATHER_BLOCK_SIZE = 4096;
+
+/**Default memory budget of the cache of decoded windows, in megabytes.*/
+const int DEFAULT_CACHE_SIZE = 256;
+
+/**Delay, in miliseconds, between a modification of the file being recorded and the update of its length.
+ * The acquisition systems write in bursts, each write being notified.*/
+const int LIVE_UPDATE_DELAY = 20;
+
+/**Converts @p nbSamples interleaved samples of @p nbChannels channels into uV, keeping only the
+ * channels @p channels (all the channels if empty). @p data has one column per kept channel.
+ */
+template <typename T>
+void convertSamples(const T* samples,dataType* data,qint64 nbSamples,int nbChannels,const QList<int>& channels,double gain,double shift,bool applyShift){
+    if(channels.isEmpty()){
+        if(applyShift)
+            TracesConversion::shift(samples,data,nbSamples * nbChannels,shift);
+        else
+            TracesConversion::scale(samples,data,nbSamples * nbChannels,gain);
+        return;
+    }
+
+    //De-interleave the requested channels one block at a time and convert the gathered block.
+    const int nbColumns = channels.size();
+    QVector<int> columns = channels.toVector();
+    QVector<T> block(GATHER_BLOCK_SIZE * nbColumns);
+    for(qint64 first = 0; first < nbSamples; first += GATHER_BLOCK_SIZE){
+        qint64 nbBlockSamples = qMin(GATHER_BLOCK_SIZE,nbSamples - first);
+        const T* source = samples + first * nbChannels;
+        T* gathered = block.data();
+        for(qint64 i = 0; i < nbBlockSamples; ++i,source += nbChannels)
+            for(int j = 0; j < nbColumns; ++j)
+                *gathered++ = source[columns[j]];
+
+        if(applyShift)
+            TracesConversion::shift(block.constData(),data + first * nbColumns,nbBlockSamples * nbColumns,shift);
+        else
+            TracesConversion::scale(block.constData(),data + first * nbColumns,nbBlockSamples * nbColumns,gain);
+    }
+}
+
+/**Conversion of a block of samples by the conversion threads, the values being written in place in the final array.*/
+template <typename T>
+class ConversionJob : public TracesConversion::BlockJob{
+public:
+    ConversionJob(const T* samples,dataType* data,int nbChannels,const QList<int>& channels,double gain,double shift,bool applyShift)
+        :samples(samples),data(data),nbChannels(nbChannels),channels(channels),gain(gain),shift(shift),applyShift(applyShift){}
+
+    void run(qint64 first,qint64 nbSamples) const{
+        const int nbColumns = channels.isEmpty() ? nbChannels : channels.size();
+        convertSamples(samples + first * nbChannels,data + first * nbColumns,nbSamples,nbChannels,channels,gain,shift,applyShift);
+    }
+
+private:
+    const T* samples;
+    dataType* data;
+    int nbChannels;
+    const QList<int>& channels;
+    double gain;
+    double shift;
+    bool applyShift;
+};
+
+/**Converts the samples as convertSamples does, splitting the large windows between the conversion threads.*/
+template <typename T>
+void convertSamplesInParallel(const T* samples,dataType* data,qint64 nbSamples,int nbChannels,const QList<int>& channels,double gain,double shift,bool applyShift){
+    ConversionJob<T> job(samples,data,nbChannels,channels,gain,shift,applyShift);
+    TracesConversion::forEachBlock(nbSamples,nbChannels,job);
+}
+
+}
+
 TracesProvider::TracesProvider(const QString &fileUrl, int nbChannels, int resolution, int voltageRange, int amplification, double samplingRate, int offset)
     : DataProvider(fileUrl),
       nbChannels(nbChannels),
@@ -41,12 +124,205 @@ TracesProvider::TracesProvider(const QString &fileUrl, int nbChannels, int resol
       voltageRange(voltageRange),
       amplification(amplification),
       samplingRate(samplingRate),
-      offset(offset)
+      offset(offset),
+      mappedFile(0L),
+      mappedData(0L),
+      mappedSize(0),
+      mappingUnavailable(false),
+      dataFileSize(-1),
+      prefetcher(0L),
+      previousRequestStartTime(-1),
+      previousRequestTimeFrame(0),
+      pyramid(0L),
+      cache(DEFAULT_CACHE_SIZE * 1024),
+      ncsFiles(0L),
+      watcher(0L),
+      liveTimer(0L),
+      nbLiveViews(0),
+      dataVersion(0),
+      lastConversionTime(0),
+      lastBytesRead(0)
 {
     computeRecordingLength();
 }
 
 TracesProvider::~TracesProvider(){
+    stopPrefetching();
+    resetPyramid();
+    unmapDataFile();
+    delete ncsFiles;
+}
+
+void TracesProvider::stopPrefetching(){
+    if(prefetcher == 0L)
+        return;
+    prefetcher->stop();
+    delete prefetcher;
+    prefetcher = 0L;
+}
+
+void TracesProvider::clearPrefetchedData(){
+    if(prefetcher != 0L)
+        prefetcher->clear();
+    QMutexLocker cacheLocker(&cacheMutex);
+    cache.clear();
+    previousRequestStartTime = -1;
+    ++dataVersion;
+}
+
+void TracesProvider::setCacheSize(int megabytes){
+    QMutexLocker locker(&cacheMutex);
+    cache.setMaxCost(qMax(0,megabytes) * 1024);
+}
+
+bool TracesProvider::startLiveUpdates(){
+    if(watcher == 0L){
+        if(!QFile::exists(fileName))
+            return false;
+        //Uses inotify on Linux, the file is not polled.
+        watcher = new QFileSystemWatcher(this);
+        watcher->addPath(fileName);
+        if(!watcher->files().contains(fileName)){
+            delete watcher;
+            watcher = 0L;
+            return false;
+        }
+        liveTimer = new QTimer(this);
+        liveTimer->setSingleShot(true);
+        liveTimer->setInterval(LIVE_UPDATE_DELAY);
+        connect(watcher,SIGNAL(fileChanged(QString)),this,SLOT(slotFileChanged()));
+        connect(liveTimer,SIGNAL(timeout()),this,SLOT(slotLiveUpdate()));
+    }
+    ++nbLiveViews;
+
+    //Data may have been appended since the last update.
+    slotFileChanged();
+    return true;
+}
+
+void TracesProvider::stopLiveUpdates(){
+    if(watcher == 0L || --nbLiveViews > 0)
+        return;
+    delete watcher;
+    watcher = 0L;
+    delete liveTimer;
+    liveTimer = 0L;
+}
+
+void TracesProvider::slotFileChanged(){
+    if(!liveTimer->isActive())
+        liveTimer->start();
+}
+
+void TracesProvider::slotLiveUpdate(){
+    //Some acquisition systems replace the file, the watch is then lost.
+    if(!watcher->files().contains(fileName) && QFile::exists(fileName))
+        watcher->addPath(fileName);
+
+    qlonglong previousLength = length;
+    updateRecordingLength();
+    if(length == previousLength)
+        return;
+
+    //The windows reaching the previous end of the recording have been shortened, discard them.
+    //The windows read ahead are all discarded, including the one being read.
+    if(prefetcher != 0L)
+        prefetcher->clear();
+    QMutexLocker locker(&cacheMutex);
+    QList<TraceWindow> windows = cache.keys();
+    QList<TraceWindow>::const_iterator iterator;
+    for(iterator = windows.begin(); iterator != windows.end(); ++iterator)
+        if((*iterator).endTime >= previousLength)
+            cache.remove(*iterator);
+
+    emit recordingLengthChanged(length);
+}
+
+long TracesProvider::timeToRecordingUnits(long startTime) const{
+    return static_cast<dataType>(startTime * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
+}
+
+bool TracesProvider::openNcsFiles(){
+    //The set of files depends on the number of channels.
+    if(ncsFiles != 0L && ncsFiles->getNbChannels() != nbChannels){
+        delete ncsFiles;
+        ncsFiles = 0L;
+    }
+    if(ncsFiles == 0L)
+        ncsFiles = new NCSFileSet(fileName,nbChannels);
+    return ncsFiles->open();
+}
+
+bool TracesProvider::supportsPyramid() const{
+    //Neuralynx recordings are split in one file per channel.
+    return fileName.lastIndexOf(".ncs") == -1;
+}
+
+bool TracesProvider::startPyramid(){
+    if(pyramid != 0L)
+        return true;
+    if(!supportsPyramid() || !TracesPyramid::isWorthBuilding(fileName,nbChannels,resolution))
+        return false;
+
+    pyramid = new TracesPyramid(fileName,nbChannels,resolution);
+    pyramid->start(QThread::LowestPriority);
+    return true;
+}
+
+void TracesProvider::resetPyramid(){
+    if(pyramid == 0L)
+        return;
+    pyramid->stop();
+    delete pyramid;
+    pyramid = 0L;
+}
+
+bool TracesProvider::mapDataFile(){
+    if(mappedData != 0L)
+        return true;
+    if(mappingUnavailable)
+        return false;
+
+    //Neuralynx recordings are split in one file per channel, they are always read with the QFile path.
+    if(fileName.lastIndexOf(".ncs") != -1){
+        mappingUnavailable = true;
+        return false;
+    }
+
+    mappedFile = new QFile(fileName);
+    if(!mappedFile->open(QIODevice::ReadOnly) || mappedFile->size() == 0){
+        delete mappedFile;
+        mappedFile = 0L;
+        mappingUnavailable = true;
+        return false;
+    }
+
+    //The mapping may fail on some filesystems (network shares, FUSE) or on 32 bits systems for very large files.
+    mappedSize = mappedFile->size();
+    mappedData = mappedFile->map(0,mappedSize);
+    if(mappedData == 0L){
+        qDebug()<<"the data file could not be mapped, using regular reads: "<<mappedFile->errorString();
+        mappedFile->close();
+        delete mappedFile;
+        mappedFile = 0L;
+        mappedSize = 0;
+        mappingUnavailable = true;
+        return false;
+    }
+
+    return true;
+}
+
+void TracesProvider::unmapDataFile(){
+    if(mappedFile != 0L){
+        if(mappedData != 0L)
+            mappedFile->unmap(mappedData);
+        mappedFile->close();
+        delete mappedFile;
+    }
+    mappedFile = 0L;
+    mappedData = 0L;
+    mappedSize = 0;
 }
 
 
@@ -62,7 +338,7 @@ dataType TracesProvider::getNbSamples(long startTime,long endTime,long startTime
     if(startTimeInRecordingUnits != 0)
         startInRecordingUnits = startTimeInRecordingUnits;
     else
-        startInRecordingUnits = static_cast<dataType>(startTime * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
+        startInRecordingUnits = timeToRecordingUnits(startTime);
 
     dataType endInRecordingUnits =  static_cast<dataType>(endTime * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
 
@@ -81,12 +357,211 @@ dataType TracesProvider::getNbSamples(long startTime,long endTime,long startTime
 
 void TracesProvider::requestData(long startTime,long endTime,QObject* initiator,long startTimeInRecordingUnits)
 {
-    retrieveData(startTime,endTime,initiator,startTimeInRecordingUnits);
+    retrieveData(startTime,endTime,initiator,startTimeInRecordingUnits,QList<int>());
 }
 
-void TracesProvider::retrieveData(long startTime,long endTime,QObject* initiator,long startTimeInRecordingUnits)
+void TracesProvider::requestData(long startTime,long endTime,QObject* initiator,long startTimeInRecordingUnits,const QList<int>& channels)
+{
+    retrieveData(startTime,endTime,initiator,startTimeInRecordingUnits,channels);
+}
+
+void TracesProvider::retrieveData(long startTime,long endTime,QObject* initiator,long startTimeInRecordingUnits,const QList<int>& channels)
+{
+    if(prefetcher == 0L)
+        prefetcher = new TracesPrefetcher(*this);
+    startPyramid();
+
+    //Use the cached window if another view or a previous request already decoded it,
+    //then the window read ahead if any, otherwise decode it now.
+    TraceWindow window(startTime,endTime,startTimeInRecordingUnits,channels);
+    cacheMutex.lock();
+    Array<dataType>* data = cache.take(window);
+    cacheMutex.unlock();
+    if(data == 0L)
+        data = prefetcher->take(window);
+    ++readStatistics.nbRequests;
+    if(data != 0L)
+        ++readStatistics.nbCacheHits;
+    else{
+        data = new Array<dataType>();
+        QElapsedTimer timer;
+        timer.start();
+        QMutexLocker locker(&readMutex);
+        //On failure, emit the signal with an empty array, the reciever will take care of it, given a message to the user.
+        if(!readData(startTime,endTime,startTimeInRecordingUnits,channels,*data))
+            data->setSize(0,0);
+        readStatistics.ioTime += qMax(Q_INT64_C(0),timer.nsecsElapsed() - lastConversionTime);
+        readStatistics.conversionTime += lastConversionTime;
+        readStatistics.bytesRead += lastBytesRead;
+    }
+
+    //The windows following a request made in recording units (spike browsing) are not predictable.
+    if(startTimeInRecordingUnits == 0)
+        schedulePrefetch(startTime,endTime,channels);
+    else
+        previousRequestStartTime = -1;
+
+    //Send the information to the receiver, the receivers copy the data they keep.
+    emit dataReady(*data,initiator);
+
+    //Keep the window for the next requests, it becomes the most recently used one.
+    //An empty window (read error) is not kept, the next request will retry to read it.
+    //A window larger than the whole budget is deleted by the cache.
+    cacheWindow(window,data);
+}
+
+void TracesProvider::requestPartialData(long startTime,long endTime,QObject* initiator,long startTimeInRecordingUnits,const QList<int>& channels,long frameEndTime)
+{
+    //The request made in recording units must not reset the navigation used to extrapolate the windows to read ahead,
+    //the time frame being the one of a scroll.
+    long requestStartTime = previousRequestStartTime;
+    long requestTimeFrame = previousRequestTimeFrame;
+    retrieveData(startTime,endTime,initiator,startTimeInRecordingUnits,channels);
+    previousRequestStartTime = requestStartTime;
+    previousRequestTimeFrame = requestTimeFrame;
+
+    if(prefetcher != 0L)
+        schedulePrefetch(startTime,frameEndTime,channels);
+}
+
+bool TracesProvider::hasWindow(long startTime,long endTime,long startTimeInRecordingUnits,const QList<int>& channels)
+{
+    TraceWindow window(startTime,endTime,startTimeInRecordingUnits,channels);
+    {
+        QMutexLocker locker(&cacheMutex);
+        if(cache.contains(window))
+            return true;
+    }
+    return prefetcher != 0L && prefetcher->isAvailable(window);
+}
+
+bool TracesProvider::getData(long startTime,long endTime,long startTimeInRecordingUnits,const QList<int>& channels,Array<dataType>& data)
+{
+    TraceWindow window(startTime,endTime,startTimeInRecordingUnits,channels);
+    {
+        QMutexLocker locker(&cacheMutex);
+        Array<dataType>* cached = cache.object(window);
+        if(cached != 0L){
+            data = *cached;
+            return true;
+        }
+    }
+
+    //The window is decoded without holding the cache, the other threads may use it meanwhile.
+    Array<dataType>* decoded = new Array<dataType>();
+    {
+        QMutexLocker locker(&readMutex);
+        if(!readData(startTime,endTime,startTimeInRecordingUnits,channels,*decoded)){
+            delete decoded;
+            return false;
+        }
+    }
+    data = *decoded;
+    cacheWindow(window,decoded);
+    return true;
+}
+
+void TracesProvider::cacheWindow(const TraceWindow& window,Array<dataType>* data)
+{
+    QMutexLocker locker(&cacheMutex);
+    int cost = static_cast<int>(static_cast<qint64>(data->nbOfRows()) * data->nbOfColumns() * sizeof(dataType) / 1024) + 1;
+    if(data->nbOfRows() == 0 || cache.maxCost() == 0)
+        delete data;
+    else
+        cache.insert(window,data,cost);
+}
+
+bool TracesProvider::requestEnvelope(long startTime,long endTime,QObject* initiator,long maxBinSize,const QList<int>& channels)
+{
+    if(!startPyramid())
+        return false;
+
+    dataType startInRecordingUnits = static_cast<dataType>(startTime * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
+    dataType nbSamples = getNbSamples(startTime,endTime,0);
+
+    Array<dataType> envelope;
+    qint64 binSize;
+    qint64 binOffset;
+    if(!pyramid->readEnvelope(startInRecordingUnits,nbSamples,maxBinSize,envelope,binSize,binOffset))
+        return false;
+
+    //Keep only the requested channels.
+    if(!channels.isEmpty()){
+        Array<dataType> selected(envelope.nbOfRows(),channels.size());
+        for(int row = 0; row < envelope.nbOfRows(); ++row){
+            const dataType* values = &envelope[row * nbChannels];
+            dataType* selectedValues = &selected[row * channels.size()];
+            for(int i = 0; i < channels.size(); ++i)
+                selectedValues[i] = values[channels.at(i)];
+        }
+        envelope = selected;
+    }
+
+    //Apply the offset if need it and convert to uV, as for the raw samples.
+    double acquisitionGain = (voltageRange * 1000000) / (pow(2.0, resolution) * amplification);
+    qint64 nbValues = static_cast<qint64>(envelope.nbOfRows()) * envelope.nbOfColumns();
+    if(offset != 0){
+        for(qint64 i = 0; i < nbValues; ++i)
+            envelope[i] = round(envelope[i] - offset * acquisitionGain);
+    }
+    else{
+        for(qint64 i = 0; i < nbValues; ++i)
+            envelope[i] = round(envelope[i] * acquisitionGain);
+    }
+
+    //Send the information to the receiver.
+    emit envelopeReady(envelope,binSize,binOffset,initiator);
+    return true;
+}
+
+void TracesProvider::prefetchData(long startTime,long endTime,long startTimeInRecordingUnits,const QList<int>& channels){
+    if(startTime < 0 || endTime > length || endTime < startTime)
+        return;
+    if(prefetcher == 0L)
+        prefetcher = new TracesPrefetcher(*this);
+
+    QList<TraceWindow> windows;
+    TraceWindow window(startTime,endTime,startTimeInRecordingUnits,channels);
+    QMutexLocker locker(&cacheMutex);
+    if(!cache.contains(window))
+        windows.append(window);
+    locker.unlock();
+    prefetcher->prefetch(windows);
+}
+
+void TracesProvider::cancelPrefetch(){
+    if(prefetcher != 0L)
+        prefetcher->prefetch(QList<TraceWindow>());
+}
+
+void TracesProvider::schedulePrefetch(long startTime,long endTime,const QList<int>& channels){
+    long timeFrame = endTime - startTime;
+    long step = timeFrame;
+    //Keep going in the same direction and with the same step as the previous move if the page size has not changed
+    //(scrolling or paging backward or forward), otherwise assume the user is paging forward.
+    if(previousRequestStartTime != -1 && timeFrame == previousRequestTimeFrame && startTime != previousRequestStartTime)
+        step = startTime - previousRequestStartTime;
+
+    previousRequestStartTime = startTime;
+    previousRequestTimeFrame = timeFrame;
+
+    QList<TraceWindow> windows;
+    QMutexLocker locker(&cacheMutex);
+    for(int i = 1; i <= 2; ++i){
+        long nextStart = startTime + i * step;
+        if(nextStart < 0 || nextStart + timeFrame > length)
+            break;
+        TraceWindow window(nextStart,nextStart + timeFrame,0,channels);
+        //A window already in the cache does not need to be read again.
+        if(!cache.contains(window))
+            windows.append(window);
+    }
+    locker.unlock();
+    prefetcher->prefetch(windows);
+}
+
+bool TracesProvider::readData(long startTime,long endTime,long startTimeInRecordingUnits,const QList<int>& channels,Array<dataType>& data)
 {
-    Array<dataType> data;
     //When the bug in gcc will be corrected for the 64 bits, the c++ code will be use
     //[alex@slut]/home/alex/src/sizetest > ./sizetest-2.95.3
     //  sizeof(std::streamoff) = 8 bytes (64 bits)
@@ -114,7 +589,7 @@ void TracesProvider::retrieveData(long startTime,long endTime,QObject* initiator
     //startTimeInRecordingUnits has been computed in a previous call to a clustersProvider browsing function. It has to be used insted of computing
     //the value from startTime because of the rounding which has been applied to it.
     if(startTimeInRecordingUnits != 0) startInRecordingUnits = startTimeInRecordingUnits;
-    else startInRecordingUnits = static_cast<dataType>(startTime * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
+    else startInRecordingUnits = timeToRecordingUnits(startTime);
     dataType endInRecordingUnits =  static_cast<dataType>(endTime * static_cast<double>(static_cast<double>(samplingRate) / static_cast<double>(1000)));
 
     //The caller should have check that we do not go over the end of the file.
@@ -124,207 +599,122 @@ void TracesProvider::retrieveData(long startTime,long endTime,QObject* initiator
     if(endTime == length) endInRecordingUnits--;
 
     dataType nbSamples = static_cast<dataType>(endInRecordingUnits - startInRecordingUnits) + 1;
+    lastConversionTime = 0;
+    lastBytesRead = 0;
+    QElapsedTimer conversionTimer;
 
-    //data will contain the final values.
-    data.setSize(nbSamples,nbChannels);
+    //data will contain the final values, one column per requested channel.
+    const int nbColumns = channels.isEmpty() ? nbChannels : channels.size();
+    data.setSize(nbSamples,nbColumns);
 
     // Compute acquisition gain
     double acquisitionGain = (voltageRange * 1000000) / (pow(2.0, resolution) * amplification);
 
     //Depending on the acquisition system resolution, the data are store as short or long
     if((resolution == 12) | (resolution == 14) | (resolution == 16)){
-        Array<int16_t> retrieveData(nbSamples,nbChannels);
+        //retrieveData is only filled when the data can not be read straight from the memory mapping.
+        Array<int16_t> retrieveData;
+        const int16_t* samples = 0L;
+        bool gathered = false;
         qint64 nbValues = nbSamples * nbChannels;
         // Is this a Neuralynx file?
         int p = fileName.lastIndexOf(".ncs");
         if ( p != -1 )
         {
-            qDebug()<<"NCS";
-            /// Modified by M.Zugaro to read Neuralynx ncs format
-
-            // Neuralynx headers
-            char			fileHeader[16*1024];
-            char			recordHeader[20];
-            const int	nSamplesPerRecord = 512;
-            int16_t		buffer[nSamplesPerRecord];
-            int			recordSize = sizeof(recordHeader)+sizeof(buffer);
-
-            // Determine offset in ncs file
-            int64_t	firstRecord = startInRecordingUnits/nSamplesPerRecord;
-            int		offsetInFirstRecord = startInRecordingUnits-firstRecord*nSamplesPerRecord;
-            qint64		position = (qint64)(sizeof(fileHeader)+firstRecord*recordSize+sizeof(recordHeader)+offsetInFirstRecord*sizeof(int16_t));
-
-            // Data will be read starting somewhere in the first record (not necessarily at the beginning), proceeding with
-            // a number of complete records, and ending somwhere in the last record (not necessarily at the end)
-            int		inFirstRecord = nSamplesPerRecord-offsetInFirstRecord;
-            int64_t	nRecords = (nbSamples-inFirstRecord)/nSamplesPerRecord;
-            int		inLastRecord = nbSamples-nRecords*nSamplesPerRecord-inFirstRecord-1;
-            qint64		nRead;
-
-            int p = fileName.lastIndexOf(".");
-            QString baseName = fileName;
-            baseName.truncate(p-1);
-            p = baseName.lastIndexOf(QRegExp("[^0-9]"));
-            baseName.truncate(p+1);
-
-            for ( int channel = 1 ; channel <= nbChannels ; ++channel )
-            {
-                // Open CSC file
-                QString cscFileName;
-                FILE* dataFile;
-                for ( int i = 0 ; i <= 3 ; ++i )
-                {
-                    // Files are numbered 1...N but we do not know if they are zero-padded,
-                    // so we try different padding lengths (from 0 to 3 digits)
-                    QString pad;
-                    for ( int j = 0 ; j < i ; ++j )
-                        pad += "0";
-                    cscFileName = baseName + pad + QString::fromLatin1("%1.ncs").arg(channel);
-                    dataFile = fopen(cscFileName.toLatin1(),"rb");
-                    if (dataFile != NULL) break;
-                }
-                if (dataFile == NULL)
-                {
-                    // Emit the signal with an empty array, let the receiver handle the error (user message).
+            /// Neuralynx ncs format, one file per channel (initially added by M.Zugaro)
+            //Only the files of the requested channels are read, retrieveData is already de-interleaved.
+            if(!openNcsFiles()){
+                // Emit the signal with an empty array, let the receiver handle the error (user message).
+                data.setSize(0,0);
+                return false;
+            }
+            retrieveData.setSize(nbSamples,nbColumns);
+            samples = &retrieveData[0];
+            gathered = true;
+            ncsFiles->read(startInRecordingUnits,nbSamples,channels,&retrieveData[0]);
+        }
+        else
+        {
+            qint64 position = static_cast<qint64>(static_cast<qint64>(startInRecordingUnits)* static_cast<qint64>(nbChannels));
+
+            //Read straight from the memory mapping if the requested samples are within the mapped file,
+            //otherwise fall back on a regular read.
+            if(mapDataFile() && position >= 0 && (position + nbValues) * static_cast<qint64>(sizeof(int16_t)) <= mappedSize){
+                samples = reinterpret_cast<const int16_t*>(mappedData) + position;
+            }
+            else{
+                QFile dataFile(fileName);
+                if (!dataFile.open(QIODevice::ReadOnly)) {
                     data.setSize(0,0);
-                    emit dataReady(data,initiator);
-                    return;
+                    return false;
                 }
 
-                // Start at appropriate offset
-                fseeko64(dataFile,position,SEEK_SET);
-
-                // 1) Read the rest of the first record
-                nRead = fread((char*)buffer,sizeof(int16_t),inFirstRecord,dataFile);
-                if (nRead != inFirstRecord)
-                {
-                    // Do not report an error, because Neuralynx files do not necessarily all have the same number of
-                    // records (sometimes the last record is missing...)
-
-                    // Emit the signal with an empty array, let the receiver handle the error (user message).
-                    //data.setSize(0,0);
-                    //fclose(dataFile);
-                    //emit dataReady(data,initiator);
-                    //return;
-                }
-                for ( int i = 0 ; i < inFirstRecord ; ++i ) retrieveData[i*nbChannels+channel-1] = buffer[i];
-
-                // 2) Read N full records
-                for ( int r = 0 ; r < nRecords ; ++r )
-                {
-                    fread(recordHeader,sizeof(recordHeader),1,dataFile); // skip header
-                    nRead = fread((char*)buffer,sizeof(int16_t),nSamplesPerRecord,dataFile);
-                    if (nRead != nSamplesPerRecord)
-                    {
-                        // Do not report an error, because Neuralynx files do not necessarily all have the same number of
-                        // records (sometimes the last record is missing...)
-
-                        // Emit the signal with an empty array, let the receiver handle the error (user message).
-                        //data.setSize(0,0);
-                        //fclose(dataFile);
-                        //emit dataReady(data,initiator);
-                        //return;
-                    }
-                    for ( int i = 0 ; i < nSamplesPerRecord ; ++i ) retrieveData[(i+inFirstRecord+r*nSamplesPerRecord)*nbChannels+channel-1] = buffer[i];
-                }
+                retrieveData.setSize(nbSamples,nbChannels);
+                dataFile.seek(position * sizeof(int16_t));
+                qint64 nbRead = dataFile.read(reinterpret_cast<char*>(&retrieveData[0]), sizeof(int16_t) * nbValues);
 
-                // 3) Read the beginning of the last record
-                if ( inLastRecord > 0 )
-                {
-                    fread(recordHeader,sizeof(recordHeader),1,dataFile); // skip header
-                    nRead = fread((char*)buffer,sizeof(int16_t),inLastRecord,dataFile);
-                    if (nRead != inLastRecord)
-                    {
-                        // Do not report an error, because Neuralynx files do not necessarily all have the same number of
-                        // records (sometimes the last record is missing...)
-
-                        // Emit the signal with an empty array, let the receiver handle the error (user message).
-                        //data.setSize(0,0);
-                        //fclose(dataFile);
-                        //emit dataReady(data,initiator);
-                        //return;
-                    }
-                    for ( int i = 0 ; i < inLastRecord ; ++i )
-                        retrieveData[(i+inFirstRecord+nRecords*nSamplesPerRecord)*nbChannels+channel-1] = buffer[i];
+                // copy the data into retrieveData.
+                if(nbRead != qint64(nbValues*sizeof(int16_t))){
+                    //emit the signal with an empty array, the reciever will take care of it, given a message to the user.
+                    data.setSize(0,0);
+                    dataFile.close();
+                    return false;
                 }
-                fclose(dataFile);
+                dataFile.close();
+                samples = &retrieveData[0];
             }
-            /// (end of code modified by M.Zugaro)
         }
-        else
-        {
+        //Apply the offset if need it,convert to dataType and store the values in data.
+        conversionTimer.start();
+        if(gathered){
+            convertSamplesInParallel(samples,&data[0],nbSamples,nbColumns,QList<int>(),acquisitionGain,offset * acquisitionGain,offset != 0);
+            lastBytesRead = static_cast<qint64>(nbSamples) * nbColumns * sizeof(int16_t);
+        }
+        else{
+            convertSamplesInParallel(samples,&data[0],nbSamples,nbChannels,channels,acquisitionGain,offset * acquisitionGain,offset != 0);
+            lastBytesRead = nbValues * sizeof(int16_t);
+        }
+        lastConversionTime = conversionTimer.nsecsElapsed();
+    } else if(resolution == 32) {
+        Array<int32_t> retrieveData;
+        const int32_t* samples = 0L;
+        qint64 nbValues = nbSamples * nbChannels;
+        qint64 position = static_cast<qint64>(static_cast<qint64>(startInRecordingUnits)* static_cast<qint64>(nbChannels));
+
+        if(mapDataFile() && position >= 0 && (position + nbValues) * static_cast<qint64>(sizeof(int32_t)) <= mappedSize){
+            samples = reinterpret_cast<const int32_t*>(mappedData) + position;
+        }
+        else{
             QFile dataFile(fileName);
             if (!dataFile.open(QIODevice::ReadOnly)) {
                 data.setSize(0,0);
-                emit dataReady(data,initiator);
-                return;
+                return false;
             }
 
-            qint64 position = static_cast<qint64>(static_cast<qint64>(startInRecordingUnits)* static_cast<qint64>(nbChannels));
-
-            dataFile.seek(position * sizeof(int16_t));
-            qint64 nbRead = dataFile.read(reinterpret_cast<char*>(&retrieveData[0]), sizeof(int16_t) * nbValues);
+            retrieveData.setSize(nbSamples,nbChannels);
+            dataFile.seek(position * sizeof(int32_t));
+            qint64 nbRead = dataFile.read(reinterpret_cast<char*>(&retrieveData[0]), sizeof(int32_t) * nbValues);
 
             // copy the data into retrieveData.
-            if(nbRead != qint64(nbValues*sizeof(int16_t))){
+            if(nbRead != qint64(nbValues*sizeof(int32_t))){
                 //emit the signal with an empty array, the reciever will take care of it, given a message to the user.
                 data.setSize(0,0);
                 dataFile.close();
-                emit dataReady(data,initiator);
-                return;
+                return false;
             }
+            //The data have been retrieve, close the file.
             dataFile.close();
+            samples = &retrieveData[0];
         }
-        //Apply the offset if need it,convert to dataType and store the values in data.
-        if(offset != 0){
-            for(qint64 i = 0; i < nbValues; ++i){
-                data[i] = round(static_cast<dataType>(retrieveData[i]) - offset * acquisitionGain);
-            }
-        } else {
 
-            for(qint64 i = 0; i < nbValues; ++i){
-                data[i] = round(static_cast<dataType>(retrieveData[i]) * acquisitionGain);
-            }
-        }
-    } else if(resolution == 32) {
-
-        QFile dataFile(fileName);
-        if (!dataFile.open(QIODevice::ReadOnly)) {
-            data.setSize(0,0);
-            emit dataReady(data,initiator);
-            return;
-        }
-        Array<dataType> retrieveData(nbSamples,nbChannels);
-        qint64 nbValues = nbSamples * nbChannels;
-        qint64 position = static_cast<qint64>(static_cast<qint64>(startInRecordingUnits)* static_cast<qint64>(nbChannels));
-
-        dataFile.seek(position * sizeof(int32_t));
-        qint64 nbRead = dataFile.read(reinterpret_cast<char*>(&retrieveData[0]), sizeof(int32_t) * nbValues);
-
-        // copy the data into retrieveData.
-        if(nbRead != qint64(nbValues*sizeof(int32_t))){
-            //emit the signal with an empty array, the reciever will take care of it, given a message to the user.
-            data.setSize(0,0);
-            dataFile.close();
-            emit dataReady(data,initiator);
-            return;
-        }
         //Apply the offset if need it and store the values in data.
-        if(offset != 0){
-            for(qint64 i = 0; i < nbValues; ++i)
-                data[i] = round(retrieveData[i] - offset * acquisitionGain);
-        }
-        else{
-            for(qint64 i = 0; i < nbValues; ++i){
-                data[i] = round(retrieveData[i] * acquisitionGain);
-            }
-        }
-        //The data have been retrieve, close the file.
-        dataFile.close();
+        conversionTimer.start();
+        convertSamplesInParallel(samples,&data[0],nbSamples,nbChannels,channels,acquisitionGain,offset * acquisitionGain,offset != 0);
+        lastConversionTime = conversionTimer.nsecsElapsed();
+        lastBytesRead = nbValues * sizeof(int32_t);
     }
 
-    //Send the information to the receiver.
-    emit dataReady(data,initiator);
+    return true;
 }
 
 void TracesProvider::computeRecordingLength(){
@@ -348,24 +738,45 @@ void TracesProvider::computeRecordingLength(){
  qint64 fileLength = dataFile.tellg();
  dataFile.close();*/
 
-    QFile f(fileName);
-    if (!f.open(QIODevice::ReadOnly)) {
+    //Only the size of the file is needed, it is not opened.
+    QFileInfo fInfo(fileName);
+    if (!fInfo.isReadable()) {
+        unmapDataFile();
+        dataFileSize = -1;
         length = 0;
         return;
     }
-    f.close();
-    QFileInfo fInfo(fileName);
     qint64 fileLength = fInfo.size();
 
+    //If the file has grown (recording in progress), the current mapping does not cover the new data,
+    //release it, the file will be remapped on the next retrieve. A file which could not be mapped is only
+    //tried again once its size has changed.
+    if(fileLength != dataFileSize){
+        dataFileSize = fileLength;
+        unmapDataFile();
+        mappingUnavailable = false;
+    }
+
     int dataSize = 0;
     if((resolution == 12) | (resolution == 14) | (resolution == 16)) dataSize = 2;
     else if(resolution == 32) dataSize = 4;
 
     // Is this a Neuralynx file?
     int p = fileName.lastIndexOf(".ncs");
-    if ( p != -1 )
+    if ( p != -1 && openNcsFiles() )
+    {
+        //Index the records appended since the last computation, the length is the one of the longest channel.
+        ncsFiles->update();
+        length = static_cast<qlonglong>(
+                    static_cast<float>(
+                        ncsFiles->getNbSamples() / static_cast<float>(samplingRate)
+                        ) * 1000
+                    );
+    }
+    else if ( p != -1 )
     {
         /// Modified by M.Zugaro to read Neuralynx ncs format
+        //Some files of the set are missing, estimate the length from the size of the file.
 
         // Neuralynx headers
         char			fileHeader[16*1024];
@@ -22,10 +22,20 @@
 #include <dataprovider.h>
 #include <array.h>
 #include <types.h>
+#include "tracesprefetcher.h"
 
 // include files for QT
 #include <QObject>
 #include <QStringList>
+#include <QList>
+#include <QMutex>
+#include <QCache>
+
+class QFile;
+class QFileSystemWatcher;
+class QTimer;
+class TracesPyramid;
+class NCSFileSet;
 
 /**Class providing the row recorded data (contained in a .dat or .eeg file).
   *@author Lynn Hazan
@@ -34,6 +44,7 @@
 
 class TracesProvider : public DataProvider  {
     Q_OBJECT
+    friend class TracesPrefetcher;
 public:
 
     /**Constructor.
@@ -47,7 +58,34 @@ public:
     virtual ~TracesProvider();
 
     /// Added by M.Zugaro to enable automatic forward paging
-    void updateRecordingLength() { computeRecordingLength(); }
+    void updateRecordingLength() {
+        QMutexLocker locker(&readMutex);
+        computeRecordingLength();
+    }
+
+    /**Follows the growth of the data file while it is being recorded: the file is watched and
+  * recordingLengthChanged is emitted when data have been appended. Each call has to be balanced by a call to stopLiveUpdates.
+  * @return true if the file can be watched, false if its length has to be polled with updateRecordingLength.
+  */
+    bool startLiveUpdates();
+
+    /**Stops following the growth of the data file when no more view needs it.*/
+    void stopLiveUpdates();
+
+    /**Returns the index of the first sample retrieved for a time frame starting at @p startTime.
+  * @param startTime begining of the time frame, given in milisecond.
+  */
+    virtual long timeToRecordingUnits(long startTime) const;
+
+    /**Returns a number changed each time the parameters used to decode the data are modified, the data retrieved
+  * with a different version are obsolete.
+  */
+    int getDataVersion() const {return dataVersion;}
+
+    /**Returns true if a time frame can be retrieved in several parts, the samples of a part starting at a given index
+  * being the same as the ones of the whole time frame.
+  */
+    virtual bool supportsPartialRetrieve() const {return true;}
 
     /**Triggers the retrieve of the traces included in the time rate given by @p startTime and @p endTime.
   * @param startTime begining of the time frame from which to retrieve the data, given in milisecond.
@@ -57,48 +95,119 @@ public:
   */
     void requestData(long startTime,long endTime,QObject* initiator,long startTimeInRecordingUnits);
 
+    /**Triggers the retrieve of the traces of the channels @p channels included in the time rate given by @p startTime and @p endTime.
+  * Only those channels are read and converted, the columns of the array sent by dataReady are the channels of @p channels, in the same order.
+  * @param startTime begining of the time frame from which to retrieve the data, given in milisecond.
+  * @param endTime end of the time frame from which to retrieve the data, given in milisecond.
+  * @param initiator instance requesting the data.
+  * @param startTimeInRecordingUnits begining of the time interval from which to retrieve the data in recording units.
+  * @param channels ids of the channels to retrieve, all the channels if empty.
+  */
+    void requestData(long startTime,long endTime,QObject* initiator,long startTimeInRecordingUnits,const QList<int>& channels);
+
+    /**Triggers the retrieve of the samples of the channels @p channels missing in a view which already has the others samples of the time frame
+  * given by @p startTime and @p frameEndTime, then schedules the read ahead of the windows following that whole time frame.
+  * @param startTime begining of the time frame, given in milisecond.
+  * @param endTime end of the time interval from which to retrieve the data, given in milisecond.
+  * @param initiator instance requesting the data.
+  * @param startTimeInRecordingUnits first sample to retrieve, in recording units.
+  * @param channels ids of the channels to retrieve, all the channels if empty.
+  * @param frameEndTime end of the time frame, given in milisecond.
+  */
+    void requestPartialData(long startTime,long endTime,QObject* initiator,long startTimeInRecordingUnits,const QList<int>& channels,long frameEndTime);
+
+    /**Returns true if the traces of the channels @p channels included in the time frame given by @p startTime and @p endTime
+  * are available without being decoded, either kept in the cache or read ahead.
+  * @param startTime begining of the time frame, given in milisecond.
+  * @param endTime end of the time frame, given in milisecond.
+  * @param startTimeInRecordingUnits begining of the time frame in recording units.
+  * @param channels ids of the channels, all the channels if empty.
+  */
+    bool hasWindow(long startTime,long endTime,long startTimeInRecordingUnits,const QList<int>& channels);
+
+    /**Hints that the traces included in the time frame given by @p startTime and @p endTime are likely to be requested soon,
+  * typically the target of the following jump to the next or previous event or spike. The data are read ahead in a background
+  * thread, replacing the windows waiting to be read ahead.
+  * @param startTime begining of the time frame, given in milisecond.
+  * @param endTime end of the time frame, given in milisecond.
+  * @param startTimeInRecordingUnits begining of the time frame in recording units.
+  * @param channels ids of the channels which will be requested, all the channels if empty.
+  */
+    virtual void prefetchData(long startTime,long endTime,long startTimeInRecordingUnits = 0,const QList<int>& channels = QList<int>());
+
+    /**Cancels the read ahead of the windows which have not been read yet, the hint given to prefetchData being obsolete.*/
+    void cancelPrefetch();
+
+    /**Triggers the retrieve of the min/max envelope of the traces included in the time rate given by @p startTime and @p endTime,
+  * read from the overview of the data file instead of the raw samples. Used to draw the zoomed out views.
+  * @param startTime begining of the time frame from which to retrieve the data, given in milisecond.
+  * @param endTime end of the time frame from which to retrieve the data, given in milisecond.
+  * @param initiator instance requesting the data.
+  * @param maxBinSize maximum number of samples summarized by each bin of the envelope.
+  * @param channels ids of the channels to retrieve, all the channels if empty.
+  * @return true if envelopeReady has been emitted, false if the overview is not available yet for this time frame
+  * and the caller has to request the raw data.
+  */
+    bool requestEnvelope(long startTime,long endTime,QObject* initiator,long maxBinSize,const QList<int>& channels = QList<int>());
+
     /**Sets the number of channels corresponding to the file identified by fileUrl.
   * @param nb the number of channels.
   */
     virtual void setNbChannels(int nb){
+        QMutexLocker locker(&readMutex);
         nbChannels = nb;
         computeRecordingLength();
+        clearPrefetchedData();
+        resetPyramid();
     }
 
     /**Sets the resolution used to record the data contained in the file identified by fileUrl.
   * @param res resolution.
   */
    virtual void setResolution(int res){
+        QMutexLocker locker(&readMutex);
         resolution = res;
         computeRecordingLength();
+        clearPrefetchedData();
+        resetPyramid();
     }
 
     /**Sets the sampling rate used to record the data contained in the file identified by fileUrl.
   * @param rate the sampling rate.
   */
     virtual void setSamplingRate(double rate){
+        QMutexLocker locker(&readMutex);
         samplingRate = rate;
         computeRecordingLength();
+        clearPrefetchedData();
     }
 
     /**Sets the voltage range used to record the data contained in the file identified by fileUrl.
   * @param range the voltage range.
   */
     virtual void setVoltageRange(int range){
+      QMutexLocker locker(&readMutex);
       voltageRange = range;
+      clearPrefetchedData();
     }
 
     /**Sets the amplification used to record the data contained in the file identified by fileUrl.
   * @param value the amplification.
   */
     virtual void setAmplification(int value){
+      QMutexLocker locker(&readMutex);
       amplification = value;
+      clearPrefetchedData();
     }
 
     /**Sets the offset to apply to the data contained in the file identified by fileUrl.
   * @param newOffset offset.
   */
-    void setOffset(int newOffset){offset =  newOffset;}
+    void setOffset(int newOffset){
+        QMutexLocker locker(&readMutex);
+        offset =  newOffset;
+        clearPrefetchedData();
+    }
 
     /**Returns the number of channels corresponding to the file identified by fileUrl.
   */
@@ -140,6 +249,53 @@ public:
     /** Return the label for each channel, by default just the ID of the channel. */
     virtual QStringList getLabels();
 
+    /**Sets the memory budget of the cache of decoded windows shared by all the views of the document.
+  * The least recently used windows are discarded when the budget is exceeded.
+  * @param megabytes maximum amount of memory used by the cache, in megabytes, 0 to disable the cache.
+  */
+    void setCacheSize(int megabytes);
+
+    /**Returns the memory budget of the cache of decoded windows, in megabytes.*/
+    int getCacheSize() const {
+        QMutexLocker locker(&cacheMutex);
+        return cache.maxCost() / 1024;
+    }
+
+    /**Retrieves synchronously the traces included in the time frame given by @p startTime and @p endTime, from the cache
+  * of decoded windows if possible. Unlike requestData, this function may be called from several threads at once.
+  * @param startTime begining of the time frame from which to retrieve the data, given in milisecond.
+  * @param endTime end of the time frame from which to retrieve the data, given in milisecond.
+  * @param startTimeInRecordingUnits begining of the time interval from which to retrieve the data in recording units.
+  * @param channels ids of the channels to retrieve, all the channels if empty.
+  * @param data array filled with the data in uV (number of samples X number of retrieved channels).
+  * @return true if the data could be read, false otherwise.
+  */
+    bool getData(long startTime,long endTime,long startTimeInRecordingUnits,const QList<int>& channels,Array<dataType>& data);
+
+    /**Time spent and data read by the requests of the views, see takeReadStatistics.*/
+    struct ReadStatistics{
+        ReadStatistics():ioTime(0),conversionTime(0),bytesRead(0),nbRequests(0),nbCacheHits(0){}
+
+        /**Time spent reading and converting the samples, in nanoseconds. The reads from the memory mapping
+      * happen while the samples are converted.*/
+        qint64 ioTime;
+        qint64 conversionTime;
+
+        /**Number of bytes of the data file read or mapped.*/
+        qint64 bytesRead;
+
+        /**Number of requests, and how many of them were served by the cache of decoded windows or the windows read ahead.*/
+        int nbRequests;
+        int nbCacheHits;
+    };
+
+    /**Returns the statistics of the requests made since the previous call, and resets them.*/
+    ReadStatistics takeReadStatistics(){
+        ReadStatistics statistics = readStatistics;
+        readStatistics = ReadStatistics();
+        return statistics;
+    }
+
 public Q_SLOTS:
     /** Called when paging is started.
      * Usefull for trace providers that have live data sources.
@@ -151,6 +307,13 @@ public Q_SLOTS:
     */
     virtual void slotPagingStopped() {};
 
+private Q_SLOTS:
+    /**Called when the data file has been modified, the length is updated shortly after, once per burst of writes.*/
+    void slotFileChanged();
+
+    /**Updates the length of the recording in progress.*/
+    void slotLiveUpdate();
+
 Q_SIGNALS:
     /**Signals that the data have been retrieved.
   * @param data array of data in uV (number of channels X number of samples).
@@ -158,6 +321,19 @@ Q_SIGNALS:
   */
     void dataReady(Array<dataType>& data, QObject* initiator);
 
+    /**Signals that the envelope of the traces has been retrieved.
+  * @param envelope array of data in uV with two rows per bin, the minimum then the maximum of each channel.
+  * @param binSize number of samples summarized by each bin.
+  * @param binOffset number of samples of the first bin preceding the requested start time.
+  * @param initiator instance requesting the data.
+  */
+    void envelopeReady(Array<dataType>& envelope, long binSize, long binOffset, QObject* initiator);
+
+    /**Signals that data have been appended to the file being recorded.
+  * @param length new length of the recording in miliseconds.
+  */
+    void recordingLengthChanged(qlonglong length);
+
 protected:
     /**Number of channels used to record the data.*/
     int nbChannels;
@@ -180,15 +356,125 @@ protected:
     /**the total length of the document in miliseconds.*/
     qlonglong length;
 
+    /**Persistent handle on the data file, kept open as long as the file is memory mapped.*/
+    QFile* mappedFile;
+
+    /**Pointer on the memory mapping of the data file, 0 if the file is not mapped.*/
+    uchar* mappedData;
+
+    /**Size in bytes of the mapped data file.*/
+    qint64 mappedSize;
+
+    /**True if the data file could not be mapped, the data are then read with QFile.*/
+    bool mappingUnavailable;
+
+    /**Size in bytes of the data file when the recording length was last computed, -1 if it could not be read.*/
+    qint64 dataFileSize;
+
+    /**Serializes the decoding of the data between the GUI thread and the prefetching thread.*/
+    mutable QMutex readMutex;
+
+    /**Background reader of the windows likely to be requested next, created on the first request.*/
+    TracesPrefetcher* prefetcher;
+
+    /**Start time and duration, in miliseconds, of the previous request, used to predict the next one.*/
+    long previousRequestStartTime;
+    long previousRequestTimeFrame;
+
+    /**Min/max overview of the data file, created on the first request.*/
+    TracesPyramid* pyramid;
+
+    /**Windows recently decoded, shared by all the views of the document. The cost of each window is its size in kilobytes.*/
+    QCache<TraceWindow,Array<dataType> > cache;
+
+    /**Protects the cache, which is used by the GUI thread and the threads calling getData.*/
+    mutable QMutex cacheMutex;
+
+    /**Files of a Neuralynx recording (one .ncs file per channel), opened on the first read.*/
+    NCSFileSet* ncsFiles;
+
+    /**Watcher of the data file while it is being recorded, 0 if the growth of the file is not followed.*/
+    QFileSystemWatcher* watcher;
+
+    /**Delays the update of the length after a modification of the file, gathering the bursts of writes.*/
+    QTimer* liveTimer;
+
+    /**Number of views following the growth of the data file.*/
+    int nbLiveViews;
+
+    /**Incremented each time the decoded data become obsolete.*/
+    int dataVersion;
+
+    /**Time spent converting the samples, in nanoseconds, and number of bytes read by the last call to readData, the caller holding readMutex.*/
+    qint64 lastConversionTime;
+    qint64 lastBytesRead;
+
+    /**Statistics of the requests since the last call to takeReadStatistics, only used by the GUI thread.*/
+    ReadStatistics readStatistics;
+
     //Functions
 
+    /**Maps the whole data file into memory if it is not already the case.
+  * @return true if the data file is mapped, false if the caller has to read the data with QFile.
+  */
+    bool mapDataFile();
+
+    /**Releases the memory mapping of the data file and closes it.*/
+    void unmapDataFile();
+
+    /**Opens and indexes the files of a Neuralynx recording if it is not already the case.
+  * @return true if all the files of the recording are open, false otherwise.
+  */
+    bool openNcsFiles();
+
     /**Retrieves the traces included in the time frame given by @p startTime and @p endTime.
   * @param startTime begining of the time frame from which to retrieve the data, given in milisecond.
   * @param endTime end of the time frame from which to retrieve the data, given in milisecond.
   * @param initiator instance requesting the data.
   * @param startTimeInRecordingUnits begining of the time interval from which to retrieve the data in recording units.
+  * @param channels ids of the channels to retrieve, all the channels if empty.
   */
-    virtual void retrieveData(long startTime,long endTime,QObject* initiator,long startTimeInRecordingUnits);
+    virtual void retrieveData(long startTime,long endTime,QObject* initiator,long startTimeInRecordingUnits,const QList<int>& channels);
+
+    /**Decodes the traces included in the time frame given by @p startTime and @p endTime into @p data.
+  * The caller has to hold readMutex. This function may be called from the prefetching thread.
+  * @param startTime begining of the time frame from which to retrieve the data, given in milisecond.
+  * @param endTime end of the time frame from which to retrieve the data, given in milisecond.
+  * @param startTimeInRecordingUnits begining of the time interval from which to retrieve the data in recording units.
+  * @param channels ids of the channels to retrieve, all the channels if empty.
+  * @param data array filled with the data in uV (number of samples X number of retrieved channels).
+  * @return true if the data could be read, false otherwise.
+  */
+    virtual bool readData(long startTime,long endTime,long startTimeInRecordingUnits,const QList<int>& channels,Array<dataType>& data);
+
+    /**Keeps @p data, decoded for @p window, in the cache which takes its ownership.
+  * An empty window (read error) is deleted, as well as all the windows when the cache is disabled.
+  */
+    void cacheWindow(const TraceWindow& window,Array<dataType>* data);
+
+    /**Schedules the read ahead of the windows following the request given by @p startTime and @p endTime,
+  * extrapolating the direction and step of the navigation.
+  */
+    void schedulePrefetch(long startTime,long endTime,const QList<int>& channels);
+
+    /**Discards the windows read ahead and the cached windows, they have been decoded with obsolete parameters.*/
+    void clearPrefetchedData();
+
+    /**Stops the prefetching thread. Derived classes overriding readData have to call it in their destructor.*/
+    void stopPrefetching();
+
+    /**Returns true if the overview of the data file can be built, which requires the samples to be stored
+  * as a flat sequence of interleaved channels, without any header.
+  */
+    virtual bool supportsPyramid() const;
+
+    /**Starts building the overview of the data file if it has not been done yet.
+  * @return true if the overview exists, even if it is still being built.
+  */
+    bool startPyramid();
+
+    /**Discards the overview, it has been built with obsolete parameters.*/
+    void resetPyramid();
 
     /**Computes the total length of the document in miliseconds.*/
     virtual void computeRecordingLength();
@@ -0,0 +1,327 @@
+/***************************************************************************
+                          tracespyramid.cpp  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+//include files for the application
+#include "tracespyramid.h"
+
+// include files for QT
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+#include <QVector>
+#include <QDebug>
+
+// include c/c++ headers
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+const qint64 TracesPyramid::BASE_BIN_SIZE = 256;
+const qint64 TracesPyramid::LEVEL_FACTOR = 16;
+const int TracesPyramid::NB_LEVELS = 4;
+
+static const char PYRAMID_MAGIC[8] = {'N','S','P','Y','R','A','M','D'};
+static const qint32 PYRAMID_VERSION = 1;
+static const qint64 PYRAMID_HEADER_SIZE = 128;
+
+/**Number of bins of the finest level computed from each read of the data file.*/
+static const qint64 BINS_PER_CHUNK = 64;
+
+/**Files shorter than this number of bins of the finest level are drawn from the raw data only.*/
+static const qint64 MIN_NB_BINS = 1024;
+
+TracesPyramid::TracesPyramid(const QString& dataFileName,int nbChannels,int resolution)
+    : QThread(),
+      dataFileName(dataFileName),
+      nbChannels(nbChannels),
+      sampleSize(resolution == 32 ? 4 : 2),
+      totalSamples(0),
+      processedSamples(0),
+      stopped(false)
+{
+    QFileInfo fileInfo(dataFileName);
+    if(nbChannels > 0)
+        totalSamples = fileInfo.size() / (static_cast<qint64>(nbChannels) * sampleSize);
+}
+
+TracesPyramid::~TracesPyramid(){
+    stop();
+}
+
+bool TracesPyramid::isWorthBuilding(const QString& dataFileName,int nbChannels,int resolution){
+    if(nbChannels <= 0 || (resolution != 12 && resolution != 14 && resolution != 16 && resolution != 32))
+        return false;
+    QFileInfo fileInfo(dataFileName);
+    qint64 nbSamples = fileInfo.size() / (static_cast<qint64>(nbChannels) * (resolution == 32 ? 4 : 2));
+    return nbSamples >= MIN_NB_BINS * BASE_BIN_SIZE;
+}
+
+qint64 TracesPyramid::binSize(int level){
+    qint64 size = BASE_BIN_SIZE;
+    for(int i = 0; i < level; ++i)
+        size *= LEVEL_FACTOR;
+    return size;
+}
+
+qint64 TracesPyramid::nbBins(int level) const{
+    qint64 size = binSize(level);
+    return (totalSamples + size - 1) / size;
+}
+
+qint64 TracesPyramid::levelPosition(int level) const{
+    qint64 position = PYRAMID_HEADER_SIZE;
+    for(int i = 0; i < level; ++i)
+        position += nbBins(i) * nbChannels * 2 * sampleSize;
+    return position;
+}
+
+void TracesPyramid::stop(){
+    mutex.lock();
+    stopped = true;
+    mutex.unlock();
+    wait();
+}
+
+qint64 TracesPyramid::openSidecar(){
+    QFileInfo fileInfo(dataFileName);
+    sidecar.setFileName(fileInfo.absoluteFilePath() + ".pyr");
+    if(!sidecar.open(QIODevice::ReadWrite)){
+        //The data directory is read only, keep the overview in the temporary directory.
+        QByteArray key = QCryptographicHash::hash(fileInfo.absoluteFilePath().toUtf8(),QCryptographicHash::Md5).toHex();
+        sidecar.setFileName(QDir::temp().filePath(QString::fromLatin1("neuroscope-%1.pyr").arg(QString::fromLatin1(key))));
+        if(!sidecar.open(QIODevice::ReadWrite)){
+            qDebug()<<"the overview of "<<dataFileName<<" could not be created: "<<sidecar.errorString();
+            return -1;
+        }
+    }
+
+    Header expected;
+    memset(&expected,0,sizeof(Header));
+    memcpy(expected.magic,PYRAMID_MAGIC,sizeof(expected.magic));
+    expected.version = PYRAMID_VERSION;
+    expected.nbChannels = nbChannels;
+    expected.sampleSize = sampleSize;
+    expected.nbLevels = NB_LEVELS;
+    expected.baseBinSize = BASE_BIN_SIZE;
+    expected.levelFactor = LEVEL_FACTOR;
+    expected.sourceSize = totalSamples * nbChannels * sampleSize;
+    expected.sourceModified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    Header header;
+    qint64 totalSize = levelPosition(NB_LEVELS);
+    if(sidecar.size() == totalSize && sidecar.read(reinterpret_cast<char*>(&header),sizeof(Header)) == sizeof(Header)){
+        qint64 completedSamples = header.completedSamples;
+        header.completedSamples = 0;
+        if(memcmp(&header,&expected,sizeof(Header)) == 0 && completedSamples >= 0 && completedSamples <= totalSamples)
+            return completedSamples;
+    }
+
+    //Missing or obsolete overview (the data file has been modified or the parameters have changed), start from scratch.
+    if(!sidecar.resize(0) || !sidecar.resize(totalSize) || !sidecar.seek(0) ||
+            sidecar.write(reinterpret_cast<const char*>(&expected),sizeof(Header)) != sizeof(Header)){
+        qDebug()<<"the overview of "<<dataFileName<<" could not be initialized: "<<sidecar.errorString();
+        sidecar.close();
+        return -1;
+    }
+    sidecar.flush();
+    return 0;
+}
+
+void TracesPyramid::writeCompletedSamples(qint64 completedSamples){
+    QMutexLocker locker(&mutex);
+    sidecar.seek(offsetof(Header,completedSamples));
+    sidecar.write(reinterpret_cast<const char*>(&completedSamples),sizeof(qint64));
+    sidecar.flush();
+}
+
+void TracesPyramid::run(){
+    if(totalSamples == 0)
+        return;
+
+    mutex.lock();
+    qint64 completedSamples = openSidecar();
+    if(completedSamples >= 0)
+        processedSamples = completedSamples;
+    mutex.unlock();
+
+    if(completedSamples < 0 || completedSamples == totalSamples)
+        return;
+
+    if(sampleSize == 2)
+        buildLevels<int16_t>(completedSamples);
+    else
+        buildLevels<int32_t>(completedSamples);
+}
+
+template <typename T>
+void TracesPyramid::buildLevels(qint64 fromSample){
+    QFile dataFile(dataFileName);
+    if(!dataFile.open(QIODevice::ReadOnly))
+        return;
+
+    //The building always resumes at the beginning of a bin of the coarsest level, so that no bin is partially summarized.
+    const qint64 topBinSize = binSize(NB_LEVELS - 1);
+    const qint64 firstBin = fromSample / BASE_BIN_SIZE;
+    const qint64 nbBaseBins = nbBins(0);
+    const qint64 binValues = nbChannels * 2;
+
+    QVector<qint64> positions(NB_LEVELS);
+    for(int level = 0; level < NB_LEVELS; ++level)
+        positions[level] = levelPosition(level);
+
+    //Running minimum and maximum of the bin being summarized in each coarser level.
+    QVector< QVector<T> > accumulators(NB_LEVELS);
+    QVector<bool> accumulatorEmpty(NB_LEVELS,true);
+    for(int level = 1; level < NB_LEVELS; ++level)
+        accumulators[level].resize(binValues);
+
+    QVector<T> samples(BINS_PER_CHUNK * BASE_BIN_SIZE * nbChannels);
+    QVector<T> bins(BINS_PER_CHUNK * binValues);
+
+    for(qint64 chunkBin = firstBin; chunkBin < nbBaseBins; chunkBin += BINS_PER_CHUNK){
+        mutex.lock();
+        bool stopRequested = stopped;
+        mutex.unlock();
+        if(stopRequested)
+            return;
+
+        //Read the samples of the chunk.
+        qint64 firstChunkSample = chunkBin * BASE_BIN_SIZE;
+        qint64 nbChunkSamples = qMin(BINS_PER_CHUNK * BASE_BIN_SIZE,totalSamples - firstChunkSample);
+        qint64 nbBytes = nbChunkSamples * nbChannels * sizeof(T);
+        if(!dataFile.seek(firstChunkSample * nbChannels * sizeof(T)) ||
+                dataFile.read(reinterpret_cast<char*>(samples.data()),nbBytes) != nbBytes){
+            qDebug()<<"the overview of "<<dataFileName<<" could not be built, the data file could not be read";
+            return;
+        }
+
+        //Summarize them in the finest level.
+        qint64 nbChunkBins = (nbChunkSamples + BASE_BIN_SIZE - 1) / BASE_BIN_SIZE;
+        for(qint64 bin = 0; bin < nbChunkBins; ++bin){
+            T* minima = bins.data() + bin * binValues;
+            T* maxima = minima + nbChannels;
+            const T* sample = samples.data() + bin * BASE_BIN_SIZE * nbChannels;
+            for(int channel = 0; channel < nbChannels; ++channel)
+                minima[channel] = maxima[channel] = sample[channel];
+
+            qint64 nbBinSamples = qMin(BASE_BIN_SIZE,nbChunkSamples - bin * BASE_BIN_SIZE);
+            for(qint64 i = 1; i < nbBinSamples; ++i){
+                sample += nbChannels;
+                for(int channel = 0; channel < nbChannels; ++channel){
+                    if(sample[channel] < minima[channel]) minima[channel] = sample[channel];
+                    if(sample[channel] > maxima[channel]) maxima[channel] = sample[channel];
+                }
+            }
+        }
+
+        mutex.lock();
+        sidecar.seek(positions[0] + chunkBin * binValues * sizeof(T));
+        sidecar.write(reinterpret_cast<const char*>(bins.data()),nbChunkBins * binValues * sizeof(T));
+        mutex.unlock();
+
+        //Fold the new bins into the coarser levels, writing the bins which are complete.
+        for(qint64 bin = 0; bin < nbChunkBins; ++bin){
+            const T* values = bins.data() + bin * binValues;
+            qint64 baseBin = chunkBin + bin;
+            qint64 ratio = 1;
+            for(int level = 1; level < NB_LEVELS; ++level){
+                ratio *= LEVEL_FACTOR;
+                T* accumulator = accumulators[level].data();
+                if(accumulatorEmpty[level]){
+                    memcpy(accumulator,values,binValues * sizeof(T));
+                    accumulatorEmpty[level] = false;
+                }
+                else{
+                    for(int channel = 0; channel < nbChannels; ++channel){
+                        if(values[channel] < accumulator[channel]) accumulator[channel] = values[channel];
+                        if(values[nbChannels + channel] > accumulator[nbChannels + channel]) accumulator[nbChannels + channel] = values[nbChannels + channel];
+                    }
+                }
+
+                if((baseBin + 1) % ratio == 0 || baseBin + 1 == nbBaseBins){
+                    mutex.lock();
+                    sidecar.seek(positions[level] + (baseBin / ratio) * binValues * sizeof(T));
+                    sidecar.write(reinterpret_cast<const char*>(accumulator),binValues * sizeof(T));
+                    mutex.unlock();
+                    accumulatorEmpty[level] = true;
+                }
+            }
+        }
+
+        //Publish the progress, the bins are readable once they have been flushed.
+        qint64 summarized = qMin(totalSamples,(chunkBin + nbChunkBins) * BASE_BIN_SIZE);
+        mutex.lock();
+        sidecar.flush();
+        processedSamples = summarized;
+        mutex.unlock();
+
+        if(summarized == totalSamples || summarized % topBinSize == 0)
+            writeCompletedSamples(summarized);
+    }
+}
+
+bool TracesPyramid::readEnvelope(qint64 firstSample,qint64 nbSamples,qint64 maxBinSize,Array<dataType>& envelope,qint64& binSize,qint64& binOffset){
+    if(nbSamples <= 0 || firstSample < 0 || firstSample + nbSamples > totalSamples)
+        return false;
+
+    QMutexLocker locker(&mutex);
+    if(!sidecar.isOpen())
+        return false;
+
+    //Use the coarsest level which is fine enough, or a finer one if its bins are not yet built.
+    qint64 lastSample = firstSample + nbSamples - 1;
+    for(int level = NB_LEVELS - 1; level >= 0; --level){
+        qint64 size = TracesPyramid::binSize(level);
+        if(size > maxBinSize)
+            continue;
+
+        qint64 firstBin = firstSample / size;
+        qint64 lastBin = lastSample / size;
+        bool built = (processedSamples == totalSamples) || ((lastBin + 1) * size <= processedSamples);
+        if(!built)
+            continue;
+
+        qint64 binValues = nbChannels * 2;
+        qint64 nbBytes = (lastBin - firstBin + 1) * binValues * sampleSize;
+        if(!sidecar.seek(levelPosition(level) + firstBin * binValues * sampleSize))
+            return false;
+        QByteArray bins = sidecar.read(nbBytes);
+        if(bins.size() != nbBytes)
+            return false;
+
+        envelope.setSize((lastBin - firstBin + 1) * 2,nbChannels);
+        if(sampleSize == 2)
+            copyBins<int16_t>(bins,envelope);
+        else
+            copyBins<int32_t>(bins,envelope);
+
+        binSize = size;
+        binOffset = firstSample - firstBin * size;
+        return true;
+    }
+
+    return false;
+}
+
+template <typename T>
+void TracesPyramid::copyBins(const QByteArray& bins,Array<dataType>& envelope) const{
+    const T* values = reinterpret_cast<const T*>(bins.constData());
+    qint64 nbValues = bins.size() / sizeof(T);
+    for(qint64 i = 0; i < nbValues; ++i)
+        envelope[i] = static_cast<dataType>(values[i]);
+}
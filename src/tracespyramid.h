@@ -0,0 +1,145 @@
+/***************************************************************************
+                          tracespyramid.h  -  description
+                             -------------------
+    begin                : Sat Oct 17 2026
+    copyright            : (C) 2026 by the Neurosuite developers
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 3 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TRACESPYRAMID_H
+#define TRACESPYRAMID_H
+
+//include files for the application
+#include <array.h>
+#include <types.h>
+
+// include files for QT
+#include <QThread>
+#include <QMutex>
+#include <QFile>
+#include <QString>
+
+/**
+  * Multi-resolution min/max overview of a raw data file (.dat, .eeg, .fil).
+  *
+  * Level l summarizes every block of BASE_BIN_SIZE * LEVEL_FACTOR^l samples of each channel by its
+  * minimum and maximum. The levels are stored in a sidecar file next to the data file (or in the temporary
+  * directory if the data directory is read only) and are built the first time the file is opened by a low
+  * priority thread, which resumes where it stopped if the application is closed before the end.
+  *
+  * The values are kept in acquisition units, the conversion to uV is left to the TracesProvider.
+  *@author the Neurosuite developers
+  */
+class TracesPyramid : public QThread {
+public:
+    /**Constructor.
+  * @param dataFileName name of the data file to summarize.
+  * @param nbChannels number of channels in the data file.
+  * @param resolution resolution of the acquisition system, 12, 14, 16 or 32 bits.
+  */
+    TracesPyramid(const QString& dataFileName,int nbChannels,int resolution);
+    ~TracesPyramid();
+
+    /**Returns true if the data file is long enough to benefit from an overview.
+  * @param dataFileName name of the data file.
+  * @param nbChannels number of channels in the data file.
+  * @param resolution resolution of the acquisition system.
+  */
+    static bool isWorthBuilding(const QString& dataFileName,int nbChannels,int resolution);
+
+    /**Reads the envelope of the samples [@p firstSample, @p firstSample + @p nbSamples[ from the coarsest level
+  * built so far whose bins are not larger than @p maxBinSize samples.
+  * @param firstSample index of the first sample, starting at 0.
+  * @param nbSamples number of samples.
+  * @param maxBinSize maximum number of samples summarized by a bin.
+  * @param envelope array filled with two rows per bin, the minimum then the maximum of each channel (in acquisition units).
+  * @param binSize set to the number of samples summarized by each bin.
+  * @param binOffset set to the number of samples of the first bin preceding @p firstSample.
+  * @return true if the envelope is available, false if the caller has to read the raw data.
+  */
+    bool readEnvelope(qint64 firstSample,qint64 nbSamples,qint64 maxBinSize,Array<dataType>& envelope,qint64& binSize,qint64& binOffset);
+
+    /**Stops the building thread and waits for its completion, what has been built so far is kept.*/
+    void stop();
+
+    /**Number of samples summarized by a bin of the finest level.*/
+    static const qint64 BASE_BIN_SIZE;
+
+    /**Ratio between the bin sizes of two consecutive levels.*/
+    static const qint64 LEVEL_FACTOR;
+
+    /**Number of levels.*/
+    static const int NB_LEVELS;
+
+protected:
+    /**Builds the missing part of the levels.*/
+    virtual void run();
+
+private:
+    /**Fixed size header at the beginning of the sidecar file.*/
+    struct Header{
+        char magic[8];
+        qint32 version;
+        qint32 nbChannels;
+        qint32 sampleSize;
+        qint32 nbLevels;
+        qint64 baseBinSize;
+        qint64 levelFactor;
+        qint64 sourceSize;
+        qint64 sourceModified;
+        /**Number of samples summarized in all the levels, a multiple of the bin size of the coarsest level
+      * unless the whole file has been summarized.*/
+        qint64 completedSamples;
+    };
+
+    QString dataFileName;
+    int nbChannels;
+    /**Size in bytes of a sample, 2 or 4.*/
+    int sampleSize;
+    qint64 totalSamples;
+
+    /**Sidecar file, written by the building thread.*/
+    QFile sidecar;
+
+    /**Protects processedSamples, stopped and the reads of the sidecar.*/
+    QMutex mutex;
+
+    /**Number of samples whose bins have been written, in all the levels.*/
+    qint64 processedSamples;
+
+    /**True once the thread has been asked to stop.*/
+    bool stopped;
+
+    /**Returns the number of samples summarized by a bin of @p level.*/
+    static qint64 binSize(int level);
+
+    /**Returns the number of bins of @p level.*/
+    qint64 nbBins(int level) const;
+
+    /**Returns the position in the sidecar file of the first bin of @p level.*/
+    qint64 levelPosition(int level) const;
+
+    /**Opens the sidecar file, checks that it matches the data file and resets it otherwise.
+  * @return the number of samples already summarized, -1 if the sidecar file could not be opened.
+  */
+    qint64 openSidecar();
+
+    /**Writes the number of samples summarized in the header of the sidecar file.*/
+    void writeCompletedSamples(qint64 completedSamples);
+
+    /**Summarizes the data file from sample @p fromSample.*/
+    template <typename T> void buildLevels(qint64 fromSample);
+
+    /**Converts the bins read from the sidecar into @p envelope.*/
+    template <typename T> void copyBins(const QByteArray& bins,Array<dataType>& envelope) const;
+};
+
+#endif
@@ -37,15 +37,194 @@
 #include <QPolygon>
 #include <QApplication>
 #include <QMessageBox>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QBitArray>
+#include <QElapsedTimer>
+#include <QThread>
 
 #include <QDebug>
 
+// include c/c++ headers
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
 
 
 
 const int TraceView::XMARGIN = 50;
 const int TraceView::YMARGIN = 0;
+const long TraceView::ENVELOPE_MIN_SAMPLES_PER_PIXEL = 512;
 const float TraceView::U_THETA = 400.0f;
+const int TraceView::SCROLL_REDRAW_DELAY = 250;
+TraceView::RenderingBackend TraceView::renderingBackend = TraceView::QPAINTER;
+
+//Threads drawing the traces in tiles, independent from the global pool which may be used by the providers.
+Q_GLOBAL_STATIC(QThreadPool,renderingPool)
+
+namespace {
+
+/**Returns the set of the cluster ids in @p clusters, as bits indexed by the cluster id.*/
+QBitArray clusterBits(const QList<int>& clusters){
+    int maxId = -1;
+    QList<int>::const_iterator iterator;
+    for(iterator = clusters.begin(); iterator != clusters.end(); ++iterator)
+        maxId = qMax(maxId,*iterator);
+    QBitArray bits(maxId + 1);
+    for(iterator = clusters.begin(); iterator != clusters.end(); ++iterator)
+        if (*iterator >= 0) bits.setBit(*iterator);
+    return bits;
+}
+
+/**Returns, for each id up to the largest one in @p ids, its first position in @p ids, -1 for the ids not in the list.*/
+QVector<int> itemIndexes(const QList<int>& ids){
+    int maxId = -1;
+    QList<int>::const_iterator iterator;
+    for(iterator = ids.begin(); iterator != ids.end(); ++iterator)
+        maxId = qMax(maxId,*iterator);
+    QVector<int> indexes(maxId + 1,-1);
+    for(int i = ids.size() - 1; i >= 0; --i)
+        if (ids.at(i) >= 0) indexes[ids.at(i)] = i;
+    return indexes;
+}
+
+/**Tells if @p clusterId is in @p clusters, built by clusterBits.*/
+inline bool containsCluster(const QBitArray& clusters,long clusterId){
+    return clusterId >= 0 && clusterId < clusters.size() && clusters.testBit(clusterId);
+}
+
+}
+
+/**Traces of consecutive channels drawn into their own image by a rendering thread, see startTraceTiles.*/
+class TraceView::TraceTile {
+public:
+    /**Trace of a channel, drawn with @p pen from the abscissa @p X around the ordinate @p basePosition.*/
+    struct Trace{
+        int channelId;
+        int basePosition;
+        int X;
+        QPen pen;
+    };
+
+    explicit TraceTile(int groupId):groupId(groupId){}
+
+    /**Group of the traces in multiple columns mode, -1 otherwise.*/
+    int groupId;
+    QList<Trace> traces;
+
+    /**Image of the traces and its position on the device, null if none of the traces is visible.*/
+    QImage image;
+    QPoint origin;
+
+    /**Released once the image has been rendered.*/
+    QSemaphore rendered;
+};
+
+/**Tiles of one drawing of the traces, rendered in order by the rendering threads and the GUI thread.*/
+class TraceView::TileQueue {
+public:
+    TileQueue():nextTile(0),nextComposited(0),nbWorkers(0),limit(0),nbSamples(0),nbSamplesToDraw(0){}
+
+    ~TileQueue(){
+        //The workers refer to the queue until they are done.
+        workersDone.acquire(nbWorkers);
+        qDeleteAll(tiles);
+    }
+
+    QList<TraceTile*> tiles;
+
+    /**Index of the next tile to render.*/
+    QAtomicInt nextTile;
+
+    /**Index of the next tile to draw on the double buffer.*/
+    int nextComposited;
+
+    int nbWorkers;
+    QSemaphore workersDone;
+
+    /**Parameters of the drawing, see drawTraces.*/
+    int limit;
+    int nbSamples;
+    int nbSamplesToDraw;
+    QRect window;
+    QRect viewport;
+    QRect deviceRect;
+    QTransform transform;
+};
+
+/**Renders the tiles of a queue until none is left.*/
+class TraceView::TileWorker : public QRunnable {
+public:
+    TileWorker(TraceView& view,TileQueue& queue):view(view),queue(queue){}
+
+    void run(){
+        while (view.renderNextTile(queue));
+        queue.workersDone.release();
+    }
+
+private:
+    TraceView& view;
+    TileQueue& queue;
+};
+
+/**Lines of an overlay grouped by color, each group being drawn with a single call.*/
+class TraceView::LineBatches {
+public:
+    /**Returns the index of the batch of the lines drawn with @p color, creating it if needed.*/
+    int batch(const QColor& color){
+        const QRgb rgb = color.rgba();
+        QHash<QRgb,int>::const_iterator found = indexes.constFind(rgb);
+        if (found != indexes.constEnd())
+            return found.value();
+        indexes.insert(rgb,colors.size());
+        colors.append(color);
+        lines.append(QVector<QLine>());
+        return colors.size() - 1;
+    }
+
+    /**Returns, for each id up to the largest one in @p ids, the index of the batch of its color in @p itemColors,
+  * -1 for the ids not in the list.
+  */
+    QVector<int> batches(const QList<int>& ids,ItemColors* itemColors){
+        QVector<int> indexes = itemIndexes(ids);
+        for(int id = 0; id < indexes.size(); ++id)
+            if (indexes.at(id) >= 0) indexes[id] = batch(itemColors->color(id));
+        return indexes;
+    }
+
+    /**Draws the batches with @p pen, set to the color of each batch, moved by (@p dx, @p dy).*/
+    void draw(QPainter& painter,QPen pen,int dx,int dy) const{
+        if (colors.isEmpty())
+            return;
+        painter.translate(dx,dy);
+        for(int i = 0; i < colors.size(); ++i){
+            if (lines.at(i).isEmpty()) continue;
+            pen.setColor(colors.at(i));
+            painter.setPen(pen);
+            painter.drawLines(lines.at(i));
+        }
+        painter.translate(-dx,-dy);
+    }
+
+    QHash<QRgb,int> indexes;
+    QVector<QColor> colors;
+    QVector< QVector<QLine> > lines;
+};
+
+/**Event lines, cluster vertical lines and raster ticks of a drawing, computed for the first column and shared by all the columns.*/
+class TraceView::OverlayLines {
+public:
+    LineBatches events;
+
+    /**Vertical lines of the selected clusters, indexed by cluster file id.*/
+    QMap<int,LineBatches> clusterLines;
+
+    /**Ticks of each selected cluster, indexed by cluster file id then cluster id, going from the ordinate 0 to rasterHeight.*/
+    QMap<int,QHash<int,QVector<QLine> > > rasterTicks;
+};
 
 TraceView::TraceView(TracesProvider& tracesProvider,bool greyScale,bool multiColumns,bool verticalLines,
                      bool raster,bool waveforms,bool labelsDisplay,QList<int>& channelsToDisplay, float screenGain,long start,long timeFrameWidth,
@@ -56,12 +235,16 @@ TraceView::TraceView(TracesProvider& tracesProvider,bool greyScale,bool multiCol
     BaseFrame(10,0,parent,name,backgroundColor,minSize,maxSize,windowTopLeft,windowBottomRight,border),
     greyScaleMode(greyScale),
     statusBar(statusBar),
+    showFrameTimings(false),
+    decimationTime(0),
+    guiDecimationTime(0),
     tracesProvider(tracesProvider),
     multiColumns(multiColumns),
     verticalLines(verticalLines),
     raster(raster),
     waveforms(waveforms),
-    dataReady(false),data(),
+    dataReady(false),data(),envelopeBinSize(0),envelopeBinOffset(0),
+    dataFirstSample(-1),dataVersion(0),partialRow(-1),partialNbSamples(0),
     autocenterChannels(autocenterChannels),
     channelOffsets(channelOffsets),
     gains(gains),
@@ -86,6 +269,19 @@ TraceView::TraceView(TracesProvider& tracesProvider,bool greyScale,bool multiCol
     showLabels(labelsDisplay),
     showCalibrationScale(false),
     downSampling(1),
+    decimatedDownSampling(0),
+    decimatedNbSamplesToDraw(0),
+    decimationMode(TracesDecimation::MIN_MAX),
+    decimatedMode(TracesDecimation::MIN_MAX),
+    firstColumnToDraw(1),
+    lastColumnToDraw(-1),
+    tracesLayerValid(false),
+    tracesLayerDownSampling(0),
+    scrollColumns(0),
+    pendingScrollColumns(0),
+    scrollDrift(0),
+    tracesScrolled(false),
+    scrollTimer(0L),
     zoomed(false),
     firstZoom(true),
     doubleClick(false),
@@ -96,6 +292,7 @@ TraceView::TraceView(TracesProvider& tracesProvider,bool greyScale,bool multiCol
     startTimeInRecordingUnits(0),
     previousStartTimeInRecordingUnits(0),
     spikeBrowsing(false),
+    jumpPrefetch(NO_JUMP_PREFETCH),
     newEventPosition(-1),
     eventBeingModified(false),
     retrieveClusterData(false)
@@ -180,6 +377,12 @@ TraceView::TraceView(TracesProvider& tracesProvider,bool greyScale,bool multiCol
 
     //Set Connection(s).
     connect(&tracesProvider,SIGNAL(dataReady(Array<dataType>&,QObject*)),this,SLOT(dataAvailable(Array<dataType>&,QObject*)));
+    connect(&tracesProvider,SIGNAL(envelopeReady(Array<dataType>&,long,long,QObject*)),this,SLOT(envelopeAvailable(Array<dataType>&,long,long,QObject*)));
+
+    scrollTimer = new QTimer(this);
+    scrollTimer->setSingleShot(true);
+    scrollTimer->setInterval(SCROLL_REDRAW_DELAY);
+    connect(scrollTimer,SIGNAL(timeout()),this,SLOT(slotScrollStopped()));
 
     //Set the display of the labels, the default is to hide them, if need it change that.
     if (showLabels){
@@ -209,7 +412,7 @@ TraceView::TraceView(TracesProvider& tracesProvider,bool greyScale,bool multiCol
     scaleBackgroundImage();
 
     //Get the data.
-    tracesProvider.requestData(startTime,endTime,this,startTimeInRecordingUnits);
+    requestTraces();
 }
 
 
@@ -247,7 +450,17 @@ void TraceView::dataAvailable(Array<dataType>& data,QObject* initiator)
     if (initiator != this)
         return;
 
+    //The reads are part of the next frame.
+    const TracesProvider::ReadStatistics statistics = tracesProvider.takeReadStatistics();
+    pendingFrame.durations[FrameTimings::IO] += statistics.ioTime / 1e6;
+    pendingFrame.durations[FrameTimings::CONVERSION] += statistics.conversionTime / 1e6;
+    pendingFrame.bytesRead += statistics.bytesRead;
+    pendingFrame.nbRequests += statistics.nbRequests;
+    pendingFrame.nbCacheHits += statistics.nbCacheHits;
+
     if (data.nbOfRows() == 0){
+        partialRow = -1;
+        dataFirstSample = -1;
         QApplication::restoreOverrideCursor();
 
         QMessageBox::critical(this, tr("IO Error"),tr("An error has occured, the data file could not be opened or the file size is incorrect."));
@@ -256,9 +469,208 @@ void TraceView::dataAvailable(Array<dataType>& data,QObject* initiator)
         return;
     }
 
-    this->data = data;
+    envelopeBinSize = 0;
+    envelopeBinOffset = 0;
+
+    //Samples completing the ones kept from the previous time frame.
+    if (partialRow >= 0){
+        long row = partialRow;
+        partialRow = -1;
+        const int nbColumns = this->data.nbOfColumns();
+
+        //The provider did not return what was expected, retrieve the whole time frame.
+        if (data.nbOfColumns() != nbColumns || data.nbOfRows() < partialNbSamples){
+            dataFirstSample = -1;
+            pendingScrollColumns = 0;
+            tracesProvider.requestData(startTime,endTime,this,startTimeInRecordingUnits,requestedChannels);
+            return;
+        }
+
+        memcpy(&this->data[row * nbColumns],&data[0],partialNbSamples * nbColumns * sizeof(dataType));
+        tracesAvailable(this->data);
+        return;
+    }
+
+    dataFirstSample = (startTimeInRecordingUnits != 0) ? startTimeInRecordingUnits : tracesProvider.timeToRecordingUnits(startTime);
+    dataChannels = requestedChannels;
+    dataVersion = tracesProvider.getDataVersion();
+    tracesAvailable(data);
+}
+
+void TraceView::envelopeAvailable(Array<dataType>& envelope,long binSize,long binOffset,QObject* initiator)
+{
+    //If another widget was the initiator of the request, ignore the data.
+    if (initiator != this)
+        return;
+
+    envelopeBinSize = binSize;
+    envelopeBinOffset = binOffset;
+    dataFirstSample = -1;
+    tracesAvailable(envelope);
+}
+
+void TraceView::requestTraces(){
+    //When many samples are drawn in each pixel column, only their minimum and maximum matter: use the overview of the file,
+    //with at least two bins per column so that the column boundaries stay accurate.
+    const long nbSamples = tracesProvider.getNbSamples(startTime,endTime,startTimeInRecordingUnits);
+    requestedChannels = channelsToRetrieve();
+    pendingScrollColumns = 0;
+    const long binSize = (startTimeInRecordingUnits == 0) ? envelopeBinSizeFor(nbSamples) : 0;
+    if (binSize != 0 && tracesProvider.requestEnvelope(startTime,endTime,this,binSize,requestedChannels))
+        return;
+
+    if (requestMissingTraces())
+        return;
+
+    partialRow = -1;
+    tracesProvider.requestData(startTime,endTime,this,startTimeInRecordingUnits,requestedChannels);
+}
+
+bool TraceView::requestMissingTraces(){
+    if (printState || dataFirstSample < 0 || envelopeBinSize != 0 || startTimeInRecordingUnits != 0 ||
+            !tracesProvider.supportsPartialRetrieve() || dataVersion != tracesProvider.getDataVersion() || dataChannels != requestedChannels)
+        return false;
+
+    //Samples of the new time frame, [firstSample,endSample[, and of the previous one, [dataFirstSample,dataEndSample[.
+    const long firstSample = tracesProvider.timeToRecordingUnits(startTime);
+    const long nbSamples = tracesProvider.getNbSamples(startTime,endTime,0);
+    const long endSample = firstSample + nbSamples;
+    const long dataEndSample = dataFirstSample + data.nbOfRows();
+    const long keptFirstSample = qMax(firstSample,dataFirstSample);
+    const long keptEndSample = qMin(endSample,dataEndSample);
+    const long nbKeptSamples = keptEndSample - keptFirstSample;
+
+    //Nothing in common, or samples missing on both sides (zoom out).
+    if (nbSamples <= 0 || nbKeptSamples <= 0 || (keptFirstSample > firstSample && keptEndSample < endSample))
+        return false;
+
+    //The whole time frame has been read ahead (or is cached), taking it is cheaper than retrieving the missing samples.
+    if (nbKeptSamples < nbSamples && tracesProvider.hasWindow(startTime,endTime,0,requestedChannels))
+        return false;
+
+    //Move the kept samples to their new rows, in place if the number of samples has not changed.
+    //A move by whole pixel columns only requires to draw the exposed columns.
+    if (nbSamples == data.nbOfRows())
+        pendingScrollColumns = scrollableColumns(firstSample - dataFirstSample);
+
+    const int nbColumns = data.nbOfColumns();
+    const long sourceRow = keptFirstSample - dataFirstSample;
+    const long targetRow = keptFirstSample - firstSample;
+    if (nbSamples == data.nbOfRows()){
+        if (sourceRow != targetRow)
+            memmove(&data[targetRow * nbColumns],&data[sourceRow * nbColumns],nbKeptSamples * nbColumns * sizeof(dataType));
+    }
+    else{
+        Array<dataType> traces(nbSamples,nbColumns);
+        memcpy(&traces[targetRow * nbColumns],&data[sourceRow * nbColumns],nbKeptSamples * nbColumns * sizeof(dataType));
+        data = traces;
+    }
+    dataFirstSample = firstSample;
+
+    //The previous time frame covers the new one.
+    if (nbKeptSamples == nbSamples){
+        tracesAvailable(data);
+        return true;
+    }
+
+    if (keptEndSample < endSample){
+        //Samples missing at the end, they end with the time frame.
+        partialRow = nbKeptSamples;
+        partialNbSamples = endSample - keptEndSample;
+        tracesProvider.requestPartialData(startTime,endTime,this,keptEndSample,requestedChannels,endTime);
+    }
+    else{
+        //Samples missing at the begining, retrieve the first miliseconds containing them, the extra samples are ignored.
+        partialRow = 0;
+        partialNbSamples = keptFirstSample - firstSample;
+        const long partialEndTime = qMin(endTime,static_cast<long>(ceil(keptFirstSample * 1000.0 / tracesProvider.getSamplingRate())) + 1);
+        tracesProvider.requestPartialData(startTime,partialEndTime,this,firstSample,requestedChannels,endTime);
+    }
+    return true;
+}
+
+bool TraceView::startLiveUpdates(){
+    if (!tracesProvider.startLiveUpdates())
+        return false;
+    connect(&tracesProvider,SIGNAL(recordingLengthChanged(qlonglong)),this,SLOT(slotRecordingLengthChanged(qlonglong)));
+    return true;
+}
+
+void TraceView::stopLiveUpdates(){
+    disconnect(&tracesProvider,SIGNAL(recordingLengthChanged(qlonglong)),this,SLOT(slotRecordingLengthChanged(qlonglong)));
+    tracesProvider.stopLiveUpdates();
+}
+
+void TraceView::slotRecordingLengthChanged(qlonglong length){
+    this->length = length;
+    emit recordingLengthChanged();
+}
+
+QList<int> TraceView::channelsToRetrieve() const{
+    QList<int> channels;
+    QList<int>::const_iterator iterator;
+    for(iterator = shownChannels.begin(); iterator != shownChannels.end(); ++iterator)
+        if (!skippedChannels.contains(*iterator) && !channels.contains(*iterator))
+            channels.append(*iterator);
+
+    if (channels.size() == nbChannels)
+        return QList<int>();
+    qSort(channels);
+    return channels;
+}
+
+long TraceView::envelopeBinSizeFor(long nbSamples) const{
+    int nbColumns = viewport.width();
+    if (multiColumns && !shownGroupsChannels.isEmpty())
+        nbColumns /= shownGroupsChannels.size();
+    if (printState || nbColumns <= 0 || nbSamples / nbColumns < ENVELOPE_MIN_SAMPLES_PER_PIXEL)
+        return 0;
+    return nbSamples / (2 * nbColumns);
+}
+
+void TraceView::prefetchTraces(long start,long end,long startInRecordingUnits){
+    if (startInRecordingUnits == 0 && envelopeBinSizeFor(tracesProvider.getNbSamples(start,end,0)) != 0)
+        return;
+    tracesProvider.prefetchData(start,end,startInRecordingUnits,channelsToRetrieve());
+}
+
+void TraceView::cancelJumpPrefetch(){
+    if (jumpPrefetch == NO_JUMP_PREFETCH)
+        return;
+    jumpPrefetch = NO_JUMP_PREFETCH;
+    tracesProvider.cancelPrefetch();
+}
+
+void TraceView::tracesAvailable(Array<dataType>& data)
+{
+    if (&data != &this->data)
+        this->data = data;
+
+    //The pixel columns have to be reduced again, only the exposed ones if the time frame has moved by whole columns.
+    const int nbScrolledColumns = pendingScrollColumns;
+    pendingScrollColumns = 0;
+    if (nbScrolledColumns != 0)
+        shiftDecimatedTraces(nbScrolledColumns);
+    else
+        decimatedTraces.clear();
+
+    //Map each channel to its column, the provider may have returned all the channels.
+    dataColumns.fill(0,nbChannels);
+    if (requestedChannels.isEmpty() || data.nbOfColumns() != requestedChannels.size()){
+        for(int i = 0; i < qMin(nbChannels,static_cast<int>(data.nbOfColumns())); ++i)
+            dataColumns[i] = i + 1;
+    }
+    else{
+        for(int i = 0; i < requestedChannels.size(); ++i)
+            if (requestedChannels.at(i) < nbChannels)
+                dataColumns[requestedChannels.at(i)] = i + 1;
+    }
     dataReady = true;
     updateWindow();
+    if (nbScrolledColumns != 0){
+        scrollColumns = nbScrolledColumns;
+        drawContentsMode = SCROLL;
+    }
 
     //The following code was done in case of threads, without thread the trace data arrive always last
     //No clusters or events selected
@@ -436,6 +848,9 @@ void TraceView::displayTimeFrame(long start,long timeFrameWidth){
     if (!spikeBrowsing) startTimeInRecordingUnits = 0;
     else spikeBrowsing = false;
 
+    //The request of the new time frame replaces the read ahead of the target of the following jump, if any.
+    jumpPrefetch = NO_JUMP_PREFETCH;
+
     //Retreive the data for the clusters, only request data from the provider for which clusters have been selected
     if (verticalLines || raster || waveforms){
         QList<int> toRemove;
@@ -506,7 +921,7 @@ void TraceView::displayTimeFrame(long start,long timeFrameWidth){
         }
     }
 
-    tracesProvider.requestData(startTime,endTime,this,startTimeInRecordingUnits);
+    requestTraces();
 }
 
 void TraceView::setAutocenterChannels(bool status){
@@ -537,13 +952,10 @@ void TraceView::showHideLabels(bool show){
 }
 
 // Timing code (CDF-111)
-#define ENABLE_TIMING 0
-
 void TraceView::paintEvent ( QPaintEvent*){
-#if ENABLE_TIMING
-    QTime dt; dt.start();
-    bool fullDraw = false;
-#endif
+    QElapsedTimer paintTimer;
+    paintTimer.start();
+    bool frameDrawn = false;
 
     bool isInitAndResized = false;
     if (isInit){
@@ -600,7 +1012,7 @@ void TraceView::paintEvent ( QPaintEvent*){
     // See comment in drawTraces about Antialiasing
     //p.setRenderHint(QPainter::Antialiasing);
 
-    if (drawContentsMode == REDRAW && dataReady){
+    if ((drawContentsMode == REDRAW || drawContentsMode == SCROLL) && dataReady){
         QRect contentsRec = contentsRect();
         QRect r((QRect)window);
 
@@ -635,42 +1047,18 @@ void TraceView::paintEvent ( QPaintEvent*){
             }
 
 
-            //Create a painter to paint on the double buffer
-            QPainter painter;
-            painter.begin(&doublebuffer);
-
-            //if need it, draw the background image before applying any transformation to the painter.
-            if (!background.isNull())
-                painter.drawPixmap(0,0,scaledBackground);
-
             //Correct the window after the user zoomed if need it.
             correctZoom(r);
 
-            //Set the window (part of the world I want to show)
-            painter.setWindow(r.left(),r.top(),r.width()-1,r.height()-1);//hack because Qt QRect is used differently in this function
-
-            //Set the viewport (part of the device I want to write on).
-            //By default, the viewport is the same as the device's rectangle (contentsRec), taking a smaller
-            //one will ensure that the legends (cluster ids) will not ovelap a correlogram.
-            painter.setViewport(viewport);
-
-            //Fill the double buffer with the background color if no image has been set.
-            if (background.isNull())
-                doublebuffer.fill(palette().color(backgroundRole()));
-
-            // Force FastDraw (src/gui/painting/qcosmeticstroker.cpp)
-            painter.save();
-            painter.setClipRect(painter.window());
-            painter.setClipping(true);
-
-            //Paint all the traces in the shownChannels list (in the double buffer,on top of the background image or the background color )
-            drawTraces(painter);
+            //Draw the traces, only the exposed columns if the time frame has moved by whole columns.
+            if (drawContentsMode != SCROLL || !scrollTracesLayer(r))
+                drawTracesLayer(r);
+            scrollColumns = 0;
 
-            // Remove clipping otherwise labels don't show up
-            painter.restore();
-
-            //reset transformation due to setWindow and setViewport
-            painter.resetMatrix() ;
+            //Create a painter to paint on the double buffer
+            QPainter painter;
+            painter.begin(&doublebuffer);
+            painter.drawPixmap(0,0,tracesLayer);
 
             //Draw channel ids and amplitude on the left side.
             if (showLabels)
@@ -683,9 +1071,7 @@ void TraceView::paintEvent ( QPaintEvent*){
             //Closes the painter on the double buffer
             painter.end();
 
-#if ENABLE_TIMING
-            fullDraw = true;
-#endif
+            frameDrawn = true;
         }
 
         //Back to the default
@@ -697,6 +1083,11 @@ void TraceView::paintEvent ( QPaintEvent*){
     //Draw the double buffer (pixmap) by copying it into the widget device.
     p.drawPixmap(0, 0, doublebuffer);
 
+    if (frameDrawn)
+        recordFrame(paintTimer.nsecsElapsed());
+    if (showFrameTimings)
+        drawFrameTimings(p);
+
     if (mode == DRAW_LINE ) {
         drawTimeLine(&p);
     }
@@ -737,7 +1128,7 @@ void TraceView::paintEvent ( QPaintEvent*){
             //if the channel is skipped, do no draw it
             if (skippedChannels.contains(*channelIterator ))
                 continue;
-				int initialBasePosition = channelsStartingOrdinate[*channelIterator] +  static_cast<long>(data(1,*channelIterator + 1) * channelFactors[*channelIterator]);
+				int initialBasePosition = channelsStartingOrdinate[*channelIterator] +  static_cast<long>(channelValue(1,*channelIterator) * channelFactors[*channelIterator]);
             //draw the new trace
             int X = channelsStartingAbscissa[*channelIterator];
             int delta = m_currentPoint.y() - lastClickOrdinate;
@@ -749,7 +1140,7 @@ void TraceView::paintEvent ( QPaintEvent*){
             else{
                 QPolygon trace(nbSamples);
                 for(int i = 0; i < nbSamples;++i){
-                    int y = basePosition - static_cast<long>(data(i + 1,*channelIterator + 1) * channelFactors[*channelIterator]);
+                    int y = basePosition - static_cast<long>(channelValue(i + 1,*channelIterator) * channelFactors[*channelIterator]);
                     trace.setPoint(i,X,y);
                     X += Xstep;
                 }
@@ -763,16 +1154,55 @@ void TraceView::paintEvent ( QPaintEvent*){
         drawContentsMode = REDRAW;
         update();
     }
-#if ENABLE_TIMING
-    const int elapsed = dt.elapsed();
-    if (fullDraw) {
-        static int s_total = 0;
-        static int s_num = 0;
-        s_total += elapsed;
-        ++s_num;
-        qDebug() << "painting traces took" << elapsed << "ms" << "average:" << (s_total/s_num) << "ms";
-    }
-#endif
+}
+
+void TraceView::setFrameTimingsShown(bool show){
+    showFrameTimings = show;
+    if (!show && statusBar != 0L)
+        statusBar->clearMessage();
+    update();
+}
+
+void TraceView::recordFrame(qint64 paintTime){
+    //The decimation and the overlay done on the GUI thread are not part of the painting.
+    FrameTimings::Frame& frame = pendingFrame;
+    const double guiTime = paintTime / 1e6;
+    frame.durations[FrameTimings::DECIMATION] = decimationTime.fetchAndStoreOrdered(0) / 1e3;
+    frame.durations[FrameTimings::PAINT] = qMax(0.0,guiTime - guiDecimationTime / 1e6 - frame.durations[FrameTimings::OVERLAY]);
+    frame.total = frame.durations[FrameTimings::IO] + frame.durations[FrameTimings::CONVERSION] + guiTime;
+    guiDecimationTime = 0;
+
+    frameTimings.add(frame);
+    pendingFrame = FrameTimings::Frame();
+
+    if (showFrameTimings && statusBar != 0L)
+        statusBar->showMessage(frameTimings.summary());
+}
+
+void TraceView::drawFrameTimings(QPainter& painter){
+    const QStringList lines = frameTimings.table();
+    if (lines.isEmpty())
+        return;
+
+    painter.save();
+    painter.resetTransform();
+    painter.setClipping(false);
+    QFont f("Courier",8);
+    f.setStyleHint(QFont::TypeWriter);
+    painter.setFont(f);
+    const QFontMetrics metrics(f);
+    int width = 0;
+    for(int i = 0; i < lines.size(); ++i)
+        width = qMax(width,metrics.width(lines.at(i)));
+
+    //Translucent box in the top right corner.
+    QRect box(0,0,width + 8,lines.size() * metrics.lineSpacing() + 6);
+    box.moveTopRight(contentsRect().topRight() + QPoint(-4,4));
+    painter.fillRect(box,QColor(0,0,0,170));
+    painter.setPen(Qt::white);
+    for(int i = 0; i < lines.size(); ++i)
+        painter.drawText(box.left() + 4,box.top() + 3 + metrics.ascent() + i * metrics.lineSpacing(),lines.at(i));
+    painter.restore();
 }
 
 void TraceView::setMultiColumns(bool multiple){
@@ -865,7 +1295,7 @@ void TraceView::showChannels(const QList<int>& channelsToShow){
 
     //Request the data
     dataReady = false;
-    tracesProvider.requestData(startTime,endTime,this,startTimeInRecordingUnits);
+    requestTraces();
 }
 
 void TraceView::updateShownGroupsChannels(const QList<int>& channelsToShow){
@@ -1188,179 +1618,396 @@ void TraceView::updateWindow(){
 }
 
 
-void TraceView::drawTrace(QPainter& painter,int limit,int basePosition,int X,int channelId,int nbSamplesToDraw,bool mouseMoveEvent){
-    bool areClustersToDraw = false;
-    int clusterFileId = 0;
-    QString providerName;
-    if (!clusterProviders.isEmpty()){
-        clusterFileId = (*channelClusterFiles)[channelId];
-        providerName = QString::number(clusterFileId);
-        if (clustersData.contains(providerName))
-            areClustersToDraw = true;
+void TraceView::setDecimationMode(TracesDecimation::Mode mode){
+    if (mode == decimationMode)
+        return;
+    decimationMode = mode;
+    decimatedTraces.clear();
+
+    //Everything has to be redraw
+    drawContentsMode = REDRAW;
+    update();
+}
+
+void TraceView::resetDecimatedTraces(int nbSamplesToDraw){
+    //The envelope of the overview is already reduced to ranges.
+    const TracesDecimation::Mode mode = (envelopeBinSize != 0) ? TracesDecimation::MIN_MAX : decimationMode;
+    if (decimatedDownSampling != downSampling || decimatedNbSamplesToDraw != nbSamplesToDraw || decimatedTraces.size() != nbChannels ||
+            decimatedMode != mode){
+        decimatedTraces.clear();
+        decimatedTraces.resize(nbChannels);
+        decimatedDownSampling = downSampling;
+        decimatedNbSamplesToDraw = nbSamplesToDraw;
+        decimatedMode = mode;
+
+        //First sample of each column, as used by decimateColumns, to place the spikes of the waveforms.
+        columnStarts.resize(nbSamplesToDraw);
+        for(int i = 1; i <= nbSamplesToDraw;++i)
+            columnStarts[i - 1] = static_cast<int>(floor((i-1) * downSampling + 0.5 + 1));
     }
+}
 
-    if (!waveforms || (waveforms && !areClustersToDraw) || (waveforms && areClustersToDraw && mouseMoveEvent) || (waveforms && areClustersToDraw && !selectedClusters.contains(clusterFileId))){
-        int start = 1;
-        int stop = static_cast<int>(floor(downSampling + 0.5));//included
-        long min = data(1,channelId + 1);
-        long max = min;
-        long value;
-        int nbSamples = tracesProvider.getNbSamples(startTime,endTime,startTimeInRecordingUnits);
+const QVector<long>& TraceView::decimatedTrace(int channelId,int nbSamplesToDraw){
+    resetDecimatedTraces(nbSamplesToDraw);
 
-        for(int k = start + 1;k<= stop;++k){
-            value = data(k,channelId + 1);
-            if (value < min) min = value;
-            if (value > max) max = value;
-        }
-        int yMin = basePosition - static_cast<long>(min * channelFactors.at(channelId));
-        int yMax = basePosition - static_cast<long>(max * channelFactors.at(channelId));
-        if ((yMax - yMin) <= limit){
-            painter.drawPoint(X,yMin);
-        }
-        else{
-            painter.drawLine(X,yMin,X,yMax);
+    QVector<long>& extrema = decimatedTraces[channelId];
+    if (extrema.isEmpty() && nbSamplesToDraw > 0)
+        decimateTrace(channelId,nbSamplesToDraw,tracesProvider.getNbSamples(startTime,endTime,startTimeInRecordingUnits),extrema);
+    return extrema;
+}
+
+void TraceView::decimateTrace(int channelId,int nbSamplesToDraw,int nbSamples,QVector<long>& extrema){
+    QElapsedTimer timer;
+    timer.start();
+    extrema.resize(2 * nbSamplesToDraw);
+    decimateColumns(channelId,1,nbSamplesToDraw,nbSamples,extrema);
+
+    //This function is also called by the threads rendering the tiles.
+    const qint64 elapsed = timer.nsecsElapsed();
+    decimationTime.fetchAndAddOrdered(static_cast<int>(elapsed / 1000));
+    if (QThread::currentThread() == thread())
+        guiDecimationTime += elapsed;
+}
+
+void TraceView::decimateColumns(int channelId,int firstColumn,int lastColumn,int nbSamples,QVector<long>& extrema){
+    const int column = dataColumns.value(channelId);
+    if (column == 0){
+        for(int i = 2 * (firstColumn - 1); i < 2 * lastColumn;++i)
+            extrema[i] = 0;
+        return;
+    }
+    if (decimatedMode == TracesDecimation::LTTB){
+        decimateLargestTriangles(column,firstColumn,lastColumn,nbSamples,extrema);
+        return;
+    }
+
+    long min;
+    long max;
+    for(int i = firstColumn; i <= lastColumn;++i){
+        const int start = static_cast<int>(floor((i-1) * downSampling + 0.5 + 1));//the index in data starts at 1
+        int stop = static_cast<int>(floor(i * downSampling + 0.5));//included
+        if (i > 1)
+            stop = qMin(stop,nbSamples);
+
+        switch(decimatedMode){
+        case TracesDecimation::STRIDE:
+            min = max = data(start,column);
+            break;
+        case TracesDecimation::RMS_BAND:
+            TracesDecimation::band(&data(start,column),data.nbOfColumns(),qMax(1,stop - start + 1),min,max);
+            break;
+        default:
+            columnExtrema(channelId,start,stop,min,max);
         }
-        X += Xstep;
-        long previousMin = min;
-        long previousMax = max;
-
-        for(int i = 2; i <= nbSamplesToDraw;++i){
-            start = static_cast<int>(floor((i-1) * downSampling + 0.5 + 1));//the index in data starts at 1
-            stop = qMin(static_cast<int>(floor(i * downSampling + 0.5)),nbSamples);
-
-            min = data(start,channelId + 1);
-            max = min;
-            for(int k = start + 1;k<= stop;++k){
-                value = data(k,channelId + 1);
-                if (value < min) min = value;
-                if (value > max) max = value;
-            }
+
+        //Each column joins the previous one, the points are joined while drawing.
+        if (i > 1 && !TracesDecimation::isPointMode(decimatedMode)){
+            const long previousMin = extrema[2 * (i - 2)];
+            const long previousMax = extrema[2 * (i - 2) + 1];
             if (min > previousMax) min = previousMax;
             if (max < previousMin) max = previousMin;
-            previousMax = max;
-            previousMin = min;
+        }
 
-            yMax = basePosition - static_cast<long>(min * channelFactors.at(channelId));
-            yMin = basePosition - static_cast<long>(max * channelFactors.at(channelId));
+        extrema[2 * (i - 1)] = min;
+        extrema[2 * (i - 1) + 1] = max;
+    }
+}
 
-            if ((yMax - yMin) <= limit){
-                painter.drawPoint(X,yMin);
-            }
-            else{
-                painter.drawLine(X,yMin,X,yMax);
-            }
-            X += Xstep;
+void TraceView::decimateLargestTriangles(int column,int firstColumn,int lastColumn,int nbSamples,QVector<long>& extrema){
+    //Buckets of the columns, as indexes from the first row of data, followed by the end of the next column.
+    QVector<qint64> starts(lastColumn - firstColumn + 3);
+    for(int i = firstColumn; i <= lastColumn + 1;++i)
+        starts[i - firstColumn] = static_cast<qint64>(floor((i-1) * downSampling + 0.5));
+    const int nextColumn = qMin(lastColumn + 1,decimatedNbSamplesToDraw);
+    starts[lastColumn - firstColumn + 2] = static_cast<qint64>(floor(nextColumn * downSampling + 0.5));
+    //As in decimateColumns, the columns end at the last sample, none of them being empty.
+    for(int k = 1; k < starts.size();++k){
+        starts[k] = qMin(starts[k],static_cast<qint64>(nbSamples));
+        starts[k] = qMax(starts[k],starts[k - 1] + (k < starts.size() - 1 ? 1 : 0));
+    }
+
+    //The point of the previous column is placed at its middle.
+    const bool hasPrevious = firstColumn > 1;
+    double previousIndex = 0;
+    double previousValue = 0;
+    if (hasPrevious){
+        previousIndex = (floor((firstColumn - 2) * downSampling + 0.5) + starts[0] - 1) / 2.0;
+        previousValue = extrema[2 * (firstColumn - 2)];
+    }
+
+    QVector<dataType> selected(lastColumn - firstColumn + 1);
+    TracesDecimation::largestTriangles(&data(1,column),data.nbOfColumns(),starts.constData(),selected.size(),
+                                       previousIndex,previousValue,hasPrevious,selected.data());
+    for(int i = firstColumn; i <= lastColumn;++i){
+        extrema[2 * (i - 1)] = selected[i - firstColumn];
+        extrema[2 * (i - 1) + 1] = selected[i - firstColumn];
+    }
+}
+
+void TraceView::shiftDecimatedTraces(int nbColumns){
+    QElapsedTimer timer;
+    timer.start();
+    const int nbSamplesToDraw = decimatedNbSamplesToDraw;
+    const int nbSamples = tracesProvider.getNbSamples(startTime,endTime,startTimeInRecordingUnits);
+    const int nbKeptColumns = nbSamplesToDraw - qAbs(nbColumns);
+
+    for(int channelId = 0; channelId < decimatedTraces.size(); ++channelId){
+        QVector<long>& extrema = decimatedTraces[channelId];
+        if (extrema.isEmpty())
+            continue;
+
+        long* values = extrema.data();
+        if (nbColumns > 0){
+            memmove(values,values + 2 * nbColumns,2 * nbKeptColumns * sizeof(long));
+            decimateColumns(channelId,nbKeptColumns + 1,nbSamplesToDraw,nbSamples,extrema);
+        }
+        else{
+            memmove(values - 2 * nbColumns,values,2 * nbKeptColumns * sizeof(long));
+            //The first column kept joins the exposed ones.
+            decimateColumns(channelId,1,1 - nbColumns,nbSamples,extrema);
         }
     }
+    tracesScrolled = true;
+
+    const qint64 elapsed = timer.nsecsElapsed();
+    decimationTime.fetchAndAddOrdered(static_cast<int>(elapsed / 1000));
+    guiDecimationTime += elapsed;
+}
+
+int TraceView::scrollableColumns(long shift){
+    //The layer holds everything drawn in the viewport, it can only be scrolled if all of it moves with the time frame.
+    if (shift == 0 || multiColumns || printState || !tracesLayerValid || !background.isNull() || autocenterChannels || downSampling == 1 ||
+            (waveforms && !selectedClusters.isEmpty()) || decimatedDownSampling != downSampling)
+        return 0;
+
+    const int nbColumns = static_cast<int>(floor(shift / downSampling + 0.5));
+    const float drift = scrollDrift + shift - nbColumns * downSampling;
+
+    //Beyond half of the columns, drawing everything costs as much.
+    if (nbColumns == 0 || qAbs(nbColumns) > decimatedNbSamplesToDraw / 2 || qAbs(drift) > downSampling / 2)
+        return 0;
+
+    scrollDrift = drift;
+    return nbColumns;
+}
+
+void TraceView::drawTracesLayer(const QRect& r){
+    if (tracesLayer.size() != contentsRect().size())
+        tracesLayer = QPixmap(contentsRect().size());
+
+    //The columns kept while scrolling have been reduced from the previous time frames.
+    if (tracesScrolled){
+        decimatedTraces.clear();
+        tracesScrolled = false;
+    }
+    scrollDrift = 0;
+
+    //Fill the layer with the background color if no image has been set.
+    if (background.isNull())
+        tracesLayer.fill(palette().color(backgroundRole()));
+
+    QPainter painter;
+    painter.begin(&tracesLayer);
+
+    //if need it, draw the background image before applying any transformation to the painter.
+    if (!background.isNull())
+        painter.drawPixmap(0,0,scaledBackground);
+
+    //Set the window (part of the world I want to show)
+    painter.setWindow(r.left(),r.top(),r.width()-1,r.height()-1);//hack because Qt QRect is used differently in this function
+
+    //Set the viewport (part of the device I want to write on).
+    //By default, the viewport is the same as the device's rectangle (contentsRec), taking a smaller
+    //one will ensure that the legends (cluster ids) will not ovelap a correlogram.
+    painter.setViewport(viewport);
+
+    // Force FastDraw (src/gui/painting/qcosmeticstroker.cpp)
+    painter.setClipRect(painter.window());
+    painter.setClipping(true);
+
+    //Paint all the traces in the shownChannels list (on top of the background image or the background color )
+    drawTraces(painter);
+    painter.end();
+
+    tracesLayerValid = true;
+    tracesLayerWindow = r;
+    tracesLayerViewport = viewport;
+    tracesLayerDownSampling = downSampling;
+}
+
+bool TraceView::scrollTracesLayer(const QRect& r){
+    const int nbColumns = scrollColumns;
+    const int nbSamplesToDraw = decimatedNbSamplesToDraw;
+    if (nbColumns == 0 || !tracesLayerValid || !tracesScrolled || tracesLayer.size() != contentsRect().size() || r != tracesLayerWindow ||
+            viewport != tracesLayerViewport || downSampling != tracesLayerDownSampling || decimatedDownSampling != downSampling ||
+            qAbs(nbColumns) >= nbSamplesToDraw)
+        return false;
+
+    QPainter painter;
+    painter.begin(&tracesLayer);
+    painter.setWindow(r.left(),r.top(),r.width()-1,r.height()-1);//hack because Qt QRect is used differently in this function
+    painter.setViewport(viewport);
+    const QTransform transform = painter.combinedTransform();
+    painter.end();
+
+    //Move the columns kept by the nearest number of pixels.
+    const int dx = static_cast<int>(floor(nbColumns * Xstep * transform.m11() + 0.5));
+    tracesLayer.scroll(-dx,0,viewport);
+
+    //The exposed columns are drawn, with the kept column joining them. The next column is drawn as well, outside of the strip,
+    //for the pixels of its pen overlapping the strip.
+    QRect strip;
+    if (nbColumns > 0){
+        firstColumnToDraw = qMax(1,nbSamplesToDraw - nbColumns - 1);
+        lastColumnToDraw = nbSamplesToDraw;
+        const int left = static_cast<int>(floor(transform.map(QPointF(X0 + (nbSamplesToDraw - nbColumns - 1) * Xstep,0)).x()));
+        strip = QRect(QPoint(left,viewport.top()),viewport.bottomRight());
+    }
     else{
-        //Array containing 4 lines: sample starting index, abscissa, ordinate min, ordinate max
-        Array<dataType> traceInfo(4,nbSamplesToDraw);
-
-        int start = 1;
-        int stop = static_cast<int>(floor(downSampling + 0.5));//included
-        long min = data(1,channelId + 1);
-        long max = min;
-        long value;
-        int nbSamples = tracesProvider.getNbSamples(startTime,endTime,startTimeInRecordingUnits);
+        firstColumnToDraw = 1;
+        lastColumnToDraw = qMin(nbSamplesToDraw,3 - nbColumns);
+        const int right = static_cast<int>(floor(transform.map(QPointF(X0 + (2 - nbColumns) * Xstep,0)).x()));
+        strip = QRect(viewport.topLeft(),QPoint(right - 1,viewport.bottom()));
+    }
+    strip &= viewport;
+
+    painter.begin(&tracesLayer);
+    painter.fillRect(strip,palette().color(backgroundRole()));
+    painter.setClipRect(strip);
+    painter.setWindow(r.left(),r.top(),r.width()-1,r.height()-1);//hack because Qt QRect is used differently in this function
+    painter.setViewport(viewport);
+    painter.setClipRect(painter.window(),Qt::IntersectClip);
+    drawTraces(painter);
+    painter.end();
+
+    firstColumnToDraw = 1;
+    lastColumnToDraw = -1;
+
+    //Draw the exact columns once the scrolling has stopped.
+    scrollTimer->start();
+    return true;
+}
+
+void TraceView::slotScrollStopped(){
+    if (!tracesScrolled || drawContentsMode != REFRESH)
+        return;
+    drawContentsMode = REDRAW;
+    update();
+}
 
-        for(int k = start + 1;k<= stop;++k){
-            value = data(k,channelId + 1);
-            if (value < min) min = value;
-            if (value > max) max = value;
+template <class Canvas>
+void TraceView::drawExtrema(Canvas& canvas,int limit,int basePosition,int X,const QVector<long>& extrema,float factor,int nbSamplesToDraw){
+    const int firstColumn = qMax(1,firstColumnToDraw);
+    const int lastColumn = (lastColumnToDraw < 0) ? nbSamplesToDraw : qMin(nbSamplesToDraw,lastColumnToDraw);
+    X += (firstColumn - 1) * Xstep;
+
+    for(int i = firstColumn; i <= lastColumn;++i){
+        long min;
+        long max;
+        columnRange(extrema,i,min,max);
+        int yMin;
+        int yMax;
+        if (i == 1){
+            yMin = basePosition - static_cast<long>(min * factor);
+            yMax = basePosition - static_cast<long>(max * factor);
+        }
+        else{
+            yMax = basePosition - static_cast<long>(min * factor);
+            yMin = basePosition - static_cast<long>(max * factor);
         }
-        int yMin = basePosition - static_cast<long>(min * channelFactors.at(channelId));
-        int yMax = basePosition - static_cast<long>(max * channelFactors.at(channelId));
+
         if ((yMax - yMin) <= limit){
-            painter.drawPoint(X,yMin);
+            canvas.drawPoint(X,yMin);
         }
         else{
-            painter.drawLine(X,yMin,X,yMax);
+            canvas.drawLine(X,yMin,X,yMax);
         }
+        X += Xstep;
+    }
+}
 
-        traceInfo(1,1) = 1;
-        traceInfo(2,1) = X;
-        traceInfo(3,1) = yMin;
-        traceInfo(4,1) = yMax;
+void TraceView::drawTrace(QPainter& painter,int limit,int basePosition,int X,int channelId,int nbSamplesToDraw,bool mouseMoveEvent){
+    bool areClustersToDraw = false;
+    int clusterFileId = 0;
+    QString providerName;
+    if (!clusterProviders.isEmpty()){
+        clusterFileId = (*channelClusterFiles)[channelId];
+        providerName = QString::number(clusterFileId);
+        if (clustersData.contains(providerName))
+            areClustersToDraw = true;
+    }
 
-        X += Xstep;
-        long previousMin = min;
-        long previousMax = max;
-
-        for(int i = 2; i <= nbSamplesToDraw;++i){
-            start = static_cast<int>(floor((i-1) * downSampling + 0.5 + 1));//the index in data starts at 1
-            stop = qMin(static_cast<int>(floor(i * downSampling + 0.5)),nbSamples);
-
-            min = data(start,channelId + 1);
-            max = min;
-            for(int k = start + 1;k<= stop;++k){
-                value = data(k,channelId + 1);
-                if (value < min) min = value;
-                if (value > max) max = value;
-            }
-            if (min > previousMax) min = previousMax;
-            if (max < previousMin) max = previousMin;
-            previousMax = max;
-            previousMin = min;
+    //The reduction of the samples to the pixel columns is only done once, the gain is applied while drawing.
+    const QVector<long>& extrema = decimatedTrace(channelId,nbSamplesToDraw);
+    if (extrema.isEmpty())
+        return;
+    const float factor = channelFactors.at(channelId);
 
-            yMax = basePosition - static_cast<long>(min * channelFactors.at(channelId));
-            yMin = basePosition - static_cast<long>(max * channelFactors.at(channelId));
+    if (renderingBackend == RASTERIZER && rasterizer.begin(painter)){
+        drawExtrema(rasterizer,limit,basePosition,X,extrema,factor,nbSamplesToDraw);
+        rasterizer.end();
+    }
+    else drawExtrema(painter,limit,basePosition,X,extrema,factor,nbSamplesToDraw);
 
-            if ((yMax - yMin) <= limit){
-                painter.drawPoint(X,yMin);
-            }
-            else{
-                painter.drawLine(X,yMin,X,yMax);
-            }
+    if (!waveforms || !areClustersToDraw || mouseMoveEvent || !selectedClusters.contains(clusterFileId))
+        return;
 
-            traceInfo(1,i) = start;
-            traceInfo(2,i) = X;
-            traceInfo(3,i) = yMin;
-            traceInfo(4,i) = yMax;
+    //Draw the waveforms on top of the trace
+    ItemColors* colors = providerItemColors[providerName];
+    if (!clustersData[providerName])
+        return;
 
-            X += Xstep;
-        }
+    Array<dataType>& currentData = static_cast<ClusterData*>(clustersData[providerName])->getData();
+    int nbSpikes = currentData.nbOfColumns();
+    const QBitArray clusterSet = clusterBits(selectedClusters[clusterFileId]);
+    const int* starts = columnStarts.constData();
+    const int* startsEnd = starts + nbSamplesToDraw;
+    int currentIndex = 1;
+    dataType currentClusterId = -1;
 
-        //Draw the waveforms on top of the trace
-        ItemColors* colors = providerItemColors[providerName];
-        if (!clustersData[providerName])
-            return;
+    for(int i = 1; i < nbSpikes + 1;++i){
+        dataType index = currentData(1,i);
+        int firstIndex = index - nbSamplesBefore;
+        int lastIndex = index + nbSamplesAfter;
+        dataType clusterId = currentData(2,i);
 
-        Array<dataType>& currentData = static_cast<ClusterData*>(clustersData[providerName])->getData();
-        int nbSpikes = currentData.nbOfColumns();
-        QList<int> clusterList = selectedClusters[clusterFileId];
-        int currentIndex = 1;
+        if (!containsCluster(clusterSet,clusterId))
+            continue;
 
-        for(int i = 1; i < nbSpikes + 1;++i){
-            dataType index = currentData(1,i);
-            int firstIndex = index - nbSamplesBefore;
-            int lastIndex = index + nbSamplesAfter;
-            dataType clusterId = currentData(2,i);
+        //The columns are sorted by starting sample, the first one starting in the waveform and the first one starting after it are searched.
+        const int j = qMax(currentIndex,static_cast<int>(std::lower_bound(starts,startsEnd,firstIndex) - starts) + 1);
+        if (j > nbSamplesToDraw)
+            continue;
+        const int kEnd = qMax(j,static_cast<int>(std::upper_bound(starts,startsEnd,lastIndex) - starts) + 1);
 
-            if (clusterList.contains(clusterId)){
-                QColor color = colors->color(clusterId);
-                QPen pen(color);
-                pen.setCosmetic(true);
-                painter.setPen(pen);
-                for(int j = currentIndex; j <= nbSamplesToDraw;++j){
-                    if (firstIndex > traceInfo(1,j)) continue;//case 1
-                    else if (firstIndex <= traceInfo(1,j)){//case 2
-                        for(int k = j;k<= nbSamplesToDraw;++k){
-                            if (traceInfo(1,k) > lastIndex){
-                                currentIndex = k;
-                                break;
-                            }
-                            else if (traceInfo(1,k) <= lastIndex){
-                                if (traceInfo(3,k) != traceInfo(4,k)) painter.drawLine(traceInfo(2,k),traceInfo(3,k),traceInfo(2,k),traceInfo(4,k));
-                                else painter.drawPoint(traceInfo(2,k),traceInfo(3,k));
-                            }
-                        }
-                        break;
-                    }
-                }//loop on samples to draw
-            }
-        }//loop on spikes
-    }//waveform to draw
+        if (clusterId != currentClusterId){
+            QPen pen(colors->color(clusterId));
+            pen.setCosmetic(true);
+            painter.setPen(pen);
+            currentClusterId = clusterId;
+        }
 
+        for(int k = j;k < kEnd;++k){
+            long min;
+            long max;
+            columnRange(extrema,k,min,max);
+            int yMin;
+            int yMax;
+            if (k == 1){
+                yMin = basePosition - static_cast<long>(min * factor);
+                yMax = basePosition - static_cast<long>(max * factor);
+            }
+            else{
+                yMax = basePosition - static_cast<long>(min * factor);
+                yMin = basePosition - static_cast<long>(max * factor);
+            }
+            const int abscissa = X + (k - 1) * Xstep;
+            if (yMin != yMax) painter.drawLine(abscissa,yMin,abscissa,yMax);
+            else painter.drawPoint(abscissa,yMin);
+        }
+        if (kEnd <= nbSamplesToDraw)
+            currentIndex = kEnd;
+    }//loop on spikes
 }
 
 void TraceView::drawTraces( const QList<int>& channels,bool highlight)
@@ -1369,6 +2016,9 @@ void TraceView::drawTraces( const QList<int>& channels,bool highlight)
 
     QRect r((QRect)window);
 
+    //The double buffer no longer matches the layer of the traces, it will be drawn entirely before being scrolled.
+    tracesLayerValid = false;
+
     //Create a painter to paint on the double buffer
     QPainter painter;
     painter.begin(&doublebuffer);
@@ -1396,7 +2046,7 @@ void TraceView::drawTraces( const QList<int>& channels,bool highlight)
         if (skippedChannels.contains(*iterator))
             continue;
 
-        int basePosition = channelsStartingOrdinate[*iterator] +  static_cast<long>(data(1,*iterator + 1) * channelFactors.at(*iterator));
+        int basePosition = channelsStartingOrdinate[*iterator] +  static_cast<long>(channelValue(1,*iterator) * channelFactors.at(*iterator));
 
         //The abscissa of the system coordinate center for the current channel
         int X;
@@ -1452,7 +2102,7 @@ void TraceView::drawTraces( const QList<int>& channels,bool highlight)
             if (!waveforms || (waveforms && !areClustersToDraw) || (waveforms && areClustersToDraw && !selectedClusters.contains(clusterFileId))){
                 QPolygon trace(nbSamples);
                 for(int i = 0; i < nbSamples;++i){
-                    int y = basePosition - static_cast<long>(data(i + 1,*iterator + 1) * channelFactors.at(*iterator));
+                    int y = basePosition - static_cast<long>(channelValue(i + 1,*iterator) * channelFactors.at(*iterator));
                     trace.setPoint(i,X,y);
                     X += Xstep;
                 }
@@ -1477,7 +2127,7 @@ void TraceView::drawTraces( const QList<int>& channels,bool highlight)
                 Array<dataType> traceInfo(3,nbSamples);
                 QPolygon trace(nbSamples);
                 for(int i = 1; i <= nbSamples;++i){
-                    int y = basePosition - static_cast<long>(data(i,*iterator + 1) * channelFactors[*iterator]);
+                    int y = basePosition - static_cast<long>(channelValue(i,*iterator) * channelFactors[*iterator]);
                     trace.setPoint(i - 1,X,y);
                     traceInfo(1,i) = i;
                     traceInfo(2,i) = X;
@@ -1505,7 +2155,7 @@ void TraceView::drawTraces( const QList<int>& channels,bool highlight)
                 ItemColors* colors = providerItemColors[providerName];
                 Array<dataType>& currentData = static_cast<ClusterData*>(clustersData[providerName])->getData();
                 int nbSpikes = currentData.nbOfColumns();
-                QList<int> clusterList = selectedClusters[clusterFileId];
+                const QBitArray clusterSet = clusterBits(selectedClusters[clusterFileId]);
                 int currentIndex = 1;
 
                 for(int i = 1; i < nbSpikes + 1;++i){
@@ -1515,38 +2165,35 @@ void TraceView::drawTraces( const QList<int>& channels,bool highlight)
                     int nbWaveformSamples = lastIndex - firstIndex + 1;
                     dataType clusterId = currentData(2,i);
 
-                    if (clusterList.contains(clusterId)){
+                    if (containsCluster(clusterSet,clusterId)){
                         QColor color = colors->color(clusterId);
-                        for(int j = currentIndex; j <= nbSamples;++j){
-                            if (firstIndex > traceInfo(1,j)) continue;//case 1
-                            else if (firstIndex == traceInfo(1,j)){//case 2
-                                QPolygon trace(nbWaveformSamples);
-                                int pos = 0;
-                                for(int k = firstIndex;k<= lastIndex;++k){
-                                    trace.setPoint(pos,traceInfo(2,k),traceInfo(3,k));
-                                    pos++;
-                                }
-                                if (highlight){
-                                    QPen pen(color,2);
-                                    pen.setCosmetic(true);
-                                    painter.setPen(pen);
-                                    painter.drawPolyline(trace);
-                                }
-                                else{
-                                    QPen pen(palette().color(backgroundRole()),2);
-                                    pen.setCosmetic(true);
-                                    painter.setPen(pen);
-                                    painter.drawPolyline(trace);
-                                    pen.setColor(color);
-                                    pen.setWidth(1);
-                                    pen.setCosmetic(true);
-                                    painter.setPen(pen);
-                                    painter.drawPolyline(trace);
-                                }
-                                currentIndex = firstIndex;
-                                break;
+                        //traceInfo(1,j) equals j, the waveform is drawn if it starts after the previous one.
+                        if (firstIndex >= currentIndex && firstIndex <= nbSamples){
+                            QPolygon trace(nbWaveformSamples);
+                            int pos = 0;
+                            for(int k = firstIndex;k<= lastIndex;++k){
+                                trace.setPoint(pos,traceInfo(2,k),traceInfo(3,k));
+                                pos++;
+                            }
+                            if (highlight){
+                                QPen pen(color,2);
+                                pen.setCosmetic(true);
+                                painter.setPen(pen);
+                                painter.drawPolyline(trace);
+                            }
+                            else{
+                                QPen pen(palette().color(backgroundRole()),2);
+                                pen.setCosmetic(true);
+                                painter.setPen(pen);
+                                painter.drawPolyline(trace);
+                                pen.setColor(color);
+                                pen.setWidth(1);
+                                pen.setCosmetic(true);
+                                painter.setPen(pen);
+                                painter.drawPolyline(trace);
                             }
-                        }//loop on samples to draw
+                            currentIndex = firstIndex;
+                        }
                     }
                 }//loop on spikes
             }//else waveform
@@ -1565,19 +2212,28 @@ void TraceView::drawTraces( const QList<int>& channels,bool highlight)
 }
 
 void TraceView::drawTraces(QPainter& painter){
-    channelsStartingOrdinate.clear();
     int limit = viewportToWorldHeight(1);
     int nbSamples = tracesProvider.getNbSamples(startTime,endTime,startTimeInRecordingUnits);
     int nbSamplesToDraw = static_cast<int>(floor(0.5 + static_cast<float>(nbSamples)/downSampling));
+    const QHash<int,int> tracePositions = computeTracePositions(nbSamples);
+
+    //The traces are drawn in tiles on the rendering threads while the events, clusters and rasters are drawn here.
+    TileQueue tileQueue;
+    const bool tiled = startTraceTiles(painter,tileQueue,tracePositions,limit,nbSamples,nbSamplesToDraw);
+
+    //The lines of the events, clusters and rasters are computed once and drawn with one call per color in each column.
+    QElapsedTimer overlayTimer;
+    overlayTimer.start();
+    OverlayLines overlay;
+    computeOverlayLines(overlay);
+    pendingFrame.durations[FrameTimings::OVERLAY] += overlayTimer.nsecsElapsed() / 1e6;
+    QPen eventPen(Qt::DotLine);
+    eventPen.setCosmetic(true);
 
     //traces presented on multiple columns
     if (multiColumns){
         //The abscissa of the system coordinate center for the current channel
-        int X = X0;
-        //The ordinate of the system coordinate center for the current channel
-        int Y = Y0;
-
-        //Start at the top of the view.
+        int X = X0;
 
         //Loop on all the groups (one by column)
         clustersOrder.clear();
@@ -1588,175 +2244,102 @@ void TraceView::drawTraces(QPainter& painter){
         for(iterator = groupIds.begin(); iterator != groupIds.end(); ++iterator){
 
             //Draw events
-            if (!selectedEvents.isEmpty()){
-                QRect windowRectangle((QRect)window);
-                int top = windowRectangle.top();
-                int bottom = windowRectangle.bottom();
-                QPen pen(Qt::DotLine);
-                pen.setCosmetic(true);
-
-                QMap<QString, QList<int> >::Iterator iterator;
-                for(iterator = selectedEvents.begin(); iterator != selectedEvents.end(); ++iterator){
-                    QList<int> eventList = iterator.value();
-                    QString providerName = iterator.key();
-                    if (eventList.size() == 0 || eventsData[providerName] == 0) continue;
-                    ItemColors* colors = providerItemColors[providerName];
-                    Array<dataType>& currentData = static_cast<EventData*>(eventsData[providerName])->getTimes();
-                    Array<int>& currentIds = static_cast<EventData*>(eventsData[providerName])->getIds();
-                    int nbEvents = currentData.nbOfColumns();
-                    for(int i = 1; i <= nbEvents;++i){
-                        dataType index = currentData(1,i);
-                        int eventId = currentIds(1,i);
-                        if (eventList.contains(eventId)){
-                            QColor color = colors->color(eventId);
-                            pen.setColor(color);
-                            pen.setCosmetic(true);
-                            painter.setPen(pen);
-                            int abscissa = X + static_cast<int>(0.5 + (static_cast<float>(index) / downSampling));
-                            painter.drawLine(abscissa,top,abscissa,bottom);
-                        }
-                    }
-                }
-            }//events
-            if (verticalLines && nbClusters != 0){
-                QRect windowRectangle((QRect)window);
-                int top = windowRectangle.top();
-                int bottom = windowRectangle.bottom();
-                QList<int> clusterFileList = (*groupClusterFiles)[*iterator];
-
-                QMap<int,QList<int> >::Iterator selectedIterator;
-                for(selectedIterator = selectedClusters.begin(); selectedIterator != selectedClusters.end(); ++selectedIterator){
-                    //Only draw vertical lines for clusters contained in a cluster file containing data for channels of the current group
-                    if (!clusterFileList.contains(selectedIterator.key())) continue;
-                    QString providerName = QString::number(selectedIterator.key());
-                    if (clustersData[providerName] == 0)
-                        continue;
-
-                    ItemColors* colors = providerItemColors[providerName];
-                    Array<dataType>& currentData = static_cast<ClusterData*>(clustersData[providerName])->getData();
-                    int nbSpikes = currentData.nbOfColumns();
-                    QList<int> clusterList = selectedIterator.value();
-                    QList<int>::iterator clusterIterator;
-                    for(clusterIterator = clusterList.begin(); clusterIterator != clusterList.end(); ++clusterIterator){
-                        QColor color = colors->color(*clusterIterator);
-                        QPen pen(color);
-                        pen.setCosmetic(true);
-                        painter.setPen(pen);
-                        for(int i = 1; i <= nbSpikes;++i){
-                            dataType index = currentData(1,i);
-                            dataType clusterId = currentData(2,i);
-                            if (clusterId == *clusterIterator){
-                                int abscissa = X + static_cast<int>(0.5 + (static_cast<float>(index) / downSampling));
-                                painter.drawLine(abscissa,top,abscissa,bottom);
-                            }
-                        }
-                    }
-                }
-            }//verticalLines
+            overlay.events.draw(painter,eventPen,X,0);
+            QList<int> clusterFileList = (*groupClusterFiles)[*iterator];
+            if (verticalLines && nbClusters != 0)
+                drawClusterLines(painter,overlay,X,clusterFileList);
 
             QList<int> channelIds = shownGroupsChannels[*iterator];
             int currentNbChannels = channelIds.size();
 
             QList<int> positions;
-            int y = Y;
-            for(int j = 0; j < currentNbChannels; ++j){
-                const int channelId = channelIds.at(j);
-
-					 int m = 0;
-					 if (autocenterChannels){
-						 for (int i = 1;i <= nbSamples;++i) m += static_cast<long>(data(i,channelId + 1) * channelFactors.at(channelId));
-						 m /= nbSamples;
-					 }
-
-					 int position = -y + m + channelOffsets.at(channelId);
-                positions.append(position);
-                channelsStartingOrdinate.insert(channelId,position - static_cast<long>(data(1,channelId + 1) * channelFactors.at(channelId)));
-                channelsStartingAbscissa.insert(channelId,X);
-                y -= Yshift;
-            }
+            for(int j = 0; j < currentNbChannels; ++j)
+                positions.append(tracePositions.value(channelIds.at(j)));
 
-            for(int j = 0; j < currentNbChannels; ++j){
-                const int channelId = channelIds.at(j);
-                //The abscissa of the system coordinate center for the current channel
-                int x = 0;
-
-                //if the channel is skipped, do no draw it
-                if (skippedChannels.contains(channelId)) continue;
+            if (tiled)
+                drawTraceTiles(painter,tileQueue,*iterator);
+            else{
+                for(int j = 0; j < currentNbChannels; ++j){
+                    const int channelId = channelIds.at(j);
+                    //The abscissa of the system coordinate center for the current channel
+                    int x = 0;
 
-                QColor color = channelColors->color(channelId);
+                    //if the channel is skipped, do no draw it
+                    if (skippedChannels.contains(channelId)) continue;
 
-                if (greyScaleMode){
-                    int greyvalue = qGray(color.rgb());
-                    color.setHsv(0,0,greyvalue);
-                }
-                QPen pen(color,1);
-                if (mSelectedChannels.contains(channelId))
-                    pen.setWidth(2);
-                pen.setCosmetic(true);
-                painter.setPen(pen);
+                    QColor color = channelColors->color(channelId);
 
-                if (downSampling != 1){
-                    drawTrace(painter,limit,positions.at(j),X,channelId,nbSamplesToDraw);
-                }
-                else{
-                    bool areClustersToDraw = false;
-                    int clusterFileId = 0;
-                    QString providerName;
-                    if (!clusterProviders.isEmpty()){
-                        areClustersToDraw = true;
-                        clusterFileId = (*channelClusterFiles)[channelId];
-                        providerName = QString::number(clusterFileId);
-                        if (clustersData.contains(providerName))
-                            areClustersToDraw = true;
+                    if (greyScaleMode){
+                        int greyvalue = qGray(color.rgb());
+                        color.setHsv(0,0,greyvalue);
                     }
+                    QPen pen(color,1);
+                    if (mSelectedChannels.contains(channelId))
+                        pen.setWidth(2);
+                    pen.setCosmetic(true);
+                    painter.setPen(pen);
 
-                    if (!waveforms || (waveforms && !areClustersToDraw) || (waveforms && areClustersToDraw && !selectedClusters.contains(clusterFileId))){
-                        QPolygon trace(nbSamples);
-                        for(int i = 0; i < nbSamples;++i){
-                            int y = positions[j] - static_cast<long>(data(i + 1,channelId + 1) * channelFactors[channelId]);
-                            trace.setPoint(i,X + x,y);
-                            x += Xstep;
-                        }
-                        painter.drawPolyline(trace);
+                    if (downSampling != 1){
+                        drawTrace(painter,limit,positions.at(j),X,channelId,nbSamplesToDraw);
                     }
                     else{
-                        //Array containing 3 lines: sample index, abscissa and ordinate
-                        Array<dataType> traceInfo(3,nbSamples);
-                        QPolygon trace(nbSamples);
-                        for(int i = 1; i <= nbSamples;++i){
-                            int y = positions[j] - static_cast<long>(data(i,channelId + 1) * channelFactors[channelId]);
-                            trace.setPoint(i - 1,X + x,y);
-                            traceInfo(1,i) = i;
-                            traceInfo(2,i) = X + x;
-                            traceInfo(3,i) = y;
-                            x += Xstep;
+                        bool areClustersToDraw = false;
+                        int clusterFileId = 0;
+                        QString providerName;
+                        if (!clusterProviders.isEmpty()){
+                            areClustersToDraw = true;
+                            clusterFileId = (*channelClusterFiles)[channelId];
+                            providerName = QString::number(clusterFileId);
+                            if (clustersData.contains(providerName))
+                                areClustersToDraw = true;
                         }
-                        painter.drawPolyline(trace);
 
-                        //Draw the waveforms on top of the trace
-                        ItemColors* colors = providerItemColors[providerName];
-                        Array<dataType>& currentData = static_cast<ClusterData*>(clustersData[providerName])->getData();
-                        int nbSpikes = currentData.nbOfColumns();
-                        QList<int> clusterList = selectedClusters[clusterFileId];
-                        int currentIndex = 1;
-
-                        for(int i = 1; i < nbSpikes + 1;++i){
-                            dataType index = currentData(1,i);
-                            int firstIndex = qMax(1L,index - nbSamplesBefore);
-                            int lastIndex = qMin((long)nbSamples,index + nbSamplesAfter);
-                            int nbWaveformSamples = lastIndex - firstIndex + 1;
-                            dataType clusterId = currentData(2,i);
-
-                            if (clusterList.contains(clusterId)){
-                                QColor color = colors->color(clusterId);
-                                QPen pen(color,1);
-                                if (mSelectedChannels.contains(channelId)) pen.setWidth(2);
-                                pen.setCosmetic(true);
-                                painter.setPen(pen);
+                        if (!waveforms || (waveforms && !areClustersToDraw) || (waveforms && areClustersToDraw && !selectedClusters.contains(clusterFileId))){
+                            QPolygon trace(nbSamples);
+                            for(int i = 0; i < nbSamples;++i){
+                                int y = positions[j] - static_cast<long>(channelValue(i + 1,channelId) * channelFactors[channelId]);
+                                trace.setPoint(i,X + x,y);
+                                x += Xstep;
+                            }
+                            painter.drawPolyline(trace);
+                        }
+                        else{
+                            //Array containing 3 lines: sample index, abscissa and ordinate
+                            Array<dataType> traceInfo(3,nbSamples);
+                            QPolygon trace(nbSamples);
+                            for(int i = 1; i <= nbSamples;++i){
+                                int y = positions[j] - static_cast<long>(channelValue(i,channelId) * channelFactors[channelId]);
+                                trace.setPoint(i - 1,X + x,y);
+                                traceInfo(1,i) = i;
+                                traceInfo(2,i) = X + x;
+                                traceInfo(3,i) = y;
+                                x += Xstep;
+                            }
+                            painter.drawPolyline(trace);
+
+                            //Draw the waveforms on top of the trace
+                            ItemColors* colors = providerItemColors[providerName];
+                            Array<dataType>& currentData = static_cast<ClusterData*>(clustersData[providerName])->getData();
+                            int nbSpikes = currentData.nbOfColumns();
+                            const QBitArray clusterSet = clusterBits(selectedClusters[clusterFileId]);
+                            int currentIndex = 1;
+
+                            for(int i = 1; i < nbSpikes + 1;++i){
+                                dataType index = currentData(1,i);
+                                int firstIndex = qMax(1L,index - nbSamplesBefore);
+                                int lastIndex = qMin((long)nbSamples,index + nbSamplesAfter);
+                                int nbWaveformSamples = lastIndex - firstIndex + 1;
+                                dataType clusterId = currentData(2,i);
+
+                                if (containsCluster(clusterSet,clusterId)){
+                                    QColor color = colors->color(clusterId);
+                                    QPen pen(color,1);
+                                    if (mSelectedChannels.contains(channelId)) pen.setWidth(2);
+                                    pen.setCosmetic(true);
+                                    painter.setPen(pen);
 
-                                for(int j = currentIndex; j <= nbSamples;++j){
-                                    if (firstIndex > traceInfo(1,j)) continue;//case 1
-                                    else if (firstIndex == traceInfo(1,j)){//case 2
+                                    //traceInfo(1,j) equals j, the waveform is drawn if it starts after the previous one.
+                                    if (firstIndex >= currentIndex && firstIndex <= nbSamples){
                                         QPolygon trace(nbWaveformSamples);
                                         int pos = 0;
                                         for(int k = firstIndex;k<= lastIndex;++k){
@@ -1765,237 +2348,133 @@ void TraceView::drawTraces(QPainter& painter){
                                         }
                                         painter.drawPolyline(trace);
                                         currentIndex = firstIndex;
-                                        break;
                                     }
-                                }//loop on samples to draw
-                            }
-                        }//loop on spikes
-                    }//else waveform
+                                }
+                            }//loop on spikes
+                        }//else waveform
+                    }
                 }
             }
 
-            //Loop on all the selected clusters (first on the cluster files containing selected clusters) if the raster is asked.
-            if (raster && nbClusters != 0){
-                int y = Y0Raster;
-
-                QList<int> clusterFileList = (*groupClusterFiles)[*iterator];
-
-                QMap<int,QList<int> >::Iterator selectedIterator;
-                for(selectedIterator = selectedClusters.begin(); selectedIterator != selectedClusters.end(); ++selectedIterator){
-                    //Only draw rasters for clusters contained in a cluster file containing data for channels of the current group
-                    if (!clusterFileList.contains(selectedIterator.key())) continue;
-                    QList<int> clusterList = selectedIterator.value();
-                    if (clusterList.size() == 0) continue;
-                    QString providerName = QString::number(selectedIterator.key());
-                    ItemColors* colors = providerItemColors[providerName];
-                    Array<dataType>& currentData = static_cast<ClusterData*>(clustersData[providerName])->getData();
-                    int nbSpikes = currentData.nbOfColumns();
-                    QList<int>::iterator clusterIterator;
-                    for(clusterIterator = clusterList.begin(); clusterIterator != clusterList.end(); ++clusterIterator){
-                        const QString identifier = QString::fromLatin1("%1-%2").arg(providerName).arg(*clusterIterator);
-
-
-                        clustersOrder.append(identifier);
-                        rasterOrdinates.append(-y);
-                        rasterAbscisses.append(X);
-                        QColor color = colors->color(*clusterIterator);
-                        QPen pen(color);
-                        pen.setCosmetic(true);
-                        painter.setPen(pen);
-                        int bottom = y - rasterHeight;
-                        for(int i = 1; i <= nbSpikes;++i){
-                            dataType index = currentData(1,i);
-                            dataType clusterId = currentData(2,i);
-                            if (clusterId == *clusterIterator){
-                                int abscissa = X + static_cast<int>(0.5 + (static_cast<float>(index) / downSampling));
-                                painter.drawLine(abscissa,-y,abscissa,-bottom);
-                            }
-                        }
-                        y -= (rasterHeight + YRasterSpace);
-                    }
-                }
-            }//raster
+            //Draw the rasters of the selected clusters (first on the cluster files containing selected clusters) if asked.
+            if (raster && nbClusters != 0)
+                drawRasters(painter,overlay,X,clusterFileList);
             X += Xshift;
         }//groups (<=> columns)
     }//multicolumns
     //traces presented on a single column
     else{
         //Draw events
-        if (!selectedEvents.isEmpty()){
-            QRect windowRectangle((QRect)window);
-            int top = windowRectangle.top();
-            int bottom = windowRectangle.bottom();
-            QPen pen(Qt::DotLine);
-            QMap<QString, QList<int> >::Iterator iterator;
-            for(iterator = selectedEvents.begin(); iterator != selectedEvents.end(); ++iterator){
-                QList<int> eventList = iterator.value();
-                QString providerName = iterator.key();
-
-                if (eventList.size() == 0 || eventsData[providerName] == 0) continue;
-                ItemColors* colors = providerItemColors[providerName];
-                Array<dataType>& currentData = static_cast<EventData*>(eventsData[providerName])->getTimes();
-                Array<int>& currentIds = static_cast<EventData*>(eventsData[providerName])->getIds();
-                int nbEvents = currentData.nbOfColumns();
-                for(int i = 1; i <= nbEvents;++i){
-                    dataType index = currentData(1,i);
-                    int eventId = currentIds(1,i);
-                    if (eventList.contains(eventId)){
-                        QColor color = colors->color(eventId);
-                        pen.setColor(color);
-                        pen.setCosmetic(true);
-                        painter.setPen(pen);
-                        int abscissa = static_cast<int>(0.5 + (static_cast<float>(index) / downSampling));
-                        painter.drawLine(abscissa,top,abscissa,bottom);
-                    }
-                }
-            }
-        }//events
+        overlay.events.draw(painter,eventPen,0,0);
 
         //Draw clusters on vertical lines
-        if (verticalLines && nbClusters != 0){
-            QRect windowRectangle((QRect)window);
-            int top = windowRectangle.top();
-            int bottom = windowRectangle.bottom();
-            QHashIterator<QString, ClusterData*> iterator(clustersData);
-            while (iterator.hasNext()) {
-                iterator.next();
-                ItemColors* colors = providerItemColors[iterator.key()];
-                QList<int> clusterList = selectedClusters[iterator.key().toInt()];
-                Array<dataType>& currentData = iterator.value()->getData();
-                int nbSpikes = currentData.nbOfColumns();
-
-                for(int i = 1; i < nbSpikes + 1;++i){
-                    dataType index = currentData(1,i);
-                    dataType clusterId = currentData(2,i);
-
-                    if (clusterList.contains(clusterId)){
-                        QColor color = colors->color(clusterId);
-                        QPen pen(color);
-                        pen.setCosmetic(true);
-                        painter.setPen(pen);
-                        int abscissa = static_cast<int>(0.5 + (static_cast<float>(index) / downSampling));
-                        painter.drawLine(abscissa,top,abscissa,bottom);
-                    }
-                }
-            }
-        }//verticalLines
+        if (verticalLines && nbClusters != 0)
+            drawClusterLines(painter,overlay,0,QList<int>());
 
         //The ordinate of the system coordinate center for the current channel
         int Y = Y0;
         //Start at the top of the view.
 
-        //Loop on all the groups
-        QList<int> groupIds = shownGroupsChannels.keys();
-        QList<int>::iterator iterator;
-        for(iterator = groupIds.begin(); iterator != groupIds.end(); ++iterator){
-            QList<int> channelIds = shownGroupsChannels[*iterator];
-            int currentNbChannels = channelIds.size();
-
-            QList<int> positions;
-            int y = Y;
-            for(int j = 0; j < currentNbChannels; ++j){
-                int channelId = channelIds[j];
-
-					 int m = 0;
-					 if (autocenterChannels){
-						 for (int i = 1;i <= nbSamples;++i) m += static_cast<long>(data(i,channelId + 1) * channelFactors.at(channelId));
-						 m /= nbSamples;
-					 }
-
-                int position = -y + m + channelOffsets[channelId];
-                positions.append(position);
-                channelsStartingOrdinate.insert(channelId,position - static_cast<long>(data(1,channelId + 1) * channelFactors[channelId]));
-                channelsStartingAbscissa.insert(channelId,X0);
-                y -= Yshift;
-            }
+        if (tiled)
+            drawTraceTiles(painter,tileQueue);
+        else{
+            //Loop on all the groups
+            QList<int> groupIds = shownGroupsChannels.keys();
+            QList<int>::iterator iterator;
+            for(iterator = groupIds.begin(); iterator != groupIds.end(); ++iterator){
+                QList<int> channelIds = shownGroupsChannels[*iterator];
+                int currentNbChannels = channelIds.size();
 
+                QList<int> positions;
+                for(int j = 0; j < currentNbChannels; ++j)
+                    positions.append(tracePositions.value(channelIds[j]));
 
-            for(int j = 0; j < currentNbChannels; ++j){
-                int channelId = channelIds[j];
 
-                //if the channel is skipped, do no draw it
-                if (skippedChannels.contains(channelId)) continue;
+                for(int j = 0; j < currentNbChannels; ++j){
+                    int channelId = channelIds[j];
 
-                //The abscissa of the system coordinate center for the current channel
-                int X = X0;
+                    //if the channel is skipped, do no draw it
+                    if (skippedChannels.contains(channelId)) continue;
 
-                //Get the color associated with the channel and set the color to use to this color
-                QColor color = channelColors->color(channelId);
-                if (greyScaleMode){
-                    int greyvalue = qGray(color.rgb());
-                    color.setHsv(0,0,greyvalue);
-                }
-                QPen pen(color,1);
-                if (mSelectedChannels.contains(channelId)) pen.setWidth(2);
-                pen.setCosmetic(true);
-                painter.setPen(pen);
+                    //The abscissa of the system coordinate center for the current channel
+                    int X = X0;
 
-                if (downSampling != 1){
-                    drawTrace(painter,limit,positions[j],X,channelId,nbSamplesToDraw);
-                }
-                else{
-                    bool areClustersToDraw = false;
-                    int clusterFileId = 0;
-                    QString providerName;
-
-                    if (!clusterProviders.isEmpty()){
-                        areClustersToDraw = true;
-                        clusterFileId = (*channelClusterFiles)[channelId];
-                        providerName = QString::number(clusterFileId);
-                        if (clustersData.contains(providerName))
-                            areClustersToDraw = true;
+                    //Get the color associated with the channel and set the color to use to this color
+                    QColor color = channelColors->color(channelId);
+                    if (greyScaleMode){
+                        int greyvalue = qGray(color.rgb());
+                        color.setHsv(0,0,greyvalue);
                     }
+                    QPen pen(color,1);
+                    if (mSelectedChannels.contains(channelId)) pen.setWidth(2);
+                    pen.setCosmetic(true);
+                    painter.setPen(pen);
 
-                    if (!waveforms || (waveforms && !areClustersToDraw) || (waveforms && areClustersToDraw && !selectedClusters.contains(clusterFileId))){
-                        QPolygon trace(nbSamples);
-                        for(int i = 0; i < nbSamples;++i){
-                            int y = positions[j] - static_cast<long>(data(i + 1,channelId + 1) * channelFactors[channelId]);
-                            trace.setPoint(i,X,y);
-                            X += Xstep;
-                        }
-                        painter.drawPolyline(trace);
+                    if (downSampling != 1){
+                        drawTrace(painter,limit,positions[j],X,channelId,nbSamplesToDraw);
                     }
                     else{
-                        //Array containing 3 lines: sample index, abscissa and ordinate
-                        Array<dataType> traceInfo(3,nbSamples);
-                        QPolygon trace(nbSamples);
-                        for(int i = 1; i <= nbSamples;++i){
-                            int y = positions[j] - static_cast<long>(data(i,channelId + 1) * channelFactors[channelId]);
-                            trace.setPoint(i - 1,X,y);
-                            traceInfo(1,i) = i;
-                            traceInfo(2,i) = X;
-                            traceInfo(3,i) = y;
-                            X += Xstep;
+                        bool areClustersToDraw = false;
+                        int clusterFileId = 0;
+                        QString providerName;
+
+                        if (!clusterProviders.isEmpty()){
+                            areClustersToDraw = true;
+                            clusterFileId = (*channelClusterFiles)[channelId];
+                            providerName = QString::number(clusterFileId);
+                            if (clustersData.contains(providerName))
+                                areClustersToDraw = true;
+                        }
+
+                        if (!waveforms || (waveforms && !areClustersToDraw) || (waveforms && areClustersToDraw && !selectedClusters.contains(clusterFileId))){
+                            QPolygon trace(nbSamples);
+                            for(int i = 0; i < nbSamples;++i){
+                                int y = positions[j] - static_cast<long>(channelValue(i + 1,channelId) * channelFactors[channelId]);
+                                trace.setPoint(i,X,y);
+                                X += Xstep;
+                            }
+                            painter.drawPolyline(trace);
                         }
-                        painter.drawPolyline(trace);
+                        else{
+                            //Array containing 3 lines: sample index, abscissa and ordinate
+                            Array<dataType> traceInfo(3,nbSamples);
+                            QPolygon trace(nbSamples);
+                            for(int i = 1; i <= nbSamples;++i){
+                                int y = positions[j] - static_cast<long>(channelValue(i,channelId) * channelFactors[channelId]);
+                                trace.setPoint(i - 1,X,y);
+                                traceInfo(1,i) = i;
+                                traceInfo(2,i) = X;
+                                traceInfo(3,i) = y;
+                                X += Xstep;
+                            }
+                            painter.drawPolyline(trace);
 
-                        //Draw the waveforms on top of the trace
-                        ItemColors* colors = providerItemColors[providerName];
+                            //Draw the waveforms on top of the trace
+                            ItemColors* colors = providerItemColors[providerName];
 
-                        Array<dataType>& currentData = static_cast<ClusterData*>(clustersData[providerName])->getData();
-                        int nbSpikes = currentData.nbOfColumns();
-                        QList<int> clusterList = selectedClusters[clusterFileId];
-                        int currentIndex = 1;
+                            Array<dataType>& currentData = static_cast<ClusterData*>(clustersData[providerName])->getData();
+                            int nbSpikes = currentData.nbOfColumns();
+                            const QBitArray clusterSet = clusterBits(selectedClusters[clusterFileId]);
+                            int currentIndex = 1;
 
-                        for(int i = 1; i < nbSpikes + 1;++i){
-                            dataType index = currentData(1,i);
-                            int firstIndex = qMax(1L,index - nbSamplesBefore);
-                            int lastIndex = qMin((long)nbSamples,index + nbSamplesAfter);
-                            int nbWaveformSamples = lastIndex - firstIndex + 1;
-                            dataType clusterId = currentData(2,i);
+                            for(int i = 1; i < nbSpikes + 1;++i){
+                                dataType index = currentData(1,i);
+                                int firstIndex = qMax(1L,index - nbSamplesBefore);
+                                int lastIndex = qMin((long)nbSamples,index + nbSamplesAfter);
+                                int nbWaveformSamples = lastIndex - firstIndex + 1;
+                                dataType clusterId = currentData(2,i);
 
-                            if (clusterList.contains(clusterId)){
-                                QColor color = colors->color(clusterId);
-                                QPen pen(color,1);
+                                if (containsCluster(clusterSet,clusterId)){
+                                    QColor color = colors->color(clusterId);
+                                    QPen pen(color,1);
 
-                                if (mSelectedChannels.contains(channelId))
-                                    pen.setWidth(2);
-                                pen.setCosmetic(true);
-                                painter.setPen(pen);
+                                    if (mSelectedChannels.contains(channelId))
+                                        pen.setWidth(2);
+                                    pen.setCosmetic(true);
+                                    painter.setPen(pen);
 
-                                for(int j = currentIndex; j <= nbSamples;++j){
-                                    if (firstIndex > traceInfo(1,j)) continue;//case 1
-                                    else if (firstIndex == traceInfo(1,j)){//case 2
+                                    //traceInfo(1,j) equals j, the waveform is drawn if it starts after the previous one.
+                                    if (firstIndex >= currentIndex && firstIndex <= nbSamples){
                                         QPolygon trace(nbWaveformSamples);
                                         int pos = 0;
                                         for(int k = firstIndex;k<= lastIndex;++k){
@@ -2004,69 +2483,379 @@ void TraceView::drawTraces(QPainter& painter){
                                         }
                                         painter.drawPolyline(trace);
                                         currentIndex = firstIndex;
-                                        break;
                                     }
-                                }//loop on samples to draw
-                            }
-                        }//loop on spikes
-                    }//else waveform
+                                }
+                            }//loop on spikes
+                        }//else waveform
+                    }
+
                 }
 
+                Y -= (currentNbChannels * traceVspace + (currentNbChannels -1) * Yspace);
+                Y -= YGroupSpace;
+            }//groups
+        }
+
+        clustersOrder.clear();
+        rasterOrdinates.clear();
+        rasterAbscisses.clear();
+
+        //Draw the rasters of the selected clusters (first on the cluster files containing selected clusters) if asked.
+        if (raster && nbClusters != 0)
+            drawRasters(painter,overlay,0,QList<int>());
+    }//single column
+
+}
+
+void TraceView::computeOverlayLines(OverlayLines& overlay){
+    QRect windowRectangle((QRect)window);
+    const int top = windowRectangle.top();
+    const int bottom = windowRectangle.bottom();
+
+    QMap<QString, QList<int> >::const_iterator eventIterator;
+    for(eventIterator = selectedEvents.constBegin(); eventIterator != selectedEvents.constEnd(); ++eventIterator){
+        EventData* data = eventsData.value(eventIterator.key());
+        if (eventIterator.value().isEmpty() || data == 0) continue;
+        const QVector<int> batches = overlay.events.batches(eventIterator.value(),providerItemColors.value(eventIterator.key()));
+        Array<dataType>& currentData = data->getTimes();
+        Array<int>& currentIds = data->getIds();
+        int nbEvents = currentData.nbOfColumns();
+        for(int i = 1; i <= nbEvents;++i){
+            const int eventId = currentIds(1,i);
+            if (eventId < 0 || eventId >= batches.size() || batches.at(eventId) < 0) continue;
+            const int abscissa = static_cast<int>(0.5 + (static_cast<float>(currentData(1,i)) / downSampling));
+            overlay.events.lines[batches.at(eventId)].append(QLine(abscissa,top,abscissa,bottom));
+        }
+    }
+
+    if (nbClusters == 0 || (!verticalLines && !raster))
+        return;
+
+    //The vertical lines and the raster ticks are computed in a single pass on the spikes of each cluster file.
+    QMap<int,QList<int> >::const_iterator selectedIterator;
+    for(selectedIterator = selectedClusters.constBegin(); selectedIterator != selectedClusters.constEnd(); ++selectedIterator){
+        const QList<int>& clusterList = selectedIterator.value();
+        const QString providerName = QString::number(selectedIterator.key());
+        ClusterData* data = clustersData.value(providerName);
+        if (clusterList.isEmpty() || data == 0) continue;
+
+        const QVector<int> indexes = itemIndexes(clusterList);
+        QVector<int> batches;
+        LineBatches* lines = 0L;
+        if (verticalLines){
+            lines = &overlay.clusterLines[selectedIterator.key()];
+            batches = lines->batches(clusterList,providerItemColors.value(providerName));
+        }
+        QVector< QVector<QLine> > ticks;
+        if (raster)
+            ticks.resize(clusterList.size());
+
+        Array<dataType>& currentData = data->getData();
+        int nbSpikes = currentData.nbOfColumns();
+        for(int i = 1; i <= nbSpikes;++i){
+            const dataType clusterId = currentData(2,i);
+            if (clusterId < 0 || clusterId >= indexes.size() || indexes.at(clusterId) < 0) continue;
+            const int abscissa = static_cast<int>(0.5 + (static_cast<float>(currentData(1,i)) / downSampling));
+            if (lines != 0L)
+                lines->lines[batches.at(clusterId)].append(QLine(abscissa,top,abscissa,bottom));
+            if (raster)
+                ticks[indexes.at(clusterId)].append(QLine(abscissa,0,abscissa,rasterHeight));
+        }
+
+        if (raster){
+            QHash<int,QVector<QLine> >& clusterTicks = overlay.rasterTicks[selectedIterator.key()];
+            for(int i = 0; i < clusterList.size(); ++i)
+                if (indexes.value(clusterList.at(i),-1) == i) clusterTicks.insert(clusterList.at(i),ticks.at(i));
+        }
+    }
+}
+
+void TraceView::drawClusterLines(QPainter& painter,const OverlayLines& overlay,int X,const QList<int>& clusterFiles){
+    QPen pen;
+    pen.setCosmetic(true);
+    QMap<int,LineBatches>::const_iterator iterator;
+    for(iterator = overlay.clusterLines.constBegin(); iterator != overlay.clusterLines.constEnd(); ++iterator){
+        //Only draw vertical lines for clusters contained in a cluster file containing data for channels of the current group
+        if (multiColumns && !clusterFiles.contains(iterator.key())) continue;
+        iterator.value().draw(painter,pen,X,0);
+    }
+}
+
+void TraceView::drawRasters(QPainter& painter,const OverlayLines& overlay,int X,const QList<int>& clusterFiles){
+    int y = Y0Raster;
+
+    QMap<int,QList<int> >::const_iterator iterator;
+    for(iterator = selectedClusters.constBegin(); iterator != selectedClusters.constEnd(); ++iterator){
+        //Only draw rasters for clusters contained in a cluster file containing data for channels of the current group
+        if (multiColumns && !clusterFiles.contains(iterator.key())) continue;
+        const QList<int>& clusterList = iterator.value();
+        if (clusterList.isEmpty()) continue;
+        const QString providerName = QString::number(iterator.key());
+        ItemColors* colors = providerItemColors.value(providerName);
+        const QHash<int,QVector<QLine> > ticks = overlay.rasterTicks.value(iterator.key());
+
+        QList<int>::const_iterator clusterIterator;
+        for(clusterIterator = clusterList.begin(); clusterIterator != clusterList.end(); ++clusterIterator){
+            const QString identifier = QString::fromLatin1("%1-%2").arg(providerName).arg(*clusterIterator);
+            clustersOrder.append(identifier);
+            rasterOrdinates.append(-y);
+            rasterAbscisses.append(X);
+
+            const QVector<QLine> clusterTicks = ticks.value(*clusterIterator);
+            if (!clusterTicks.isEmpty()){
+                QPen pen(colors->color(*clusterIterator));
+                pen.setCosmetic(true);
+                painter.setPen(pen);
+                painter.translate(X,-y);
+                painter.drawLines(clusterTicks);
+                painter.translate(-X,y);
+            }
+            y -= (rasterHeight + YRasterSpace);
+        }
+    }
+}
+
+QHash<int,int> TraceView::computeTracePositions(int nbSamples){
+    channelsStartingOrdinate.clear();
+    QHash<int,int> positions;
+
+    //The abscissa and the ordinate of the system coordinate center for the current group
+    int X = X0;
+    int Y = Y0;
+
+    QList<int> groupIds = shownGroupsChannels.keys();
+    QList<int>::iterator iterator;
+    for(iterator = groupIds.begin(); iterator != groupIds.end(); ++iterator){
+        const QList<int> channelIds = shownGroupsChannels[*iterator];
+        const int currentNbChannels = channelIds.size();
+
+        int y = Y;
+        for(int j = 0; j < currentNbChannels; ++j){
+            const int channelId = channelIds.at(j);
+
+            int m = 0;
+            if (autocenterChannels){
+                //An envelope has two rows per bin, their mean approximates the mean of the samples.
+                const int nbRows = (envelopeBinSize == 0) ? nbSamples : data.nbOfRows();
+                for (int i = 1;i <= nbRows;++i) m += static_cast<long>(channelValue(i,channelId) * channelFactors.at(channelId));
+                m /= nbRows;
             }
 
+            const int position = -y + m + channelOffsets.at(channelId);
+            positions.insert(channelId,position);
+            channelsStartingOrdinate.insert(channelId,position - static_cast<long>(channelValue(1,channelId) * channelFactors.at(channelId)));
+            channelsStartingAbscissa.insert(channelId,X);
+            y -= Yshift;
+        }
+
+        //Each group has its column in multiple columns mode, the groups follow each other otherwise.
+        if (multiColumns)
+            X += Xshift;
+        else{
             Y -= (currentNbChannels * traceVspace + (currentNbChannels -1) * Yspace);
             Y -= YGroupSpace;
-        }//groups
+        }
+    }
+    return positions;
+}
 
-        clustersOrder.clear();
-        rasterOrdinates.clear();
-        rasterAbscisses.clear();
+QPen TraceView::tracePen(int channelId){
+    QColor color = channelColors->color(channelId);
+    if (greyScaleMode){
+        int greyvalue = qGray(color.rgb());
+        color.setHsv(0,0,greyvalue);
+    }
+    QPen pen(color,1);
+    if (mSelectedChannels.contains(channelId))
+        pen.setWidth(2);
+    pen.setCosmetic(true);
+    return pen;
+}
 
-        //Loop on all the selected clusters (first on the cluster files containing selected clusters) if the raster is asked.
-        if (raster && nbClusters != 0){
-            Y = Y0Raster;
-
-            QMap<int,QList<int> >::Iterator iterator;
-            for(iterator = selectedClusters.begin(); iterator != selectedClusters.end(); ++iterator){
-                qDebug()<<" selectedClusters.begin()"<<*iterator;
-                QList<int> clusterList = iterator.value();
-                if (clusterList.isEmpty())
-                    continue;
-                QString providerName = QString::number(iterator.key());
-                qDebug()<<" providerName "<<providerName;
-                ItemColors* colors = providerItemColors[providerName];
-                qDebug()<<" clustersData[providerName]"<<clustersData[providerName];
-                Array<dataType>& currentData = static_cast<ClusterData*>(clustersData[providerName])->getData();
-                int nbSpikes = currentData.nbOfColumns();
-                QList<int>::iterator clusterIterator;
-                QList<int>::iterator clusterIteratorEnd(clusterList.end());
-                for(clusterIterator = clusterList.begin(); clusterIterator != clusterIteratorEnd; ++clusterIterator){
-                    const QString identifier = QString("%1-%2").arg(providerName).arg(*clusterIterator);
-
-                    qDebug()<<" *** identifier " <<identifier<<" nbSpikes " <<nbSpikes ;
-
-                    clustersOrder.append(identifier);
-                    rasterOrdinates.append(-Y);
-                    rasterAbscisses.append(0);
-                    QColor color = colors->color(*clusterIterator);
-                    QPen pen(color);
-                    pen.setCosmetic(true);
-                    painter.setPen(pen);
-                    int bottom = Y - rasterHeight;
-                    for(int i = 1; i < nbSpikes + 1;++i){
-                        dataType index = currentData(1,i);
-                        dataType clusterId = currentData(2,i);
-                        if (clusterId == *clusterIterator){
-                            int abscissa = static_cast<int>(0.5 + (static_cast<float>(index) / downSampling));
-                            painter.drawLine(abscissa,-Y,abscissa,-bottom);
-                        }
-                    }
-                    Y -= (rasterHeight + YRasterSpace);
-                }
+bool TraceView::startTraceTiles(QPainter& painter,TileQueue& queue,const QHash<int,int>& tracePositions,int limit,int nbSamples,int nbSamplesToDraw){
+    //The waveforms are drawn on top of the traces while they are drawn, these drawings stay on the GUI thread.
+    const int nbThreads = renderingPool()->maxThreadCount();
+    const int deviceType = painter.device()->devType();
+    if (nbThreads < 2 || (waveforms && !selectedClusters.isEmpty()) || (deviceType != QInternal::Pixmap && deviceType != QInternal::Image))
+        return false;
+
+    //Gather the traces in drawing order, by column in multiple columns mode.
+    QList< QList<TraceTile::Trace> > columns;
+    QList<int> columnGroups;
+    QList<int> groupIds = shownGroupsChannels.keys();
+    QList<int>::iterator iterator;
+    for(iterator = groupIds.begin(); iterator != groupIds.end(); ++iterator){
+        if (multiColumns || columns.isEmpty()){
+            columns.append(QList<TraceTile::Trace>());
+            columnGroups.append(multiColumns ? *iterator : -1);
+        }
+        const QList<int> channelIds = shownGroupsChannels[*iterator];
+        for(int j = 0; j < channelIds.size(); ++j){
+            const int channelId = channelIds.at(j);
+            if (skippedChannels.contains(channelId))
+                continue;
+            TraceTile::Trace trace;
+            trace.channelId = channelId;
+            trace.basePosition = tracePositions.value(channelId);
+            trace.X = channelsStartingAbscissa.value(channelId);
+            trace.pen = tracePen(channelId);
+            columns.last().append(trace);
+        }
+    }
+
+    //Split the columns in horizontal bands to have at least one tile per thread.
+    const int nbBands = qMax(1,(nbThreads + columns.size() - 1) / qMax(1,columns.size()));
+    for(int i = 0; i < columns.size(); ++i){
+        const QList<TraceTile::Trace>& traces = columns.at(i);
+        const int nbTiles = qMin(nbBands,traces.size());
+        for(int j = 0; j < nbTiles; ++j){
+            TraceTile* tile = new TraceTile(columnGroups.at(i));
+            tile->traces = traces.mid((j * traces.size()) / nbTiles,((j + 1) * traces.size()) / nbTiles - (j * traces.size()) / nbTiles);
+            queue.tiles.append(tile);
+        }
+    }
+    if (queue.tiles.size() < 2){
+        qDeleteAll(queue.tiles);
+        queue.tiles.clear();
+        return false;
+    }
+
+    queue.limit = limit;
+    queue.nbSamples = nbSamples;
+    queue.nbSamplesToDraw = nbSamplesToDraw;
+    queue.window = painter.window();
+    queue.viewport = painter.viewport();
+    queue.deviceRect = QRect(0,0,painter.device()->width(),painter.device()->height());
+    queue.transform = painter.combinedTransform();
+
+    //The decimated traces are computed by the tiles, each one filling the entries of its channels.
+    if (downSampling != 1)
+        resetDecimatedTraces(nbSamplesToDraw);
+
+    queue.nbWorkers = qMin(nbThreads,queue.tiles.size() - 1);
+    for(int i = 0; i < queue.nbWorkers; ++i)
+        renderingPool()->start(new TileWorker(*this,queue));
+    return true;
+}
+
+bool TraceView::renderNextTile(TileQueue& queue){
+    const int index = queue.nextTile.fetchAndAddOrdered(1);
+    if (index >= queue.tiles.size())
+        return false;
+
+    TraceTile* tile = queue.tiles.at(index);
+    renderTile(*tile,queue);
+    tile->rendered.release();
+    return true;
+}
+
+void TraceView::renderTile(TraceTile& tile,const TileQueue& queue){
+    const bool decimated = (downSampling != 1);
+    const int nbColumns = decimated ? queue.nbSamplesToDraw : queue.nbSamples;
+    if (nbColumns <= 0 || tile.traces.isEmpty())
+        return;
+
+    //Only some columns are drawn while scrolling, see drawExtrema.
+    const int firstColumn = decimated ? qMax(1,firstColumnToDraw) : 1;
+    const int lastColumn = (decimated && lastColumnToDraw >= 0) ? qMin(nbColumns,lastColumnToDraw) : nbColumns;
+    if (firstColumn > lastColumn)
+        return;
+
+    //Bounds of the traces in the world, the image only covers the part of the device they can reach.
+    QRect bounds;
+    QList<TraceTile::Trace>::const_iterator iterator;
+    for(iterator = tile.traces.constBegin(); iterator != tile.traces.constEnd(); ++iterator){
+        const int channelId = (*iterator).channelId;
+        long min;
+        long max;
+        if (decimated){
+            QVector<long>& extrema = decimatedTraces[channelId];
+            if (extrema.isEmpty())
+                decimateTrace(channelId,queue.nbSamplesToDraw,queue.nbSamples,extrema);
+            min = max = extrema.at(0);
+            for(int i = 1; i < extrema.size(); ++i){
+                min = qMin(min,extrema.at(i));
+                max = qMax(max,extrema.at(i));
             }
-        }//raster
-    }//single column
+        }
+        else{
+            min = max = channelValue(1,channelId);
+            for(int i = 2; i <= queue.nbSamples; ++i){
+                const long value = channelValue(i,channelId);
+                min = qMin(min,value);
+                max = qMax(max,value);
+            }
+        }
+        const float factor = channelFactors.at(channelId);
+        const int y1 = (*iterator).basePosition - static_cast<long>(min * factor);
+        const int y2 = (*iterator).basePosition - static_cast<long>(max * factor);
+        bounds |= QRect(QPoint((*iterator).X + (firstColumn - 1) * Xstep,qMin(y1,y2)),QPoint((*iterator).X + (lastColumn - 1) * Xstep,qMax(y1,y2)));
+    }
+
+    //The margin covers the rounding of the coordinates and the width of the pens.
+    const QRect area = queue.transform.mapRect(QRectF(bounds)).toAlignedRect().adjusted(-2,-2,2,2) & queue.deviceRect;
+    if (area.isEmpty())
+        return;
+
+    tile.image = QImage(area.size(),QImage::Format_ARGB32_Premultiplied);
+    tile.image.fill(0);
+    tile.origin = area.topLeft();
+
+    //Same transformation and clipping as the painter of the double buffer, shifted to the origin of the tile.
+    QPainter painter(&tile.image);
+    painter.setWindow(queue.window);
+    painter.setViewport(queue.viewport.translated(-area.topLeft()));
+    painter.setClipRect(queue.window);
+    painter.setClipping(true);
+
+    TraceRasterizer tileRasterizer;
+    for(iterator = tile.traces.constBegin(); iterator != tile.traces.constEnd(); ++iterator){
+        const int channelId = (*iterator).channelId;
+        const float factor = channelFactors.at(channelId);
+        painter.setPen((*iterator).pen);
+
+        if (decimated){
+            const QVector<long>& extrema = decimatedTraces.at(channelId);
+            if (renderingBackend == RASTERIZER && tileRasterizer.begin(painter)){
+                drawExtrema(tileRasterizer,queue.limit,(*iterator).basePosition,(*iterator).X,extrema,factor,queue.nbSamplesToDraw);
+                tileRasterizer.end();
+            }
+            else drawExtrema(painter,queue.limit,(*iterator).basePosition,(*iterator).X,extrema,factor,queue.nbSamplesToDraw);
+        }
+        else{
+            QPolygon trace(queue.nbSamples);
+            int X = (*iterator).X;
+            for(int i = 0; i < queue.nbSamples;++i){
+                trace.setPoint(i,X,(*iterator).basePosition - static_cast<long>(channelValue(i + 1,channelId) * factor));
+                X += Xstep;
+            }
+            painter.drawPolyline(trace);
+        }
+    }
+    painter.end();
+}
+
+void TraceView::drawTraceTiles(QPainter& painter,TileQueue& queue,int groupId){
+    //The images are in device coordinates, the clipping of the painter still applies.
+    painter.save();
+    painter.resetTransform();
+    while (queue.nextComposited < queue.tiles.size()){
+        TraceTile* tile = queue.tiles.at(queue.nextComposited);
+        if (groupId != -1 && tile->groupId != groupId)
+            break;
 
+        //Help rendering the remaining tiles until this one is ready.
+        while (!tile->rendered.tryAcquire()){
+            if (!renderNextTile(queue)){
+                tile->rendered.acquire();
+                break;
+            }
+        }
+        if (!tile->image.isNull())
+            painter.drawImage(tile->origin,tile->image);
+        ++queue.nextComposited;
+    }
+    painter.restore();
 }
 
 void TraceView::drawChannelGain(QPainter& painter, const QList<int>& channels, bool enableSkipping)
@@ -2723,14 +3512,14 @@ void TraceView::mousePressEvent(QMouseEvent* event){
                         }
                     }
 
-                    int position = -y + channelOffsets[channelId] - static_cast<long>(data(sampleIndex,channelId + 1) * channelFactors[channelId]);
+                    int position = -y + channelOffsets[channelId] - static_cast<long>(channelValue(dataRow(sampleIndex),channelId) * channelFactors[channelId]);
                     int difference = abs(current.y() - position);
                     int selectedChannel = channelId;
                     y -= Yshift;
 
                     for(int i = channelIndex; i < currentNbChannels; ++i){
                         channelId = channelIds[i];
-                        position = -y + channelOffsets[channelId] - static_cast<long>(data(sampleIndex,channelId + 1) * channelFactors[channelId]);
+                        position = -y + channelOffsets[channelId] - static_cast<long>(channelValue(dataRow(sampleIndex),channelId) * channelFactors[channelId]);
 
                         if (abs(current.y() - position) < difference && !skippedChannels.contains(channelId)){
                             difference = abs(current.y() - position);
@@ -2899,7 +3688,7 @@ void TraceView::mousePressEvent(QMouseEvent* event){
                         }
                     }
 
-                    int position = -y + channelOffsets[channelId] - static_cast<long>(data(sampleIndex,channelId + 1) * channelFactors[channelId]);
+                    int position = -y + channelOffsets[channelId] - static_cast<long>(channelValue(dataRow(sampleIndex),channelId) * channelFactors[channelId]);
                     int difference = abs(current.y() - position);
                     int selectedChannel = channelId;
                     y -= Yshift;
@@ -2911,7 +3700,7 @@ void TraceView::mousePressEvent(QMouseEvent* event){
                         if (j == startingGroupIndex) i = channelIndex;
                         for(; i < currentNbChannels; ++i){
                             channelId = channelIds[i];
-                            position = -y + channelOffsets[channelId] - static_cast<long>(data(sampleIndex,channelId + 1) * channelFactors[channelId]);
+                            position = -y + channelOffsets[channelId] - static_cast<long>(channelValue(dataRow(sampleIndex),channelId) * channelFactors[channelId]);
 
                             if (abs(current.y() - position) < difference && !skippedChannels.contains(channelId)){
                                 difference = abs(current.y() - position);
@@ -3720,6 +4509,7 @@ void TraceView::addClusterProvider(ClustersProvider* clustersProvider,QString na
 }
 
 void TraceView::removeClusterProvider(const QString &name, bool active){
+    cancelJumpPrefetch();
     selectedClusters.remove(name.toInt());
     clustersNotUsedForBrowsing.remove(name);
     clusterProviders.remove(name);
@@ -3735,6 +4525,7 @@ void TraceView::removeClusterProvider(const QString &name, bool active){
 
 
 void TraceView::showClusters(const QString &name, const QList<int> &clustersToShow){
+    cancelJumpPrefetch();
     qDebug()<<" void TraceView::showClusters(const QString &name, const QList<int> &clustersToShow){"<<name;
     ClusterData* clusterData = clustersData[name];
 
@@ -3765,6 +4556,7 @@ void TraceView::showClusters(const QString &name, const QList<int> &clustersToSh
 }
 
 void TraceView::updateNoneBrowsingClusterList(const QString &providerName,const QList<int>& clustersToNotBrowse){
+    cancelJumpPrefetch();
     QList<int> clusters;
     QList<int>::const_iterator iterator;
     for(iterator = clustersToNotBrowse.begin(); iterator != clustersToNotBrowse.end(); ++iterator){
@@ -3779,6 +4571,17 @@ void TraceView::skipStatusChanged(const QList<int>& skippedChannels){
     for(iterator = skippedChannels.begin(); iterator != skippedChannels.end(); ++iterator){
         this->skippedChannels.append(*iterator);
     }
+
+    //Retrieve the channels which are no longer skipped if they have not been retrieved yet.
+    if (!dataReady)
+        return;
+    for(iterator = shownChannels.begin(); iterator != shownChannels.end(); ++iterator){
+        if (!this->skippedChannels.contains(*iterator) && dataColumns.value(*iterator) == 0){
+            dataReady = false;
+            requestTraces();
+            return;
+        }
+    }
 }
 
 void TraceView::clusterColorUpdate(const QColor &c, const QString &name, int clusterId, bool active){
@@ -3816,6 +4619,9 @@ void TraceView::print(QPainter& printPainter,int width, int height,bool whiteBac
     //Enable to draw all the points without down sampling in order to have one line per trace and not a multiple number of small vertical lines
     //This will suppress any zoom.
     printState = true;
+    //An envelope can not be drawn without down sampling, get the samples.
+    if (envelopeBinSize != 0)
+        requestTraces();
     updateWindow();
     r = ((QRect)window);
 
@@ -3908,6 +4714,7 @@ void TraceView::addEventProvider(EventsProvider* eventsProvider,QString name,Ite
 }
 
 void TraceView::removeEventProvider(const QString& name,bool active){
+    cancelJumpPrefetch();
     selectedEvents.remove(name);
     eventsNotUsedForBrowsing.remove(name);
     eventProviders.remove(name);
@@ -3919,6 +4726,7 @@ void TraceView::removeEventProvider(const QString& name,bool active){
 }
 
 void TraceView::showEvents(const QString &name,QList<int>& eventsToShow){
+    cancelJumpPrefetch();
     EventData* eventData;
     eventData = eventsData[name];
 
@@ -3950,6 +4758,7 @@ void TraceView::showEvents(const QString &name,QList<int>& eventsToShow){
 }
 
 void  TraceView::updateEvents(const QString& providerName,QList<int>& eventsToShow,bool active){
+    cancelJumpPrefetch();
     EventData* eventData;
     eventData = eventsData[providerName];
 
@@ -3970,6 +4779,7 @@ void  TraceView::updateEvents(const QString& providerName,QList<int>& eventsToSh
 }
 
 void TraceView::updateNoneBrowsingEventList(const QString& providerName,const QList<int>& eventsToNotBrowse){
+    cancelJumpPrefetch();
     QList<int> events;
     QList<int>::const_iterator iterator;
     QList<int>::const_iterator end(eventsToNotBrowse.end());
@@ -3991,6 +4801,10 @@ void TraceView::eventColorUpdate(const QColor &c, const  QString &name,int event
 void TraceView::showNextEvent(){
     if (endTime == length) return;
 
+    //The target of a jump in another direction, or of another kind, has been read ahead for nothing.
+    if (jumpPrefetch != NEXT_EVENT_PREFETCH)
+        cancelJumpPrefetch();
+
     //Only request data from the provider for which events have been selected
     if (!selectedEvents.isEmpty()){
 
@@ -4039,6 +4853,10 @@ void TraceView::showNextEvent(){
 void TraceView::showPreviousEvent(){
     if (startTime == 0) return;
 
+    //The target of a jump in another direction, or of another kind, has been read ahead for nothing.
+    if (jumpPrefetch != PREVIOUS_EVENT_PREFETCH)
+        cancelJumpPrefetch();
+
     //Only request data from the provider for which events have been selected
     if (!selectedEvents.isEmpty()){
 
@@ -4084,6 +4902,39 @@ void TraceView::showPreviousEvent(){
     }
 }
 
+QList<int> TraceView::eventIdsToBrowse(const QString& providerName) const{
+    QList<int> selectedIds = selectedEvents.value(providerName);
+    QList<int> idsToNotUse = eventsNotUsedForBrowsing.value(providerName);
+    QList<int> ids;
+    QList<int>::const_iterator iterator;
+    for(iterator = selectedIds.constBegin(); iterator != selectedIds.constEnd(); ++iterator)
+        if (!idsToNotUse.contains(*iterator)) ids.append(*iterator);
+    return ids;
+}
+
+void TraceView::prefetchEventJump(bool forward){
+    //Look up for the closest target among the providers, as showNextEvent and showPreviousEvent do from the current time frame.
+    long timeFrameWidth = endTime - startTime;
+    long target = -1;
+    QMap<QString, QList<int> >::const_iterator iterator;
+    for(iterator = selectedEvents.constBegin(); iterator != selectedEvents.constEnd(); ++iterator){
+        EventsProvider* provider = eventProviders.value(iterator.key());
+        QList<int> ids = eventIdsToBrowse(iterator.key());
+        if (provider == 0L || ids.isEmpty()) continue;
+        long startingTime = provider->browsingTarget(startTime,timeFrameWidth,ids,forward);
+        if (startingTime < 0 || startingTime == startTime) continue;
+        if (target < 0 || (forward && startingTime < target) || (!forward && startingTime > target))
+            target = startingTime;
+    }
+    if (target < 0 || target >= length)
+        return;
+
+    if (target + timeFrameWidth > length)
+        target = length - timeFrameWidth;
+    jumpPrefetch = forward ? NEXT_EVENT_PREFETCH : PREVIOUS_EVENT_PREFETCH;
+    prefetchTraces(target,target + timeFrameWidth,0);
+}
+
 void TraceView::nextEventDataAvailable(Array<dataType>& times,Array<int>& ids,QObject* initiator,QString providerName,long startingTime){
     //If another widget was the initiator of the request, ignore the data.
     if (initiator != this) return;
@@ -4124,6 +4975,7 @@ void TraceView::nextEventDataAvailable(Array<dataType>& times,Array<int>& ids,QO
             eventProviderToSkip = nextEventProvider.first;
             //update the traceWidget time widgets and retreive the data for the new start time for all the providers except the one containing the data for the new start time.
             emit setStartAndDuration(nextEventProvider.second,timeFrameWidth);
+            prefetchEventJump(true);
         }
     }
     else if (ready && (nextEventProvider.second == startTime || nextEventProvider.second > length)){
@@ -4174,6 +5026,7 @@ void TraceView::previousEventDataAvailable(Array<dataType>& times,Array<int>& id
             eventProviderToSkip = previousEventProvider.first;
             //update the traceWidget time widgets and retreive the data for the new start time for all the providers except the one containing the data for the new start time.
             emit setStartAndDuration(previousEventProvider.second,timeFrameWidth);
+            prefetchEventJump(false);
         }
     }
     //if the new start time is equals to the current one or superior to the recording lenght do not do anything
@@ -4197,6 +5050,9 @@ void TraceView::previousEventDataAvailable(Array<dataType>& times,Array<int>& id
 
 
 void TraceView::drawEvent(const QString& providerName,int selectedEventId,dataType selectedEventIndex,bool highlight){
+    //The double buffer no longer matches the layer of the traces.
+    tracesLayerValid = false;
+
     QPainter painter;
     painter.begin(&doublebuffer);
     //set the window (part of the world I want to show)
@@ -4363,6 +5219,10 @@ void TraceView::showNextCluster(){
     if (endTime == length)
         return;
 
+    //The target of a jump in another direction, or of another kind, has been read ahead for nothing.
+    if (jumpPrefetch != NEXT_CLUSTER_PREFETCH)
+        cancelJumpPrefetch();
+
     //Only request data from the provider for which clusters have been selected
     if (!selectedClusters.isEmpty()){
         QList<int> toRemove;
@@ -4412,6 +5272,10 @@ void TraceView::showNextCluster(){
 void TraceView::showPreviousCluster(){
     if (startTime == 0) return;
 
+    //The target of a jump in another direction, or of another kind, has been read ahead for nothing.
+    if (jumpPrefetch != PREVIOUS_CLUSTER_PREFETCH)
+        cancelJumpPrefetch();
+
     //Only request data from the provider for which clusters have been selected
     if (!selectedClusters.isEmpty()){
         QList<int> toRemove;
@@ -4458,6 +5322,44 @@ void TraceView::showPreviousCluster(){
     }
 }
 
+QList<int> TraceView::clusterIdsToBrowse(int providerName) const{
+    QList<int> selectedIds = selectedClusters.value(providerName);
+    QList<int> idsToNotUse = clustersNotUsedForBrowsing.value(QString::number(providerName));
+    QList<int> ids;
+    QList<int>::const_iterator iterator;
+    for(iterator = selectedIds.constBegin(); iterator != selectedIds.constEnd(); ++iterator)
+        if (!idsToNotUse.contains(*iterator)) ids.append(*iterator);
+    return ids;
+}
+
+void TraceView::prefetchClusterJump(bool forward){
+    //Look up for the closest target among the providers, as showNextCluster and showPreviousCluster do from the current time frame.
+    long timeFrameWidth = endTime - startTime;
+    long target = -1;
+    long targetInRecordingUnits = 0;
+    QMap<int, QList<int> >::const_iterator iterator;
+    for(iterator = selectedClusters.constBegin(); iterator != selectedClusters.constEnd(); ++iterator){
+        ClustersProvider* provider = clusterProviders.value(QString::number(iterator.key()));
+        QList<int> ids = clusterIdsToBrowse(iterator.key());
+        if (provider == 0L || ids.isEmpty()) continue;
+        long startingTime;
+        long startingTimeInRecordingUnits;
+        if (!provider->browsingTarget(startTime,timeFrameWidth,ids,forward,startTimeInRecordingUnits,startingTime,startingTimeInRecordingUnits) ||
+                startingTimeInRecordingUnits == startTimeInRecordingUnits) continue;
+        if (target < 0 || (forward && startingTimeInRecordingUnits < targetInRecordingUnits) || (!forward && startingTimeInRecordingUnits > targetInRecordingUnits)){
+            target = startingTime;
+            targetInRecordingUnits = startingTimeInRecordingUnits;
+        }
+    }
+    if (target < 0 || target >= length)
+        return;
+
+    if (target + timeFrameWidth > length)
+        target = length - timeFrameWidth;
+    jumpPrefetch = forward ? NEXT_CLUSTER_PREFETCH : PREVIOUS_CLUSTER_PREFETCH;
+    prefetchTraces(target,target + timeFrameWidth,targetInRecordingUnits);
+}
+
 void TraceView::nextClusterDataAvailable(Array<dataType>& data,QObject* initiator,QString providerName,long startingTime,long startingTimeInRecordingUnits){
     //If another widget was the initiator of the request, ignore the data.
     if (initiator != this)
@@ -4501,6 +5403,7 @@ void TraceView::nextClusterDataAvailable(Array<dataType>& data,QObject* initiato
 
             //update the traceWidget time widgets and retrieve the data for the new start time for all the providers except the one containing the data for the new start time.
             emit setStartAndDuration(nextClusterProvider.second,timeFrameWidth);
+            prefetchClusterJump(true);
         }
     }
     else if (ready && (startTimeInRecordingUnits == previousStartTimeInRecordingUnits || nextClusterProvider.second > length)){
@@ -4554,6 +5457,7 @@ void TraceView::previousClusterDataAvailable(Array<dataType>& data,QObject* init
             clusterProviderToSkip = previousClusterProvider.first;
             //update the traceWidget time widgets and retrieve the data for the new start time for all the providers except the one containing the data for the new start time.
             emit setStartAndDuration(previousClusterProvider.second,timeFrameWidth);
+            prefetchClusterJump(false);
         }
     }
     //if the new start time (in recording unit) is equals to the current one do not do anything
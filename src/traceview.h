@@ -24,9 +24,13 @@
 #include <QHash>
 #include <QPair>
 #include <QImage>
+#include <QPen>
 #include <QDebug>
 
 #include <QList>
+#include <QVector>
+#include <QTimer>
+#include <QAtomicInt>
 #include <QResizeEvent>
 #include <QMouseEvent>
 
@@ -34,6 +38,9 @@
 #include "baseframe.h"
 #include "tracesprovider.h"
 #include "eventdata.h"
+#include "tracerasterizer.h"
+#include "tracesdecimation.h"
+#include "frametimings.h"
 
 #include <QStatusBar>
 
@@ -104,6 +111,28 @@ public:
         length = tracesProvider.recordingLength();
     }
 
+    /**Follows the growth of the data file being recorded, recordingLengthChanged is emitted when data have been appended.
+  * @return true if the growth of the file is notified, false if the length has to be polled with updateRecordingLength.
+  */
+    bool startLiveUpdates();
+
+    /**Stops following the growth of the data file.*/
+    void stopLiveUpdates();
+
+    /**Backends used to draw the traces.
+  * <ul>
+  * <li>QPAINTER each pixel column of the traces is drawn with the painter.</li>
+  * <li>RASTERIZER the pixel columns are written directly in an image, drawn once per trace (see TraceRasterizer).</li>
+  * </ul>
+  */
+    enum RenderingBackend {QPAINTER=0,RASTERIZER=1};
+
+    /**Sets the backend used by all the views to draw the traces, the change applies on the next drawing.*/
+    static void setRenderingBackend(RenderingBackend backend){renderingBackend = backend;}
+
+    /**Returns the backend used by all the views to draw the traces.*/
+    static RenderingBackend getRenderingBackend(){return renderingBackend;}
+
     /**Enum to be use as a Mode.
   * <ul>
   * <li>SELECT Enumeration indicating that the user is in a mode enabling him to select traces.</li>
@@ -240,6 +269,29 @@ public:
             update();
     }
 
+    /**Sets the reduction of the samples to the pixel columns of the traces.
+  * The overview envelope, which already is a range per bin, is always reduced to its extrema.
+  * @param mode the new reduction.
+  */
+    void setDecimationMode(TracesDecimation::Mode mode);
+
+    /**Returns the reduction of the samples to the pixel columns of the traces.*/
+    TracesDecimation::Mode getDecimationMode() const{return decimationMode;}
+
+    /**Shows or hides the timings of the frames, drawn on top of the traces and summarized in the status bar.
+  * The timings are recorded in both cases.
+  * @param show true if the timings have to be shown, false otherwise.
+  */
+    void setFrameTimingsShown(bool show);
+
+    /**Returns true if the timings of the frames are shown, false otherwise.*/
+    bool isFrameTimingsShown() const{return showFrameTimings;}
+
+    /**Writes the timings of the last frames as comma separated values in the file @p fileName, see FrameTimings.
+  * @return true if the file could be written, false otherwise.
+  */
+    bool exportFrameTimings(const QString& fileName) const{return frameTimings.exportCsv(fileName);}
+
     /**Adds a new provider of cluster data.
   * @param clustersProvider provider of cluster data.
   * @param name name use to identified the cluster provider.
@@ -421,6 +473,22 @@ public Q_SLOTS:
   */
     void dataAvailable(Array<dataType>& data,QObject* initiator);
 
+    /**Displays the envelope of the traces that has been retrieved from the overview of the data file.
+  * @param envelope array of data with two rows per bin, the minimum then the maximum of each channel.
+  * @param binSize number of samples summarized by each bin.
+  * @param binOffset number of samples of the first bin preceding the start of the time frame.
+  * @param initiator instance requesting the data.
+  */
+    void envelopeAvailable(Array<dataType>& envelope,long binSize,long binOffset,QObject* initiator);
+
+    /**Updates the length of the recording in progress.
+  * @param length new length of the recording in miliseconds.
+  */
+    void slotRecordingLengthChanged(qlonglong length);
+
+    /**Redraws the traces entirely once the scrolling has stopped, see scrollTracesLayer.*/
+    void slotScrollStopped();
+
     /**Displays the cluster information that has been retrieved.
   * @param data 2 line array containing the sample index of the peak index of each spike existing in the requested time frame with the
   * corresponding cluster id. The first line contains the sample index and the second line the cluster id.
@@ -511,6 +579,9 @@ Q_SIGNALS:
     // Emitted if dataAvailable(...) receives faulty data
     void dataError();
 
+    /**Emitted when data have been appended to the file being recorded, see startLiveUpdates.*/
+    void recordingLengthChanged();
+
 protected:
     /**
   * Draws the contents of the frame
@@ -555,6 +626,19 @@ private:
     /**Pointer to the status bar of the application.*/
     QStatusBar* statusBar;
 
+    /**True if the timings of the frames are drawn on top of the traces and summarized in the status bar.*/
+    bool showFrameTimings;
+
+    /**Timings of the last frames drawn, and of the frame being prepared.*/
+    FrameTimings frameTimings;
+    FrameTimings::Frame pendingFrame;
+
+    /**Time spent computing the decimated traces during the frame being prepared, in microseconds, summed over the rendering threads,
+  * and the part of it spent on the GUI thread, in nanoseconds.
+  */
+    QAtomicInt decimationTime;
+    qint64 guiDecimationTime;
+
     /**Provider of the channels data.*/
     TracesProvider& tracesProvider;
 
@@ -579,6 +663,35 @@ private:
     /**Array containing the traces data.*/
     Array<dataType> data;
 
+    /**Number of samples summarized by each bin if data contains an envelope (two rows per bin, the minimum
+  * then the maximum), 0 if data contains the samples.*/
+    long envelopeBinSize;
+
+    /**Number of samples of the first bin of the envelope preceding startTime.*/
+    long envelopeBinOffset;
+
+    /**Channels of the last request, all the channels if empty.*/
+    QList<int> requestedChannels;
+
+    /**Column of data (starting at 1) containing each channel, 0 if the channel has not been retrieved.*/
+    QVector<int> dataColumns;
+
+    /**Index of the sample contained in the first row of data, -1 if data can not be reused for the next time frame
+  * (envelope, error).*/
+    long dataFirstSample;
+
+    /**Channels contained in data, all the channels if empty.*/
+    QList<int> dataChannels;
+
+    /**Version of the provider parameters used to decode data.*/
+    int dataVersion;
+
+    /**Row of data (starting at 0) receiving the samples of a partial retrieve, -1 if the whole time frame is retrieved.*/
+    long partialRow;
+
+    /**Number of samples expected from the partial retrieve.*/
+    long partialNbSamples;
+
     /**Autocenter channels.*/
     bool autocenterChannels;
 
@@ -736,6 +849,9 @@ private:
   * to the part of the drawing which will actually be drawn onto the widget).*/
     static const int YMARGIN;
 
+    /**Number of samples per pixel column above which the traces are drawn from the overview of the data file.*/
+    static const long ENVELOPE_MIN_SAMPLES_PER_PIXEL;
+
     /**Border on the left and right sides inside the window (QRect corresponding
   * to the part of the drawing which will actually be drawn onto the widget).*/
     int xMargin;
@@ -814,6 +930,61 @@ private:
   * and the the size of the widget.*/
     float downSampling;
 
+    /**Extrema of each pixel column of the traces, indexed by channel id, empty if not computed yet. See decimatedTrace.*/
+    QVector< QVector<long> > decimatedTraces;
+
+    /**Downsampling and number of pixel columns used to compute decimatedTraces.*/
+    float decimatedDownSampling;
+    int decimatedNbSamplesToDraw;
+
+    /**Reduction of the samples to the pixel columns chosen for the view, and the one used to compute decimatedTraces.*/
+    TracesDecimation::Mode decimationMode;
+    TracesDecimation::Mode decimatedMode;
+
+    /**First sample of each pixel column of decimatedTraces (index 0 for the first column), sorted, used to map the spikes to the columns.*/
+    QVector<int> columnStarts;
+
+    /**Backend used to draw the traces, shared by all the views.*/
+    static RenderingBackend renderingBackend;
+
+    /**Rasterizer used to draw the traces with the RASTERIZER backend.*/
+    TraceRasterizer rasterizer;
+
+    /**Columns drawn by drawExtrema, starting at 1, lastColumnToDraw being -1 to draw up to the last column.*/
+    int firstColumnToDraw;
+    int lastColumnToDraw;
+
+    /**Traces, events and clusters drawn by drawTraces, below the labels and the calibration scale of the double buffer.
+  * It is scrolled when only the time frame has moved.
+  */
+    QPixmap tracesLayer;
+
+    /**False if the double buffer has been drawn on since tracesLayer was drawn (highlights), the layer cannot be scrolled then.*/
+    bool tracesLayerValid;
+
+    /**Window, viewport and downsampling used to draw tracesLayer.*/
+    QRect tracesLayerWindow;
+    QRect tracesLayerViewport;
+    float tracesLayerDownSampling;
+
+    /**Number of pixel columns the time frame has moved by, positive forward, to scroll tracesLayer on the next drawing.
+  * pendingScrollColumns holds the move until the missing traces are available.
+  */
+    int scrollColumns;
+    int pendingScrollColumns;
+
+    /**Difference, in samples, between the moves of the time frame and the columns scrolled since the last complete drawing.*/
+    float scrollDrift;
+
+    /**True if decimatedTraces and tracesLayer have been scrolled since the last complete drawing.*/
+    bool tracesScrolled;
+
+    /**Timer redrawing the traces entirely, with exact columns, once the scrolling has stopped.*/
+    QTimer* scrollTimer;
+
+    /**Delay, in miliseconds, after the last scroll before the traces are redrawn entirely.*/
+    static const int SCROLL_REDRAW_DELAY;
+
     /**Boolean indicating that the view has been zoomed.*/
     bool zoomed;
 
@@ -943,6 +1114,12 @@ private:
     /**True if the user has just browsed spikes, false otherwise.*/
     bool spikeBrowsing;
 
+    /**Jumps whose following target can be read ahead.*/
+    enum JumpPrefetch {NO_JUMP_PREFETCH=0,NEXT_EVENT_PREFETCH=1,PREVIOUS_EVENT_PREFETCH=2,NEXT_CLUSTER_PREFETCH=3,PREVIOUS_CLUSTER_PREFETCH=4};
+
+    /**Jump whose following target is being read ahead, NO_JUMP_PREFETCH if none.*/
+    JumpPrefetch jumpPrefetch;
+
     /**Dictionary between the event provider names and the event data and status.*/
     QHash<QString, EventData*> eventsData;
 
@@ -1047,6 +1224,214 @@ private:
  */
     void drawTrace(QPainter& painter,int limit,int basePosition,int X,int channelId,int nbSamplesToDraw,bool mouseMoveEvent = false);
 
+    /**Draws the pixel columns of a trace on @p canvas, a QPainter or a TraceRasterizer.
+  * @param extrema the extrema of each pixel column, see decimatedTrace.
+  * @param factor the drawing gain of the channel.
+  * The other parameters are the ones of drawTrace.
+  */
+    template <class Canvas>
+    void drawExtrema(Canvas& canvas,int limit,int basePosition,int X,const QVector<long>& extrema,float factor,int nbSamplesToDraw);
+
+    /**Returns the extrema drawn in each pixel column of the trace of the channel @p channelId, the minimum then the maximum,
+  * each column joining the previous one. With the LTTB and STRIDE reductions, both are the point of the column, joined to the
+  * previous one while drawing (see columnRange). They are computed on the first call after the traces or the downsampling
+  * have changed, and reused by all the drawings (highlight, selection, repaint) until then.
+  * @param channelId the id of the channel.
+  * @param nbSamplesToDraw number of pixel columns of the trace.
+  */
+    const QVector<long>& decimatedTrace(int channelId,int nbSamplesToDraw);
+
+    /**Computes the extrema of the pixel columns @p firstColumn to @p lastColumn (included, starting at 1) of the trace of
+  * the channel @p channelId into @p extrema, the previous columns being already computed, see decimatedTrace.
+  */
+    void decimateColumns(int channelId,int firstColumn,int lastColumn,int nbSamples,QVector<long>& extrema);
+
+    /**Moves the extrema of the decimated traces by @p nbColumns pixel columns (positive to move them to the left)
+  * and computes the exposed columns, after the time frame has moved by as many columns.
+  */
+    void shiftDecimatedTraces(int nbColumns);
+
+    /**Returns the number of pixel columns by which tracesLayer can be scrolled after the time frame has moved by @p shift samples,
+  * 0 if the traces have to be drawn entirely. The difference with the move is added to scrollDrift.
+  */
+    int scrollableColumns(long shift);
+
+    /**Draws tracesLayer entirely.
+  * @param r the window, the part of the world shown.
+  */
+    void drawTracesLayer(const QRect& r);
+
+    /**Scrolls tracesLayer by scrollColumns pixel columns and draws the exposed columns only.
+  * The columns kept have been reduced from the previous time frames, they may differ from the exact ones by less than half a column
+  * and are drawn at the nearest pixel: the traces are redrawn entirely once the scrolling has stopped.
+  * @param r the window, the part of the world shown.
+  * @return true if the layer has been scrolled, false if it has to be drawn entirely.
+  */
+    bool scrollTracesLayer(const QRect& r);
+
+    /**Computes the points of the pixel columns @p firstColumn to @p lastColumn of the trace stored in the column @p column of data
+  * with the LTTB reduction, see decimateColumns.
+  */
+    void decimateLargestTriangles(int column,int firstColumn,int lastColumn,int nbSamples,QVector<long>& extrema);
+
+    /**Empties decimatedTraces if the downsampling, the number of pixel columns @p nbSamplesToDraw or the reduction have changed.*/
+    void resetDecimatedTraces(int nbSamplesToDraw);
+
+    /**Computes in @p extrema the extrema of the @p nbSamplesToDraw pixel columns of the trace of the channel @p channelId,
+  * see decimatedTrace.
+  * @param nbSamples number of samples of the time frame.
+  */
+    void decimateTrace(int channelId,int nbSamplesToDraw,int nbSamples,QVector<long>& extrema);
+
+    /**Computes the base ordinate of the traces of the shown channels, and their starting ordinate and abscissa
+  * (channelsStartingOrdinate and channelsStartingAbscissa).
+  * @param nbSamples number of samples of the time frame.
+  * @return the base ordinate of each trace, indexed by channel id.
+  */
+    QHash<int,int> computeTracePositions(int nbSamples);
+
+    /**Returns the pen used to draw the trace of the channel @p channelId.*/
+    QPen tracePen(int channelId);
+
+    class TraceTile;
+    class TileQueue;
+    class TileWorker;
+
+    /**Starts drawing the traces in tiles, images of the traces of consecutive channels rendered by several threads.
+  * Each column is a tile in multiple columns mode, and the columns are split in bands when there are less tiles than threads.
+  * The traces on which waveforms are drawn are not drawn in tiles.
+  * @param painter painter of the double buffer, giving the transformation and the clipping of the tiles.
+  * @param queue queue receiving the tiles.
+  * @param tracePositions base ordinate of each trace, see computeTracePositions.
+  * The other parameters are the ones of drawTrace.
+  * @return true if the tiles have been started and have to be drawn with drawTraceTiles, false if the traces have to be drawn directly.
+  */
+    bool startTraceTiles(QPainter& painter,TileQueue& queue,const QHash<int,int>& tracePositions,int limit,int nbSamples,int nbSamplesToDraw);
+
+    /**Renders the next tile of @p queue not taken by another thread.
+  * @return true if a tile has been rendered, false if none was left.
+  */
+    bool renderNextTile(TileQueue& queue);
+
+    /**Renders the traces of @p tile into its image.*/
+    void renderTile(TraceTile& tile,const TileQueue& queue);
+
+    /**Draws on @p painter the next tiles of @p queue, waiting for their rendering.
+  * @param groupId group whose tiles are drawn in multiple columns mode, -1 to draw all the remaining tiles.
+  */
+    void drawTraceTiles(QPainter& painter,TileQueue& queue,int groupId = -1);
+
+    class LineBatches;
+    class OverlayLines;
+
+    /**Computes the lines of the selected events, the vertical lines and the raster ticks of the selected clusters
+  * of the current time frame, for the column starting at the abscissa 0.
+  */
+    void computeOverlayLines(OverlayLines& overlay);
+
+    /**Draws the vertical lines of the selected clusters of @p overlay for the column starting at the abscissa @p X.
+  * @param clusterFiles cluster files containing data for the channels of the column, in multiple columns mode.
+  */
+    void drawClusterLines(QPainter& painter,const OverlayLines& overlay,int X,const QList<int>& clusterFiles);
+
+    /**Draws the rasters of the selected clusters of @p overlay for the column starting at the abscissa @p X
+  * and records their position in clustersOrder, rasterOrdinates and rasterAbscisses.
+  * @param clusterFiles cluster files containing data for the channels of the column, in multiple columns mode.
+  */
+    void drawRasters(QPainter& painter,const OverlayLines& overlay,int X,const QList<int>& clusterFiles);
+
+    /**Requests the traces of the current time frame, as an envelope if the view is zoomed out enough
+  * and the overview of the data file is available, as samples otherwise.
+  */
+    void requestTraces();
+
+    /**Stores the traces which have been retrieved and updates the display.*/
+    void tracesAvailable(Array<dataType>& data);
+
+    /**Reuses the samples of the previous time frame which are part of the current one: they are shifted to their new rows
+  * and only the samples missing before or after them are requested.
+  * @return true if the traces have been requested, false if the whole time frame has to be retrieved.
+  */
+    bool requestMissingTraces();
+
+    /**Returns the channels which have to be retrieved, the shown channels which are not skipped,
+  * sorted by id. The list is empty if all the channels have to be retrieved.
+  */
+    QList<int> channelsToRetrieve() const;
+
+    /**Returns the size of the bins of the envelope drawn instead of the @p nbSamples samples of a time frame,
+  * 0 if the samples themselves are drawn.
+  */
+    long envelopeBinSizeFor(long nbSamples) const;
+
+    /**Reads ahead the traces of the time frame [@p start,@p end], unless they would be drawn from the overview of the data file.*/
+    void prefetchTraces(long start,long end,long startInRecordingUnits);
+
+    /**Returns the ids of the events of the provider @p providerName used to browse, the selected ones which are not skipped.*/
+    QList<int> eventIdsToBrowse(const QString& providerName) const;
+
+    /**Returns the ids of the clusters of the provider @p providerName used to browse, the selected ones which are not skipped.*/
+    QList<int> clusterIdsToBrowse(int providerName) const;
+
+    /**Once a jump to the next (@p forward true) or previous event has landed, reads ahead the traces of the target of the following jump
+  * in the same direction.
+  */
+    void prefetchEventJump(bool forward);
+
+    /**Once a jump to the next (@p forward true) or previous spike has landed, reads ahead the traces of the target of the following jump
+  * in the same direction.
+  */
+    void prefetchClusterJump(bool forward);
+
+    /**Cancels the read ahead of the target of the following jump, the user having changed the direction or the selection.*/
+    void cancelJumpPrefetch();
+
+    /**Returns the value of the channel @p channelId at the row @p row of data (starting at 1),
+  * 0 if the channel has not been retrieved.
+  */
+    inline long channelValue(int row,int channelId){
+        const int column = dataColumns.value(channelId);
+        return (column == 0) ? 0 : data(row,column);
+    }
+
+    /**Returns the row of data containing the sample @p sampleIndex (starting at 1), the row of the minimum
+  * of the bin containing the sample if data contains an envelope.
+  */
+    inline int dataRow(long sampleIndex){
+        if (envelopeBinSize == 0)
+            return sampleIndex;
+        long row = 2 * ((sampleIndex - 1 + envelopeBinOffset) / envelopeBinSize) + 1;
+        return static_cast<int>(qBound(1L,row,static_cast<long>(data.nbOfRows()) - 1));
+    }
+
+    /**Returns in @p min and @p max the range drawn in the pixel column @p i (starting at 1) of the decimated trace @p extrema,
+  * the point of the column joined to the previous one if the reduction gives one point per column.
+  */
+    inline void columnRange(const QVector<long>& extrema,int i,long& min,long& max) const{
+        min = extrema[2 * (i - 1)];
+        max = extrema[2 * (i - 1) + 1];
+        if (i > 1 && TracesDecimation::isPointMode(decimatedMode)){
+            const long previous = extrema[2 * (i - 2)];
+            if (previous < min) min = previous;
+            if (previous > max) max = previous;
+        }
+    }
+
+    /**Computes the minimum and maximum of the channel @p channelId over the samples @p start to @p stop (included, starting at 1).*/
+    inline void columnExtrema(int channelId,int start,int stop,long& min,long& max){
+        if (envelopeBinSize != 0){
+            //Each bin of the envelope contributes its minimum and its maximum.
+            start = dataRow(start);
+            stop = dataRow(stop) + 1;
+        }
+        const int column = dataColumns.value(channelId);
+        if (column == 0){
+            min = max = 0;
+            return;
+        }
+        TracesDecimation::extrema(&data(start,column),data.nbOfColumns(),stop - start + 1,min,max);
+    }
+
     /**Draws on the left side the id and the amplitude for each channel.
  * @param painter painter on which to draw the information.
  */
@@ -1073,6 +1458,16 @@ private:
  */
     void drawCalibrationScale(QPainter& painter);
 
+    /**Records the timings of the frame which has just been drawn.
+ * @param paintTime time spent drawing the frame on the GUI thread, in nanoseconds.
+ */
+    void recordFrame(qint64 paintTime);
+
+    /**Draws the table of the timings of the frames in the top right corner of the widget.
+ * @param painter painter on which to draw the information, in the coordinates of the widget.
+ */
+    void drawFrameTimings(QPainter& painter);
+
     /** Corrects the window due to a zoom.
  * @param r rectangle corresponding to the window.
  */
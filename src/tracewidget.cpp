@@ -47,7 +47,11 @@ TraceWidget::TraceWidget(long startTime,long duration,bool greyScale,TracesProvi
     updateView(true),
     statusBar(statusBar),
     timer(new QTimer(this)),
-    pageTime(500)
+    pageTime(500),
+    paging(false),
+    following(false),
+    recordingGrown(false),
+    advancing(false)
 {
 
     QVBoxLayout *lay = new QVBoxLayout;
@@ -88,9 +92,12 @@ TraceWidget::TraceWidget(long startTime,long duration,bool greyScale,TracesProvi
 
     // Configure auto advance timer
     connect(timer, SIGNAL(timeout()), this, SLOT(advance()));
+    connect(&view, SIGNAL(recordingLengthChanged()), this, SLOT(slotRecordingLengthChanged()));
 }
 
 TraceWidget::~TraceWidget(){
+    if(following)
+        view.stopLiveUpdates();
 }
 
 /// Added by M.Zugaro to enable automatic forward paging
@@ -99,14 +106,25 @@ void TraceWidget::page()
     if(!isStill())
         return;
 
-   timer->start(pageTime);
+   paging = true;
    emit pagingStarted();
-   statusBar->showMessage(tr("Auto-advance every %1 ms").arg(pageTime));
+
+   //Follow the growth of the file as it is notified, poll its length otherwise (live streams, unsupported file systems).
+   following = view.startLiveUpdates();
+   if(following){
+       statusBar->showMessage(tr("Following the end of the recording"));
+       recordingGrown = true;
+       advance();
+   }
+   else{
+       timer->start(pageTime);
+       statusBar->showMessage(tr("Auto-advance every %1 ms").arg(pageTime));
+   }
 }
 
 bool TraceWidget::isStill()
 {
-	return !timer->isActive();
+	return !paging;
 }
 
 void TraceWidget::stop()
@@ -115,9 +133,29 @@ void TraceWidget::stop()
         return;
 
     timer->stop();
+    if(following){
+        view.stopLiveUpdates();
+        following = false;
+    }
+    paging = false;
 	emit pagingStopped();
 }
 
+void TraceWidget::slotRecordingLengthChanged()
+{
+    //The display is updated at most once per page time, the growth notified in between is shown when the delay expires.
+    recordingGrown = true;
+    if(!timer->isActive())
+        advance();
+}
+
+void TraceWidget::slotTimeFrameEdited()
+{
+    //Only the changes made by the user stop the paging.
+    if(!advancing)
+        stop();
+}
+
 void TraceWidget::accelerate()
 {
     if (isStill())
@@ -143,15 +181,22 @@ void TraceWidget::decelerate()
 /// Added by M.Zugaro to enable automatic forward paging
 void TraceWidget::advance()
 {
-	 // Temporarily disconnect so that changes to scrollbar and time boxes do not automatically stop paging!
-	 disconnect(startMinute,SIGNAL(valueChanged(int)),this, SLOT(stop()));
-    disconnect(startSecond,SIGNAL(valueChanged(int)),this, SLOT(stop()));
-    disconnect(startMilisecond,SIGNAL(valueChanged(int)),this, SLOT(stop()));
-    disconnect(scrollBar,SIGNAL(valueChanged(int)),this, SLOT(stop()));
-	 
+    if(following){
+        //Nothing has been appended since the last update, wait for the next notification.
+        if(!recordingGrown){
+            timer->stop();
+            return;
+        }
+        recordingGrown = false;
+    }
+
+    // Changes to scrollbar and time boxes made here must not stop paging, see slotTimeFrameEdited
+    advancing = true;
+
     // Because data files are expected to have grown, update recording length,
-    // as well as spin box and scroll bar in the view
-    view.updateRecordingLength();
+    // as well as spin box and scroll bar in the view. When following the file, the length is already known.
+    if(!following)
+        view.updateRecordingLength();
     recordingLength = view.recordingLength();
     minutePart = recordingLength / 60000;
     int remainingSeconds = static_cast<int>(fmod(static_cast<double>(recordingLength),60000));
@@ -166,18 +211,14 @@ void TraceWidget::advance()
     updateView = false; // do not redraw yet
     correctStartTime();
     updateView = true;
-    //Inform the traceView
+    //Inform the traceView, only the samples appended since the previous page are read
     view.displayTimeFrame(startTime,timeWindow);
-	 
+
     //Inform listener of the modification
     emit updateStartAndDuration(startTime,timeWindow);
-	 
-	 // Reconnect
-	 connect(startMinute,SIGNAL(valueChanged(int)),this, SLOT(stop()));
-    connect(startSecond,SIGNAL(valueChanged(int)),this, SLOT(stop()));
-    connect(startMilisecond,SIGNAL(valueChanged(int)),this, SLOT(stop()));
-    connect(scrollBar,SIGNAL(valueChanged(int)),this, SLOT(stop()));
-	 
+
+    advancing = false;
+
     timer->start(pageTime); // restart timer
 }
 
@@ -263,9 +304,9 @@ void TraceWidget::initSelectionWidgets()
     connect(startMilisecond,SIGNAL(editingFinished()),this, SLOT(slotStartMilisecondTimeUpdated()));
 
 	 /// Added by M.Zugaro to enable automatic forward paging
-	 connect(startMinute,SIGNAL(valueChanged(int)),this, SLOT(stop()));
-    connect(startSecond,SIGNAL(valueChanged(int)),this, SLOT(stop()));
-    connect(startMilisecond,SIGNAL(valueChanged(int)),this, SLOT(stop()));
+	 connect(startMinute,SIGNAL(valueChanged(int)),this, SLOT(slotTimeFrameEdited()));
+    connect(startSecond,SIGNAL(valueChanged(int)),this, SLOT(slotTimeFrameEdited()));
+    connect(startMilisecond,SIGNAL(valueChanged(int)),this, SLOT(slotTimeFrameEdited()));
 #endif
     connect(duration,SIGNAL(returnPressed()),this, SLOT(slotDurationUpdated()));
 
@@ -285,7 +326,7 @@ void TraceWidget::initSelectionWidgets()
     scrollBar->setValue(startTime);
     connect(scrollBar,SIGNAL(sliderReleased()),this, SLOT(slotScrollBarUpdated()));
     connect(scrollBar,SIGNAL(valueChanged(int)),this, SLOT(slotScrollBarUpdated()));
-    connect(scrollBar,SIGNAL(valueChanged(int)),this, SLOT(stop()));
+    connect(scrollBar,SIGNAL(valueChanged(int)),this, SLOT(slotTimeFrameEdited()));
 
     //enable the user to use the keyboard to interact with the scrollbar.
     scrollBar->setMouseTracking(false);
@@ -294,6 +294,21 @@ public Q_SLOTS:
   */
     void setAutocenterChannels(bool status);
 
+    /**Informs the view to change the reduction of the samples to the pixel columns of the traces.
+  * @param mode the new reduction.
+  */
+    void setDecimationMode(TracesDecimation::Mode mode){view.setDecimationMode(mode);}
+
+    /**Informs the view to show or hide the timings of the frames.
+  * @param show true if the timings have to be shown, false otherwise.
+  */
+    void showFrameTimings(bool show){view.setFrameTimingsShown(show);}
+
+    /**Writes the timings of the last frames of the view as comma separated values in the file @p fileName.
+  * @return true if the file could be written, false otherwise.
+  */
+    bool exportFrameTimings(const QString& fileName) const{return view.exportFrameTimings(fileName);}
+
     /**Informs the view to show or hide the labels display next to the traces.
   * @param show true if the labels have to be shown, false otherwise.
   */
@@ -632,11 +647,29 @@ private Q_SLOTS:
     /**Update the selection widgets and informs view to present the traces for an updated time frame.*/
     void slotScrollBarUpdated();
 
+    /**Shows the data appended to the file being recorded.*/
+    void slotRecordingLengthChanged();
+
+    /**Stops the paging when the user modifies the time frame.*/
+    void slotTimeFrameEdited();
+
 private:
     /// Added by M.Zugaro to enable automatic forward paging
     QTimer	*timer;
     int		pageTime;
 
+    /**True while paging, either polling the length of the recording or following the growth of the file.*/
+    bool paging;
+
+    /**True if the growth of the file is notified by the view instead of being polled.*/
+    bool following;
+
+    /**True if data have been appended to the file since the last page.*/
+    bool recordingGrown;
+
+    /**True while advance updates the selection widgets.*/
+    bool advancing;
+
     /**Amount of time used when looking for the traces.
   * This amount is in miliseconds and the default is 1000.
   */